@@ -0,0 +1,106 @@
+/*
+ * mcp4725_bus.h
+ *
+ *  I2C bus manager. The manager owns an I2C peripheral and runs the transactions submitted by any
+ *  driver back to back in IT or DMA Mode: the next transaction is started from the completion IRQ
+ *  of the previous one. The queue is sorted by priority, so the real-time DAC samples are served
+ *  before the pending EEPROM writes or status reads (a transaction already on the bus is not aborted).
+ *
+ *  The descriptors are owned by the caller and must stay valid until their callback. The bus time of
+ *  each transaction (SCL periods) is accumulated per slave address to report the utilisation.
+ */
+
+#ifndef MCP4725_MCP4725_BUS_H_
+#define MCP4725_MCP4725_BUS_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+
+#ifndef MCP4725_BUS_MAX_CLIENTS
+#define MCP4725_BUS_MAX_CLIENTS		8		/* Slave addresses with utilisation statistics per bus */
+#endif
+
+#define MCP4725_BUS_XFER_BUFFER		5		/* Bytes of the descriptor buffer, the largest MCP4725 transfer */
+
+/* Transfer Direction Enumeration */
+
+typedef enum{
+	MCP4725_BUS_WRITE = 0,
+	MCP4725_BUS_READ
+}MCP4725_Bus_Dir_e;
+
+typedef struct mcp4725_bus_xfer MCP4725_Bus_Xfer_t;
+
+/* Called from the I2C IRQ at the end of the transaction */
+typedef void (*MCP4725_Bus_Callback_t)(MCP4725_Bus_Xfer_t* xfer, HAL_StatusTypeDef status);
+
+/* Transaction Descriptor Structure */
+
+struct mcp4725_bus_xfer{
+	uint8_t					dev_addr;						/* 7-bit slave address, 0x00 for the general call */
+	MCP4725_Bus_Dir_e		dir;							/* Write or read */
+	uint8_t *				data;							/* Bytes to send or receive, commonly buffer */
+	uint16_t				size;							/* Bytes of the transaction */
+	uint8_t					priority;						/* Higher value is served first, same priority in order of arrival */
+	MCP4725_Bus_Callback_t	callback;						/* End of the transaction, NULL if not needed */
+	void *					context;						/* Free for the caller */
+	MCP4725_Handle_t *		device;							/* MCP4725 updated at the end of the transaction, NULL for other drivers */
+	MCP4725_Operation_e		operation;						/* MCP4725 command of the transaction, reference to MCP4725_Operation_e */
+	uint16_t				dac_data;						/* DAC register written by the MCP4725 command */
+	uint8_t					pd_mode;						/* Power down mode written by the MCP4725 command */
+	uint8_t					buffer[MCP4725_BUS_XFER_BUFFER];	/* Storage of the bytes for the prepare functions */
+	__IO uint8_t			queued;							/* 1 from the submit to the callback */
+	MCP4725_Bus_Xfer_t *	next;							/* Next descriptor in the queue */
+};
+
+/* Utilisation of a slave address */
+
+typedef struct mcp4725_bus_client{
+	uint8_t					dev_addr;						/* 7-bit slave address */
+	uint32_t				xfers;							/* Transactions completed */
+	uint32_t				errors;							/* Transactions failed */
+	uint32_t				scl;							/* Bus time, SCL periods */
+}MCP4725_Bus_Client_t;
+
+/* Bus Manager Handle Structure */
+
+typedef struct mcp4725_bus_handle{
+	I2C_HandleTypeDef *		i2c_handle;						/* I2C peripheral owned by the manager */
+	MCP4725_Xfer_e			xfer_mode;						/* Interrupt or DMA Mode, reference to MCP4725_Xfer_e */
+	uint32_t				bus_clock;						/* SCL frequency in Hz, to convert the bus time */
+	MCP4725_Bus_Xfer_t *	head;							/* Queue sorted by priority */
+	MCP4725_Bus_Xfer_t *	active;							/* Transaction on the bus, NULL when idle */
+	uint32_t				stats_tick;						/* HAL tick of the start of the statistics */
+	uint8_t					num_clients;					/* Entries used in clients[] */
+	MCP4725_Bus_Client_t	clients[MCP4725_BUS_MAX_CLIENTS];	/* Utilisation per slave address */
+}MCP4725_Bus_Handle_t;
+
+/* Initialization function */
+HAL_StatusTypeDef mcp4725_Bus_Init(MCP4725_Bus_Handle_t* bus, I2C_HandleTypeDef* i2c_handle, uint32_t bus_clock, MCP4725_Xfer_e xfer_mode);
+
+/* Queue functions */
+HAL_StatusTypeDef mcp4725_Bus_Submit(MCP4725_Bus_Handle_t* bus, MCP4725_Bus_Xfer_t* xfer);
+HAL_StatusTypeDef mcp4725_Bus_Cancel(MCP4725_Bus_Handle_t* bus, MCP4725_Bus_Xfer_t* xfer);
+
+/* Descriptors of the MCP4725 commands */
+void mcp4725_Bus_Prepare_Fast_Mode(MCP4725_Bus_Xfer_t* xfer, MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode, uint8_t priority);
+void mcp4725_Bus_Prepare_DAC_EEPROM(MCP4725_Bus_Xfer_t* xfer, MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode, uint8_t priority);
+void mcp4725_Bus_Prepare_Read(MCP4725_Bus_Xfer_t* xfer, MCP4725_Handle_t* mcp4725_dev, uint8_t priority);
+
+/* Call from HAL_I2C_MasterTxCpltCallback / HAL_I2C_MasterRxCpltCallback and HAL_I2C_ErrorCallback */
+void mcp4725_Bus_I2C_CpltCallback(I2C_HandleTypeDef* hi2c);
+void mcp4725_Bus_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c);
+
+/* Utilisation, per mille of the time since the reset of the statistics */
+uint16_t mcp4725_Bus_Utilisation(MCP4725_Bus_Handle_t* bus, uint8_t dev_addr);
+uint16_t mcp4725_Bus_Total_Utilisation(MCP4725_Bus_Handle_t* bus);
+void mcp4725_Bus_Reset_Stats(MCP4725_Bus_Handle_t* bus);
+
+#endif /* MCP4725_MCP4725_BUS_H_ */
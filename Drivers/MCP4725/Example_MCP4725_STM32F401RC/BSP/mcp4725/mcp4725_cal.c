@@ -0,0 +1,341 @@
+/*
+ * mcp4725_cal.c
+ *
+ *  Linearity calibration of MCP4725.
+ *
+ *  The DAC is monotonic, so the measured curve can be inverted segment by segment: the code of an ideal
+ *  voltage is interpolated between the two breakpoints measured around it, or extrapolated from the first
+ *  and last segments. The breakpoints can be out of the code range (a positive offset gives a negative
+ *  code at 0 V), only the corrected codes are clamped to 0 and 4095: the outputs below the offset and
+ *  above the full scale are not reachable.
+ *
+ *  The measure is a weak function: by default it averages MCP4725_CAL_AVERAGES conversions of the ADC,
+ *  override it for an external meter or, on the host, a model of the transfer curve.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "mcp4725_cal.h"
+
+#define CAL_SEGMENT				( 1U << MCP4725_CAL_SHIFT )
+#define CAL_CRC_POLY			0xEDB88320U
+#define CAL_CRC_LEN				offsetof(MCP4725_Cal_Table_t, crc)
+
+static HAL_StatusTypeDef mcp4725_cal_measure(MCP4725_Cal_t* cal, uint16_t dac_data, uint32_t* output_uv);
+static uint32_t mcp4725_cal_ideal_uv(const MCP4725_Cal_t* cal, uint32_t dac_data);
+static uint32_t mcp4725_cal_crc(const MCP4725_Cal_Table_t* table);
+
+/**
+  * @brief  Initialize the calibration of a device.
+  * @param  cal Pointer to a MCP4725_Cal_t structure. Set cal->hadc to the ADC channel on VOUT for the default measure.
+  * @param  mcp4725_dev Device initialized by mcp4725_Init, in normal mode.
+  * @param  full_scale_mv VDD of the DAC, the ideal output of code 4096.
+  * @param  adc_vref_mv Reference voltage of the ADC.
+  * @retval HAL_OK, HAL_ERROR if the parameters are not valid.
+  */
+HAL_StatusTypeDef mcp4725_Cal_Init(MCP4725_Cal_t* cal, MCP4725_Handle_t* mcp4725_dev, uint16_t full_scale_mv, uint16_t adc_vref_mv){
+
+	if( mcp4725_dev == NULL || full_scale_mv == 0 ){
+		return HAL_ERROR;
+	}
+
+	cal->device = mcp4725_dev;
+#if defined(HAL_ADC_MODULE_ENABLED)
+	cal->hadc = NULL;
+#endif
+	cal->full_scale_mv = full_scale_mv;
+	cal->adc_vref_mv = adc_vref_mv;
+	cal->error_before_uv = 0;
+	cal->error_after_uv = 0;
+
+	for( uint8_t idx = 0; idx < MCP4725_CAL_POINTS; idx++ ){
+		cal->measured_uv[idx] = 0;
+	}
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Sweep the breakpoints, build the correction table and measure the residual error.
+  * @note	Blocking, about (MCP4725_CAL_POINTS + 16) * (MCP4725_CAL_SETTLE_MS + measure) ms. The output moves
+  * 		over the full range, disconnect the load if needed.
+  * @param  cal Pointer to a MCP4725_Cal_t structure.
+  * @param  table Correction table built, valid (magic and CRC) when HAL_OK.
+  * @retval HAL_OK, HAL_ERROR if a write failed, the device is in power down or the output is not monotonic.
+  */
+HAL_StatusTypeDef mcp4725_Cal_Run(MCP4725_Cal_t* cal, MCP4725_Cal_Table_t* table){
+
+	if( cal->device->powerdown_mode != MCP4725_NORMAL_MODE ){
+		return HAL_ERROR;
+	}
+
+	/* Output at the breakpoints, the last one (4096) extrapolated from the slope of the last LSB */
+	cal->error_before_uv = 0;
+	for( uint8_t idx = 0; idx < MCP4725_CAL_POINTS - 1; idx++ ){
+		if( mcp4725_cal_measure(cal, idx << MCP4725_CAL_SHIFT, &cal->measured_uv[idx]) != HAL_OK ){
+			return HAL_ERROR;
+		}
+	}
+
+	uint32_t top;
+	if( mcp4725_cal_measure(cal, 4095, &top) != HAL_OK ){
+		return HAL_ERROR;
+	}
+	uint32_t last = cal->measured_uv[MCP4725_CAL_POINTS - 2];
+	if( top < last ){
+		return HAL_ERROR;
+	}
+	cal->measured_uv[MCP4725_CAL_POINTS - 1] = top + ( top - last ) / ( CAL_SEGMENT - 1 );
+
+	for( uint8_t idx = 0; idx < MCP4725_CAL_POINTS; idx++ ){
+
+		if( idx > 0 && cal->measured_uv[idx] <= cal->measured_uv[idx - 1] ){
+			return HAL_ERROR;
+		}
+
+		int32_t error = (int32_t) ( cal->measured_uv[idx] - mcp4725_cal_ideal_uv(cal, idx << MCP4725_CAL_SHIFT) );
+		uint32_t magnitude = ( error < 0 ) ? (uint32_t) -error : (uint32_t) error;
+		if( magnitude > cal->error_before_uv ){
+			cal->error_before_uv = magnitude;
+		}
+	}
+
+	/* Code of the ideal voltage of each breakpoint, in the measured segment around it */
+	uint8_t segment = 0;
+	for( uint8_t idx = 0; idx < MCP4725_CAL_POINTS; idx++ ){
+
+		uint32_t target = mcp4725_cal_ideal_uv(cal, idx << MCP4725_CAL_SHIFT);
+
+		while( segment < MCP4725_CAL_POINTS - 2 && cal->measured_uv[segment + 1] < target ){
+			segment++;
+		}
+
+		int64_t delta = (int64_t) target - cal->measured_uv[segment];
+		int64_t span = cal->measured_uv[segment + 1] - cal->measured_uv[segment];
+		int64_t code = ( (int64_t) segment << MCP4725_CAL_SHIFT ) + ( delta * CAL_SEGMENT + ( ( delta >= 0 ) ? span / 2 : -span / 2 ) ) / span;
+
+		table->point[idx] = (int16_t) ( ( code < -4096 ) ? -4096 : ( ( code > 8192 ) ? 8192 : code ) );
+	}
+
+	table->magic = MCP4725_CAL_MAGIC;
+	table->full_scale_mv = cal->full_scale_mv;
+	table->dev_addr = cal->device->dev_addr;
+	table->reserved = 0;
+	table->crc = mcp4725_cal_crc(table);
+
+	/* Residual error, at the codes farthest from the breakpoints */
+	cal->error_after_uv = 0;
+	for( uint8_t idx = 0; idx < MCP4725_CAL_POINTS - 1; idx++ ){
+
+		uint16_t dac_data = ( idx << MCP4725_CAL_SHIFT ) + CAL_SEGMENT / 2;
+		uint32_t output;
+		if( mcp4725_cal_measure(cal, mcp4725_Cal_Correct(table, dac_data), &output) != HAL_OK ){
+			return HAL_ERROR;
+		}
+
+		int32_t error = (int32_t) ( output - mcp4725_cal_ideal_uv(cal, dac_data) );
+		uint32_t magnitude = ( error < 0 ) ? (uint32_t) -error : (uint32_t) error;
+		if( magnitude > cal->error_after_uv ){
+			cal->error_after_uv = magnitude;
+		}
+	}
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Measure the output of the DAC, average of MCP4725_CAL_AVERAGES conversions of cal->hadc.
+  * @note	This function should not be modified, for another instrument (external meter, host model) it can be implemented in the user file.
+  * @param  cal Pointer to a MCP4725_Cal_t structure.
+  * @retval Output voltage in uV, 0 if the ADC is not available.
+  */
+__weak uint32_t mcp4725_Cal_Measure_uV(MCP4725_Cal_t* cal){
+
+#if defined(HAL_ADC_MODULE_ENABLED)
+	uint32_t sum = 0;
+
+	if( cal->hadc == NULL ){
+		return 0;
+	}
+
+	for( uint8_t idx = 0; idx < MCP4725_CAL_AVERAGES; idx++ ){
+		HAL_ADC_Start(cal->hadc);
+		if( HAL_ADC_PollForConversion(cal->hadc, 10) != HAL_OK ){
+			HAL_ADC_Stop(cal->hadc);
+			return 0;
+		}
+		sum += HAL_ADC_GetValue(cal->hadc);
+		HAL_ADC_Stop(cal->hadc);
+	}
+
+	return (uint32_t) ( ( (uint64_t) sum * cal->adc_vref_mv * 1000U ) / ( (uint64_t) MCP4725_CAL_ADC_MAX * MCP4725_CAL_AVERAGES ) );
+#else
+	UNUSED(cal);
+	return 0;
+#endif
+}
+
+/**
+  * @brief  Table with no correction, used when no valid table is stored.
+  * @param  table Pointer to a MCP4725_Cal_Table_t structure.
+  * @param  dev_addr Device of the table.
+  * @retval None
+  */
+void mcp4725_Cal_Identity(MCP4725_Cal_Table_t* table, uint8_t dev_addr){
+
+	for( uint8_t idx = 0; idx < MCP4725_CAL_POINTS; idx++ ){
+		table->point[idx] = (int16_t) ( idx << MCP4725_CAL_SHIFT );
+	}
+
+	table->magic = MCP4725_CAL_MAGIC;
+	table->full_scale_mv = 0;
+	table->dev_addr = dev_addr;
+	table->reserved = 0;
+	table->crc = mcp4725_cal_crc(table);
+
+}
+
+/**
+  * @brief  Check a table, in RAM or in flash.
+  * @retval 1 if the magic and the CRC are valid, 0 if not (erased flash, other layout).
+  */
+uint8_t mcp4725_Cal_Valid(const MCP4725_Cal_Table_t* table){
+
+	if( table == NULL || table->magic != MCP4725_CAL_MAGIC ){
+		return 0;
+	}
+
+	return ( mcp4725_cal_crc(table) == table->crc ) ? 1 : 0;
+}
+
+/**
+  * @brief  Erase a flash sector (page on the STM32F1) and write the table at its start.
+  * @note	The sector must not hold code, reserve it in the linker script. The CPU stalls during the erase.
+  * @param  table Table built by mcp4725_Cal_Run.
+  * @param  address Start of the sector (page), aligned to 32 bytes.
+  * @param  sector FLASH_SECTOR_x of address, not used on the STM32F1.
+  * @retval HAL_OK, HAL_ERROR if the table is not valid, the flash module is not enabled or the write failed.
+  */
+HAL_StatusTypeDef mcp4725_Cal_Save(const MCP4725_Cal_Table_t* table, uint32_t address, uint32_t sector){
+
+#if defined(HAL_FLASH_MODULE_ENABLED)
+	FLASH_EraseInitTypeDef erase = {0};
+	uint32_t error = 0;
+	uint32_t words[8];
+	const uint8_t* data = (const uint8_t*) table;
+	HAL_StatusTypeDef status;
+
+	if( mcp4725_Cal_Valid(table) == 0 || ( address & 0x1F ) != 0 ){
+		return HAL_ERROR;
+	}
+
+#if defined(STM32F103x6)
+	UNUSED(sector);
+	erase.TypeErase = FLASH_TYPEERASE_PAGES;
+	erase.PageAddress = address;
+	erase.NbPages = 1;
+#else
+	erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+	erase.Sector = sector;
+	erase.NbSectors = 1;
+	erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+	#if defined(STM32H723xx)
+		erase.Banks = FLASH_BANK_1;
+	#endif
+#endif
+
+	HAL_FLASH_Unlock();
+	status = HAL_FLASHEx_Erase(&erase, &error);
+
+	/* 32 bytes at a time, the flash word of the STM32H7 */
+	for( uint32_t offset = 0; offset < sizeof(MCP4725_Cal_Table_t) && status == HAL_OK; offset += sizeof(words) ){
+
+		uint32_t len = ( sizeof(MCP4725_Cal_Table_t) - offset < sizeof(words) ) ? sizeof(MCP4725_Cal_Table_t) - offset : sizeof(words);
+
+		memset(words, 0xFF, sizeof(words));
+		memcpy(words, &data[offset], len);
+
+#if defined(STM32H723xx)
+		status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_FLASHWORD, address + offset, (uint32_t) words);
+#else
+		for( uint8_t idx = 0; idx < ( len + 3 ) / 4 && status == HAL_OK; idx++ ){
+			status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address + offset + 4 * idx, words[idx]);
+		}
+#endif
+	}
+
+	HAL_FLASH_Lock();
+
+	if( status != HAL_OK || mcp4725_Cal_Valid((const MCP4725_Cal_Table_t*) address) == 0 ){
+		return HAL_ERROR;
+	}
+
+	return HAL_OK;
+#else
+	UNUSED(table);
+	UNUSED(address);
+	UNUSED(sector);
+	return HAL_ERROR;
+#endif
+}
+
+/**
+  * @brief  Code to write for an ideal output: dac_data * full scale / 4096.
+  * @note	Call before each write, two table reads and one multiply.
+  * @param  table Valid table, in flash or RAM.
+  * @param  dac_data 12-bit value.
+  * @retval Corrected 12-bit value.
+  */
+uint16_t mcp4725_Cal_Correct(const MCP4725_Cal_Table_t* table, uint16_t dac_data){
+
+	dac_data &= 0x0FFF;
+
+	const int16_t* point = &table->point[dac_data >> MCP4725_CAL_SHIFT];
+	int32_t frac = dac_data & ( CAL_SEGMENT - 1 );
+
+	int32_t code = point[0] + ( ( ( (int32_t) point[1] - point[0] ) * frac + (int32_t) ( CAL_SEGMENT / 2 ) ) >> MCP4725_CAL_SHIFT );
+
+	return (uint16_t) ( ( code < 0 ) ? 0 : ( ( code > 4095 ) ? 4095 : code ) );
+}
+
+/**
+  * @brief  Write a code and measure the output after the settling time.
+  * @retval HAL_OK, HAL_ERROR if the write failed (output_uv not set).
+  */
+static HAL_StatusTypeDef mcp4725_cal_measure(MCP4725_Cal_t* cal, uint16_t dac_data, uint32_t* output_uv){
+
+	if( mcp4725_Write_DAC_Register(cal->device, dac_data) != HAL_OK ){
+		return HAL_ERROR;
+	}
+
+	HAL_Delay(MCP4725_CAL_SETTLE_MS);
+
+	*output_uv = mcp4725_Cal_Measure_uV(cal);
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Ideal output of a code, full scale at 4096.
+  */
+static uint32_t mcp4725_cal_ideal_uv(const MCP4725_Cal_t* cal, uint32_t dac_data){
+	return (uint32_t) ( ( (uint64_t) dac_data * cal->full_scale_mv * 1000U ) >> 12 );
+}
+
+/**
+  * @brief  CRC-32 (IEEE) of the table, the crc field excluded.
+  */
+static uint32_t mcp4725_cal_crc(const MCP4725_Cal_Table_t* table){
+
+	const uint8_t* data = (const uint8_t*) table;
+	uint32_t crc = 0xFFFFFFFFU;
+
+	for( uint32_t idx = 0; idx < CAL_CRC_LEN; idx++ ){
+		crc ^= data[idx];
+		for( uint8_t bit = 0; bit < 8; bit++ ){
+			crc = ( crc >> 1 ) ^ ( CAL_CRC_POLY & ( 0U - ( crc & 1U ) ) );
+		}
+	}
+
+	return ~crc;
+}
@@ -0,0 +1,80 @@
+/*
+ * mcp4725_cal.h
+ *
+ *  Linearity calibration of MCP4725. The output is measured at MCP4725_CAL_POINTS codes, 256 codes
+ *  apart, with an ADC channel wired to VOUT. For each breakpoint the table keeps the code that gives
+ *  the ideal voltage (code * full scale / 4096), the offset, gain and INL errors are corrected by
+ *  linear interpolation between the breakpoints:
+ *
+ *  	corrected = point[code >> 8] + ( point[(code >> 8) + 1] - point[code >> 8] ) * ( code & 0xFF ) / 256
+ *
+ *  The table (17 codes, magic and CRC, 48 bytes) is written in a flash sector once, at the next boot it
+ *  is checked and used in place. The residual error is measured at the middle of each segment.
+ */
+
+#ifndef MCP4725_MCP4725_CAL_H_
+#define MCP4725_MCP4725_CAL_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+
+#define MCP4725_CAL_SHIFT			8								/* log2 of the codes per segment */
+#define MCP4725_CAL_POINTS			( ( 4096 >> MCP4725_CAL_SHIFT ) + 1 )	/* Breakpoints, the last one at code 4096 */
+#define MCP4725_CAL_MAGIC			0x4D433235						/* "MC25" */
+
+#ifndef MCP4725_CAL_ADC_MAX
+#define MCP4725_CAL_ADC_MAX			4095		/* ADC reading at the reference voltage, 12-bit */
+#endif
+
+#ifndef MCP4725_CAL_AVERAGES
+#define MCP4725_CAL_AVERAGES		16			/* ADC readings per measure */
+#endif
+
+#ifndef MCP4725_CAL_SETTLE_MS
+#define MCP4725_CAL_SETTLE_MS		1			/* Wait after a write, the output settles in 6 us */
+#endif
+
+/* Correction Table, stored in flash */
+
+typedef struct mcp4725_cal_table{
+	uint32_t				magic;							/* MCP4725_CAL_MAGIC when valid */
+	uint16_t				full_scale_mv;					/* VDD of the calibration, output of code 4096 */
+	uint16_t				dev_addr;						/* Device calibrated */
+	int16_t					point[MCP4725_CAL_POINTS];		/* Code of the ideal voltage of the breakpoints 0, 256, ... 4096 */
+	uint16_t				reserved;
+	uint32_t				crc;							/* CRC-32 of the previous fields */
+}MCP4725_Cal_Table_t;
+
+/* Calibration Handle Structure */
+
+typedef struct mcp4725_cal{
+	MCP4725_Handle_t *		device;							/* Device calibrated */
+#if defined(HAL_ADC_MODULE_ENABLED)
+	ADC_HandleTypeDef *		hadc;							/* ADC channel on VOUT, used by mcp4725_Cal_Measure_uV */
+#endif
+	uint16_t				full_scale_mv;					/* VDD of the DAC */
+	uint16_t				adc_vref_mv;					/* Reference of the ADC */
+	uint32_t				measured_uv[MCP4725_CAL_POINTS];	/* Output at the breakpoints, not corrected */
+	uint32_t				error_before_uv;				/* Largest error at the breakpoints, not corrected */
+	uint32_t				error_after_uv;					/* Largest error at the middle of the segments, corrected */
+}MCP4725_Cal_t;
+
+/* Calibration */
+HAL_StatusTypeDef mcp4725_Cal_Init(MCP4725_Cal_t* cal, MCP4725_Handle_t* mcp4725_dev, uint16_t full_scale_mv, uint16_t adc_vref_mv);
+HAL_StatusTypeDef mcp4725_Cal_Run(MCP4725_Cal_t* cal, MCP4725_Cal_Table_t* table);
+uint32_t mcp4725_Cal_Measure_uV(MCP4725_Cal_t* cal);
+
+/* Correction table */
+void mcp4725_Cal_Identity(MCP4725_Cal_Table_t* table, uint8_t dev_addr);
+uint8_t mcp4725_Cal_Valid(const MCP4725_Cal_Table_t* table);
+HAL_StatusTypeDef mcp4725_Cal_Save(const MCP4725_Cal_Table_t* table, uint32_t address, uint32_t sector);
+uint16_t mcp4725_Cal_Correct(const MCP4725_Cal_Table_t* table, uint16_t dac_data);
+
+#endif /* MCP4725_MCP4725_CAL_H_ */
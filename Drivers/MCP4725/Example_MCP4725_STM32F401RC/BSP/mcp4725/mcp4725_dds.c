@@ -0,0 +1,260 @@
+/*
+ * mcp4725_dds.c
+ *
+ *  Direct digital synthesis for MCP4725, fixed-point phase accumulator and table lookup.
+ *
+ *  The phase is 32 bits: the upper table_bits bits index the table and the next 16 bits are the
+ *  fraction used by the linear interpolation. All the arithmetic per sample is integer, the float
+ *  math is only used to build the sine table.
+ */
+
+#include <math.h>
+#include "mcp4725_dds.h"
+#include "mcp4725_wave.h"
+
+#define DDS_FRAC_BITS		16			/* Bits of the interpolation fraction */
+#define DDS_GAIN_SHIFT		11			/* log2 of MCP4725_DDS_UNITY */
+
+static inline uint16_t mcp4725_dds_lookup(const MCP4725_DDS_Handle_t* dds, uint32_t phase);
+static inline uint32_t mcp4725_dds_sweep(MCP4725_DDS_Handle_t* dds, uint32_t tuning_word);
+
+/**
+  * @brief  Initialize the DDS: fixed frequency of 0 Hz, table scale and midscale at the table zero.
+  * @param  dds Pointer to a MCP4725_DDS_Handle_t structure.
+  * @param  table One period of the waveform, 2^table_bits samples of 12 bits (mcp4725_DDS_Sine_Table or user table).
+  * @param  table_bits 1 to MCP4725_DDS_MAX_TABLE_BITS.
+  * @param  sample_rate Samples per second of the output (TIM2 rate, or f_SCL / MCP4725_STREAM_SCL_PER_SAMPLE when streaming).
+  * @retval HAL_OK, HAL_ERROR if the parameters are not valid.
+  */
+HAL_StatusTypeDef mcp4725_DDS_Init(MCP4725_DDS_Handle_t* dds, const uint16_t* table, uint8_t table_bits, uint32_t sample_rate){
+
+	if( table == NULL || table_bits == 0 || table_bits > MCP4725_DDS_MAX_TABLE_BITS || sample_rate == 0 ){
+		return HAL_ERROR;
+	}
+
+	dds->table = table;
+	dds->table_bits = table_bits;
+	dds->interpolate = 0;
+	dds->sample_rate = sample_rate;
+	dds->phase = 0;
+	dds->tuning_word = 0;
+	dds->amplitude = MCP4725_DDS_UNITY;
+	dds->offset = MCP4725_DDS_MIDSCALE;
+	dds->pd_mode = MCP4725_NORMAL_MODE;
+	dds->sweep_mode = MCP4725_DDS_SWEEP_NONE;
+	dds->sweep_start = 0;
+	dds->sweep_stop = 0;
+	dds->sweep_step = 0;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Build one period of a full scale sine wave, centered at MCP4725_DDS_MIDSCALE.
+  * @param  table Buffer of 2^table_bits samples.
+  * @retval None
+  */
+void mcp4725_DDS_Sine_Table(uint16_t* table, uint8_t table_bits){
+
+	const uint32_t len = 1UL << table_bits;
+	const float step = MCP4725_WAVE_TWO_PI / (float) len;
+
+	for( uint32_t idx = 0; idx < len; idx++ ){
+		table[idx] = (uint16_t) lrintf( (float) MCP4725_DDS_MIDSCALE + (float) ( MCP4725_DAC_MAX - MCP4725_DDS_MIDSCALE ) * sinf(step * (float) idx) );
+	}
+
+}
+
+/**
+  * @brief  Tuning word of a frequency: freq * 2^32 / sample_rate.
+  * @param  freq_mhz Frequency in mHz.
+  * @retval Tuning word
+  */
+uint32_t mcp4725_DDS_Tuning_Word(const MCP4725_DDS_Handle_t* dds, uint32_t freq_mhz){
+	return (uint32_t) ( ( (uint64_t) freq_mhz << 32 ) / ( (uint64_t) dds->sample_rate * 1000U ) );
+}
+
+/**
+  * @brief  Output frequency of the current tuning word, in mHz.
+  */
+uint32_t mcp4725_DDS_Get_Frequency(const MCP4725_DDS_Handle_t* dds){
+	return (uint32_t) ( ( (uint64_t) dds->tuning_word * dds->sample_rate * 1000U ) >> 32 );
+}
+
+/**
+  * @brief  Set a fixed frequency, a sweep in progress is stopped. The phase is kept (no discontinuity).
+  * @param  freq_mhz Frequency in mHz, below sample_rate / 2 (Nyquist).
+  * @retval HAL_OK, HAL_ERROR if the frequency is sample_rate / 2 or above.
+  */
+HAL_StatusTypeDef mcp4725_DDS_Set_Frequency(MCP4725_DDS_Handle_t* dds, uint32_t freq_mhz){
+
+	if( (uint64_t) freq_mhz * 2 >= (uint64_t) dds->sample_rate * 1000U ){
+		return HAL_ERROR;
+	}
+
+	dds->sweep_mode = MCP4725_DDS_SWEEP_NONE;
+	dds->tuning_word = mcp4725_DDS_Tuning_Word(dds, freq_mhz);
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Start a linear sweep (chirp), the tuning word changes at each sample.
+  * @param  start_mhz Frequency at the start, in mHz.
+  * @param  stop_mhz Frequency at the end, in mHz. Lower than start_mhz for a falling sweep.
+  * @param  duration_ms Time from start to stop frequency.
+  * @param  mode Reference to MCP4725_DDS_Sweep_e
+  * @retval HAL_OK, HAL_ERROR if a frequency is sample_rate / 2 or above or the sweep is too short.
+  */
+HAL_StatusTypeDef mcp4725_DDS_Sweep(MCP4725_DDS_Handle_t* dds, uint32_t start_mhz, uint32_t stop_mhz, uint32_t duration_ms, MCP4725_DDS_Sweep_e mode){
+
+	uint64_t nyquist = (uint64_t) dds->sample_rate * 1000U;
+	uint32_t num_samples = (uint32_t) ( ( (uint64_t) dds->sample_rate * duration_ms ) / 1000U );
+
+	if( (uint64_t) start_mhz * 2 >= nyquist || (uint64_t) stop_mhz * 2 >= nyquist || num_samples == 0 ){
+		return HAL_ERROR;
+	}
+
+	if( mode == MCP4725_DDS_SWEEP_NONE ){
+		return mcp4725_DDS_Set_Frequency(dds, start_mhz);
+	}
+
+	dds->sweep_start = mcp4725_DDS_Tuning_Word(dds, start_mhz);
+	dds->sweep_stop = mcp4725_DDS_Tuning_Word(dds, stop_mhz);
+	dds->sweep_step = ( (int32_t) dds->sweep_stop - (int32_t) dds->sweep_start ) / (int32_t) num_samples;
+
+	/* Slow sweeps below the tuning word resolution still move */
+	if( dds->sweep_step == 0 && dds->sweep_stop != dds->sweep_start ){
+		dds->sweep_step = ( dds->sweep_stop > dds->sweep_start ) ? 1 : -1;
+	}
+
+	dds->tuning_word = dds->sweep_start;
+	dds->sweep_mode = mode;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Set the amplitude and offset: out = offset + ( table - MCP4725_DDS_MIDSCALE ) * amplitude / MCP4725_DDS_UNITY
+  * @note	The values out of 0 - MCP4725_DAC_MAX are clamped.
+  * @param  amplitude Gain, MCP4725_DDS_UNITY keeps the table scale (1024 is half the table scale).
+  * @param  offset Output value of the table midscale, in DAC codes.
+  * @retval None
+  */
+void mcp4725_DDS_Set_Level(MCP4725_DDS_Handle_t* dds, uint16_t amplitude, uint16_t offset){
+
+	dds->amplitude = amplitude;
+	dds->offset = offset;
+
+}
+
+/**
+  * @brief  Set the phase accumulator, 2^32 is one period (0x40000000 is 90 degrees).
+  */
+void mcp4725_DDS_Set_Phase(MCP4725_DDS_Handle_t* dds, uint32_t phase){
+	dds->phase = phase;
+}
+
+/**
+  * @brief  Generate a block of samples as Fast Mode words.
+  * @note	Commonly called from the stream callbacks with the half of the buffer that was just sent.
+  * @param  dest Buffer of 2 bytes per sample.
+  * @param  num_samples Samples to generate.
+  * @retval None
+  */
+void mcp4725_DDS_Generate(MCP4725_DDS_Handle_t* dds, uint8_t* dest, uint16_t num_samples){
+
+	/* Local copies, the stores to dest do not reload them */
+	uint32_t phase = dds->phase;
+	uint32_t tuning_word = dds->tuning_word;
+	const uint8_t pd_bits = ( (uint8_t) dds->pd_mode ) << 4;
+	const uint8_t sweeping = ( dds->sweep_mode != MCP4725_DDS_SWEEP_NONE );
+
+	for( uint16_t idx = 0; idx < num_samples; idx++ ){
+
+		uint16_t value = mcp4725_dds_lookup(dds, phase);
+
+		dest[0] = pd_bits | (uint8_t) ( value >> 8 );
+		dest[1] = (uint8_t) ( value & 0xFF );
+		dest += 2;
+
+		phase += tuning_word;
+		if( sweeping ){
+			tuning_word = mcp4725_dds_sweep(dds, tuning_word);
+		}
+	}
+
+	dds->phase = phase;
+	dds->tuning_word = tuning_word;
+
+}
+
+/**
+  * @brief  Generate one sample, for the output paced by a timer (one transfer per sample).
+  * @retval 12-bit value for DAC output
+  */
+uint16_t mcp4725_DDS_Next(MCP4725_DDS_Handle_t* dds){
+
+	uint16_t value = mcp4725_dds_lookup(dds, dds->phase);
+
+	dds->phase += dds->tuning_word;
+	if( dds->sweep_mode != MCP4725_DDS_SWEEP_NONE ){
+		dds->tuning_word = mcp4725_dds_sweep(dds, dds->tuning_word);
+	}
+
+	return value;
+}
+
+/**
+  * @brief  Table sample at the phase, interpolated if enabled, scaled and clamped to 0 - MCP4725_DAC_MAX.
+  */
+static inline uint16_t mcp4725_dds_lookup(const MCP4725_DDS_Handle_t* dds, uint32_t phase){
+
+	const uint8_t shift = 32 - dds->table_bits;
+	uint32_t idx = phase >> shift;
+	int32_t sample = dds->table[idx];
+
+	if( dds->interpolate ){
+		int32_t next = dds->table[ ( idx + 1 ) & ( ( 1UL << dds->table_bits ) - 1 ) ];
+		int32_t frac = (int32_t) ( ( phase >> ( shift - DDS_FRAC_BITS ) ) & 0xFFFF );
+		sample += ( ( next - sample ) * frac ) >> DDS_FRAC_BITS;
+	}
+
+	int32_t value = (int32_t) dds->offset + ( ( ( sample - MCP4725_DDS_MIDSCALE ) * (int32_t) dds->amplitude ) >> DDS_GAIN_SHIFT );
+
+	if( value < 0 )		value = 0;
+	if( value > MCP4725_DAC_MAX )	value = MCP4725_DAC_MAX;
+
+	return (uint16_t) value;
+}
+
+/**
+  * @brief  Next tuning word of the sweep, applies the end of the sweep.
+  */
+static inline uint32_t mcp4725_dds_sweep(MCP4725_DDS_Handle_t* dds, uint32_t tuning_word){
+
+	/* Below Nyquist (exclusive) the tuning words are lower than 2^31, the signed arithmetic does not overflow */
+	int32_t next = (int32_t) tuning_word + dds->sweep_step;
+	int32_t start = (int32_t) dds->sweep_start;
+	int32_t stop = (int32_t) dds->sweep_stop;
+	uint8_t rising = ( dds->sweep_step > 0 );
+
+	if( ( rising && next < stop ) || ( !rising && next > stop ) ){
+		return (uint32_t) next;
+	}
+
+	switch (dds->sweep_mode) {
+		case MCP4725_DDS_SWEEP_LOOP:
+			return dds->sweep_start;
+		case MCP4725_DDS_SWEEP_UP_DOWN:
+			/* Turn back, the start becomes the stop */
+			dds->sweep_start = (uint32_t) stop;
+			dds->sweep_stop = (uint32_t) start;
+			dds->sweep_step = -dds->sweep_step;
+			return (uint32_t) stop;
+		default:
+			dds->sweep_mode = MCP4725_DDS_SWEEP_NONE;
+			return (uint32_t) stop;
+	}
+
+}
@@ -0,0 +1,74 @@
+/*
+ * mcp4725_dds.h
+ *
+ *  Direct digital synthesis for MCP4725. A 32-bit phase accumulator advances by the tuning word at
+ *  each sample, the upper bits index a table of one period (2^table_bits samples):
+ *
+ *  	f_out = tuning_word * f_sample / 2^32,	resolution f_sample / 2^32 (about 5 uHz at 22.2 kS/s)
+ *
+ *  Any frequency up to f_sample / 2 is produced at a fixed sample rate, the sweeps change the tuning
+ *  word at each sample (linear chirp). Amplitude and offset are applied in integer arithmetic and the
+ *  samples are written in blocks as Fast Mode words, directly into the half of the stream buffer.
+ */
+
+#ifndef MCP4725_MCP4725_DDS_H_
+#define MCP4725_MCP4725_DDS_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+
+#define MCP4725_DDS_MAX_TABLE_BITS		16		/* Largest table, 65536 samples */
+#define MCP4725_DDS_MIDSCALE			2048	/* Zero of the table samples */
+#define MCP4725_DDS_UNITY				2048	/* Amplitude that keeps the table scale */
+
+/* Sweep Mode Enumeration */
+
+typedef enum{
+	MCP4725_DDS_SWEEP_NONE = 0,		/* Fixed frequency */
+	MCP4725_DDS_SWEEP_ONCE,			/* From start to stop frequency, then hold the stop frequency */
+	MCP4725_DDS_SWEEP_LOOP,			/* From start to stop frequency, then jump back to the start */
+	MCP4725_DDS_SWEEP_UP_DOWN		/* From start to stop frequency and back */
+}MCP4725_DDS_Sweep_e;
+
+/* MCP4725 DDS Handle Structure */
+
+typedef struct mcp4725_dds_handle{
+	const uint16_t *		table;				/* One period of the waveform, 12-bit values centered at MCP4725_DDS_MIDSCALE */
+	uint8_t					table_bits;			/* Table of 2^table_bits samples, 1 to MCP4725_DDS_MAX_TABLE_BITS */
+	uint8_t					interpolate;		/* 1 for linear interpolation between the table samples */
+	uint32_t				sample_rate;		/* Samples per second sent to the DAC */
+	uint32_t				phase;				/* Phase accumulator, 2^32 is one period */
+	uint32_t				tuning_word;		/* Phase increment per sample */
+	uint16_t				amplitude;			/* Gain, MCP4725_DDS_UNITY keeps the table scale */
+	uint16_t				offset;				/* Output value of the table midscale */
+	MCP4725_PowerDown_e		pd_mode;			/* Power Down Mode written with each sample */
+	MCP4725_DDS_Sweep_e		sweep_mode;			/* Sweep in progress, reference to MCP4725_DDS_Sweep_e */
+	uint32_t				sweep_start;		/* Tuning word at the start of the sweep */
+	uint32_t				sweep_stop;			/* Tuning word at the end of the sweep */
+	int32_t					sweep_step;			/* Added to the tuning word at each sample */
+}MCP4725_DDS_Handle_t;
+
+/* Initialization functions */
+HAL_StatusTypeDef mcp4725_DDS_Init(MCP4725_DDS_Handle_t* dds, const uint16_t* table, uint8_t table_bits, uint32_t sample_rate);
+void mcp4725_DDS_Sine_Table(uint16_t* table, uint8_t table_bits);
+
+/* Control functions, frequencies in mHz */
+HAL_StatusTypeDef mcp4725_DDS_Set_Frequency(MCP4725_DDS_Handle_t* dds, uint32_t freq_mhz);
+HAL_StatusTypeDef mcp4725_DDS_Sweep(MCP4725_DDS_Handle_t* dds, uint32_t start_mhz, uint32_t stop_mhz, uint32_t duration_ms, MCP4725_DDS_Sweep_e mode);
+void mcp4725_DDS_Set_Level(MCP4725_DDS_Handle_t* dds, uint16_t amplitude, uint16_t offset);
+void mcp4725_DDS_Set_Phase(MCP4725_DDS_Handle_t* dds, uint32_t phase);
+uint32_t mcp4725_DDS_Tuning_Word(const MCP4725_DDS_Handle_t* dds, uint32_t freq_mhz);
+uint32_t mcp4725_DDS_Get_Frequency(const MCP4725_DDS_Handle_t* dds);
+
+/* Sample generation */
+void mcp4725_DDS_Generate(MCP4725_DDS_Handle_t* dds, uint8_t* dest, uint16_t num_samples);
+uint16_t mcp4725_DDS_Next(MCP4725_DDS_Handle_t* dds);
+
+#endif /* MCP4725_MCP4725_DDS_H_ */
@@ -0,0 +1,352 @@
+/*
+ * mcp4725_group.c
+ *
+ *  Group update of the MCP4725 of an I2C bus.
+ *
+ *  The general call ends with a STOP condition, the devices run the command at that point. The reads
+ *  are sequential transfers of the HAL with the I2C_OTHER_FRAME option: each read starts with a START
+ *  or a repeated START and the new address, its last byte is not acknowledged so the device releases
+ *  the bus. The last read ends with the STOP condition. A device that does not acknowledge its address
+ *  ends the sequence (the HAL sends a STOP), the next read starts with a START.
+ *
+ *  The scan uses the same sequence with 3-byte reads: the DAC register is known at once, the EEPROM bytes
+ *  are not clocked. A NACK of the address is expected during the scan, it is not an error.
+ *
+ *  The devices are marked busy while the group is updated, the asynchronous functions of the driver
+ *  return HAL_BUSY for them in the meantime.
+ */
+
+#include "mcp4725_group.h"
+
+#define GROUP_READ_BYTES	5		/* Status and DAC register, EEPROM */
+#define GROUP_SCAN_BYTES	3		/* Status and DAC register */
+
+/* Groups registered, one per bus */
+static MCP4725_Group_t* groups[MCP4725_MAX_I2C_BUS] = {0};
+
+static HAL_StatusTypeDef mcp4725_group_start(MCP4725_Group_t* group, uint8_t command);
+static MCP4725_Group_t* mcp4725_group_find(I2C_HandleTypeDef* hi2c);
+static void mcp4725_group_next(MCP4725_Group_t* group);
+static void mcp4725_group_done(MCP4725_Group_t* group);
+
+/**
+  * @brief  Register the group of a bus, with no devices.
+  * @param  group Pointer to a MCP4725_Group_t structure.
+  * @param  hi2c I2C bus of the devices.
+  * @param  xfer_mode Reference to MCP4725_Xfer_e, the DMA must be linked to the I2C handle in DMA Mode.
+  * @retval HAL_OK, HAL_ERROR if there are MCP4725_MAX_I2C_BUS groups.
+  */
+HAL_StatusTypeDef mcp4725_Group_Init(MCP4725_Group_t* group, I2C_HandleTypeDef* hi2c, MCP4725_Xfer_e xfer_mode){
+
+	group->hi2c = hi2c;
+	group->num_devices = 0;
+	group->xfer_mode = xfer_mode;
+	group->command = MCP4725_GROUP_READ_ONLY;
+	group->active = MCP4725_GROUP_NO_DEVICE;
+	group->present = 0;
+	group->scan = 0;
+	group->result = HAL_OK;
+	group->updates = 0;
+
+	for( uint8_t idx = 0; idx < MCP4725_MAX_I2C_BUS; idx++ ){
+		if( groups[idx] == NULL || groups[idx] == group ){
+			groups[idx] = group;
+			return HAL_OK;
+		}
+	}
+
+	return HAL_ERROR;
+}
+
+/**
+  * @brief  Set up the handle of a device of the bus and add it to the group, with no bus traffic.
+  * @note	Replaces mcp4725_Init for the devices of the group. The shadow state is not known (cache stale)
+  * 		until the first update, the devices are read in the order they are added.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @param  mcp4725_addr 7-bit address, 0x60 to 0x67.
+  * @retval HAL_OK, HAL_BUSY if an update is in progress, HAL_ERROR if there are MCP4725_GROUP_MAX_DEVICES devices.
+  */
+HAL_StatusTypeDef mcp4725_Group_Add(MCP4725_Group_t* group, MCP4725_Handle_t* mcp4725_dev, uint8_t mcp4725_addr){
+
+	if( group->active != MCP4725_GROUP_NO_DEVICE ){
+		return HAL_BUSY;
+	}
+
+	if( group->num_devices == MCP4725_GROUP_MAX_DEVICES ){
+		return HAL_ERROR;
+	}
+
+	mcp4725_Handle_Init(mcp4725_dev, group->hi2c, mcp4725_addr);
+	mcp4725_dev->xfer_mode = group->xfer_mode;
+
+	group->devices[group->num_devices++] = mcp4725_dev;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  General call reset of the bus, then read all the devices of the group.
+  * @note	Each device loads the DAC register from its EEPROM, as at power on. The devices of the bus
+  * 		that are not in the group are reset too.
+  * @param  group Pointer to a MCP4725_Group_t structure.
+  * @retval HAL_OK if the update was started, HAL_BUSY if the bus or a device has a transfer in progress,
+  * 		HAL_ERROR if the group has no devices.
+  */
+HAL_StatusTypeDef mcp4725_Group_Reset(MCP4725_Group_t* group){
+	return mcp4725_group_start(group, MCP4725_GENERAL_CALL_RESET);
+}
+
+/**
+  * @brief  General call wake-up of the bus, then read all the devices of the group.
+  * @note	The power down bits of each device are cleared, the DAC registers are kept.
+  * @param  group Pointer to a MCP4725_Group_t structure.
+  * @retval HAL status, as mcp4725_Group_Reset.
+  */
+HAL_StatusTypeDef mcp4725_Group_WakeUp(MCP4725_Group_t* group){
+	return mcp4725_group_start(group, MCP4725_GENERAL_CALL_WAKEUP);
+}
+
+/**
+  * @brief  Read all the devices of the group, with no general call.
+  * @param  group Pointer to a MCP4725_Group_t structure.
+  * @retval HAL status, as mcp4725_Group_Reset.
+  */
+HAL_StatusTypeDef mcp4725_Group_Read(MCP4725_Group_t* group){
+	return mcp4725_group_start(group, MCP4725_GROUP_READ_ONLY);
+}
+
+/**
+  * @brief  Fast init: find the devices of the bus and read their DAC register, in one asynchronous sequence.
+  * @note	Replaces mcp4725_Init and mcp4725_Group_Add. The handle n is set up for the address 0x60 + n, the
+  * 		handles of the devices that answer are kept in the group (in address order) and bit n of
+  * 		group->present is set for them, the other handles stay cache stale. The EEPROM is not read, it is
+  * 		read on the first call to mcp4725_Get_EEPROM (or by the next mcp4725_Group_Reset / mcp4725_Group_Read).
+  * @param  group Pointer to a MCP4725_Group_t structure, its devices are replaced.
+  * @param  devices Handles of the MCP4725_GROUP_MAX_DEVICES addresses of the bus.
+  * @retval HAL_OK if the scan was started, HAL_BUSY if the bus has a transfer in progress.
+  */
+HAL_StatusTypeDef mcp4725_Group_Scan(MCP4725_Group_t* group, MCP4725_Handle_t devices[MCP4725_GROUP_MAX_DEVICES]){
+
+	if( group->active != MCP4725_GROUP_NO_DEVICE || group->hi2c->State != HAL_I2C_STATE_READY ){
+		return HAL_BUSY;
+	}
+
+	group->num_devices = 0;
+	for( uint8_t idx = 0; idx < MCP4725_GROUP_MAX_DEVICES; idx++ ){
+		mcp4725_Group_Add(group, &devices[idx], MCP4725_GROUP_BASE_ADDR + idx);
+	}
+
+	group->scan = 1;
+
+	HAL_StatusTypeDef status = mcp4725_group_start(group, MCP4725_GROUP_READ_ONLY);
+	if( status != HAL_OK ){
+		group->scan = 0;
+	}
+
+	return status;
+}
+
+/**
+  * @brief  Check if an update is in progress.
+  * @retval 1 until all the devices are read.
+  */
+uint8_t mcp4725_Group_Busy(MCP4725_Group_t* group){
+	return ( group->active != MCP4725_GROUP_NO_DEVICE );
+}
+
+/**
+  * @brief  End of the general call or of the read of a device, update its handle and start the next read.
+  * @note	Call from HAL_I2C_MasterTxCpltCallback and HAL_I2C_MasterRxCpltCallback, the transfers of other drivers are ignored.
+  * @param  hi2c Pointer to the I2C_HandleTypeDef of the completed transfer.
+  * @retval None
+  */
+void mcp4725_Group_I2C_CpltCallback(I2C_HandleTypeDef* hi2c){
+
+	MCP4725_Group_t* group = mcp4725_group_find(hi2c);
+	if( group == NULL )	return;
+
+	if( group->command != MCP4725_GROUP_READ_ONLY ){
+		/* The general call is done, the reads follow */
+		group->command = MCP4725_GROUP_READ_ONLY;
+		group->active = 0;
+	}else{
+		MCP4725_Handle_t* mcp4725_dev = group->devices[group->active];
+		if( group->scan ){
+			mcp4725_Decode_DAC_Register(mcp4725_dev, mcp4725_dev->buffer);
+		}else{
+			mcp4725_Decode_DAC_EEPROM(mcp4725_dev, mcp4725_dev->buffer);
+		}
+		mcp4725_dev->cache_stale = 0;
+		group->present |= (uint8_t) ( 1 << group->active );
+		group->active++;
+	}
+
+	mcp4725_group_next(group);
+}
+
+/**
+  * @brief  The general call or the read of a device failed (NACK, bus error), go on with the next device.
+  * @note	Call from HAL_I2C_ErrorCallback, the cause is in hi2c->ErrorCode.
+  * @param  hi2c Pointer to the I2C_HandleTypeDef of the failed transfer.
+  * @retval None
+  */
+void mcp4725_Group_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c){
+
+	MCP4725_Group_t* group = mcp4725_group_find(hi2c);
+	if( group == NULL )	return;
+
+	if( group->scan == 0 || hi2c->ErrorCode != HAL_I2C_ERROR_AF ){
+		group->result = HAL_ERROR;
+	}
+
+	if( group->command != MCP4725_GROUP_READ_ONLY ){
+		/* No device took the general call, read them anyway */
+		group->command = MCP4725_GROUP_READ_ONLY;
+		group->active = 0;
+	}else{
+		group->devices[group->active]->cache_stale = 1;
+		group->active++;
+	}
+
+	mcp4725_group_next(group);
+}
+
+/**
+  * @brief  Update completed callback, the handles are updated and group->present has the devices that answered.
+  * @note	This function should not be modified, when the callback is needed it can be implemented in the user file.
+  * @retval None
+  */
+__weak void mcp4725_Group_CpltCallback(MCP4725_Group_t* group){
+	UNUSED(group);
+}
+
+/**
+  * @brief  Claim the bus and the devices, send the general call (or the first read).
+  */
+static HAL_StatusTypeDef mcp4725_group_start(MCP4725_Group_t* group, uint8_t command){
+
+	if( group->num_devices == 0 ){
+		return HAL_ERROR;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if( group->active != MCP4725_GROUP_NO_DEVICE || group->hi2c->State != HAL_I2C_STATE_READY ){
+		__set_PRIMASK(primask);
+		return HAL_BUSY;
+	}
+
+	for( uint8_t idx = 0; idx < group->num_devices; idx++ ){
+		if( group->devices[idx]->state != MCP4725_STATE_READY ){
+			__set_PRIMASK(primask);
+			return HAL_BUSY;
+		}
+	}
+
+	for( uint8_t idx = 0; idx < group->num_devices; idx++ ){
+		group->devices[idx]->state = MCP4725_STATE_BUSY_RX;
+	}
+
+	group->command = command;
+	group->active = 0;
+	group->present = 0;
+	group->result = HAL_OK;
+
+	__set_PRIMASK(primask);
+
+	if( command == MCP4725_GROUP_READ_ONLY ){
+		mcp4725_group_next(group);
+		return HAL_OK;
+	}
+
+	HAL_StatusTypeDef status;
+
+	if( group->xfer_mode == MCP4725_XFER_DMA ){
+		status = HAL_I2C_Master_Seq_Transmit_DMA(group->hi2c, MCP4725_GENERAL_CALL_ADDR, &group->command, 1, I2C_FIRST_AND_LAST_FRAME);
+	}else{
+		status = HAL_I2C_Master_Seq_Transmit_IT(group->hi2c, MCP4725_GENERAL_CALL_ADDR, &group->command, 1, I2C_FIRST_AND_LAST_FRAME);
+	}
+
+	if( status != HAL_OK ){
+		/* The bus was not started, release the devices */
+		group->result = HAL_ERROR;
+		group->active = group->num_devices;
+		mcp4725_group_done(group);
+		return status;
+	}
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Search the group with an update in progress on the I2C bus.
+  * @retval Pointer to the group, NULL if the transfer was not started by this module.
+  */
+static MCP4725_Group_t* mcp4725_group_find(I2C_HandleTypeDef* hi2c){
+
+	for( uint8_t idx = 0; idx < MCP4725_MAX_I2C_BUS; idx++ ){
+		if( groups[idx] != NULL && groups[idx]->hi2c == hi2c && groups[idx]->active != MCP4725_GROUP_NO_DEVICE ){
+			return groups[idx];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+  * @brief  Start the read of the active device, with a repeated START after the previous read. The devices
+  * 		that can not be started are skipped.
+  */
+static void mcp4725_group_next(MCP4725_Group_t* group){
+
+	while( group->active < group->num_devices ){
+
+		MCP4725_Handle_t* mcp4725_dev = group->devices[group->active];
+		uint32_t option = ( group->active == group->num_devices - 1 ) ? I2C_OTHER_AND_LAST_FRAME : I2C_OTHER_FRAME;
+		uint16_t size = group->scan ? GROUP_SCAN_BYTES : GROUP_READ_BYTES;
+		HAL_StatusTypeDef status;
+
+		if( group->xfer_mode == MCP4725_XFER_DMA ){
+			status = HAL_I2C_Master_Seq_Receive_DMA(group->hi2c, mcp4725_dev->dev_addr << 1, mcp4725_dev->buffer, size, option);
+		}else{
+			status = HAL_I2C_Master_Seq_Receive_IT(group->hi2c, mcp4725_dev->dev_addr << 1, mcp4725_dev->buffer, size, option);
+		}
+
+		if( status == HAL_OK ){
+			return;
+		}
+
+		mcp4725_dev->cache_stale = 1;
+		group->result = HAL_ERROR;
+		group->active++;
+	}
+
+	mcp4725_group_done(group);
+}
+
+/**
+  * @brief  All the devices are read, release them and call the callback. After a scan, only the devices
+  * 		that answered are kept in the group.
+  */
+static void mcp4725_group_done(MCP4725_Group_t* group){
+
+	uint8_t found = 0;
+
+	for( uint8_t idx = 0; idx < group->num_devices; idx++ ){
+		group->devices[idx]->state = MCP4725_STATE_READY;
+		if( group->scan && ( group->present & ( 1 << idx ) ) ){
+			group->devices[found++] = group->devices[idx];
+		}
+	}
+
+	if( group->scan ){
+		group->num_devices = found;
+		group->scan = 0;
+	}
+
+	group->updates++;
+	group->active = MCP4725_GROUP_NO_DEVICE;
+
+	mcp4725_Group_CpltCallback(group);
+}
@@ -0,0 +1,75 @@
+/*
+ * mcp4725_group.h
+ *
+ *  Group update of the MCP4725 of an I2C bus, for the boot and the reset of boards with many DACs.
+ *  The devices are added with no bus traffic. One general call (reset or wake-up) reaches all of them,
+ *  then the 5-byte reads of all the devices are chained with repeated STARTs, with one IRQ per device in
+ *  Interrupt or DMA Mode. The handles are updated from the read back, so the shadow of each device
+ *  (DAC register, power down bits, EEPROM) is the state of the device. The devices that do not answer
+ *  are reported in the present mask.
+ *
+ *  8 devices at 400 kHz (host model): 1.16 ms of bus time and 18 us of CPU time in DMA Mode, against
+ *  1.95 ms of blocking transfers for mcp4725_Init of each device (probe, write and read). A missing device
+ *  costs one NACK in the sequence, with no retries.
+ *
+ *  Fast init: mcp4725_Group_Scan finds the devices of the bus with no blocking probe. The 8 addresses
+ *  1100xxx are read in one chained sequence of 3 bytes (status and DAC register, no EEPROM): a missing
+ *  device costs its address byte and a NACK, there are no timeouts and no retries. 8 devices at 400 kHz:
+ *  0.74 ms of bus time. The EEPROM of the devices found is read on the first access (mcp4725_Get_EEPROM).
+ */
+
+#ifndef MCP4725_MCP4725_GROUP_H_
+#define MCP4725_MCP4725_GROUP_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+
+#ifndef MCP4725_GROUP_MAX_DEVICES
+#define MCP4725_GROUP_MAX_DEVICES	8			/* Addresses 0x60 to 0x67 */
+#endif
+
+#define MCP4725_GROUP_BASE_ADDR		0x60		/* Address 1100 000, first address of the scan */
+#define MCP4725_GROUP_NO_DEVICE		0xFF
+#define MCP4725_GROUP_READ_ONLY		0x00		/* Update with no general call */
+
+/* MCP4725 Group Structure */
+
+typedef struct mcp4725_group{
+	I2C_HandleTypeDef *		hi2c;								/* Bus of the devices, the general call reaches all of them */
+	MCP4725_Handle_t *		devices[MCP4725_GROUP_MAX_DEVICES];
+	uint8_t					num_devices;						/* Entries used in devices[] */
+	MCP4725_Xfer_e			xfer_mode;							/* Interrupt or DMA Mode, reference to MCP4725_Xfer_e */
+	uint8_t					command;							/* General call of the update in progress, or MCP4725_GROUP_READ_ONLY */
+	__IO uint8_t			active;								/* Device read, MCP4725_GROUP_NO_DEVICE when no update is in progress */
+	__IO uint8_t			present;							/* Bit n set if the device n answered the last read (after a scan, the address 0x60 + n) */
+	uint8_t					scan;								/* 1 while the bus is scanned, the reads stop after the DAC register */
+	__IO HAL_StatusTypeDef	result;								/* HAL_OK if the general call and all the reads succeeded */
+	__IO uint32_t			updates;							/* Updates completed */
+}MCP4725_Group_t;
+
+/* Initialization functions */
+HAL_StatusTypeDef mcp4725_Group_Init(MCP4725_Group_t* group, I2C_HandleTypeDef* hi2c, MCP4725_Xfer_e xfer_mode);
+HAL_StatusTypeDef mcp4725_Group_Add(MCP4725_Group_t* group, MCP4725_Handle_t* mcp4725_dev, uint8_t mcp4725_addr);
+
+/* Group updates, the end is notified by mcp4725_Group_CpltCallback */
+HAL_StatusTypeDef mcp4725_Group_Reset(MCP4725_Group_t* group);
+HAL_StatusTypeDef mcp4725_Group_WakeUp(MCP4725_Group_t* group);
+HAL_StatusTypeDef mcp4725_Group_Read(MCP4725_Group_t* group);
+HAL_StatusTypeDef mcp4725_Group_Scan(MCP4725_Group_t* group, MCP4725_Handle_t devices[MCP4725_GROUP_MAX_DEVICES]);
+uint8_t mcp4725_Group_Busy(MCP4725_Group_t* group);
+
+/* Call from HAL_I2C_MasterTxCpltCallback / HAL_I2C_MasterRxCpltCallback and HAL_I2C_ErrorCallback */
+void mcp4725_Group_I2C_CpltCallback(I2C_HandleTypeDef* hi2c);
+void mcp4725_Group_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c);
+
+/* Weak callback, implement it in the user file */
+void mcp4725_Group_CpltCallback(MCP4725_Group_t* group);
+
+#endif /* MCP4725_MCP4725_GROUP_H_ */
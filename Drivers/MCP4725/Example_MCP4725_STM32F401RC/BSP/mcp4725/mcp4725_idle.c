@@ -0,0 +1,245 @@
+/*
+ * mcp4725_idle.c
+ *
+ *  Idle manager for MCP4725.
+ *
+ *  The managed devices are registered, a general call wake-up reaches every device of the bus, so all
+ *  the managers of the same bus are marked awake. The general call only clears the PD bits, the DAC
+ *  register keeps the value of before the power down. The writes and the power down are blocking, call
+ *  mcp4725_Idle_Poll from the main loop.
+ */
+
+#include "mcp4725_idle.h"
+
+#define IDLE_US_PER_S			1000000U
+
+static MCP4725_Idle_t* idle_registry[MCP4725_IDLE_MAX_DEVICES] = {0};
+
+static void mcp4725_idle_awake(MCP4725_Idle_t* idle, uint32_t now, uint32_t start);
+static uint32_t mcp4725_idle_period(const MCP4725_Idle_t* idle, uint8_t asleep);
+
+/**
+  * @brief  Initialize the manager of a device and start the DWT cycle counter.
+  * @param  idle Pointer to a MCP4725_Idle_t structure.
+  * @param  mcp4725_dev Device initialized by mcp4725_Init.
+  * @param  pd_mode Power down mode of the idle output, MCP4725_PD_1K_TO_GND to MCP4725_PD_500K_TO_GND.
+  * @param  timeout_ms Quiet period before the power down.
+  * @retval HAL_OK, HAL_ERROR if the parameters are not valid or MCP4725_IDLE_MAX_DEVICES are managed.
+  */
+HAL_StatusTypeDef mcp4725_Idle_Init(MCP4725_Idle_t* idle, MCP4725_Handle_t* mcp4725_dev, MCP4725_PowerDown_e pd_mode, uint32_t timeout_ms){
+
+	uint8_t slot = MCP4725_IDLE_MAX_DEVICES;
+
+	if( mcp4725_dev == NULL || pd_mode == MCP4725_NORMAL_MODE || pd_mode >= MCP4725_PD_LEN ){
+		return HAL_ERROR;
+	}
+
+	for( uint8_t idx = 0; idx < MCP4725_IDLE_MAX_DEVICES; idx++ ){
+		if( idle_registry[idx] == idle ){
+			slot = idx;
+			break;
+		}
+		if( idle_registry[idx] == NULL && slot == MCP4725_IDLE_MAX_DEVICES ){
+			slot = idx;
+		}
+	}
+
+	if( slot == MCP4725_IDLE_MAX_DEVICES ){
+		return HAL_ERROR;
+	}
+
+	idle->device = mcp4725_dev;
+	idle->pd_mode = pd_mode;
+	idle->timeout_ms = timeout_ms;
+	idle->asleep = ( mcp4725_dev->powerdown_mode != MCP4725_NORMAL_MODE ) ? 1 : 0;
+	idle->last_activity = HAL_GetTick();
+
+	mcp4725_Idle_Reset_Stats(idle);
+
+	idle_registry[slot] = idle;
+
+	/* Enable the DWT cycle counter, it times the wakes */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	#if (__CORTEX_M == 7U)
+		DWT->LAR = 0xC5ACCE55;
+	#endif
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Write the DAC register in normal mode. When the output is in power down the same Fast Mode
+  * 		write wakes it, with no extra transaction.
+  * @param  idle Pointer to a MCP4725_Idle_t structure.
+  * @param  dac_data 12-bit value.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef mcp4725_Idle_Write(MCP4725_Idle_t* idle, uint16_t dac_data){
+
+	uint32_t start = DWT->CYCCNT;
+
+	idle->last_activity = HAL_GetTick();
+
+	if( mcp4725_Write_PowerDown_DAC_Register(idle->device, dac_data, MCP4725_NORMAL_MODE) != HAL_OK ){
+		if( idle->asleep ){
+			idle->errors++;
+		}
+		return HAL_ERROR;
+	}
+
+	if( idle->asleep ){
+		mcp4725_idle_awake(idle, HAL_GetTick(), start);
+	}
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Wake all the DACs of the bus with a general call wake-up, they come back at their previous values.
+  * @note	Call ahead of the writes, when the activity is known in advance. The devices of the bus that are not
+  * 		managed are also woken, their handles keep the PD bits of before.
+  * @param  idle Pointer to a MCP4725_Idle_t structure.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef mcp4725_Idle_Wake(MCP4725_Idle_t* idle){
+
+	uint32_t start = DWT->CYCCNT;
+
+	if( mcp4725_GeneralCall_WakeUp(idle->device) != HAL_OK ){
+		idle->errors++;
+		return HAL_ERROR;
+	}
+
+	uint32_t now = HAL_GetTick();
+	idle->general_calls++;
+
+	for( uint8_t idx = 0; idx < MCP4725_IDLE_MAX_DEVICES; idx++ ){
+
+		MCP4725_Idle_t* managed = idle_registry[idx];
+
+		if( managed == NULL || managed->device->i2c_handle != idle->device->i2c_handle ){
+			continue;
+		}
+
+		managed->device->powerdown_mode = MCP4725_NORMAL_MODE;
+		managed->device->cache_stale = 1;
+		managed->last_activity = now;
+
+		if( managed->asleep ){
+			mcp4725_idle_awake(managed, now, start);
+		}
+	}
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Restart the quiet period with no write, for the writes done by other layers (stream, bus manager).
+  * @note	Can be called from an IRQ.
+  */
+void mcp4725_Idle_Touch(MCP4725_Idle_t* idle){
+	idle->last_activity = HAL_GetTick();
+}
+
+/**
+  * @brief  Put the output in power down after the quiet period.
+  * @note	Call from the main loop. The power down keeps the DAC register, a transfer in progress delays it.
+  * @param  idle Pointer to a MCP4725_Idle_t structure.
+  * @retval HAL_OK, HAL_ERROR if the power down command failed.
+  */
+HAL_StatusTypeDef mcp4725_Idle_Poll(MCP4725_Idle_t* idle){
+
+	uint32_t now = HAL_GetTick();
+
+	if( idle->asleep || ( now - idle->last_activity ) < idle->timeout_ms || idle->device->state != MCP4725_STATE_READY ){
+		return HAL_OK;
+	}
+
+	if( mcp4725_Write_PowerDown(idle->device, idle->pd_mode) != HAL_OK ){
+		idle->errors++;
+		return HAL_ERROR;
+	}
+
+	idle->awake_ms += now - idle->state_tick;
+	idle->state_tick = now;
+	idle->asleep = 1;
+	idle->sleeps++;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Time in power down since the reset of the statistics, current period included.
+  * @retval Per mille
+  */
+uint32_t mcp4725_Idle_Asleep_Permille(const MCP4725_Idle_t* idle){
+
+	uint64_t asleep = mcp4725_idle_period(idle, 1);
+	uint64_t total = asleep + mcp4725_idle_period(idle, 0);
+
+	if( total == 0 ){
+		return 0;
+	}
+
+	return (uint32_t) ( ( asleep * 1000U ) / total );
+}
+
+/**
+  * @brief  Energy saved by the power down since the reset of the statistics, from the typical supply currents.
+  * @retval uJ
+  */
+uint32_t mcp4725_Idle_Energy_Saved_uJ(const MCP4725_Idle_t* idle){
+
+	/* ms x nA x mV = 1e-15 J */
+	uint64_t energy = (uint64_t) mcp4725_idle_period(idle, 1) * ( MCP4725_IDLE_ACTIVE_NA - MCP4725_IDLE_PD_NA ) * MCP4725_IDLE_SUPPLY_MV;
+
+	return (uint32_t) ( energy / 1000000000ULL );
+}
+
+/**
+  * @brief  Clear the statistics, the current period starts now.
+  */
+void mcp4725_Idle_Reset_Stats(MCP4725_Idle_t* idle){
+
+	idle->state_tick = HAL_GetTick();
+	idle->sleeps = 0;
+	idle->wakes = 0;
+	idle->general_calls = 0;
+	idle->errors = 0;
+	idle->asleep_ms = 0;
+	idle->awake_ms = 0;
+	idle->last_wake_us = 0;
+	idle->max_wake_us = 0;
+
+}
+
+/**
+  * @brief  End of a power down period, the wake latency is timed from start.
+  */
+static void mcp4725_idle_awake(MCP4725_Idle_t* idle, uint32_t now, uint32_t start){
+
+	idle->last_wake_us = ( DWT->CYCCNT - start ) / ( SystemCoreClock / IDLE_US_PER_S );
+	if( idle->last_wake_us > idle->max_wake_us ){
+		idle->max_wake_us = idle->last_wake_us;
+	}
+
+	idle->asleep_ms += now - idle->state_tick;
+	idle->state_tick = now;
+	idle->asleep = 0;
+	idle->wakes++;
+}
+
+/**
+  * @brief  Time asleep (1) or awake (0), with the current period.
+  */
+static uint32_t mcp4725_idle_period(const MCP4725_Idle_t* idle, uint8_t asleep){
+
+	uint32_t period = ( asleep ) ? idle->asleep_ms : idle->awake_ms;
+
+	if( idle->asleep == asleep ){
+		period += HAL_GetTick() - idle->state_tick;
+	}
+
+	return period;
+}
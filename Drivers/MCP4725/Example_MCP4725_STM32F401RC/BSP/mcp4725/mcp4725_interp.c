@@ -0,0 +1,235 @@
+/*
+ * mcp4725_interp.c
+ *
+ *  Interpolation stage for MCP4725, polyphase FIR upsampler in q15.
+ *
+ *  The taps are a Blackman windowed sinc, cut at the Nyquist frequency of the input. Each phase is
+ *  normalized to a gain of 1, so a constant input gives a constant output with no ripple. The portable
+ *  kernel is the loop of arm_fir_interpolate_q15: same taps order, 64-bit sums and q15 saturation, so
+ *  both give the same samples. The float math is only used to design the taps.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "mcp4725_interp.h"
+
+#define INTERP_Q15_ONE			32768
+#define INTERP_Q15_SHIFT		4		/* 12-bit value to q15 */
+
+#ifndef MCP4725_USE_CMSIS_DSP
+static void mcp4725_interp_fir(MCP4725_Interp_t* interp, const int16_t* src, int16_t* dst, uint16_t num_samples);
+#endif
+
+/**
+  * @brief  Design the taps of the upsampler.
+  * @param  coeffs Buffer of MCP4725_INTERP_TAPS(factor, phase_len) taps.
+  * @param  factor Upsampling factor, 2 to MCP4725_INTERP_MAX_FACTOR.
+  * @param  phase_len Taps per phase, 2 to MCP4725_INTERP_MAX_PHASE_LEN. 4 to 8 for the DAC output.
+  * @retval HAL_OK, HAL_ERROR if the parameters are not valid.
+  */
+HAL_StatusTypeDef mcp4725_Interp_Design(int16_t* coeffs, uint8_t factor, uint16_t phase_len){
+
+	if( coeffs == NULL || factor < 2 || factor > MCP4725_INTERP_MAX_FACTOR || phase_len < 2 || phase_len > MCP4725_INTERP_MAX_PHASE_LEN ){
+		return HAL_ERROR;
+	}
+
+	const uint16_t taps = MCP4725_INTERP_TAPS(factor, phase_len);
+	const float pi = 3.14159265f;
+	const float center = (float) ( taps - 1 ) / 2.0f;
+	float gain[MCP4725_INTERP_MAX_FACTOR] = {0};
+	float tap[MCP4725_INTERP_TAPS(MCP4725_INTERP_MAX_FACTOR, MCP4725_INTERP_MAX_PHASE_LEN)];
+
+	for( uint16_t idx = 0; idx < taps; idx++ ){
+
+		float x = ( (float) idx - center ) / (float) factor;
+		float sinc = ( fabsf(x) < 1e-6f ) ? 1.0f : sinf(pi * x) / ( pi * x );
+		float window = 0.42f - 0.5f * cosf(2.0f * pi * (float) idx / (float) ( taps - 1 ))
+							+ 0.08f * cosf(4.0f * pi * (float) idx / (float) ( taps - 1 ));
+
+		tap[idx] = sinc * window;
+		gain[idx % factor] += tap[idx];
+	}
+
+	/* Unity gain for each phase, the rounding error goes to the largest tap of the phase */
+	for( uint8_t phase = 0; phase < factor; phase++ ){
+
+		int32_t sum = 0;
+		uint16_t largest = phase;
+
+		for( uint16_t idx = phase; idx < taps; idx += factor ){
+			int32_t value = lrintf( tap[idx] * (float) INTERP_Q15_ONE / gain[phase] );
+			coeffs[idx] = (int16_t) ( ( value > 32767 ) ? 32767 : ( ( value < -32768 ) ? -32768 : value ) );
+			sum += coeffs[idx];
+			if( coeffs[idx] > coeffs[largest] ){
+				largest = idx;
+			}
+		}
+
+		int32_t value = coeffs[largest] + ( INTERP_Q15_ONE - sum );
+		coeffs[largest] = (int16_t) ( ( value > 32767 ) ? 32767 : value );
+	}
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Initialize the upsampler, the filter starts at midscale.
+  * @param  interp Pointer to a MCP4725_Interp_t structure.
+  * @param  coeffs MCP4725_INTERP_TAPS(factor, phase_len) taps, from mcp4725_Interp_Design or a symmetric filter of the user.
+  * @param  factor Upsampling factor, 2 to MCP4725_INTERP_MAX_FACTOR.
+  * @param  phase_len Taps per phase, 2 to MCP4725_INTERP_MAX_PHASE_LEN.
+  * @param  state Buffer of MCP4725_INTERP_STATE_LEN(phase_len, max_block) samples.
+  * @param  work Buffer of MCP4725_INTERP_WORK_LEN(factor, max_block) samples.
+  * @param  max_block Largest input block of mcp4725_Interp_Block.
+  * @retval HAL_OK, HAL_ERROR if the parameters are not valid.
+  */
+HAL_StatusTypeDef mcp4725_Interp_Init(MCP4725_Interp_t* interp, const int16_t* coeffs, uint8_t factor, uint16_t phase_len, int16_t* state, int16_t* work, uint16_t max_block){
+
+	if( coeffs == NULL || state == NULL || work == NULL || max_block == 0 ||
+		factor < 2 || factor > MCP4725_INTERP_MAX_FACTOR || phase_len < 2 || phase_len > MCP4725_INTERP_MAX_PHASE_LEN ){
+		return HAL_ERROR;
+	}
+
+	interp->coeffs = coeffs;
+	interp->state = state;
+	interp->work = work;
+	interp->factor = factor;
+	interp->phase_len = phase_len;
+	interp->max_block = max_block;
+	interp->pd_mode = MCP4725_NORMAL_MODE;
+
+#ifdef MCP4725_USE_CMSIS_DSP
+	/* The taps are symmetric, the time reversed order of CMSIS-DSP is the same */
+	if( arm_fir_interpolate_init_q15(&interp->fir, factor, MCP4725_INTERP_TAPS(factor, phase_len), (q15_t*) coeffs, state, max_block) != ARM_MATH_SUCCESS ){
+		return HAL_ERROR;
+	}
+#endif
+
+#if defined(DWT)
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	#if (__CORTEX_M == 7U)
+		DWT->LAR = 0xC5ACCE55;
+	#endif
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+	mcp4725_Interp_Reset(interp);
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Clear the filter history (output at midscale) and the profile.
+  */
+void mcp4725_Interp_Reset(MCP4725_Interp_t* interp){
+
+	memset(interp->state, 0, MCP4725_INTERP_STATE_LEN(interp->phase_len, interp->max_block) * sizeof(int16_t));
+	interp->samples = 0;
+	interp->cycles = 0;
+
+}
+
+/**
+  * @brief  Upsample a block of 12-bit values and write the output in Fast Mode words.
+  * @note	Call from mcp4725_Stream_HalfCpltCallback / mcp4725_Stream_CpltCallback with num_samples / factor
+  * 		input samples. The output is delayed by (factor * phase_len - 1) / 2 output samples.
+  * @param  interp Pointer to a MCP4725_Interp_t structure.
+  * @param  dest Buffer of MCP4725_WAVE_BYTES(num_samples * factor) bytes.
+  * @param  samples 12-bit input values.
+  * @param  num_samples Input samples, up to max_block.
+  * @retval Output samples written in dest, 0 if num_samples is larger than max_block.
+  */
+uint16_t mcp4725_Interp_Block(MCP4725_Interp_t* interp, uint8_t* dest, const uint16_t* samples, uint16_t num_samples){
+
+	if( num_samples > interp->max_block ){
+		return 0;
+	}
+
+#if defined(DWT)
+	uint32_t start = DWT->CYCCNT;
+#endif
+
+	int16_t* src = interp->work;
+	int16_t* dst = &interp->work[interp->max_block];
+	uint8_t pd_bits = (uint8_t) ( ( interp->pd_mode & 0x3 ) << 4 );
+	uint32_t num_out = (uint32_t) num_samples * interp->factor;
+
+	for( uint16_t idx = 0; idx < num_samples; idx++ ){
+		int32_t value = ( samples[idx] > 4095 ) ? 4095 : samples[idx];
+		src[idx] = (int16_t) ( ( value - MCP4725_INTERP_MIDSCALE ) << INTERP_Q15_SHIFT );
+	}
+
+#ifdef MCP4725_USE_CMSIS_DSP
+	arm_fir_interpolate_q15(&interp->fir, src, dst, num_samples);
+#else
+	mcp4725_interp_fir(interp, src, dst, num_samples);
+#endif
+
+	/* Back to 12 bits, rounded, the overshoot of the steps is clamped */
+	for( uint32_t idx = 0; idx < num_out; idx++ ){
+
+		int32_t value = ( ( (int32_t) dst[idx] + ( 1 << ( INTERP_Q15_SHIFT - 1 ) ) ) >> INTERP_Q15_SHIFT ) + MCP4725_INTERP_MIDSCALE;
+		if( value > 4095 )	value = 4095;
+
+		dest[2 * idx] = pd_bits | (uint8_t) ( ( value >> 8 ) & 0x0F );
+		dest[2 * idx + 1] = (uint8_t) value;
+	}
+
+	interp->samples += num_out;
+
+#if defined(DWT)
+	interp->cycles += DWT->CYCCNT - start;
+#endif
+
+	return (uint16_t) num_out;
+}
+
+/**
+  * @brief  Mean time per output sample, conversions and Fast Mode word included. 0 when the DWT is not available.
+  * @retval Cycles per output sample x 100.
+  */
+uint32_t mcp4725_Interp_Cycles_x100(const MCP4725_Interp_t* interp){
+
+	if( interp->samples == 0 ){
+		return 0;
+	}
+
+	return (uint32_t) ( ( (uint64_t) interp->cycles * 100U ) / interp->samples );
+}
+
+#ifndef MCP4725_USE_CMSIS_DSP
+/**
+  * @brief  Polyphase kernel, as arm_fir_interpolate_q15.
+  * @note	state holds the last phase_len - 1 inputs followed by the block, output j of an input uses the
+  * 		taps factor - 1 - j, 2 * factor - 1 - j, ...
+  */
+static void mcp4725_interp_fir(MCP4725_Interp_t* interp, const int16_t* src, int16_t* dst, uint16_t num_samples){
+
+	const uint16_t phase_len = interp->phase_len;
+	const uint8_t factor = interp->factor;
+	int16_t* state = interp->state;
+
+	memcpy(&state[phase_len - 1], src, num_samples * sizeof(int16_t));
+
+	for( uint16_t idx = 0; idx < num_samples; idx++ ){
+
+		const int16_t* window = &state[idx];
+
+		for( uint8_t phase = 1; phase <= factor; phase++ ){
+
+			const int16_t* coeff = &interp->coeffs[factor - phase];
+			int64_t sum = 0;
+
+			for( uint16_t tap = 0; tap < phase_len; tap++ ){
+				sum += (int32_t) window[tap] * coeff[tap * factor];
+			}
+
+			sum >>= 15;
+			*dst++ = (int16_t) ( ( sum > 32767 ) ? 32767 : ( ( sum < -32768 ) ? -32768 : sum ) );
+		}
+	}
+
+	/* Keep the last phase_len - 1 inputs for the next block */
+	memmove(state, &state[num_samples], ( phase_len - 1 ) * sizeof(int16_t));
+}
+#endif
@@ -0,0 +1,66 @@
+/*
+ * mcp4725_interp.h
+ *
+ *  Interpolation stage for MCP4725. The samples of a table or of the DDS are upsampled by a factor of
+ *  2 to 8 with a polyphase FIR filter (low-pass at the Nyquist frequency of the input) before the
+ *  stream, so the DAC output steps are factor times smaller and the images of the input rate are
+ *  filtered. The filter has factor * phase_len taps, each output sample costs phase_len multiplies.
+ *
+ *  The samples are processed in blocks in q15: 12-bit value - MCP4725_INTERP_MIDSCALE, shifted by 4.
+ *  Define MCP4725_USE_CMSIS_DSP in the project symbols (with arm_math.h and the CMSIS-DSP library)
+ *  to run the filter with arm_fir_interpolate_q15, without it the same kernel is in portable C.
+ */
+
+#ifndef MCP4725_MCP4725_INTERP_H_
+#define MCP4725_MCP4725_INTERP_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+
+#ifdef MCP4725_USE_CMSIS_DSP
+	#include "arm_math.h"
+#endif
+
+#define MCP4725_INTERP_MAX_FACTOR		8		/* Largest upsampling factor */
+#define MCP4725_INTERP_MAX_PHASE_LEN	32		/* Largest taps per phase */
+#define MCP4725_INTERP_MIDSCALE			2048	/* 12-bit value of q15 zero */
+
+/* Buffers of the caller, in int16_t */
+#define MCP4725_INTERP_TAPS(factor, phase_len)			( (factor) * (phase_len) )
+#define MCP4725_INTERP_STATE_LEN(phase_len, max_block)	( (phase_len) + (max_block) - 1 )
+#define MCP4725_INTERP_WORK_LEN(factor, max_block)		( (max_block) * ( (factor) + 1 ) )
+
+/* MCP4725 Interpolation Handle Structure */
+
+typedef struct mcp4725_interp{
+#ifdef MCP4725_USE_CMSIS_DSP
+	arm_fir_interpolate_instance_q15 fir;		/* CMSIS-DSP instance */
+#endif
+	const int16_t *			coeffs;				/* factor * phase_len taps in q15, symmetric (linear phase) */
+	int16_t *				state;				/* MCP4725_INTERP_STATE_LEN samples */
+	int16_t *				work;				/* MCP4725_INTERP_WORK_LEN samples, input and output block in q15 */
+	uint8_t					factor;				/* Output samples per input sample */
+	uint16_t				phase_len;			/* Taps per phase */
+	uint16_t				max_block;			/* Largest input block */
+	MCP4725_PowerDown_e		pd_mode;			/* Power Down Mode written with each sample */
+	uint32_t				samples;			/* Output samples, for the profile */
+	uint32_t				cycles;				/* DWT cycles of the blocks, for the profile */
+}MCP4725_Interp_t;
+
+/* Initialization functions */
+HAL_StatusTypeDef mcp4725_Interp_Design(int16_t* coeffs, uint8_t factor, uint16_t phase_len);
+HAL_StatusTypeDef mcp4725_Interp_Init(MCP4725_Interp_t* interp, const int16_t* coeffs, uint8_t factor, uint16_t phase_len, int16_t* state, int16_t* work, uint16_t max_block);
+void mcp4725_Interp_Reset(MCP4725_Interp_t* interp);
+
+/* Block processing */
+uint16_t mcp4725_Interp_Block(MCP4725_Interp_t* interp, uint8_t* dest, const uint16_t* samples, uint16_t num_samples);
+uint32_t mcp4725_Interp_Cycles_x100(const MCP4725_Interp_t* interp);
+
+#endif /* MCP4725_MCP4725_INTERP_H_ */
@@ -0,0 +1,231 @@
+/*
+ * mcp4725_jitter.c
+ *
+ *  Jitter of the sample instants of MCP4725.
+ *
+ *  Each stamp gives the period from the previous one, the error is period - nominal. The peak to peak
+ *  jitter is max_error - min_error, the RMS jitter the square root of the mean squared error. A
+ *  constant offset (timer rounding) moves the mean period, not the jitter.
+ */
+
+#include "mcp4725_jitter.h"
+#include <math.h>
+
+#define JITTER_NS_PER_S			1000000000ULL
+#define JITTER_GAP_SCL			2		/* Idle SCL periods that mark the start of a sample */
+
+static uint32_t mcp4725_jitter_ns(const MCP4725_Jitter_t* jitter, uint64_t counts);
+
+/**
+  * @brief  Initialize the measure for a counter and a sample rate.
+  * @param  jitter Pointer to a MCP4725_Jitter_t structure.
+  * @param  clock Frequency of the counter in Hz, the timer clock after the prescaler for the input capture.
+  * @param  counter_mask Range of the counter, 0xFFFFFFFF for 32-bit timers and the DWT, 0xFFFF for 16-bit timers.
+  * @param  sample_rate Nominal samples per second.
+  * @retval HAL_OK, HAL_ERROR if the parameters are not valid or the period does not fit in the counter.
+  */
+HAL_StatusTypeDef mcp4725_Jitter_Init(MCP4725_Jitter_t* jitter, uint32_t clock, uint32_t counter_mask, uint32_t sample_rate){
+
+	if( clock == 0 || sample_rate == 0 || sample_rate > clock ){
+		return HAL_ERROR;
+	}
+
+	jitter->clock = clock;
+	jitter->counter_mask = counter_mask;
+	jitter->nominal = ( clock + sample_rate / 2 ) / sample_rate;
+
+	/* A period longer than the counter range can not be measured */
+	if( jitter->nominal > counter_mask / 2 ){
+		return HAL_ERROR;
+	}
+
+	mcp4725_Jitter_Reset(jitter);
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Initialize the measure with the DWT cycle counter, and start the counter.
+  * @param  jitter Pointer to a MCP4725_Jitter_t structure.
+  * @param  sample_rate Nominal samples per second.
+  * @retval HAL_OK, HAL_ERROR if the sample rate is not valid.
+  */
+HAL_StatusTypeDef mcp4725_Jitter_Init_DWT(MCP4725_Jitter_t* jitter, uint32_t sample_rate){
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	#if (__CORTEX_M == 7U)
+		DWT->LAR = 0xC5ACCE55;
+	#endif
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	return mcp4725_Jitter_Init(jitter, SystemCoreClock, 0xFFFFFFFFU, sample_rate);
+}
+
+/**
+  * @brief  Clear the results, the next stamp starts a new measure.
+  */
+void mcp4725_Jitter_Reset(MCP4725_Jitter_t* jitter){
+
+	jitter->started = 0;
+	jitter->last = 0;
+	jitter->periods = 0;
+	jitter->min_error = 0;
+	jitter->max_error = 0;
+	jitter->sum_error = 0;
+	jitter->sum_square = 0;
+
+}
+
+/**
+  * @brief  Add the instant of a sample.
+  * @note	Can be called from an IRQ. A missing sample counts as a period error of one nominal period.
+  * @param  jitter Pointer to a MCP4725_Jitter_t structure.
+  * @param  stamp Value of the counter at the sample instant.
+  * @retval None
+  */
+void mcp4725_Jitter_Stamp(MCP4725_Jitter_t* jitter, uint32_t stamp){
+
+	if( jitter->started == 0 ){
+		jitter->started = 1;
+		jitter->last = stamp;
+		return;
+	}
+
+	int32_t error = (int32_t) ( ( stamp - jitter->last ) & jitter->counter_mask ) - (int32_t) jitter->nominal;
+	jitter->last = stamp;
+
+	if( jitter->periods == 0 || error < jitter->min_error )	jitter->min_error = error;
+	if( jitter->periods == 0 || error > jitter->max_error )	jitter->max_error = error;
+
+	jitter->sum_error += error;
+	jitter->sum_square += (uint64_t) ( (int64_t) error * error );
+	jitter->periods++;
+}
+
+/**
+  * @brief  Add the current instant, from the DWT cycle counter.
+  * @note	Call where the write of the sample is started, the measure must be initialized by mcp4725_Jitter_Init_DWT.
+  * @retval None
+  */
+void mcp4725_Jitter_Stamp_DWT(MCP4725_Jitter_t* jitter){
+	mcp4725_Jitter_Stamp(jitter, DWT->CYCCNT);
+}
+
+/**
+  * @brief  Add the sample instants of a buffer of SCL rising edges captured by a timer.
+  * @note	IRQ paced (MCP4725_JITTER_SINGLE): a sample starts after an idle gap longer than 2 SCL periods and is
+  * 		stamped at its ACK clock. When the edges of a sample are not followed by a gap (NACK, glitch) the count is
+  * 		resynchronized at the next gap and the period is not measured.
+  * 		Paced stream (MCP4725_JITTER_PACED): every byte leaves an idle gap, the gaps do not tell the first byte of a
+  * 		word from the second. The capture must start with the stream (edges[0] is the first clock of the address
+  * 		byte) and the words are counted 9 clocks per byte from there. The timer updates must leave a gap (update
+  * 		period longer than 11 SCL periods), a byte not preceded by a gap means a miscount and ends the capture.
+  * @param  jitter Pointer to a MCP4725_Jitter_t structure, initialized with the clock of the capture timer.
+  * @param  edges Captured values of the SCL rising edges, in order.
+  * @param  num_edges Edges in the buffer.
+  * @param  bus_clock SCL frequency in Hz.
+  * @param  capture Reference to MCP4725_Jitter_Capture_e, the transfer that produced the edges.
+  * @retval Samples stamped.
+  */
+uint32_t mcp4725_Jitter_Capture(MCP4725_Jitter_t* jitter, const uint32_t* edges, uint32_t num_edges, uint32_t bus_clock, MCP4725_Jitter_Capture_e capture){
+
+	uint32_t gap = ( bus_clock != 0 ) ? ( JITTER_GAP_SCL * jitter->clock ) / bus_clock : 0;
+	uint32_t stamped = 0;
+	uint32_t idx = 1;
+
+	if( gap == 0 ){
+		return 0;
+	}
+
+	if( capture == MCP4725_JITTER_PACED ){
+
+		for( idx = MCP4725_JITTER_EDGES_ADDR; idx + MCP4725_JITTER_EDGES_PACED <= num_edges; idx += MCP4725_JITTER_EDGES_PACED ){
+
+			/* First and second byte of the word, each after a timer update */
+			if( ( ( edges[idx] - edges[idx - 1] ) & jitter->counter_mask ) <= gap ||
+				( ( edges[idx + 9] - edges[idx + 8] ) & jitter->counter_mask ) <= gap ){
+				break;
+			}
+
+			mcp4725_Jitter_Stamp(jitter, edges[idx + MCP4725_JITTER_ACK_PACED]);
+			stamped++;
+		}
+
+		return stamped;
+	}
+
+	/* The first edge of the buffer can be in the middle of a sample, start at the first gap */
+	while( idx < num_edges ){
+
+		if( ( ( edges[idx] - edges[idx - 1] ) & jitter->counter_mask ) <= gap ){
+			idx++;
+			continue;
+		}
+
+		if( idx + MCP4725_JITTER_EDGES_SINGLE > num_edges ){
+			break;
+		}
+
+		mcp4725_Jitter_Stamp(jitter, edges[idx + MCP4725_JITTER_ACK_SINGLE]);
+		stamped++;
+
+		idx += MCP4725_JITTER_EDGES_SINGLE;
+
+		/* The next sample must start after a gap, if not the edges were miscounted */
+		if( idx < num_edges && ( ( edges[idx] - edges[idx - 1] ) & jitter->counter_mask ) <= gap ){
+			jitter->started = 0;
+		}
+	}
+
+	return stamped;
+}
+
+/**
+  * @brief  Peak to peak jitter: largest - smallest period.
+  * @retval ns
+  */
+uint32_t mcp4725_Jitter_Peak_ns(const MCP4725_Jitter_t* jitter){
+
+	if( jitter->periods == 0 ){
+		return 0;
+	}
+
+	return mcp4725_jitter_ns(jitter, (uint64_t) ( (int64_t) jitter->max_error - jitter->min_error ));
+}
+
+/**
+  * @brief  RMS jitter of the period, around the nominal period.
+  * @retval ns
+  */
+uint32_t mcp4725_Jitter_RMS_ns(const MCP4725_Jitter_t* jitter){
+
+	if( jitter->periods == 0 ){
+		return 0;
+	}
+
+	float rms = sqrtf( (float) jitter->sum_square / (float) jitter->periods );
+
+	return (uint32_t) lrintf( rms * (float) JITTER_NS_PER_S / (float) jitter->clock );
+}
+
+/**
+  * @brief  Mean period of the samples.
+  * @retval ns
+  */
+uint32_t mcp4725_Jitter_Mean_Period_ns(const MCP4725_Jitter_t* jitter){
+
+	if( jitter->periods == 0 ){
+		return 0;
+	}
+
+	int64_t mean = (int64_t) jitter->nominal + jitter->sum_error / (int64_t) jitter->periods;
+
+	return mcp4725_jitter_ns(jitter, ( mean > 0 ) ? (uint64_t) mean : 0);
+}
+
+/**
+  * @brief  Counts of the counter to ns.
+  */
+static uint32_t mcp4725_jitter_ns(const MCP4725_Jitter_t* jitter, uint64_t counts){
+	return (uint32_t) ( ( counts * JITTER_NS_PER_S ) / jitter->clock );
+}
@@ -0,0 +1,251 @@
+/*
+ * mcp4725_pack.c
+ *
+ *  Compressed waveforms for MCP4725, encoder and block decoder.
+ *
+ *  The decoder keeps the last sample, the last difference and the repeats left, so a waveform can be
+ *  decoded in blocks of any size. The time of each block is measured with the DWT cycle counter when
+ *  it is available (not in the host build).
+ */
+
+#include "mcp4725_pack.h"
+
+#define PACK_SHORT_MIN			-64
+#define PACK_SHORT_MAX			63
+#define PACK_LONG_FLAG			0x80
+#define PACK_RUN_FLAG			0xC0
+#define PACK_RUN_MASK			0x3F
+
+static uint8_t mcp4725_pack_put_run(uint8_t* dest, uint32_t dest_size, uint32_t* len, uint32_t run);
+static uint8_t mcp4725_pack_put_delta(uint8_t* dest, uint32_t dest_size, uint32_t* len, int32_t delta);
+
+/**
+  * @brief  Compress a waveform of 12-bit values.
+  * @param  dest Buffer of the codes, MCP4725_PACK_MAX_BYTES(num_samples) bytes for any waveform.
+  * @param  dest_size Bytes of dest.
+  * @param  samples 12-bit values for DAC output, the values above 4095 are clamped.
+  * @param  num_samples Samples of the waveform.
+  * @retval Bytes of the codes, 0 if dest is too small.
+  */
+uint32_t mcp4725_Pack_Encode(uint8_t* dest, uint32_t dest_size, const uint16_t* samples, uint32_t num_samples){
+
+	int32_t previous = 0;
+	int32_t last_delta = 0;
+	uint32_t run = 0;
+	uint32_t len = 0;
+
+	for( uint32_t idx = 0; idx < num_samples; idx++ ){
+
+		int32_t value = ( samples[idx] > 4095 ) ? 4095 : samples[idx];
+		int32_t delta = value - previous;
+		previous = value;
+
+		/* The decoder starts with a difference of 0, a waveform that starts at 0 starts with a run */
+		if( delta == last_delta ){
+			if( run == MCP4725_PACK_MAX_RUN ){
+				if( mcp4725_pack_put_run(dest, dest_size, &len, run) == 0 )	return 0;
+				run = 0;
+			}
+			run++;
+			continue;
+		}
+
+		if( mcp4725_pack_put_run(dest, dest_size, &len, run) == 0 )		return 0;
+		if( mcp4725_pack_put_delta(dest, dest_size, &len, delta) == 0 )	return 0;
+		run = 0;
+		last_delta = delta;
+	}
+
+	if( mcp4725_pack_put_run(dest, dest_size, &len, run) == 0 ){
+		return 0;
+	}
+
+	return len;
+}
+
+/**
+  * @brief  Compression ratio against a raw table of 2 bytes per sample.
+  * @retval Ratio x 100, 250 is 2.5:1.
+  */
+uint32_t mcp4725_Pack_Ratio_x100(const MCP4725_Pack_t* pack){
+
+	if( pack->size == 0 ){
+		return 0;
+	}
+
+	return (uint32_t) ( ( (uint64_t) pack->num_samples * 200U ) / pack->size );
+}
+
+/**
+  * @brief  Initialize the decoder at the start of the waveform.
+  * @param  unpack Pointer to a MCP4725_Unpack_t structure.
+  * @param  pack Compressed waveform.
+  * @param  loop 1 to decode the waveform in loop, 0 to hold the last sample at the end.
+  * @param  pd_mode Power Down Mode written with each sample. Reference to MCP4725_PowerDown_e
+  * @retval HAL_OK, HAL_ERROR if the waveform is empty.
+  */
+HAL_StatusTypeDef mcp4725_Unpack_Init(MCP4725_Unpack_t* unpack, const MCP4725_Pack_t* pack, uint8_t loop, MCP4725_PowerDown_e pd_mode){
+
+	if( pack == NULL || pack->data == NULL || pack->size == 0 ){
+		return HAL_ERROR;
+	}
+
+	unpack->pack = pack;
+	unpack->loop = loop;
+	unpack->pd_mode = pd_mode;
+	unpack->samples = 0;
+	unpack->cycles = 0;
+
+#if defined(DWT)
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	#if (__CORTEX_M == 7U)
+		DWT->LAR = 0xC5ACCE55;
+	#endif
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+	mcp4725_Unpack_Rewind(unpack);
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Go back to the start of the waveform.
+  */
+void mcp4725_Unpack_Rewind(MCP4725_Unpack_t* unpack){
+
+	unpack->pos = 0;
+	unpack->value = 0;
+	unpack->delta = 0;
+	unpack->run = 0;
+
+}
+
+/**
+  * @brief  Decode the next samples of the waveform in Fast Mode words.
+  * @note	Call from mcp4725_Stream_HalfCpltCallback / mcp4725_Stream_CpltCallback with the half of the buffer.
+  * 		At the end of the waveform the decoder starts again (loop) or fills the block with the last sample.
+  * @param  unpack Pointer to a MCP4725_Unpack_t structure.
+  * @param  dest Buffer of MCP4725_WAVE_BYTES(num_samples) bytes.
+  * @param  num_samples Samples to write in dest.
+  * @retval Samples of the waveform in dest, less than num_samples at the end with no loop.
+  */
+uint16_t mcp4725_Unpack_Block(MCP4725_Unpack_t* unpack, uint8_t* dest, uint16_t num_samples){
+
+#if defined(DWT)
+	uint32_t start = DWT->CYCCNT;
+#endif
+
+	const uint8_t* data = unpack->pack->data;
+	uint32_t size = unpack->pack->size;
+	uint32_t pos = unpack->pos;
+	int32_t value = unpack->value;
+	int32_t delta = unpack->delta;
+	uint8_t run = unpack->run;
+	uint8_t pd_bits = (uint8_t) ( ( unpack->pd_mode & 0x3 ) << 4 );
+	uint16_t decoded = 0;
+
+	for( uint16_t idx = 0; idx < num_samples; idx++ ){
+
+		if( run > 0 ){
+			run--;
+		}else{
+
+			if( pos >= size ){
+				if( unpack->loop == 0 ){
+					/* Hold the last sample */
+					dest[2 * idx] = pd_bits | (uint8_t) ( ( value >> 8 ) & 0x0F );
+					dest[2 * idx + 1] = (uint8_t) value;
+					continue;
+				}
+				pos = 0;
+				value = 0;
+				delta = 0;
+			}
+
+			uint8_t code = data[pos++];
+
+			if( ( code & PACK_LONG_FLAG ) == 0 ){
+				delta = (int32_t) ( (uint32_t) code << 25 ) >> 25;
+			}else if( ( code & PACK_RUN_FLAG ) == PACK_LONG_FLAG ){
+				delta = (int32_t) ( ( ( (uint32_t) code << 8 ) | data[pos++] ) << 18 ) >> 18;
+			}else{
+				run = code & PACK_RUN_MASK;
+			}
+		}
+
+		value += delta;
+
+		dest[2 * idx] = pd_bits | (uint8_t) ( ( value >> 8 ) & 0x0F );
+		dest[2 * idx + 1] = (uint8_t) value;
+		decoded++;
+	}
+
+	unpack->pos = pos;
+	unpack->value = (uint16_t) value;
+	unpack->delta = (int16_t) delta;
+	unpack->run = run;
+	unpack->samples += num_samples;
+
+#if defined(DWT)
+	unpack->cycles += DWT->CYCCNT - start;
+#endif
+
+	return decoded;
+}
+
+/**
+  * @brief  Mean decode time per sample, Fast Mode word included. 0 when the DWT is not available.
+  * @retval Cycles per sample x 100.
+  */
+uint32_t mcp4725_Unpack_Cycles_x100(const MCP4725_Unpack_t* unpack){
+
+	if( unpack->samples == 0 ){
+		return 0;
+	}
+
+	return (uint32_t) ( ( (uint64_t) unpack->cycles * 100U ) / unpack->samples );
+}
+
+/**
+  * @brief  Write the code of the repeats of the last difference, if any.
+  * @retval 1, 0 if dest is full.
+  */
+static uint8_t mcp4725_pack_put_run(uint8_t* dest, uint32_t dest_size, uint32_t* len, uint32_t run){
+
+	if( run == 0 ){
+		return 1;
+	}
+
+	if( *len + 1 > dest_size ){
+		return 0;
+	}
+
+	dest[(*len)++] = (uint8_t) ( PACK_RUN_FLAG | ( run - 1 ) );
+
+	return 1;
+}
+
+/**
+  * @brief  Write the code of a difference, 1 or 2 bytes.
+  * @retval 1, 0 if dest is full.
+  */
+static uint8_t mcp4725_pack_put_delta(uint8_t* dest, uint32_t dest_size, uint32_t* len, int32_t delta){
+
+	if( delta >= PACK_SHORT_MIN && delta <= PACK_SHORT_MAX ){
+		if( *len + 1 > dest_size ){
+			return 0;
+		}
+		dest[(*len)++] = (uint8_t) ( delta & 0x7F );
+		return 1;
+	}
+
+	if( *len + 2 > dest_size ){
+		return 0;
+	}
+
+	dest[(*len)++] = (uint8_t) ( PACK_LONG_FLAG | ( ( delta >> 8 ) & 0x3F ) );
+	dest[(*len)++] = (uint8_t) delta;
+
+	return 1;
+}
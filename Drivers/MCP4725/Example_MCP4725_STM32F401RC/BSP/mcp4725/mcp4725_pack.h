@@ -0,0 +1,68 @@
+/*
+ * mcp4725_pack.h
+ *
+ *  Compressed waveforms for MCP4725. Long arbitrary waveforms (test profiles, audio prompts) are stored
+ *  as the differences between consecutive samples in variable-length codes, and the repeats of the same
+ *  difference (flat segments and ramps) as one byte per 64 samples:
+ *
+ *  	0ddddddd					difference -64 to 63
+ *  	10dddddd dddddddd			difference -8192 to 8191 (the 12-bit range needs -4095 to 4095)
+ *  	11rrrrrr					the previous difference again, r + 1 times (1 to 64)
+ *
+ *  The format is lossless, the first difference is from 0. A raw table takes 2 bytes per sample, a
+ *  smooth waveform about 1 byte per sample and a profile of steps and ramps a few bytes per segment.
+ *
+ *  The block decoder writes Fast Mode words directly into the half of the stream buffer, from the
+ *  stream callbacks. The encoder is portable C, it is used by the host tool (Host/mcp4725_pack_tool.c)
+ *  to build the tables in flash.
+ */
+
+#ifndef MCP4725_MCP4725_PACK_H_
+#define MCP4725_MCP4725_PACK_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+
+#define MCP4725_PACK_MAX_BYTES(num_samples)		( (num_samples) * 2 )	/* Worst case, every difference in 2 bytes */
+#define MCP4725_PACK_MAX_RUN					64						/* Repeats of a difference in one code */
+
+/* Compressed waveform, built by mcp4725_Pack_Encode */
+
+typedef struct mcp4725_pack{
+	const uint8_t *			data;				/* Codes */
+	uint32_t				size;				/* Bytes of the codes */
+	uint32_t				num_samples;		/* Samples of the waveform */
+}MCP4725_Pack_t;
+
+/* Decoder State Structure */
+
+typedef struct mcp4725_unpack{
+	const MCP4725_Pack_t *	pack;				/* Waveform decoded */
+	uint32_t				pos;				/* Next code */
+	uint16_t				value;				/* Last sample */
+	int16_t					delta;				/* Last difference */
+	uint8_t					run;				/* Repeats of the difference left */
+	uint8_t					loop;				/* 1 to start again at the end, 0 to hold the last sample */
+	MCP4725_PowerDown_e		pd_mode;			/* Power Down Mode written with each sample */
+	uint32_t				samples;			/* Samples decoded, for the profile */
+	uint32_t				cycles;				/* DWT cycles of the decode, for the profile */
+}MCP4725_Unpack_t;
+
+/* Encoder, host or target */
+uint32_t mcp4725_Pack_Encode(uint8_t* dest, uint32_t dest_size, const uint16_t* samples, uint32_t num_samples);
+uint32_t mcp4725_Pack_Ratio_x100(const MCP4725_Pack_t* pack);
+
+/* Block decoder */
+HAL_StatusTypeDef mcp4725_Unpack_Init(MCP4725_Unpack_t* unpack, const MCP4725_Pack_t* pack, uint8_t loop, MCP4725_PowerDown_e pd_mode);
+void mcp4725_Unpack_Rewind(MCP4725_Unpack_t* unpack);
+uint16_t mcp4725_Unpack_Block(MCP4725_Unpack_t* unpack, uint8_t* dest, uint16_t num_samples);
+uint32_t mcp4725_Unpack_Cycles_x100(const MCP4725_Unpack_t* unpack);
+
+#endif /* MCP4725_MCP4725_PACK_H_ */
@@ -0,0 +1,164 @@
+/*
+ * mcp4725_plan.c
+ *
+ *  Sample rate planner for MCP4725.
+ *
+ *  The pacing timer is set with the prescaler and period closest to the requested rate, from the
+ *  timer kernel clock (PCLK, or 2 x PCLK when the APB prescaler is not 1). The rate is rejected
+ *  when it is above the maximum of the bus, a timer faster than the bus stretches or drops samples.
+ */
+
+#include "mcp4725_plan.h"
+
+#define PLAN_PER_MILLE		1000U
+
+static uint32_t mcp4725_plan_timer_clock(TIM_HandleTypeDef* htim);
+
+/**
+  * @brief  Compute the maximum sample rate of the bus.
+  * @param  plan Pointer to a MCP4725_Plan_t structure.
+  * @param  bus_clock SCL frequency in Hz (hi2c.Init.ClockSpeed on STM32F1/F4).
+  * @param  mode Reference to MCP4725_Plan_Mode_e
+  * @param  num_dacs DACs on the same bus updated at each sample, 1 in streaming.
+  * @retval HAL_OK, HAL_ERROR if the parameters are not valid.
+  */
+HAL_StatusTypeDef mcp4725_Plan_Init(MCP4725_Plan_t* plan, uint32_t bus_clock, MCP4725_Plan_Mode_e mode, uint8_t num_dacs){
+
+	if( bus_clock == 0 || num_dacs == 0 || ( mode == MCP4725_PLAN_STREAM && num_dacs != 1 ) ){
+		return HAL_ERROR;
+	}
+
+	plan->bus_clock = bus_clock;
+	plan->mode = mode;
+	plan->num_dacs = num_dacs;
+	plan->htim = NULL;
+
+	if( mode == MCP4725_PLAN_STREAM ){
+		plan->scl_per_sample = MCP4725_PLAN_STREAM_SCL;
+	}else{
+		plan->scl_per_sample = (uint32_t) num_dacs * ( MCP4725_PLAN_SINGLE_SCL + MCP4725_PLAN_GAP_SCL );
+	}
+
+	plan->max_rate = bus_clock / plan->scl_per_sample;
+
+	/* In streaming the bus paces the samples, there is no free time */
+	plan->sample_rate = ( mode == MCP4725_PLAN_STREAM ) ? plan->max_rate : 0;
+	plan->headroom = ( mode == MCP4725_PLAN_STREAM ) ? 0 : PLAN_PER_MILLE;
+
+	mcp4725_Plan_Reset_Stats(plan);
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Configure the period of the pacing timer for the sample rate, the timer is not started.
+  * @note	Call before HAL_TIM_Base_Start_IT. The rate set (rounded to the timer clock) is in plan->sample_rate.
+  * @param  htim Timer whose update event paces the samples.
+  * @param  sample_rate Samples per second, up to plan->max_rate.
+  * @retval HAL_OK, HAL_ERROR if the rate is above the maximum of the bus, out of the timer range or the mode is streaming.
+  */
+HAL_StatusTypeDef mcp4725_Plan_Config_Timer(MCP4725_Plan_t* plan, TIM_HandleTypeDef* htim, uint32_t sample_rate){
+
+	uint32_t max_period = 0xFFFFU;
+	uint32_t timer_clock;
+	uint32_t ticks;
+	uint32_t prescaler;
+	uint32_t period;
+
+	if( plan->mode == MCP4725_PLAN_STREAM || sample_rate == 0 || sample_rate > plan->max_rate ){
+		return HAL_ERROR;
+	}
+
+	if( IS_TIM_32B_COUNTER_INSTANCE(htim->Instance) ){
+		max_period = 0xFFFFFFFFU;
+	}
+
+	timer_clock = mcp4725_plan_timer_clock(htim);
+	ticks = ( timer_clock + sample_rate / 2 ) / sample_rate;
+
+	/* Smallest prescaler, the finest period */
+	prescaler = ( ticks - 1 ) / max_period;
+	if( prescaler > 0xFFFFU || ticks < 2 ){
+		return HAL_ERROR;
+	}
+
+	period = ( ticks + ( prescaler + 1 ) / 2 ) / ( prescaler + 1 );
+
+	htim->Init.Prescaler = prescaler;
+	htim->Init.Period = period - 1;
+	if( HAL_TIM_Base_Init(htim) != HAL_OK ){
+		return HAL_ERROR;
+	}
+
+	plan->htim = htim;
+	plan->sample_rate = timer_clock / ( ( prescaler + 1 ) * period );
+	plan->headroom = mcp4725_Plan_Headroom(plan, plan->sample_rate);
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Free bus time at a sample rate: 1 - sample_rate / max_rate.
+  * @retval Per mille of the sample period, 0 if the rate can not be sustained.
+  */
+uint16_t mcp4725_Plan_Headroom(const MCP4725_Plan_t* plan, uint32_t sample_rate){
+
+	if( sample_rate >= plan->max_rate ){
+		return 0;
+	}
+
+	return (uint16_t) ( PLAN_PER_MILLE - ( (uint64_t) sample_rate * PLAN_PER_MILLE ) / plan->max_rate );
+}
+
+/**
+  * @brief  Count a sample due, and an overrun if the previous transfer of the device is in progress.
+  * @note	Call from the timer update IRQ, start the transfer only when it returns 1.
+  * @retval 1 if the device is free, 0 on overrun (the sample is dropped).
+  */
+uint8_t mcp4725_Plan_Check(MCP4725_Plan_t* plan, MCP4725_Handle_t* mcp4725_dev){
+
+	plan->samples++;
+
+	/* During an EEPROM commit the write is queued, not lost */
+	MCP4725_State_e state = mcp4725_GetState(mcp4725_dev);
+
+	if( state != MCP4725_STATE_READY && state != MCP4725_STATE_BUSY_EEPROM ){
+		plan->overruns++;
+		return 0;
+	}
+
+	return 1;
+}
+
+/**
+  * @brief  Clear the sample and overrun counters.
+  */
+void mcp4725_Plan_Reset_Stats(MCP4725_Plan_t* plan){
+
+	plan->samples = 0;
+	plan->overruns = 0;
+
+}
+
+/**
+  * @brief  Kernel clock of the timer, from the APB bus of the instance.
+  */
+static uint32_t mcp4725_plan_timer_clock(TIM_HandleTypeDef* htim){
+
+	uint32_t instance = (uint32_t) htim->Instance;
+	uint8_t apb2 = ( instance >= APB2PERIPH_BASE && instance < ( APB2PERIPH_BASE + 0x10000U ) );
+	uint32_t pclk = apb2 ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+	uint32_t divider = HAL_RCC_GetHCLKFreq() / pclk;
+
+#if defined(RCC_CFGR_TIMPRE)
+	if( READ_BIT(RCC->CFGR, RCC_CFGR_TIMPRE) ){
+		return pclk * ( ( divider <= 4 ) ? divider : 4 );
+	}
+#elif defined(RCC_DCKCFGR_TIMPRE)
+	if( READ_BIT(RCC->DCKCFGR, RCC_DCKCFGR_TIMPRE) ){
+		return pclk * ( ( divider <= 4 ) ? divider : 4 );
+	}
+#endif
+
+	return ( divider == 1 ) ? pclk : 2 * pclk;
+}
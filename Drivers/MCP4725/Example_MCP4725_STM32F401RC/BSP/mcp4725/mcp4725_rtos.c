@@ -0,0 +1,345 @@
+/*
+ * mcp4725_rtos.c
+ *
+ *  FreeRTOS layer for MCP4725. Each device keeps a queue of requests sorted by priority, the
+ *  transfers are started with the asynchronous functions when the I2C bus is free (the devices
+ *  registered on the same bus are served one at a time) and the calling task waits for the task
+ *  notification sent from the I2C completion IRQ. No CPU time is used while waiting. The notification
+ *  index MCP4725_RTOS_NOTIFY_INDEX is used, the tasks keep index 0 for their own notifications.
+ *
+ *  Note: The I2C IRQ priority must be lower than (numerically greater) configMAX_SYSCALL_INTERRUPT_PRIORITY.
+ *  This layer implements mcp4725_TxCpltCallback, mcp4725_RxCpltCallback, mcp4725_EEPROM_CpltCallback and
+ *  mcp4725_ErrorCallback. The EEPROM writes are committed: the request ends when the device reports the end of
+ *  the programming, mcp4725_EEPROM_Poll must be called every 1 ms from a timer IRQ.
+ */
+
+#include "mcp4725_rtos.h"
+
+#ifdef MCP4725_USE_FREERTOS
+
+/* Registered devices */
+static MCP4725_RTOS_Handle_t* rtos_devices[MCP4725_RTOS_MAX_DEVICES] = {0};
+
+static HAL_StatusTypeDef mcp4725_rtos_request(MCP4725_RTOS_Handle_t* rtos, MCP4725_RTOS_Request_t* request, TickType_t timeout);
+static void mcp4725_rtos_push(MCP4725_RTOS_Handle_t* rtos, const MCP4725_RTOS_Request_t* request);
+static void mcp4725_rtos_cancel(MCP4725_RTOS_Handle_t* rtos, TaskHandle_t task);
+static void mcp4725_rtos_start_next(I2C_HandleTypeDef* hi2c, BaseType_t* woken);
+static void mcp4725_rtos_complete(MCP4725_Handle_t* mcp4725_dev, HAL_StatusTypeDef status);
+
+/**
+  * @brief  Register the device in the RTOS layer.
+  * @param  rtos Pointer to a MCP4725_RTOS_Handle_t structure.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t initialized by mcp4725_Init.
+  * @retval HAL_OK, HAL_ERROR if there are MCP4725_RTOS_MAX_DEVICES registered.
+  */
+HAL_StatusTypeDef mcp4725_rtos_Init(MCP4725_RTOS_Handle_t* rtos, MCP4725_Handle_t* mcp4725_dev){
+
+	HAL_StatusTypeDef status = HAL_ERROR;
+
+	rtos->device = mcp4725_dev;
+	rtos->count = 0;
+	rtos->busy = 0;
+
+	taskENTER_CRITICAL();
+	for( uint8_t idx = 0; idx < MCP4725_RTOS_MAX_DEVICES; idx++ ){
+		if( rtos_devices[idx] == NULL || rtos_devices[idx] == rtos ){
+			rtos_devices[idx] = rtos;
+			status = HAL_OK;
+			break;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return status;
+}
+
+/**
+  * @brief  Write the specified DAC data and Power Mode (Fast Mode command).
+  * @retval HAL status, HAL_BUSY if the queue is full, HAL_TIMEOUT.
+  */
+HAL_StatusTypeDef mcp4725_rtos_Write_PowerDown_DAC_Register(MCP4725_RTOS_Handle_t* rtos, uint16_t dac_data, MCP4725_PowerDown_e pd_mode, uint8_t priority, TickType_t timeout){
+
+	MCP4725_RTOS_Request_t request = { .type = MCP4725_RTOS_REQ_FAST_MODE, .priority = priority, .pd_mode = pd_mode, .dac_data = dac_data };
+	return mcp4725_rtos_request(rtos, &request, timeout);
+}
+
+/**
+  * @brief  Write the DAC register keeping the current power down mode (Fast Mode command).
+  * @retval HAL status, HAL_BUSY if the queue is full, HAL_TIMEOUT.
+  */
+HAL_StatusTypeDef mcp4725_rtos_Write_DAC_Register(MCP4725_RTOS_Handle_t* rtos, uint16_t dac_data, uint8_t priority, TickType_t timeout){
+
+	MCP4725_RTOS_Request_t request = { .type = MCP4725_RTOS_REQ_FAST_MODE, .priority = priority, .pd_mode = rtos->device->powerdown_mode, .dac_data = dac_data };
+	return mcp4725_rtos_request(rtos, &request, timeout);
+}
+
+/**
+  * @brief  Write the power down mode keeping the current DAC register (Fast Mode command).
+  * @retval HAL status, HAL_BUSY if the queue is full, HAL_TIMEOUT.
+  */
+HAL_StatusTypeDef mcp4725_rtos_Write_PowerDown(MCP4725_RTOS_Handle_t* rtos, MCP4725_PowerDown_e pd_mode, uint8_t priority, TickType_t timeout){
+
+	MCP4725_RTOS_Request_t request = { .type = MCP4725_RTOS_REQ_FAST_MODE, .priority = priority, .pd_mode = pd_mode, .dac_data = rtos->device->dac_register };
+	return mcp4725_rtos_request(rtos, &request, timeout);
+}
+
+/**
+  * @brief  Write the DAC register and the EEPROM, the task waits until the EEPROM programming ends (up to 50 ms).
+  * @note	The next requests on the bus are held until then, the device ignores the commands while programming.
+  * @retval HAL status, HAL_BUSY if the queue is full, HAL_TIMEOUT.
+  */
+HAL_StatusTypeDef mcp4725_rtos_Write_DAC_EEPROM(MCP4725_RTOS_Handle_t* rtos, uint16_t dac_data, MCP4725_PowerDown_e pd_mode, uint8_t priority, TickType_t timeout){
+
+	MCP4725_RTOS_Request_t request = { .type = MCP4725_RTOS_REQ_DAC_EEPROM, .priority = priority, .pd_mode = pd_mode, .dac_data = dac_data };
+	return mcp4725_rtos_request(rtos, &request, timeout);
+}
+
+/**
+  * @brief  Read the current settings and EEPROM settings and update the MCP4725_Handle_t instance.
+  * @retval HAL status, HAL_BUSY if the queue is full, HAL_TIMEOUT.
+  */
+HAL_StatusTypeDef mcp4725_rtos_Read_DAC_EEPROM(MCP4725_RTOS_Handle_t* rtos, uint8_t priority, TickType_t timeout){
+
+	MCP4725_RTOS_Request_t request = { .type = MCP4725_RTOS_REQ_READ, .priority = priority };
+	return mcp4725_rtos_request(rtos, &request, timeout);
+}
+
+/**
+  * @brief  Make a general call reset.
+  * @retval HAL status, HAL_BUSY if the queue is full, HAL_TIMEOUT.
+  */
+HAL_StatusTypeDef mcp4725_rtos_GeneralCall_Reset(MCP4725_RTOS_Handle_t* rtos, uint8_t priority, TickType_t timeout){
+
+	MCP4725_RTOS_Request_t request = { .type = MCP4725_RTOS_REQ_GC_RESET, .priority = priority };
+	return mcp4725_rtos_request(rtos, &request, timeout);
+}
+
+/**
+  * @brief  Make a general call wake-up.
+  * @retval HAL status, HAL_BUSY if the queue is full, HAL_TIMEOUT.
+  */
+HAL_StatusTypeDef mcp4725_rtos_GeneralCall_WakeUp(MCP4725_RTOS_Handle_t* rtos, uint8_t priority, TickType_t timeout){
+
+	MCP4725_RTOS_Request_t request = { .type = MCP4725_RTOS_REQ_GC_WAKEUP, .priority = priority };
+	return mcp4725_rtos_request(rtos, &request, timeout);
+}
+
+/**
+  * @brief  Write completed, wake the task and start the next request on the bus.
+  * @note	Called from mcp4725_I2C_CpltCallback (I2C IRQ), overrides the weak function of mcp4725.c
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure, already updated.
+  * @retval None
+  */
+void mcp4725_TxCpltCallback(MCP4725_Handle_t* mcp4725_dev){
+	mcp4725_rtos_complete(mcp4725_dev, HAL_OK);
+}
+
+/**
+  * @brief  Read completed, wake the task and start the next request on the bus.
+  * @note	Called from mcp4725_I2C_CpltCallback (I2C IRQ), overrides the weak function of mcp4725.c
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure, already updated.
+  * @retval None
+  */
+void mcp4725_RxCpltCallback(MCP4725_Handle_t* mcp4725_dev){
+	mcp4725_rtos_complete(mcp4725_dev, HAL_OK);
+}
+
+/**
+  * @brief  EEPROM programming ended, wake the task and start the next request on the bus.
+  * @note	Called from mcp4725_EEPROM_Poll (timer IRQ), overrides the weak function of mcp4725.c
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure, already updated.
+  * @retval None
+  */
+void mcp4725_EEPROM_CpltCallback(MCP4725_Handle_t* mcp4725_dev){
+	mcp4725_rtos_complete(mcp4725_dev, HAL_OK);
+}
+
+/**
+  * @brief  Transfer failed, wake the task with HAL_ERROR and start the next request on the bus.
+  * @note	Called from mcp4725_I2C_ErrorCallback (I2C IRQ), overrides the weak function of mcp4725.c
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval None
+  */
+void mcp4725_ErrorCallback(MCP4725_Handle_t* mcp4725_dev){
+	mcp4725_rtos_complete(mcp4725_dev, HAL_ERROR);
+}
+
+/**
+  * @brief  Queue the request, start it if the bus is free and suspend the task until the transfer ends.
+  * @retval HAL status of the transfer, HAL_BUSY if the queue is full, HAL_TIMEOUT.
+  */
+static HAL_StatusTypeDef mcp4725_rtos_request(MCP4725_RTOS_Handle_t* rtos, MCP4725_RTOS_Request_t* request, TickType_t timeout){
+
+	uint32_t status = HAL_OK;
+
+	request->task = xTaskGetCurrentTaskHandle();
+
+	/* Discard a notification of a previous request that timed out */
+	xTaskNotifyStateClearIndexed(NULL, MCP4725_RTOS_NOTIFY_INDEX);
+
+	taskENTER_CRITICAL();
+	if( rtos->count == MCP4725_RTOS_QUEUE_LEN ){
+		taskEXIT_CRITICAL();
+		return HAL_BUSY;
+	}
+
+	/* Redundant write, skipped only if no other request of the device can change the DAC before it */
+	if( request->type == MCP4725_RTOS_REQ_FAST_MODE && rtos->count == 0 && rtos->busy == 0 &&
+			mcp4725_Cache_Hit(rtos->device, request->dac_data, request->pd_mode) ){
+		taskEXIT_CRITICAL();
+		return HAL_OK;
+	}
+
+	mcp4725_rtos_push(rtos, request);
+	mcp4725_rtos_start_next(rtos->device->i2c_handle, NULL);
+	taskEXIT_CRITICAL();
+
+	if( xTaskNotifyWaitIndexed(MCP4725_RTOS_NOTIFY_INDEX, 0, 0xFFFFFFFFUL, &status, timeout) != pdTRUE ){
+
+		/* The request must not notify the task after the timeout */
+		taskENTER_CRITICAL();
+		mcp4725_rtos_cancel(rtos, request->task);
+		taskEXIT_CRITICAL();
+
+		return HAL_TIMEOUT;
+	}
+
+	return (HAL_StatusTypeDef) status;
+}
+
+/**
+  * @brief  Insert the request sorted by priority, after the requests with the same priority.
+  * @note	Call inside a critical section, the queue must have space.
+  */
+static void mcp4725_rtos_push(MCP4725_RTOS_Handle_t* rtos, const MCP4725_RTOS_Request_t* request){
+
+	uint8_t idx = rtos->count;
+
+	while( idx > 0 && rtos->queue[idx - 1].priority < request->priority ){
+		rtos->queue[idx] = rtos->queue[idx - 1];
+		idx--;
+	}
+
+	rtos->queue[idx] = *request;
+	rtos->count++;
+}
+
+/**
+  * @brief  Remove the request of the task from the queue, or detach it from the transfer in progress.
+  * @note	Call inside a critical section.
+  */
+static void mcp4725_rtos_cancel(MCP4725_RTOS_Handle_t* rtos, TaskHandle_t task){
+
+	if( rtos->busy && rtos->active.task == task ){
+		rtos->active.task = NULL;
+		return;
+	}
+
+	for( uint8_t idx = 0; idx < rtos->count; idx++ ){
+		if( rtos->queue[idx].task == task ){
+			for( ; idx < ( rtos->count - 1 ); idx++ ){
+				rtos->queue[idx] = rtos->queue[idx + 1];
+			}
+			rtos->count--;
+			return;
+		}
+	}
+}
+
+/**
+  * @brief  Start the request with the highest priority among the devices on the bus, if the bus is free.
+  * @note	Call inside a critical section or from the I2C IRQ. A request that cannot be started
+  * 		wakes its task with the HAL status.
+  * @param  woken NULL in task context, the flag of the ISR otherwise.
+  */
+static void mcp4725_rtos_start_next(I2C_HandleTypeDef* hi2c, BaseType_t* woken){
+
+	MCP4725_RTOS_Handle_t* next;
+
+	do{
+		next = NULL;
+
+		for( uint8_t idx = 0; idx < MCP4725_RTOS_MAX_DEVICES; idx++ ){
+			MCP4725_RTOS_Handle_t* rtos = rtos_devices[idx];
+			if( rtos == NULL || rtos->device->i2c_handle != hi2c )	continue;
+			if( rtos->busy )	return;		/* The bus is in use */
+			if( rtos->count > 0 && ( next == NULL || rtos->queue[0].priority > next->queue[0].priority ) ){
+				next = rtos;
+			}
+		}
+
+		if( next == NULL )	return;
+
+		next->active = next->queue[0];
+		for( uint8_t idx = 1; idx < next->count; idx++ ){
+			next->queue[idx - 1] = next->queue[idx];
+		}
+		next->count--;
+
+		MCP4725_Handle_t* dev = next->device;
+		HAL_StatusTypeDef status;
+
+		/* busy is set before the start, the callbacks look for it */
+		next->busy = 1;
+
+		switch( next->active.type ){
+			case MCP4725_RTOS_REQ_FAST_MODE:
+				status = mcp4725_Write_PowerDown_DAC_Register_Async(dev, next->active.dac_data, next->active.pd_mode);
+				break;
+			case MCP4725_RTOS_REQ_DAC_EEPROM:
+				/* Ends in mcp4725_EEPROM_CpltCallback, after the programming */
+				status = mcp4725_Write_DAC_EEPROM_Commit(dev, next->active.dac_data, next->active.pd_mode);
+				break;
+			case MCP4725_RTOS_REQ_READ:
+				status = mcp4725_Read_DAC_EEPROM_Async(dev);
+				break;
+			case MCP4725_RTOS_REQ_GC_RESET:
+				status = mcp4725_GeneralCall_Reset_Async(dev);
+				break;
+			case MCP4725_RTOS_REQ_GC_WAKEUP:
+				status = mcp4725_GeneralCall_WakeUp_Async(dev);
+				break;
+			default:
+				status = HAL_ERROR;
+				break;
+		}
+
+		if( status != HAL_OK ){
+			next->busy = 0;
+			if( next->active.task != NULL && woken != NULL ){
+				xTaskNotifyIndexedFromISR(next->active.task, MCP4725_RTOS_NOTIFY_INDEX, status, eSetValueWithOverwrite, woken);
+			}else if( next->active.task != NULL ){
+				xTaskNotifyIndexed(next->active.task, MCP4725_RTOS_NOTIFY_INDEX, status, eSetValueWithOverwrite);
+			}
+		}
+
+	}while( next->busy == 0 );
+}
+
+/**
+  * @brief  End of the transfer of the device, wake the task and start the next request on the bus.
+  */
+static void mcp4725_rtos_complete(MCP4725_Handle_t* mcp4725_dev, HAL_StatusTypeDef status){
+
+	BaseType_t woken = pdFALSE;
+	UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+
+	for( uint8_t idx = 0; idx < MCP4725_RTOS_MAX_DEVICES; idx++ ){
+
+		MCP4725_RTOS_Handle_t* rtos = rtos_devices[idx];
+		if( rtos == NULL || rtos->device != mcp4725_dev || rtos->busy == 0 )	continue;
+
+		rtos->busy = 0;
+		if( rtos->active.task != NULL ){
+			xTaskNotifyIndexedFromISR(rtos->active.task, MCP4725_RTOS_NOTIFY_INDEX, status, eSetValueWithOverwrite, &woken);
+		}
+		break;
+	}
+
+	mcp4725_rtos_start_next(mcp4725_dev->i2c_handle, &woken);
+
+	taskEXIT_CRITICAL_FROM_ISR(saved);
+	portYIELD_FROM_ISR(woken);
+}
+
+#endif /* MCP4725_USE_FREERTOS */
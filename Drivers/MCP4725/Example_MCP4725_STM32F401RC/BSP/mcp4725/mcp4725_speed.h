@@ -0,0 +1,48 @@
+/*
+ * mcp4725_speed.h
+ *
+ *  I2C bus speed for MCP4725. On the STM32H7 (I2C v2) the SCL clock is set by the TIMINGR register,
+ *  computed here for any target up to 1 MHz (Fast-mode Plus, with the 20 mA drive of the pins enabled).
+ *  The streaming mode keeps one transaction open, so the FM+ clock applies to the whole stream:
+ *  1 MHz / 18 SCL periods = 55.5 kS/s, 2.5 times the rate at 400 kHz.
+ *
+ *  High Speed mode (3.4 MHz) is not reachable with the I2C peripherals of the STM32: the fastest clock
+ *  is 1 MHz, and the HS master code is not acknowledged, so the I2C v2 sends a STOP after it and the
+ *  device leaves HS mode. The MCP4725 is rated for 400 kHz in Fast Mode, check the signals with the
+ *  pull-ups of the board when it runs at FM+.
+ *
+ *  On the STM32F1/F4 (I2C v1) the clock is limited to 400 kHz.
+ */
+
+#ifndef MCP4725_MCP4725_SPEED_H_
+#define MCP4725_MCP4725_SPEED_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+
+#ifndef MCP4725_SPEED_RISE_NS
+#define MCP4725_SPEED_RISE_NS		100		/* SCL/SDA rise time of the board, depends on the pull-ups and the bus capacitance */
+#endif
+
+#ifndef MCP4725_SPEED_FALL_NS
+#define MCP4725_SPEED_FALL_NS		10		/* SCL/SDA fall time of the board */
+#endif
+
+#define MCP4725_SPEED_STANDARD		100000U
+#define MCP4725_SPEED_FAST			400000U
+#define MCP4725_SPEED_FAST_PLUS		1000000U
+
+/* TIMINGR value for the I2C kernel clock, 0 if the target can not be reached */
+uint32_t mcp4725_Speed_Timing(uint32_t i2c_clk, uint32_t scl_freq, uint16_t rise_ns, uint16_t fall_ns, uint32_t* actual_freq);
+
+/* Change the SCL clock of the I2C peripheral */
+HAL_StatusTypeDef mcp4725_Speed_Set(I2C_HandleTypeDef* hi2c, uint32_t scl_freq, uint32_t* actual_freq);
+
+#endif /* MCP4725_MCP4725_SPEED_H_ */
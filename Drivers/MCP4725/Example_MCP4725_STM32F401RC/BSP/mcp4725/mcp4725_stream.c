@@ -0,0 +1,538 @@
+/*
+ * mcp4725_stream.c
+ *
+ *  Streaming mode for MCP4725, one I2C write transaction fed by a circular DMA.
+ *
+ *  After the address byte the MCP4725 accepts Fast Mode words back to back, the DAC output is
+ *  updated at the ACK of the second byte of each word. The transaction is opened by hand (START,
+ *  address, ACK) and then the I2C TX DMA request feeds the data register in loop until the stream
+ *  is stopped.
+ *
+ *  I2C v1 (STM32F1, STM32F4): the data register is double buffered, the DMA request is raised at TXE.
+ *  I2C v2 (STM32H7): NBYTES is reloaded with 255 bytes at each TCR event in the I2C event IRQ, the
+ *  HAL_I2C_EV_IRQHandler must be called from the I2Cx_EV_IRQHandler.
+ *
+ *  The I2C errors (NACK, bus error, arbitration lost) stop the stream from the I2C error IRQ, call
+ *  mcp4725_Stream_I2C_ER_IRQHandler from the I2Cx_ER_IRQHandler before HAL_I2C_ER_IRQHandler.
+ *
+ *  Paced: the I2C DMA request is not enabled, the DMA is triggered by the update event of the timer.
+ *  When the data register is empty the master stretches SCL (BTF on I2C v1, TXIS on I2C v2), so the
+ *  next byte leaves the bus when the timer writes it. The jitter is the latency of the DMA request,
+ *  a few bus clocks, instead of the latency of the timer IRQ.
+ */
+
+#include "mcp4725_stream.h"
+
+#define STREAM_TIMEOUT		5		/* ms to open or close the transaction */
+#define STREAM_TIMEOUT_LOOPS	( ( SystemCoreClock / 1000U ) * STREAM_TIMEOUT )	/* At least one CPU clock per loop, the tick does not advance in the IRQs */
+#define STREAM_RELOAD_BYTES	255U	/* NBYTES loaded in each reload (I2C v2) */
+
+/* Streams registered, one per I2C bus */
+static MCP4725_Stream_Handle_t* streams[MCP4725_MAX_I2C_BUS] = {0};
+
+static HAL_StatusTypeDef mcp4725_stream_register(MCP4725_Stream_Handle_t* stream);
+static HAL_StatusTypeDef mcp4725_stream_open(MCP4725_Stream_Handle_t* stream);
+static void mcp4725_stream_pace(MCP4725_Stream_Handle_t* stream);
+static void mcp4725_stream_dma_half(DMA_HandleTypeDef* hdma);
+static void mcp4725_stream_dma_cplt(DMA_HandleTypeDef* hdma);
+static void mcp4725_stream_dma_error(DMA_HandleTypeDef* hdma);
+static MCP4725_Stream_Handle_t* mcp4725_stream_find(DMA_HandleTypeDef* hdma);
+static uint8_t mcp4725_stream_check(MCP4725_Stream_Handle_t* stream);
+static void mcp4725_stream_close(MCP4725_Stream_Handle_t* stream);
+static uint8_t mcp4725_stream_wait(I2C_HandleTypeDef* hi2c, uint32_t flag, FlagStatus status);
+#if defined(I2C_CR2_RELOAD)
+static HAL_StatusTypeDef mcp4725_stream_isr(I2C_HandleTypeDef* hi2c, uint32_t ITFlags, uint32_t ITSources);
+#endif
+
+/**
+  * @brief  Register the stream of the device.
+  * @param  stream Pointer to a MCP4725_Stream_Handle_t structure.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t initialized by mcp4725_Init.
+  * @param  hdma DMA linked to the I2C TX request, in Circular Mode, memory increment and byte data width.
+  * @param  buffer Fast Mode words to send, 2 bytes per sample. Fill it with mcp4725_Stream_Encode before the start.
+  * @param  num_samples Samples in buffer, even number.
+  * @retval HAL_OK, HAL_ERROR if the parameters are not valid or there are MCP4725_MAX_I2C_BUS streams.
+  */
+HAL_StatusTypeDef mcp4725_Stream_Init(MCP4725_Stream_Handle_t* stream, MCP4725_Handle_t* mcp4725_dev, DMA_HandleTypeDef* hdma, uint8_t* buffer, uint16_t num_samples){
+
+	if( hdma == NULL || buffer == NULL || num_samples < 2 || ( num_samples & 0x1 ) ){
+		return HAL_ERROR;
+	}
+
+	stream->device = mcp4725_dev;
+	stream->hdma = hdma;
+	stream->buffer = buffer;
+	stream->num_samples = num_samples;
+	stream->refill = 1;
+
+	return mcp4725_stream_register(stream);
+}
+
+/**
+  * @brief  Register the stream of a pre-encoded table, sent in loop with no refill.
+  * @note	The DMA reads the table in place, it can be in flash (const). The half/complete callbacks are not called.
+  * @param  stream Pointer to a MCP4725_Stream_Handle_t structure.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t initialized by mcp4725_Init.
+  * @param  hdma DMA linked to the I2C TX request, in Circular Mode, memory increment and byte data width.
+  * @param  wave Table of Fast Mode words, built with MCP4725_FM_WORD or the mcp4725_Wave_xxx generators.
+  * @retval HAL_OK, HAL_ERROR if the parameters are not valid or there are MCP4725_MAX_I2C_BUS streams.
+  */
+HAL_StatusTypeDef mcp4725_Stream_Init_Wave(MCP4725_Stream_Handle_t* stream, MCP4725_Handle_t* mcp4725_dev, DMA_HandleTypeDef* hdma, const MCP4725_Wave_t* wave){
+
+	if( hdma == NULL || wave == NULL || wave->words == NULL || wave->num_samples < 2 || ( wave->num_samples & 0x1 ) ){
+		return HAL_ERROR;
+	}
+
+	stream->device = mcp4725_dev;
+	stream->hdma = hdma;
+	stream->buffer = (uint8_t*) wave->words;
+	stream->num_samples = wave->num_samples;
+	stream->refill = 0;
+
+	return mcp4725_stream_register(stream);
+}
+
+/**
+  * @brief  Open the I2C write transaction and start the circular DMA, the samples are sent until mcp4725_Stream_Stop.
+  * @note	The I2C bus is owned by the stream, the other transfers on the bus return HAL_BUSY.
+  * 		Waits for the START and the address (I2C v1), a few SCL periods. The waits are bounded by a loop count
+  * 		(STREAM_TIMEOUT ms at most), not by HAL_GetTick, so they also end in an IRQ above the SysTick.
+  * @param  stream Pointer to a MCP4725_Stream_Handle_t structure.
+  * @retval HAL_OK, HAL_BUSY if the I2C bus is in use, HAL_ERROR if the device does not acknowledge.
+  */
+HAL_StatusTypeDef mcp4725_Stream_Start(MCP4725_Stream_Handle_t* stream){
+
+	if( stream->running ){
+		return HAL_BUSY;
+	}
+
+	stream->htim = NULL;
+	return mcp4725_stream_open(stream);
+}
+
+/**
+  * @brief  Open the I2C write transaction, the bytes are written by the DMA at each update event of the timer.
+  * @note	stream->hdma must be linked to the update DMA request of htim (memory to peripheral, Circular Mode,
+  * 		memory increment, byte data width). The timer is configured with twice the sample rate (one byte per
+  * 		update), at most f_SCL / 9 updates per second: a byte must leave the bus before the next update.
+  * 		The timer is started here, from counter 0, and stopped by mcp4725_Stream_Stop.
+  * 		The waits are bounded as in mcp4725_Stream_Start.
+  * @param  stream Pointer to a MCP4725_Stream_Handle_t structure.
+  * @param  htim Pacing timer, initialized and stopped.
+  * @retval HAL_OK, HAL_BUSY if the I2C bus is in use, HAL_ERROR if the device does not acknowledge.
+  */
+HAL_StatusTypeDef mcp4725_Stream_Start_Paced(MCP4725_Stream_Handle_t* stream, TIM_HandleTypeDef* htim){
+
+	if( htim == NULL ){
+		return HAL_ERROR;
+	}
+
+	if( stream->running ){
+		return HAL_BUSY;
+	}
+
+	stream->htim = htim;
+	return mcp4725_stream_open(stream);
+}
+
+/**
+  * @brief  Stop the DMA and close the transaction with a STOP condition, the I2C bus is released.
+  * @note	The sample in progress is discarded by the device if its second byte was not sent.
+  * 		On I2C v2 waits for the STOP condition, bounded by a loop count as in mcp4725_Stream_Start.
+  * @param  stream Pointer to a MCP4725_Stream_Handle_t structure.
+  * @retval HAL_OK, HAL_ERROR if the stream is not running.
+  */
+HAL_StatusTypeDef mcp4725_Stream_Stop(MCP4725_Stream_Handle_t* stream){
+
+	if( stream->running == 0 ){
+		return HAL_ERROR;
+	}
+
+	mcp4725_stream_close(stream);
+	return HAL_OK;
+}
+
+/**
+  * @brief  Encode the samples in Fast Mode words with the power down mode of the device.
+  * @param  dest Buffer of 2 bytes per sample, commonly the half of the stream buffer given by the callbacks.
+  * @param  samples 12-bit values for DAC output.
+  * @retval None
+  */
+void mcp4725_Stream_Encode(MCP4725_Stream_Handle_t* stream, uint8_t* dest, const uint16_t* samples, uint16_t num_samples){
+	mcp4725_Wave_Encode(dest, samples, num_samples, stream->device->powerdown_mode);
+}
+
+/**
+  * @brief  Open the transaction and start the DMA, fed by the I2C request or by the pacing timer.
+  */
+static HAL_StatusTypeDef mcp4725_stream_open(MCP4725_Stream_Handle_t* stream){
+
+	I2C_HandleTypeDef* hi2c = stream->device->i2c_handle;
+	I2C_TypeDef* I2Cx = hi2c->Instance;
+	uint16_t dev_addr = stream->device->dev_addr << 1;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if( hi2c->State != HAL_I2C_STATE_READY || stream->device->state != MCP4725_STATE_READY ){
+		__set_PRIMASK(primask);
+		return HAL_BUSY;
+	}
+
+	/* Take the I2C handle, the HAL functions will return HAL_BUSY */
+	hi2c->State = HAL_I2C_STATE_BUSY_TX;
+	hi2c->Mode = HAL_I2C_MODE_MASTER;
+	hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+
+	__set_PRIMASK(primask);
+
+	stream->error = HAL_I2C_ERROR_NONE;
+	stream->blocks = 0;
+
+	stream->hdma->XferHalfCpltCallback = mcp4725_stream_dma_half;
+	stream->hdma->XferCpltCallback = mcp4725_stream_dma_cplt;
+	stream->hdma->XferErrorCallback = mcp4725_stream_dma_error;
+	stream->hdma->XferAbortCallback = NULL;
+
+#if defined(I2C_CR2_RELOAD)
+
+	if( HAL_DMA_Start_IT(stream->hdma, (uint32_t) stream->buffer, (uint32_t) &I2Cx->TXDR, stream->num_samples * MCP4725_STREAM_BYTES_PER_SAMPLE) != HAL_OK ){
+		hi2c->State = HAL_I2C_STATE_READY;
+		hi2c->Mode = HAL_I2C_MODE_NONE;
+		return HAL_ERROR;
+	}
+
+	hi2c->XferISR = mcp4725_stream_isr;
+	stream->running = 1;
+
+	I2Cx->CR1 |= ( ( stream->htim == NULL ) ? I2C_CR1_TXDMAEN : 0 ) | I2C_CR1_TCIE | I2C_CR1_NACKIE | I2C_CR1_ERRIE;
+	I2Cx->CR2 = ( dev_addr & I2C_CR2_SADD ) | ( STREAM_RELOAD_BYTES << I2C_CR2_NBYTES_Pos ) | I2C_CR2_RELOAD | I2C_CR2_START;
+
+	/* TXDR is empty, the first update writes the first byte, sent after the address */
+	if( stream->htim != NULL ){
+		mcp4725_stream_pace(stream);
+	}
+
+#else
+
+	/* Wait the end of the previous STOP condition */
+	if( mcp4725_stream_wait(hi2c, I2C_FLAG_BUSY, RESET) == 0 ){
+		hi2c->State = HAL_I2C_STATE_READY;
+		hi2c->Mode = HAL_I2C_MODE_NONE;
+		return HAL_BUSY;
+	}
+
+	if( HAL_DMA_Start_IT(stream->hdma, (uint32_t) stream->buffer, (uint32_t) &I2Cx->DR, stream->num_samples * MCP4725_STREAM_BYTES_PER_SAMPLE) != HAL_OK ){
+		hi2c->State = HAL_I2C_STATE_READY;
+		hi2c->Mode = HAL_I2C_MODE_NONE;
+		return HAL_ERROR;
+	}
+
+	I2Cx->CR1 &= ~I2C_CR1_POS;
+	I2Cx->CR1 |= I2C_CR1_START;
+
+	if( mcp4725_stream_wait(hi2c, I2C_FLAG_SB, SET) == 0 ){
+		mcp4725_stream_close(stream);
+		return HAL_ERROR;
+	}
+
+	I2Cx->DR = I2C_7BIT_ADD_WRITE(dev_addr);
+
+	uint32_t loops = STREAM_TIMEOUT_LOOPS;
+	while( __HAL_I2C_GET_FLAG(hi2c, I2C_FLAG_ADDR) == RESET ){
+		if( __HAL_I2C_GET_FLAG(hi2c, I2C_FLAG_AF) || loops-- == 0 ){
+			/* The device does not acknowledge the address */
+			__HAL_I2C_CLEAR_FLAG(hi2c, I2C_FLAG_AF);
+			mcp4725_stream_close(stream);
+			return HAL_ERROR;
+		}
+	}
+
+	/* The DMA requests start with the first TXE after the ADDR flag is cleared, the errors raise the I2C error IRQ */
+	stream->running = 1;
+	I2Cx->CR2 |= I2C_CR2_ITERREN;
+
+	if( stream->htim == NULL ){
+		I2Cx->CR2 |= I2C_CR2_DMAEN;
+		__HAL_I2C_CLEAR_ADDRFLAG(hi2c);
+	}else{
+		/* DR can be written only after the address, SCL is held low until the first update */
+		__HAL_I2C_CLEAR_ADDRFLAG(hi2c);
+		mcp4725_stream_pace(stream);
+	}
+
+#endif
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  I2C error IRQ of the stream: a NACK, bus error or arbitration lost stops the stream and calls mcp4725_Stream_ErrorCallback.
+  * @note	Call from the I2Cx_ER_IRQHandler before HAL_I2C_ER_IRQHandler, skip the HAL handler when it returns 1:
+  * 		the transaction of the stream is not a HAL transfer.
+  * @param  hi2c I2C handle of the IRQ.
+  * @retval 1 if a stream was running on the bus and its error flags were cleared (IRQ handled), 0 if not: the
+  * 		other flags are left to HAL_I2C_ER_IRQHandler, so the IRQ does not fire again at once.
+  */
+uint8_t mcp4725_Stream_I2C_ER_IRQHandler(I2C_HandleTypeDef* hi2c){
+
+	for( uint8_t idx = 0; idx < MCP4725_MAX_I2C_BUS; idx++ ){
+		if( streams[idx] != NULL && streams[idx]->running && streams[idx]->device->i2c_handle == hi2c ){
+			/* The stream is running, so 1 means an error flag was found and cleared */
+			return mcp4725_stream_check(streams[idx]);
+		}
+	}
+
+	return 0;
+}
+
+/**
+  * @brief  The first half of the buffer was sent, it can be refilled while the second half is sent.
+  * @note	This function should not be modified, when the callback is needed it can be implemented in the user file.
+  * @param  half Pointer to the first half of the buffer.
+  * @param  num_samples Samples in the half.
+  * @retval None
+  */
+__weak void mcp4725_Stream_HalfCpltCallback(MCP4725_Stream_Handle_t* stream, uint8_t* half, uint16_t num_samples){
+	UNUSED(stream);
+	UNUSED(half);
+	UNUSED(num_samples);
+}
+
+/**
+  * @brief  The second half of the buffer was sent, it can be refilled while the first half is sent again.
+  * @note	This function should not be modified, when the callback is needed it can be implemented in the user file.
+  * @param  half Pointer to the second half of the buffer.
+  * @param  num_samples Samples in the half.
+  * @retval None
+  */
+__weak void mcp4725_Stream_CpltCallback(MCP4725_Stream_Handle_t* stream, uint8_t* half, uint16_t num_samples){
+	UNUSED(stream);
+	UNUSED(half);
+	UNUSED(num_samples);
+}
+
+/**
+  * @brief  The stream was stopped by an I2C or DMA error, the cause is in stream->error.
+  * @note	This function should not be modified, when the callback is needed it can be implemented in the user file.
+  * @retval None
+  */
+__weak void mcp4725_Stream_ErrorCallback(MCP4725_Stream_Handle_t* stream){
+	UNUSED(stream);
+}
+
+/**
+  * @brief  Reset the state of the stream and add it to the registered streams.
+  */
+static HAL_StatusTypeDef mcp4725_stream_register(MCP4725_Stream_Handle_t* stream){
+
+	stream->htim = NULL;
+	stream->running = 0;
+	stream->error = HAL_I2C_ERROR_NONE;
+	stream->blocks = 0;
+	stream->stop_sample = 0;
+
+	for( uint8_t idx = 0; idx < MCP4725_MAX_I2C_BUS; idx++ ){
+		if( streams[idx] == NULL || streams[idx] == stream ){
+			streams[idx] = stream;
+			return HAL_OK;
+		}
+	}
+
+	return HAL_ERROR;
+}
+
+/**
+  * @brief  Start the pacing timer from 0, each update event writes one byte.
+  */
+static void mcp4725_stream_pace(MCP4725_Stream_Handle_t* stream){
+
+	__HAL_TIM_SET_COUNTER(stream->htim, 0);
+	__HAL_TIM_CLEAR_FLAG(stream->htim, TIM_FLAG_UPDATE);
+	__HAL_TIM_ENABLE_DMA(stream->htim, TIM_DMA_UPDATE);
+	HAL_TIM_Base_Start(stream->htim);
+
+}
+
+/**
+  * @brief  DMA half transfer, ask to refill the first half.
+  */
+static void mcp4725_stream_dma_half(DMA_HandleTypeDef* hdma){
+
+	MCP4725_Stream_Handle_t* stream = mcp4725_stream_find(hdma);
+	if( stream == NULL || mcp4725_stream_check(stream) )	return;
+
+	stream->blocks++;
+	if( stream->refill == 0 )	return;
+
+	mcp4725_Stream_HalfCpltCallback(stream, stream->buffer, stream->num_samples / 2);
+}
+
+/**
+  * @brief  DMA transfer complete (the circular DMA restarts), ask to refill the second half.
+  */
+static void mcp4725_stream_dma_cplt(DMA_HandleTypeDef* hdma){
+
+	MCP4725_Stream_Handle_t* stream = mcp4725_stream_find(hdma);
+	if( stream == NULL || mcp4725_stream_check(stream) )	return;
+
+	uint16_t half = stream->num_samples / 2;
+
+	stream->blocks++;
+	if( stream->refill == 0 )	return;
+
+	mcp4725_Stream_CpltCallback(stream, &stream->buffer[ half * MCP4725_STREAM_BYTES_PER_SAMPLE ], half);
+}
+
+/**
+  * @brief  DMA error, stop the stream.
+  */
+static void mcp4725_stream_dma_error(DMA_HandleTypeDef* hdma){
+
+	MCP4725_Stream_Handle_t* stream = mcp4725_stream_find(hdma);
+	if( stream == NULL || stream->running == 0 )	return;
+
+	stream->error = HAL_I2C_ERROR_DMA;
+	mcp4725_stream_close(stream);
+	mcp4725_Stream_ErrorCallback(stream);
+}
+
+/**
+  * @brief  Search the running stream of the DMA.
+  */
+static MCP4725_Stream_Handle_t* mcp4725_stream_find(DMA_HandleTypeDef* hdma){
+
+	for( uint8_t idx = 0; idx < MCP4725_MAX_I2C_BUS; idx++ ){
+		if( streams[idx] != NULL && streams[idx]->hdma == hdma ){
+			return streams[idx];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+  * @brief  Check the I2C error flags (NACK, bus error, arbitration lost) and stop the stream if any is set.
+  * @retval 1 if the stream was stopped.
+  */
+static uint8_t mcp4725_stream_check(MCP4725_Stream_Handle_t* stream){
+
+	I2C_HandleTypeDef* hi2c = stream->device->i2c_handle;
+	uint32_t error = HAL_I2C_ERROR_NONE;
+
+	if( stream->running == 0 ){
+		return 1;
+	}
+
+	if( __HAL_I2C_GET_FLAG(hi2c, I2C_FLAG_AF) )		error |= HAL_I2C_ERROR_AF;
+	if( __HAL_I2C_GET_FLAG(hi2c, I2C_FLAG_BERR) )	error |= HAL_I2C_ERROR_BERR;
+	if( __HAL_I2C_GET_FLAG(hi2c, I2C_FLAG_ARLO) )	error |= HAL_I2C_ERROR_ARLO;
+	if( __HAL_I2C_GET_FLAG(hi2c, I2C_FLAG_OVR) )	error |= HAL_I2C_ERROR_OVR;
+
+	if( error == HAL_I2C_ERROR_NONE ){
+		return 0;
+	}
+
+	__HAL_I2C_CLEAR_FLAG(hi2c, I2C_FLAG_AF);
+	__HAL_I2C_CLEAR_FLAG(hi2c, I2C_FLAG_BERR);
+	__HAL_I2C_CLEAR_FLAG(hi2c, I2C_FLAG_ARLO);
+	__HAL_I2C_CLEAR_FLAG(hi2c, I2C_FLAG_OVR);
+
+	stream->error = error;
+	mcp4725_stream_close(stream);
+	mcp4725_Stream_ErrorCallback(stream);
+
+	return 1;
+}
+
+/**
+  * @brief  Abort the DMA, generate the STOP condition and give back the I2C handle.
+  */
+static void mcp4725_stream_close(MCP4725_Stream_Handle_t* stream){
+
+	I2C_HandleTypeDef* hi2c = stream->device->i2c_handle;
+	I2C_TypeDef* I2Cx = hi2c->Instance;
+
+	stream->running = 0;
+
+	if( stream->htim != NULL ){
+		__HAL_TIM_DISABLE_DMA(stream->htim, TIM_DMA_UPDATE);
+		HAL_TIM_Base_Stop(stream->htim);
+	}
+
+	/* Position in the buffer, to resume the stream at the same phase */
+	uint32_t sent = stream->num_samples * MCP4725_STREAM_BYTES_PER_SAMPLE - __HAL_DMA_GET_COUNTER(stream->hdma);
+	stream->stop_sample = (uint16_t) ( ( sent / MCP4725_STREAM_BYTES_PER_SAMPLE ) % stream->num_samples );
+
+	HAL_DMA_Abort(stream->hdma);
+
+#if defined(I2C_CR2_RELOAD)
+	I2Cx->CR1 &= ~( I2C_CR1_TXDMAEN | I2C_CR1_TCIE | I2C_CR1_NACKIE | I2C_CR1_ERRIE );
+	I2Cx->CR2 |= I2C_CR2_STOP;
+
+	/* No STOP condition after a bus error or a lost arbitration, the master already left the bus */
+	if( ( stream->error & ( HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_ARLO ) ) == 0 ){
+		mcp4725_stream_wait(hi2c, I2C_FLAG_STOPF, SET);
+	}
+	__HAL_I2C_CLEAR_FLAG(hi2c, I2C_FLAG_STOPF);
+	I2C_RESET_CR2(hi2c);
+
+	hi2c->XferISR = NULL;
+#else
+	I2Cx->CR2 &= ~( I2C_CR2_DMAEN | I2C_CR2_ITERREN );
+	I2Cx->CR1 |= I2C_CR1_STOP;
+#endif
+
+	hi2c->State = HAL_I2C_STATE_READY;
+	hi2c->Mode = HAL_I2C_MODE_NONE;
+}
+
+/**
+  * @brief  Wait a flag of the I2C, bounded by STREAM_TIMEOUT_LOOPS: also in the IRQs, where HAL_GetTick does not advance.
+  * @retval 1 when the flag has the status, 0 on timeout.
+  */
+static uint8_t mcp4725_stream_wait(I2C_HandleTypeDef* hi2c, uint32_t flag, FlagStatus status){
+
+	uint32_t loops = STREAM_TIMEOUT_LOOPS;
+
+	while( __HAL_I2C_GET_FLAG(hi2c, flag) != status ){
+		if( loops-- == 0 ){
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+#if defined(I2C_CR2_RELOAD)
+/**
+  * @brief  I2C event IRQ of the stream (I2C v2), called by HAL_I2C_EV_IRQHandler through hi2c->XferISR.
+  * @note	Reload NBYTES to keep the transaction open, a NACK stops the stream.
+  */
+static HAL_StatusTypeDef mcp4725_stream_isr(I2C_HandleTypeDef* hi2c, uint32_t ITFlags, uint32_t ITSources){
+
+	MCP4725_Stream_Handle_t* stream = NULL;
+
+	for( uint8_t idx = 0; idx < MCP4725_MAX_I2C_BUS; idx++ ){
+		if( streams[idx] != NULL && streams[idx]->device->i2c_handle == hi2c ){
+			stream = streams[idx];
+			break;
+		}
+	}
+
+	if( stream == NULL ){
+		return HAL_ERROR;
+	}
+
+	if( ( ITFlags & I2C_ISR_NACKF ) && ( ITSources & I2C_CR1_NACKIE ) ){
+		mcp4725_stream_check(stream);
+		return HAL_OK;
+	}
+
+	if( ( ITFlags & I2C_ISR_TCR ) && ( ITSources & I2C_CR1_TCIE ) ){
+		MODIFY_REG(hi2c->Instance->CR2, I2C_CR2_NBYTES, STREAM_RELOAD_BYTES << I2C_CR2_NBYTES_Pos);
+	}
+
+	return HAL_OK;
+}
+#endif
@@ -0,0 +1,55 @@
+/*
+ * mcp4725_wave.h
+ *
+ *  Waveform tables in the wire format of the MCP4725: each sample is stored as the 2-byte Fast Mode
+ *  word (PD1 PD0 D11..D8, D7..D0), ready to be sent by the DMA without any work per sample.
+ *
+ *  Tables in flash are built by the compiler with MCP4725_FM_WORD, tables in RAM are built once
+ *  with the generators (sine, triangle, sawtooth or an arbitrary table of 12-bit values).
+ */
+
+#ifndef MCP4725_MCP4725_WAVE_H_
+#define MCP4725_MCP4725_WAVE_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+
+#define MCP4725_DAC_MAX			4095	/* Full scale of the 12-bit DAC register */
+#define MCP4725_WAVE_TWO_PI		6.28318531f	/* One period of the sine tables, radians */
+
+/*
+ * Fast Mode word of a sample (PD1 PD0 at bits 5:4 of the first byte), expands to the 2 bytes of a table initializer:
+ *
+ *   #define SIGNAL(X)	X(2047) X(3071) X(4095) X(3071) X(2047) X(1023) X(0) X(1023)
+ *   #define AS_WORD(v)	MCP4725_FM_WORD(v, MCP4725_NORMAL_MODE),
+ *   const uint8_t signal_words[] = { SIGNAL(AS_WORD) };
+ */
+#define MCP4725_FM_WORD(dac_data, pd_mode)	\
+	(uint8_t)( ( ( (pd_mode) & 0x3 ) << 4 ) | ( ( (dac_data) >> 8 ) & 0x0F ) ), (uint8_t)( (dac_data) & 0xFF )
+
+#define MCP4725_WAVE_BYTES(num_samples)		( (num_samples) * 2 )
+
+/* Waveform table in wire format */
+
+typedef struct mcp4725_wave{
+	const uint8_t *		words;				/* Fast Mode words, 2 bytes per sample */
+	uint16_t			num_samples;		/* Samples in the table */
+}MCP4725_Wave_t;
+
+/* Generators, dest has MCP4725_WAVE_BYTES(num_samples) bytes */
+void mcp4725_Wave_Encode(uint8_t* dest, const uint16_t* samples, uint16_t num_samples, MCP4725_PowerDown_e pd_mode);
+void mcp4725_Wave_Sine(uint8_t* dest, uint16_t num_samples, uint16_t amplitude, uint16_t offset, MCP4725_PowerDown_e pd_mode);
+void mcp4725_Wave_Triangle(uint8_t* dest, uint16_t num_samples, uint16_t amplitude, uint16_t offset, MCP4725_PowerDown_e pd_mode);
+void mcp4725_Wave_Sawtooth(uint8_t* dest, uint16_t num_samples, uint16_t amplitude, uint16_t offset, MCP4725_PowerDown_e pd_mode);
+
+/* Read back the 12-bit value of a sample */
+uint16_t mcp4725_Wave_Sample(const MCP4725_Wave_t* wave, uint16_t idx);
+
+#endif /* MCP4725_MCP4725_WAVE_H_ */
@@ -22,6 +22,11 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "mcp4725.h"
+#include "mcp4725_stream.h"
+#include "mcp4725_wave.h"
+#include "mcp4725_dds.h"
+#include "mcp4725_plan.h"
+#include <string.h>
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -31,14 +36,40 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
-
+#define SIGNAL_STREAMING	0		/* 3: DDS sweep generated in the stream buffer, 2: pre-encoded table sent by DMA from flash, 1: one I2C transaction fed by DMA from a refilled buffer (about 22 kS/s at 400 kHz), 0: one transfer per TIM2 update */
+#define STREAM_SAMPLES		64		/* Samples in the circular buffer, refilled by halves */
+#define DDS_TABLE_BITS		8		/* Sine table of 256 samples */
+#define SAMPLE_RATE			10000	/* TIM2 rate, one transfer per update (the bus sustains about 12.9 kS/s at 400 kHz) */
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
 /* USER CODE BEGIN PM */
 //const uint16_t signal[] = {2047,2097,2147,2198,2248,2298,2348,2398,2447,2497,2546,2595,2643,2691,2739,2786,2833,2879,2925,2970,3015,3059,3103,3145,3188,3229,3270,3310,3349,3388,3426,3462,3498,3534,3568,3601,3633,3665,3695,3725,3753,3780,3807,3832,3856,3879,3901,3922,3941,3960,3977,3993,4008,4022,4035,4046,4056,4065,4073,4079,4085,4089,4092,4093,4093,4093,4090,4087,4082,4076,4069,4061,4051,4041,4029,4015,4001,3985,3969,3951,3932,3911,3890,3868,3844,3819,3793,3767,3739,3710,3680,3649,3617,3584,3551,3516,3481,3444,3407,3369,3330,3290,3250,3209,3167,3124,3081,3037,2993,2948,2902,2856,2809,2762,2715,2667,2619,2570,2521,2472,2423,2373,2323,2273,2223,2173,2122,2072,2021,1971,1920,1870,1820,1770,1720,1670,1621,1572,1523,1474,1426,1378,1331,1284,1237,1191,1145,1100,1056,1012,969,926,884,843,803,763,724,686,649,612,577,542,509,476,444,413,383,354,326,300,274,249,225,203,182,161,142,124,108,92,78,64,52,42,32,24,17,11,6,3,0,0,0,1,4,8,14,20,28,37,47,58,71,85,100,116,133,152,171,192,214,237,261,286,313,340,368,398,428,460,492,525,559,595,631,667,705,744,783,823,864,905,948,990,1034,1078,1123,1168,1214,1260,1307,1354,1402,1450,1498,1547,1596,1646,1695,1745,1795,1845,1895,1946,1996,2046};
-const uint16_t signal[] = {2046,2345,2145,1923,2199,2520,2344,2100,2350,2690,2540,2277,2499,2854,2731,2451,2643,3011,2915,2621,2781,3158,3091,2785,2911,3296,3257,2941,3034,3421,3412,3088,3146,3534,3554,3225,3247,3632,3681,3351,3337,3715,3793,3463,3413,3782,3888,3561,3476,3833,3965,3645,3525,3866,4025,3712,3559,3882,4065,3764,3578,3880,4086,3798,3582,3861,4088,3816,3570,3823,4070,3816,3544,3769,4033,3800,3502,3698,3977,3766,3446,3610,3903,3715,3375,3508,3811,3649,3292,3391,3703,3567,3196,3261,3578,3471,3089,3118,3439,3360,2971,2966,3287,3238,2844,2804,3123,3104,2709,2634,2949,2960,2567,2458,2766,2808,2420,2278,2577,2648,2269,2096,2383,2483,2115,1912,2185,2314,1961,1730,1986,2143,1808,1550,1788,1971,1657,1375,1592,1801,1509,1205,1401,1633,1367,1044,1216,1469,1232,892,1039,1312,1104,750,872,1162,986,621,716,1021,878,506,573,890,782,405,443,771,698,319,329,665,627,250,232,572,571,198,152,494,529,164,90,431,502,148,46,384,490,150,22,353,494,170,17,339,513,209,31,341,548,265,65,360,597,338,117,396,661,428,187,447,739,533,276,515,830,654,381,596,933,788,501,692,1047,934,637,801,1171,1091,786,922,1304,1257,946,1053,1445,1432,1117,1194,1592,1613,1297,1343,1743,1798,1484,1499,1898,1985,1675,1659,2054,2174,1871,1823};
+#define SIGNAL_TABLE(X)	\
+	X(2046) X(2345) X(2145) X(1923) X(2199) X(2520) X(2344) X(2100) X(2350) X(2690) X(2540) X(2277) X(2499) X(2854) X(2731) X(2451) \
+	X(2643) X(3011) X(2915) X(2621) X(2781) X(3158) X(3091) X(2785) X(2911) X(3296) X(3257) X(2941) X(3034) X(3421) X(3412) X(3088) \
+	X(3146) X(3534) X(3554) X(3225) X(3247) X(3632) X(3681) X(3351) X(3337) X(3715) X(3793) X(3463) X(3413) X(3782) X(3888) X(3561) \
+	X(3476) X(3833) X(3965) X(3645) X(3525) X(3866) X(4025) X(3712) X(3559) X(3882) X(4065) X(3764) X(3578) X(3880) X(4086) X(3798) \
+	X(3582) X(3861) X(4088) X(3816) X(3570) X(3823) X(4070) X(3816) X(3544) X(3769) X(4033) X(3800) X(3502) X(3698) X(3977) X(3766) \
+	X(3446) X(3610) X(3903) X(3715) X(3375) X(3508) X(3811) X(3649) X(3292) X(3391) X(3703) X(3567) X(3196) X(3261) X(3578) X(3471) \
+	X(3089) X(3118) X(3439) X(3360) X(2971) X(2966) X(3287) X(3238) X(2844) X(2804) X(3123) X(3104) X(2709) X(2634) X(2949) X(2960) \
+	X(2567) X(2458) X(2766) X(2808) X(2420) X(2278) X(2577) X(2648) X(2269) X(2096) X(2383) X(2483) X(2115) X(1912) X(2185) X(2314) \
+	X(1961) X(1730) X(1986) X(2143) X(1808) X(1550) X(1788) X(1971) X(1657) X(1375) X(1592) X(1801) X(1509) X(1205) X(1401) X(1633) \
+	X(1367) X(1044) X(1216) X(1469) X(1232) X(892) X(1039) X(1312) X(1104) X(750) X(872) X(1162) X(986) X(621) X(716) X(1021) \
+	X(878) X(506) X(573) X(890) X(782) X(405) X(443) X(771) X(698) X(319) X(329) X(665) X(627) X(250) X(232) X(572) \
+	X(571) X(198) X(152) X(494) X(529) X(164) X(90) X(431) X(502) X(148) X(46) X(384) X(490) X(150) X(22) X(353) \
+	X(494) X(170) X(17) X(339) X(513) X(209) X(31) X(341) X(548) X(265) X(65) X(360) X(597) X(338) X(117) X(396) \
+	X(661) X(428) X(187) X(447) X(739) X(533) X(276) X(515) X(830) X(654) X(381) X(596) X(933) X(788) X(501) X(692) \
+	X(1047) X(934) X(637) X(801) X(1171) X(1091) X(786) X(922) X(1304) X(1257) X(946) X(1053) X(1445) X(1432) X(1117) X(1194) \
+	X(1592) X(1613) X(1297) X(1343) X(1743) X(1798) X(1484) X(1499) X(1898) X(1985) X(1675) X(1659) X(2054) X(2174) X(1871) X(1823)
+#define SIGNAL_SAMPLE(v)	v,
+#define SIGNAL_WORD(v)		MCP4725_FM_WORD(v, MCP4725_NORMAL_MODE),
+
+/* The same signal as 12-bit values and as Fast Mode words built by the compiler (kept in flash) */
+const uint16_t signal[] = { SIGNAL_TABLE(SIGNAL_SAMPLE) };
+const uint8_t signal_words[] = { SIGNAL_TABLE(SIGNAL_WORD) };
 const uint16_t signal_len = sizeof(signal) / sizeof(uint16_t);
+const MCP4725_Wave_t signal_wave = { signal_words, sizeof(signal_words) / MCP4725_STREAM_BYTES_PER_SAMPLE };
 #define MCP4725_ADDR	0x61
 MCP4725_Handle_t mcp4725_dev = {0};
 /* USER CODE END PM */
@@ -49,7 +80,13 @@ I2C_HandleTypeDef hi2c1;
 TIM_HandleTypeDef htim2;
 
 /* USER CODE BEGIN PV */
-
+DMA_HandleTypeDef hdma_i2c1_tx;
+MCP4725_Stream_Handle_t mcp4725_stream = {0};
+uint8_t stream_buffer[STREAM_SAMPLES * MCP4725_STREAM_BYTES_PER_SAMPLE];
+uint16_t stream_idx = 0;
+MCP4725_DDS_Handle_t dds = {0};
+MCP4725_Plan_t mcp4725_plan = {0};
+uint16_t dds_table[1 << DDS_TABLE_BITS];
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -58,7 +95,8 @@ static void MX_GPIO_Init(void);
 static void MX_I2C1_Init(void);
 static void MX_TIM2_Init(void);
 /* USER CODE BEGIN PFP */
-
+static void stream_dma_init(void);
+static void stream_fill(uint8_t* dest, uint16_t num_samples);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -113,9 +151,41 @@ int main(void)
 	  HAL_GPIO_WritePin(USER_LED_GPIO_Port, USER_LED_Pin, GPIO_PIN_RESET);
   }
 
-  mcp4725_Write_DAC_EEPROM(&mcp4725_dev, 4048, MCP4725_NORMAL_MODE);
-
-  HAL_TIM_Base_Start_IT(&htim2);
+  /* Non-blocking: the EEPROM programming (up to 50 ms) is polled from SysTick, the Fast Mode writes are queued meanwhile */
+  mcp4725_Write_DAC_EEPROM_Commit(&mcp4725_dev, 4048, MCP4725_NORMAL_MODE);
+
+#if SIGNAL_STREAMING
+  /* The stream owns the bus, it starts when the device is ready */
+  while( mcp4725_GetState(&mcp4725_dev) != MCP4725_STATE_READY );
+#endif
+
+#if SIGNAL_STREAMING == 3
+  /* Sample rate paced by the I2C clock, chirp from 100 Hz to 2 kHz and back in 1 s */
+  mcp4725_Plan_Init(&mcp4725_plan, hi2c1.Init.ClockSpeed, MCP4725_PLAN_STREAM, 1);
+  mcp4725_DDS_Sine_Table(dds_table, DDS_TABLE_BITS);
+  mcp4725_DDS_Init(&dds, dds_table, DDS_TABLE_BITS, mcp4725_plan.sample_rate);
+  dds.interpolate = 1;
+  mcp4725_DDS_Sweep(&dds, 100000, 2000000, 1000, MCP4725_DDS_SWEEP_UP_DOWN);
+  stream_dma_init();
+  stream_fill(stream_buffer, STREAM_SAMPLES);
+  mcp4725_Stream_Init(&mcp4725_stream, &mcp4725_dev, &hdma_i2c1_tx, stream_buffer, STREAM_SAMPLES);
+  mcp4725_Stream_Start(&mcp4725_stream);
+#elif SIGNAL_STREAMING == 2
+  stream_dma_init();
+  mcp4725_Stream_Init_Wave(&mcp4725_stream, &mcp4725_dev, &hdma_i2c1_tx, &signal_wave);
+  mcp4725_Stream_Start(&mcp4725_stream);
+#elif SIGNAL_STREAMING == 1
+  stream_dma_init();
+  stream_fill(stream_buffer, STREAM_SAMPLES);
+  mcp4725_Stream_Init(&mcp4725_stream, &mcp4725_dev, &hdma_i2c1_tx, stream_buffer, STREAM_SAMPLES);
+  mcp4725_Stream_Start(&mcp4725_stream);
+#else
+  /* TIM2 period from the planner, the rate is rejected if the bus can not sustain it */
+  mcp4725_Plan_Init(&mcp4725_plan, hi2c1.Init.ClockSpeed, MCP4725_PLAN_SINGLE, 1);
+  if( mcp4725_Plan_Config_Timer(&mcp4725_plan, &htim2, SAMPLE_RATE) == HAL_OK ){
+	  HAL_TIM_Base_Start_IT(&htim2);
+  }
+#endif
 
   while (1)
   {
@@ -291,13 +361,87 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
 	static uint16_t cnt = 0;
 
-	mcp4725_Write_DAC_Register(&mcp4725_dev, signal[cnt]);
+	/* Only starts the transfer, the I2C1 IRQ sends the 2 bytes. Overruns are counted in mcp4725_plan */
+	if( mcp4725_Plan_Check(&mcp4725_plan, &mcp4725_dev) ){
+		mcp4725_Write_DAC_Register_Async(&mcp4725_dev, signal[cnt]);
+	}
 
 	cnt++;
 	if( cnt == signal_len)	cnt = 0;
 
 }
 
+void HAL_SYSTICK_Callback(void)
+{
+	mcp4725_EEPROM_Poll(&mcp4725_dev);
+}
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+	mcp4725_I2C_CpltCallback(hi2c);
+}
+
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+	mcp4725_I2C_CpltCallback(hi2c);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+	mcp4725_I2C_ErrorCallback(hi2c);
+}
+
+/* Refill the half of the stream buffer that was just sent */
+void mcp4725_Stream_HalfCpltCallback(MCP4725_Stream_Handle_t* stream, uint8_t* half, uint16_t num_samples)
+{
+	stream_fill(half, num_samples);
+}
+
+void mcp4725_Stream_CpltCallback(MCP4725_Stream_Handle_t* stream, uint8_t* half, uint16_t num_samples)
+{
+	stream_fill(half, num_samples);
+}
+
+static void stream_fill(uint8_t* dest, uint16_t num_samples)
+{
+#if SIGNAL_STREAMING == 3
+	mcp4725_DDS_Generate(&dds, dest, num_samples);
+#else
+	/* The words are already encoded, only copied */
+	for( uint16_t idx = 0; idx < num_samples; idx++ ){
+		memcpy(&dest[ idx * MCP4725_STREAM_BYTES_PER_SAMPLE ], &signal_words[ stream_idx * MCP4725_STREAM_BYTES_PER_SAMPLE ], MCP4725_STREAM_BYTES_PER_SAMPLE);
+		stream_idx++;
+		if( stream_idx == signal_len )	stream_idx = 0;
+	}
+#endif
+}
+
+/* I2C1_TX: DMA1 Stream 6 Channel 1, circular, owned by the stream. It is not linked to hi2c1 (hdmatx):
+   the asynchronous functions of this example run in Interrupt Mode. For MCP4725_XFER_DMA use another
+   channel in Normal Mode for HAL_I2C_Master_Transmit_DMA. */
+static void stream_dma_init(void)
+{
+	__HAL_RCC_DMA1_CLK_ENABLE();
+
+	hdma_i2c1_tx.Instance = DMA1_Stream6;
+	hdma_i2c1_tx.Init.Channel = DMA_CHANNEL_1;
+	hdma_i2c1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	hdma_i2c1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_i2c1_tx.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_i2c1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	hdma_i2c1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	hdma_i2c1_tx.Init.Mode = DMA_CIRCULAR;
+	hdma_i2c1_tx.Init.Priority = DMA_PRIORITY_HIGH;
+	hdma_i2c1_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	if (HAL_DMA_Init(&hdma_i2c1_tx) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 1, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+}
+
 /* USER CODE END 4 */
 
 /**
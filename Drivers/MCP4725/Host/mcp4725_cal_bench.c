@@ -0,0 +1,111 @@
+/*
+ * mcp4725_cal_bench.c
+ *
+ *  Linearity calibration of the MCP4725 driver on the simulated bus. mcp4725_Cal_Measure_uV is
+ *  implemented with a transfer curve of the output: the code of the model DAC register, an offset, a
+ *  gain error and an INL bow (a parabola, zero at both ends, its peak at mid-scale):
+ *
+ *  	VOUT = offset + ( 1 + gain ) * code * VDD / 4096 + bow * 4 * x * ( 1 - x ) * VDD / 4096,  x = code / 4096
+ *
+ *  The bench prints the largest error before and after the correction, the largest error of all the
+ *  4096 corrected codes, and checks that a write failure stops the calibration (device removed from the bus).
+ *
+ *  gcc -DSTM32F401xC -I. -I.. -O2 -o mcp4725_cal_bench mcp4725_cal_bench.c mcp4725_host.c mcp4725_model.c ../mcp4725.c ../mcp4725_cal.c
+ *  ./mcp4725_cal_bench [offset_uV] [gain_ppm] [bow_mLSB]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mcp4725_host.h"
+#include "mcp4725.h"
+#include "mcp4725_cal.h"
+
+#define BENCH_ADDR			0x60
+#define BENCH_VDD_MV		3300
+
+static I2C_HandleTypeDef hi2c1;
+static struct mcp4725_host_bus bus1;
+static MCP4725_Model_t model;
+static MCP4725_Handle_t mcp4725_dev;
+static MCP4725_Cal_t cal;
+static MCP4725_Cal_Table_t table;
+
+/* Transfer curve of the output */
+static double offset_uv = 4000.0;
+static double gain = -0.008;
+static double bow_lsb = 2.0;
+
+static double bench_output_uv(uint16_t dac_data){
+
+	double lsb_uv = BENCH_VDD_MV * 1000.0 / 4096.0;
+	double x = dac_data / 4096.0;
+
+	return offset_uv + ( 1.0 + gain ) * dac_data * lsb_uv + bow_lsb * 4.0 * x * ( 1.0 - x ) * lsb_uv;
+}
+
+/* Meter on VOUT, reads the model */
+uint32_t mcp4725_Cal_Measure_uV(MCP4725_Cal_t* cal){
+	UNUSED(cal);
+
+	double output = bench_output_uv(model.dac_register);
+
+	return ( output < 0 ) ? 0 : (uint32_t) ( output + 0.5 );
+}
+
+int main(int argc, char* argv[]){
+
+	if( argc > 1 )	offset_uv = atof(argv[1]);
+	if( argc > 2 )	gain = atof(argv[2]) / 1e6;
+	if( argc > 3 )	bow_lsb = atof(argv[3]) / 1e3;
+
+	double lsb_uv = BENCH_VDD_MV * 1000.0 / 4096.0;
+
+	mcp4725_Host_Init(&hi2c1, &bus1, 400000);
+	mcp4725_Model_Init(&model, BENCH_ADDR, 0, 0);
+	mcp4725_Host_Attach(&hi2c1, &model);
+
+	if( mcp4725_Init(&mcp4725_dev, &hi2c1, BENCH_ADDR, 0, MCP4725_NORMAL_MODE) != HAL_OK ){
+		printf("init failed\n");
+		return 1;
+	}
+
+	printf("model: offset %.1f mV, gain %+.2f %%, INL bow %.2f LSB, VDD %u mV (1 LSB = %.1f uV)\n",
+			offset_uv / 1e3, gain * 100.0, bow_lsb, BENCH_VDD_MV, lsb_uv);
+
+	mcp4725_Cal_Init(&cal, &mcp4725_dev, BENCH_VDD_MV, BENCH_VDD_MV);
+	uint64_t start = mcp4725_Host_Time_ns();
+	HAL_StatusTypeDef status = mcp4725_Cal_Run(&cal, &table);
+	uint64_t elapsed = mcp4725_Host_Time_ns() - start;
+
+	if( status != HAL_OK || mcp4725_Cal_Valid(&table) == 0 ){
+		printf("calibration failed\n");
+		return 1;
+	}
+
+	/* All the codes, the outputs below the offset and above the full scale are not reachable */
+	double worst = 0;
+	uint32_t reachable = 0;
+	for( uint16_t dac_data = 0; dac_data < 4096; dac_data++ ){
+
+		double ideal = dac_data * lsb_uv;
+		if( ideal < bench_output_uv(0) || ideal > bench_output_uv(4095) ){
+			continue;
+		}
+
+		double error = bench_output_uv(mcp4725_Cal_Correct(&table, dac_data)) - ideal;
+		if( error < 0 )		error = -error;
+		if( error > worst )	worst = error;
+		reachable++;
+	}
+
+	printf("calibration: %.1f ms, error at the breakpoints %.2f mV, at the middle of the segments %.2f mV (%.2f LSB)\n",
+			elapsed / 1e6, cal.error_before_uv / 1e3, cal.error_after_uv / 1e3, cal.error_after_uv / lsb_uv);
+	printf("all codes: %lu reachable, largest error %.2f mV (%.2f LSB)\n", (unsigned long) reachable, worst / 1e3, worst / lsb_uv);
+
+	/* Device removed from the bus: the first write fails */
+	mcp4725_Host_Init(&hi2c1, &bus1, 400000);
+	status = mcp4725_Cal_Run(&cal, &table);
+	printf("device removed: %s\n", ( status == HAL_ERROR ) ? "HAL_ERROR, ok" : "not detected");
+
+	return ( status == HAL_ERROR ) ? 0 : 1;
+}
@@ -0,0 +1,412 @@
+/*
+ * mcp4725_host.c
+ *
+ *  Simulated I2C bus, HAL_I2C functions of the host stand-in HAL.
+ *
+ *  A transaction is given to the models when it starts: the address byte at the START, the data bytes
+ *  and the STOP condition at the end time of the transaction. The asynchronous transfers keep the bus
+ *  busy until the virtual time reaches their end, then the HAL callbacks are called.
+ */
+
+#include "mcp4725_host.h"
+
+#define HOST_NS_PER_S			1000000000ULL
+#define HOST_NS_PER_MS			1000000ULL
+#define HOST_SCL_PER_BYTE		9U		/* 8 bits and ACK */
+#define HOST_SCL_START_STOP		2U
+#define HOST_SCL_HS_PREAMBLE	10U		/* START, master code and NACK at 400 kHz */
+
+typedef enum{
+	HOST_XFER_BLOCKING = 0,
+	HOST_XFER_IT,
+	HOST_XFER_DMA,
+	HOST_XFER_STREAM		/* Returns at the end, as the blocking transfers, with the CPU time of the DMA */
+}HOST_Xfer_e;
+
+/* Virtual time, shared by all the buses */
+static uint64_t now_ns = 0;
+
+/* Core registers of the stand-in HAL */
+DWT_Type host_dwt = {0};
+CoreDebug_Type host_coredebug = {0};
+uint32_t SystemCoreClock = 84000000U;
+
+static I2C_TypeDef* buses[MCP4725_HOST_MAX_BUSES] = {0};
+
+static HAL_StatusTypeDef mcp4725_host_xfer(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t read, uint8_t* pData, uint32_t Size, HOST_Xfer_e mode);
+static HAL_StatusTypeDef mcp4725_host_seq(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t read, uint8_t* pData, uint32_t Size, HOST_Xfer_e mode, uint32_t XferOptions);
+static uint64_t mcp4725_host_bus_free_ns(uint32_t bus_clock);
+static void mcp4725_host_complete(I2C_TypeDef* bus);
+
+/**
+  * @brief  Link the I2C handle to a simulated bus, with no devices.
+  * @param  bus Simulated bus, it becomes hi2c->Instance.
+  * @param  bus_clock SCL frequency in Hz, above 1 MHz the transactions use the High Speed mode.
+  * @retval HAL_OK, HAL_ERROR if there are MCP4725_HOST_MAX_BUSES buses.
+  */
+HAL_StatusTypeDef mcp4725_Host_Init(I2C_HandleTypeDef* hi2c, I2C_TypeDef* bus, uint32_t bus_clock){
+
+	*bus = (struct mcp4725_host_bus){0};
+	bus->hi2c = hi2c;
+
+	hi2c->Instance = bus;
+	hi2c->Init.ClockSpeed = bus_clock;
+	hi2c->State = HAL_I2C_STATE_READY;
+	hi2c->Mode = HAL_I2C_MODE_NONE;
+	hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+
+	for( uint8_t idx = 0; idx < MCP4725_HOST_MAX_BUSES; idx++ ){
+		if( buses[idx] == NULL || buses[idx] == bus ){
+			buses[idx] = bus;
+			return HAL_OK;
+		}
+	}
+
+	return HAL_ERROR;
+}
+
+/**
+  * @brief  Connect a model to the bus, initialized by mcp4725_Model_Init.
+  * @retval HAL_OK, HAL_ERROR if there are MCP4725_HOST_MAX_MODELS models.
+  */
+HAL_StatusTypeDef mcp4725_Host_Attach(I2C_HandleTypeDef* hi2c, MCP4725_Model_t* model){
+
+	I2C_TypeDef* bus = hi2c->Instance;
+
+	if( bus->num_models == MCP4725_HOST_MAX_MODELS ){
+		return HAL_ERROR;
+	}
+
+	bus->models[bus->num_models++] = model;
+	return HAL_OK;
+}
+
+/**
+  * @brief  Virtual time since the start of the program.
+  * @retval Time in ns.
+  */
+uint64_t mcp4725_Host_Time_ns(void){
+	return now_ns;
+}
+
+/**
+  * @brief  Move the virtual time forward, the asynchronous transfers that end in the interval call their callbacks in order.
+  * @note	The callbacks can start new transfers, they start at the end of the previous one.
+  * @param  ns Interval in ns.
+  * @retval None
+  */
+void mcp4725_Host_Advance(uint64_t ns){
+
+	uint64_t target = now_ns + ns;
+
+	for(;;){
+
+		I2C_TypeDef* next = NULL;
+
+		for( uint8_t idx = 0; idx < MCP4725_HOST_MAX_BUSES; idx++ ){
+			I2C_TypeDef* bus = buses[idx];
+			if( bus != NULL && bus->pending && bus->end_ns <= target && ( next == NULL || bus->end_ns < next->end_ns ) ){
+				next = bus;
+			}
+		}
+
+		if( next == NULL )	break;
+
+		/* A blocking transfer in a callback may have moved the time past the end */
+		if( next->end_ns > now_ns )	now_ns = next->end_ns;
+		mcp4725_host_complete(next);
+	}
+
+	if( target > now_ns )	now_ns = target;
+}
+
+/**
+  * @brief  Move the virtual time to the end of the asynchronous transfers, until no transfer is in progress.
+  * @note	The transfers started by the callbacks are run too.
+  * @retval None
+  */
+void mcp4725_Host_Run(void){
+
+	for(;;){
+
+		I2C_TypeDef* next = NULL;
+
+		for( uint8_t idx = 0; idx < MCP4725_HOST_MAX_BUSES; idx++ ){
+			I2C_TypeDef* bus = buses[idx];
+			if( bus != NULL && bus->pending && ( next == NULL || bus->end_ns < next->end_ns ) ){
+				next = bus;
+			}
+		}
+
+		if( next == NULL )	return;
+
+		mcp4725_Host_Advance( ( next->end_ns > now_ns ) ? ( next->end_ns - now_ns ) : 0 );
+	}
+}
+
+/**
+  * @brief  Send the Fast Mode words in one write transaction, as the streaming mode (mcp4725_stream.c) does.
+  * @note	The call returns at the end of the transaction, the CPU time is the start and the stop of the stream.
+  * @param  DevAddress 7-bit address shifted left, as for the HAL functions.
+  * @param  words 2 bytes per sample, encoded by mcp4725_Wave_Encode.
+  * @retval HAL_OK, HAL_BUSY if the bus is in use, HAL_ERROR if the device does not acknowledge.
+  */
+HAL_StatusTypeDef mcp4725_Host_Stream(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, const uint8_t* words, uint32_t num_samples){
+	return mcp4725_host_xfer(hi2c, DevAddress, 0, (uint8_t*) words, num_samples * 2, HOST_XFER_STREAM);
+}
+
+/**
+  * @brief  Bus time of a transaction, from the START to the next START.
+  * @param  num_bytes Bytes of the transaction, address included.
+  * @retval Time in ns.
+  */
+uint64_t mcp4725_Host_Transaction_ns(uint32_t bus_clock, uint32_t num_bytes){
+
+	uint64_t scl = HOST_SCL_START_STOP + (uint64_t) HOST_SCL_PER_BYTE * num_bytes;
+	uint64_t ns = ( scl * HOST_NS_PER_S ) / bus_clock;
+
+	if( bus_clock > MCP4725_HOST_HS_THRESHOLD ){
+		/* Master code in Fast Mode before each High Speed transaction */
+		ns += ( HOST_SCL_HS_PREAMBLE * HOST_NS_PER_S ) / MCP4725_HOST_HS_PREAMBLE_CLK;
+	}
+
+	return ns + mcp4725_host_bus_free_ns(bus_clock);
+}
+
+/**
+  * @brief  Reset the statistics of the bus.
+  * @retval None
+  */
+void mcp4725_Host_Reset_Stats(I2C_HandleTypeDef* hi2c){
+	hi2c->Instance->stats = (MCP4725_Host_Stats_t){0};
+}
+
+/**
+  * @brief  Virtual time in ms.
+  */
+uint32_t HAL_GetTick(void){
+	return (uint32_t) ( now_ns / HOST_NS_PER_MS );
+}
+
+/**
+  * @brief  Move the virtual time forward, the asynchronous transfers end in the meantime.
+  */
+void HAL_Delay(uint32_t Delay){
+	mcp4725_Host_Advance( (uint64_t) Delay * HOST_NS_PER_MS );
+}
+
+/**
+  * @brief  Send the address until a device acknowledges it.
+  */
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout){
+
+	UNUSED(Timeout);
+
+	for( uint32_t trial = 0; trial < Trials; trial++ ){
+		HAL_StatusTypeDef status = mcp4725_host_xfer(hi2c, DevAddress, 0, NULL, 0, HOST_XFER_BLOCKING);
+		if( status != HAL_ERROR ){
+			return status;
+		}
+	}
+
+	return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout){
+	UNUSED(Timeout);
+	return mcp4725_host_xfer(hi2c, DevAddress, 0, pData, Size, HOST_XFER_BLOCKING);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout){
+	UNUSED(Timeout);
+	return mcp4725_host_xfer(hi2c, DevAddress, 1, pData, Size, HOST_XFER_BLOCKING);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size){
+	return mcp4725_host_xfer(hi2c, DevAddress, 0, pData, Size, HOST_XFER_IT);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size){
+	return mcp4725_host_xfer(hi2c, DevAddress, 1, pData, Size, HOST_XFER_IT);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size){
+	return mcp4725_host_xfer(hi2c, DevAddress, 0, pData, Size, HOST_XFER_DMA);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size){
+	return mcp4725_host_xfer(hi2c, DevAddress, 1, pData, Size, HOST_XFER_DMA);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t XferOptions){
+	return mcp4725_host_seq(hi2c, DevAddress, 0, pData, Size, HOST_XFER_IT, XferOptions);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t XferOptions){
+	return mcp4725_host_seq(hi2c, DevAddress, 1, pData, Size, HOST_XFER_IT, XferOptions);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t XferOptions){
+	return mcp4725_host_seq(hi2c, DevAddress, 0, pData, Size, HOST_XFER_DMA, XferOptions);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t XferOptions){
+	return mcp4725_host_seq(hi2c, DevAddress, 1, pData, Size, HOST_XFER_DMA, XferOptions);
+}
+
+__weak void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c){
+	UNUSED(hi2c);
+}
+
+__weak void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c){
+	UNUSED(hi2c);
+}
+
+__weak void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c){
+	UNUSED(hi2c);
+}
+
+/**
+  * @brief  Run a transaction on the models of the bus and account its time.
+  * @note	The blocking transfers move the virtual time to their end, the asynchronous ones keep the bus
+  * 		busy until mcp4725_Host_Advance reaches it.
+  * @retval HAL_OK, HAL_BUSY if a transfer is in progress, HAL_ERROR if the address is not acknowledged
+  * 		(blocking transfers, the asynchronous ones report it with HAL_I2C_ErrorCallback).
+  */
+static HAL_StatusTypeDef mcp4725_host_xfer(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t read, uint8_t* pData, uint32_t Size, HOST_Xfer_e mode){
+
+	I2C_TypeDef* bus = hi2c->Instance;
+
+	if( bus->pending || hi2c->State != HAL_I2C_STATE_READY ){
+		return HAL_BUSY;
+	}
+
+	uint8_t address = (uint8_t) ( ( DevAddress & 0xFE ) | read );
+	uint8_t acked[MCP4725_HOST_MAX_MODELS] = {0};
+	MCP4725_Model_t* source = NULL;
+	uint8_t ack = 0;
+
+	for( uint8_t idx = 0; idx < bus->num_models; idx++ ){
+		acked[idx] = mcp4725_Model_Address(bus->models[idx], address, now_ns);
+		if( acked[idx] ){
+			ack = 1;
+			if( source == NULL )	source = bus->models[idx];
+		}
+	}
+
+	uint32_t num_bytes = ack ? Size + 1 : 1;
+	uint64_t duration = mcp4725_Host_Transaction_ns(hi2c->Init.ClockSpeed, num_bytes);
+	uint8_t stop = ( ack == 0 || bus->no_stop == 0 );
+
+	/* Sequential frame with no STOP: no STOP condition and no bus free time before the repeated START */
+	if( stop == 0 ){
+		duration -= HOST_NS_PER_S / hi2c->Init.ClockSpeed + mcp4725_host_bus_free_ns(hi2c->Init.ClockSpeed);
+	}
+
+	uint64_t end = now_ns + duration;
+
+	/* The models see the data and the STOP condition at the end of the transaction */
+	if( ack ){
+		for( uint32_t byte = 0; byte < Size; byte++ ){
+			if( read ){
+				pData[byte] = mcp4725_Model_Read_Byte(source, end);
+			}else{
+				for( uint8_t idx = 0; idx < bus->num_models; idx++ ){
+					if( acked[idx] )	mcp4725_Model_Write_Byte(bus->models[idx], pData[byte], end);
+				}
+			}
+		}
+		for( uint8_t idx = 0; idx < bus->num_models && stop; idx++ ){
+			if( acked[idx] )	mcp4725_Model_Stop(bus->models[idx], end);
+		}
+	}
+
+	bus->stats.transactions++;
+	bus->stats.bytes += num_bytes;
+	bus->stats.bus_ns += duration;
+	if( ack == 0 )	bus->stats.nacks++;
+
+	hi2c->State = read ? HAL_I2C_STATE_BUSY_RX : HAL_I2C_STATE_BUSY_TX;
+	hi2c->Mode = HAL_I2C_MODE_MASTER;
+	hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+
+	if( mode == HOST_XFER_BLOCKING || mode == HOST_XFER_STREAM ){
+
+		/* Streaming: the start and the stop of the transaction */
+		bus->stats.cpu_ns += ( mode == HOST_XFER_BLOCKING ) ? duration : 2 * MCP4725_HOST_IRQ_NS;
+
+		/* The transfers of the other buses end in the meantime */
+		mcp4725_Host_Advance(duration);
+
+		hi2c->State = HAL_I2C_STATE_READY;
+		hi2c->Mode = HAL_I2C_MODE_NONE;
+
+		if( ack == 0 ){
+			hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+			return HAL_ERROR;
+		}
+
+		return HAL_OK;
+	}
+
+	/* IT Mode: one IRQ per byte and the STOP; DMA Mode: the end of the DMA */
+	bus->stats.cpu_ns += ( mode == HOST_XFER_IT ) ? (uint64_t) MCP4725_HOST_IRQ_NS * ( num_bytes + 1 ) : MCP4725_HOST_IRQ_NS;
+
+	bus->pending = 1;
+	bus->pending_rx = read;
+	bus->pending_nack = ( ack == 0 );
+	bus->end_ns = end;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Sequential transfer, the frames that are not the last ones end with no STOP condition.
+  * @note	A NACK ends the sequence with a STOP, as the HAL does.
+  */
+static HAL_StatusTypeDef mcp4725_host_seq(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t read, uint8_t* pData, uint32_t Size, HOST_Xfer_e mode, uint32_t XferOptions){
+
+	I2C_TypeDef* bus = hi2c->Instance;
+
+	bus->no_stop = ( XferOptions != I2C_FIRST_AND_LAST_FRAME && XferOptions != I2C_LAST_FRAME && XferOptions != I2C_OTHER_AND_LAST_FRAME );
+
+	HAL_StatusTypeDef status = mcp4725_host_xfer(hi2c, DevAddress, read, pData, Size, mode);
+
+	bus->no_stop = 0;
+
+	return status;
+}
+
+/**
+  * @brief  Bus free time between a STOP and the next START (I2C specification, tBUF).
+  */
+static uint64_t mcp4725_host_bus_free_ns(uint32_t bus_clock){
+
+	if( bus_clock <= 100000U )	return 4700;
+	if( bus_clock <= 400000U )	return 1300;
+	if( bus_clock <= MCP4725_HOST_HS_THRESHOLD )	return 500;
+
+	return 1300;	/* The bus is back in Fast Mode after the STOP of a High Speed transaction */
+}
+
+/**
+  * @brief  End of the asynchronous transfer of the bus, release it and call the HAL callback.
+  */
+static void mcp4725_host_complete(I2C_TypeDef* bus){
+
+	I2C_HandleTypeDef* hi2c = bus->hi2c;
+
+	bus->pending = 0;
+	hi2c->State = HAL_I2C_STATE_READY;
+	hi2c->Mode = HAL_I2C_MODE_NONE;
+
+	if( bus->pending_nack ){
+		hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+		HAL_I2C_ErrorCallback(hi2c);
+	}else if( bus->pending_rx ){
+		HAL_I2C_MasterRxCpltCallback(hi2c);
+	}else{
+		HAL_I2C_MasterTxCpltCallback(hi2c);
+	}
+
+}
@@ -0,0 +1,84 @@
+/*
+ * mcp4725_host.h
+ *
+ *  Simulated I2C bus for host builds of the MCP4725 driver. It implements the HAL_I2C functions of the
+ *  stand-in stm32f4xx_hal.h on a virtual clock: each transaction takes the bus time of its bits at the
+ *  SCL frequency and the bytes are given to the MCP4725 models attached to the bus.
+ *
+ *  Bus time of a transaction of n bytes (address included): 9 SCL periods per byte (8 bits and ACK),
+ *  START and STOP, plus the bus free time before the next START (4.7 us at 100 kHz, 1.3 us at 400 kHz).
+ *  In High Speed mode (SCL above 1 MHz) each transaction is preceded by the master code, sent at
+ *  400 kHz (START, 8 bits, NACK), and a repeated START.
+ *
+ *  CPU time: the blocking functions hold the CPU for the whole transaction, the IT functions cost one
+ *  IRQ per byte and the DMA functions one IRQ at the end (MCP4725_HOST_IRQ_NS each).
+ *
+ *  The asynchronous transfers end when the virtual time reaches them: mcp4725_Host_Advance or HAL_Delay
+ *  call the HAL callbacks at that point, as the I2C IRQ would.
+ *
+ *  Sequential transfers (HAL_I2C_Master_Seq_xxx): the frames that are not the last one end with no STOP
+ *  condition and no bus free time, the next frame starts with a repeated START.
+ */
+
+#ifndef MCP4725_HOST_MCP4725_HOST_H_
+#define MCP4725_HOST_MCP4725_HOST_H_
+
+#include "stm32f4xx_hal.h"
+#include "mcp4725_model.h"
+
+#ifndef MCP4725_HOST_MAX_MODELS
+#define MCP4725_HOST_MAX_MODELS		8		/* Devices on each bus, addresses 0x60 to 0x67 */
+#endif
+
+#ifndef MCP4725_HOST_MAX_BUSES
+#define MCP4725_HOST_MAX_BUSES		3		/* Simulated I2C peripherals */
+#endif
+
+#ifndef MCP4725_HOST_IRQ_NS
+#define MCP4725_HOST_IRQ_NS			2000	/* CPU time of an I2C IRQ with the HAL handler */
+#endif
+
+#define MCP4725_HOST_HS_THRESHOLD	1000000U	/* SCL frequency of the High Speed mode */
+#define MCP4725_HOST_HS_PREAMBLE_CLK	400000U	/* SCL frequency of the master code */
+
+/* Transfer statistics */
+
+typedef struct mcp4725_host_stats{
+	uint32_t				transactions;		/* START to STOP, NACKs included */
+	uint32_t				nacks;				/* Transactions not acknowledged */
+	uint32_t				bytes;				/* Bytes transferred, address included */
+	uint64_t				bus_ns;				/* Time the bus was busy */
+	uint64_t				cpu_ns;				/* CPU time spent in the transfers */
+}MCP4725_Host_Stats_t;
+
+/* Simulated Bus Structure, the Instance of the I2C handle */
+
+struct mcp4725_host_bus{
+	I2C_HandleTypeDef *		hi2c;				/* Handle of the bus, for the callbacks */
+	MCP4725_Model_t *		models[MCP4725_HOST_MAX_MODELS];
+	uint8_t					num_models;
+	uint8_t					pending;			/* 1 while an asynchronous transfer is in progress */
+	uint8_t					pending_rx;			/* Direction of the transfer in progress */
+	uint8_t					pending_nack;		/* The transfer in progress ends with a NACK */
+	uint8_t					no_stop;			/* The frame started ends with no STOP, the next one starts with a repeated START */
+	uint64_t				end_ns;				/* End of the transfer in progress */
+	MCP4725_Host_Stats_t	stats;
+};
+
+/* Setup of the simulated buses */
+HAL_StatusTypeDef mcp4725_Host_Init(I2C_HandleTypeDef* hi2c, I2C_TypeDef* bus, uint32_t bus_clock);
+HAL_StatusTypeDef mcp4725_Host_Attach(I2C_HandleTypeDef* hi2c, MCP4725_Model_t* model);
+
+/* Virtual time */
+uint64_t mcp4725_Host_Time_ns(void);
+void mcp4725_Host_Advance(uint64_t ns);
+void mcp4725_Host_Run(void);
+
+/* Streaming mode, one write transaction with the Fast Mode words (as the circular DMA sends them) */
+HAL_StatusTypeDef mcp4725_Host_Stream(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, const uint8_t* words, uint32_t num_samples);
+
+/* Statistics */
+uint64_t mcp4725_Host_Transaction_ns(uint32_t bus_clock, uint32_t num_bytes);
+void mcp4725_Host_Reset_Stats(I2C_HandleTypeDef* hi2c);
+
+#endif /* MCP4725_HOST_MCP4725_HOST_H_ */
@@ -0,0 +1,224 @@
+/*
+ * mcp4725_host_bench.c
+ *
+ *  Throughput of the transfer modes of the MCP4725 driver on the simulated bus, at 100 kHz, 400 kHz
+ *  and 3.4 MHz: blocking, Interrupt and DMA Mode (one transaction per sample) and the streaming mode
+ *  (one transaction for all the samples). Also the time of a non-blocking EEPROM commit and the boot of
+ *  8 devices, one mcp4725_Init each against one group update (general call and chained reads) and the
+ *  fast init (bus scan, EEPROM read on the first access).
+ *
+ *  gcc -DSTM32F401xC -I. -I.. -O2 -o mcp4725_host_bench mcp4725_host_bench.c mcp4725_host.c mcp4725_model.c ../mcp4725.c ../mcp4725_wave.c ../mcp4725_group.c -lm
+ */
+
+#include <stdio.h>
+#include "mcp4725_host.h"
+#include "mcp4725.h"
+#include "mcp4725_wave.h"
+#include "mcp4725_group.h"
+
+#define BENCH_SAMPLES		1000
+#define BENCH_ADDR			0x60
+#define BENCH_BOOT_DEVICES	8			/* Addresses 0x60 to 0x67 */
+
+static I2C_HandleTypeDef hi2c1;
+static struct mcp4725_host_bus bus1;
+static MCP4725_Model_t model;
+static MCP4725_Handle_t mcp4725_dev;
+
+static MCP4725_Model_t boot_models[BENCH_BOOT_DEVICES];
+static MCP4725_Handle_t boot_devs[BENCH_BOOT_DEVICES];
+static MCP4725_Handle_t scan_devs[MCP4725_GROUP_MAX_DEVICES];
+static MCP4725_Group_t group;
+
+static uint16_t samples[BENCH_SAMPLES];
+static uint8_t words[ MCP4725_WAVE_BYTES(BENCH_SAMPLES) ];
+static uint32_t remaining;
+
+/* Route the HAL callbacks as in the target project */
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c){
+	mcp4725_I2C_CpltCallback(hi2c);
+	mcp4725_Group_I2C_CpltCallback(hi2c);
+}
+
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c){
+	mcp4725_I2C_CpltCallback(hi2c);
+	mcp4725_Group_I2C_CpltCallback(hi2c);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c){
+	mcp4725_I2C_ErrorCallback(hi2c);
+	mcp4725_Group_I2C_ErrorCallback(hi2c);
+}
+
+/* Next sample from the end of the previous one */
+void mcp4725_TxCpltCallback(MCP4725_Handle_t* mcp4725_dev){
+	if( remaining ){
+		remaining--;
+		mcp4725_Write_DAC_Register_Async(mcp4725_dev, remaining & 0xFFF);
+	}
+}
+
+static void bench_report(const char* mode, uint32_t clock, uint64_t start){
+
+	uint64_t elapsed = mcp4725_Host_Time_ns() - start;
+	MCP4725_Host_Stats_t* stats = &hi2c1.Instance->stats;
+
+	printf("%-9s %8lu Hz %10.1f S/s %6.1f us/sample %5.1f %% CPU   %s\n", mode, (unsigned long) clock,
+			( BENCH_SAMPLES * 1e9 ) / elapsed, ( elapsed / 1e3 ) / BENCH_SAMPLES, ( stats->cpu_ns * 100.0 ) / elapsed,
+			( model.dac_register == 0 ) ? "ok" : "model mismatch");
+}
+
+static void bench_single(const char* mode, uint32_t clock, MCP4725_Xfer_e xfer_mode, uint8_t blocking){
+
+	mcp4725_Write_DAC_Register(&mcp4725_dev, 4095);
+	mcp4725_Host_Reset_Stats(&hi2c1);
+	mcp4725_dev.xfer_mode = xfer_mode;
+
+	uint64_t start = mcp4725_Host_Time_ns();
+
+	if( blocking ){
+		for( int32_t sample = BENCH_SAMPLES - 1; sample >= 0; sample-- ){
+			mcp4725_Write_DAC_Register(&mcp4725_dev, sample & 0xFFF);
+		}
+	}else{
+		remaining = BENCH_SAMPLES - 1;
+		mcp4725_Write_DAC_Register_Async(&mcp4725_dev, remaining & 0xFFF);
+		mcp4725_Host_Run();
+	}
+
+	bench_report(mode, clock, start);
+}
+
+static void bench_stream(uint32_t clock){
+
+	/* Descending ramp, the last sample is 0 */
+	for( uint32_t sample = 0; sample < BENCH_SAMPLES; sample++ ){
+		samples[sample] = ( BENCH_SAMPLES - 1 - sample ) & 0xFFF;
+	}
+	mcp4725_Wave_Encode(words, samples, BENCH_SAMPLES, MCP4725_NORMAL_MODE);
+
+	mcp4725_Write_DAC_Register(&mcp4725_dev, 4095);
+	mcp4725_Host_Reset_Stats(&hi2c1);
+
+	uint64_t start = mcp4725_Host_Time_ns();
+	mcp4725_Host_Stream(&hi2c1, BENCH_ADDR << 1, words, BENCH_SAMPLES);
+
+	bench_report("stream", clock, start);
+}
+
+static void bench_eeprom(void){
+
+	uint64_t start = mcp4725_Host_Time_ns();
+
+	mcp4725_Write_DAC_EEPROM_Commit(&mcp4725_dev, 1234, MCP4725_NORMAL_MODE);
+	while( mcp4725_GetState(&mcp4725_dev) != MCP4725_STATE_READY ){
+		HAL_Delay(1);
+		mcp4725_EEPROM_Poll(&mcp4725_dev);
+	}
+
+	printf("EEPROM commit: %.1f ms, %u status reads, EEPROM %u %s\n", ( mcp4725_Host_Time_ns() - start ) / 1e6,
+			mcp4725_dev.eeprom_polls, model.eeprom_dac, ( model.eeprom_dac == 1234 && mcp4725_dev.eeprom_dac_register == 1234 ) ? "ok" : "model mismatch");
+}
+
+/* Boot of the devices 0x60 to 0x67, the device 0x60 + missing is not on the bus */
+static void bench_boot(uint8_t missing){
+
+	uint8_t ok = 1;
+
+	mcp4725_Host_Init(&hi2c1, &bus1, 400000);
+	for( uint8_t idx = 0; idx < BENCH_BOOT_DEVICES; idx++ ){
+		mcp4725_Model_Init(&boot_models[idx], BENCH_ADDR + idx, 100 * idx, 0);
+		if( idx != missing )	mcp4725_Host_Attach(&hi2c1, &boot_models[idx]);
+	}
+
+	/* One mcp4725_Init per device: probe, Fast Mode write, read */
+	uint64_t start = mcp4725_Host_Time_ns();
+	for( uint8_t idx = 0; idx < BENCH_BOOT_DEVICES; idx++ ){
+		mcp4725_Init(&boot_devs[idx], &hi2c1, BENCH_ADDR + idx, 0, MCP4725_NORMAL_MODE);
+	}
+	uint64_t init_ns = mcp4725_Host_Time_ns() - start;
+	uint64_t init_cpu = hi2c1.Instance->stats.cpu_ns;
+
+	/* Group: general call reset and chained reads in DMA Mode */
+	mcp4725_Host_Reset_Stats(&hi2c1);
+	mcp4725_Group_Init(&group, &hi2c1, MCP4725_XFER_DMA);
+	for( uint8_t idx = 0; idx < BENCH_BOOT_DEVICES; idx++ ){
+		mcp4725_Group_Add(&group, &boot_devs[idx], BENCH_ADDR + idx);
+	}
+
+	start = mcp4725_Host_Time_ns();
+	mcp4725_Group_Reset(&group);
+	mcp4725_Host_Run();
+	uint64_t group_ns = mcp4725_Host_Time_ns() - start;
+
+	for( uint8_t idx = 0; idx < BENCH_BOOT_DEVICES; idx++ ){
+		if( idx == missing ){
+			ok &= ( ( group.present >> idx ) & 1 ) == 0 && boot_devs[idx].cache_stale;
+		}else{
+			ok &= ( ( group.present >> idx ) & 1 ) && boot_devs[idx].dac_register == 100 * idx && boot_devs[idx].cache_stale == 0;
+		}
+	}
+
+	printf("boot %u devices%s: mcp4725_Init %.2f ms (%.2f ms CPU), group reset %.2f ms (%.3f ms CPU) present 0x%02X %s\n",
+			BENCH_BOOT_DEVICES, ( missing < BENCH_BOOT_DEVICES ) ? ", 1 missing" : "", init_ns / 1e6, init_cpu / 1e6,
+			group_ns / 1e6, hi2c1.Instance->stats.cpu_ns / 1e6, group.present, ok ? "ok" : "model mismatch");
+
+	/* Fast init: scan of the 8 addresses from power on, then the EEPROM of one device on the first access */
+	ok = 1;
+	mcp4725_Host_Reset_Stats(&hi2c1);
+	for( uint8_t idx = 0; idx < BENCH_BOOT_DEVICES; idx++ ){
+		mcp4725_Model_Init(&boot_models[idx], BENCH_ADDR + idx, 100 * idx, 0);
+	}
+
+	start = mcp4725_Host_Time_ns();
+	mcp4725_Group_Scan(&group, scan_devs);
+	mcp4725_Host_Run();
+	uint64_t scan_ns = mcp4725_Host_Time_ns() - start;
+	uint64_t scan_cpu = hi2c1.Instance->stats.cpu_ns;
+
+	for( uint8_t idx = 0; idx < BENCH_BOOT_DEVICES; idx++ ){
+		if( idx == missing ){
+			ok &= ( ( group.present >> idx ) & 1 ) == 0 && scan_devs[idx].cache_stale;
+		}else{
+			ok &= ( ( group.present >> idx ) & 1 ) && scan_devs[idx].dac_register == 100 * idx && scan_devs[idx].eeprom_stale;
+		}
+	}
+	ok &= group.result == HAL_OK && group.num_devices == __builtin_popcount(group.present);
+
+	uint16_t eeprom_dac = 0;
+	start = mcp4725_Host_Time_ns();
+	ok &= mcp4725_Get_EEPROM(&scan_devs[1], &eeprom_dac, NULL) == HAL_OK && eeprom_dac == 100 && scan_devs[1].eeprom_stale == 0;
+	uint64_t eeprom_ns = mcp4725_Host_Time_ns() - start;
+
+	printf("boot %u devices%s: scan %.2f ms (%.3f ms CPU) present 0x%02X, first EEPROM access %.3f ms %s\n",
+			BENCH_BOOT_DEVICES, ( missing < BENCH_BOOT_DEVICES ) ? ", 1 missing" : "", scan_ns / 1e6, scan_cpu / 1e6,
+			group.present, eeprom_ns / 1e6, ok ? "ok" : "model mismatch");
+}
+
+int main(void){
+
+	const uint32_t clocks[] = { 100000, 400000, 3400000 };
+
+	for( uint8_t idx = 0; idx < sizeof(clocks) / sizeof(clocks[0]); idx++ ){
+
+		mcp4725_Model_Init(&model, BENCH_ADDR, 2048, 0);
+		mcp4725_Host_Init(&hi2c1, &bus1, clocks[idx]);
+		mcp4725_Host_Attach(&hi2c1, &model);
+
+		if( mcp4725_Init(&mcp4725_dev, &hi2c1, BENCH_ADDR, 0, MCP4725_NORMAL_MODE) != HAL_OK ){
+			printf("mcp4725_Init failed\n");
+			return 1;
+		}
+
+		bench_single("blocking", clocks[idx], MCP4725_XFER_IT, 1);
+		bench_single("IT", clocks[idx], MCP4725_XFER_IT, 0);
+		bench_single("DMA", clocks[idx], MCP4725_XFER_DMA, 0);
+		bench_stream(clocks[idx]);
+	}
+
+	bench_eeprom();
+	bench_boot(BENCH_BOOT_DEVICES);
+	bench_boot(3);
+
+	return 0;
+}
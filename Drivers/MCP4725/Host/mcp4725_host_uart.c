@@ -0,0 +1,217 @@
+/*
+ * mcp4725_host_uart.c
+ *
+ *  UART on a pseudo-terminal, HAL_UART functions of the host stand-in HAL.
+ *
+ *  Both sides are in raw mode (no echo, no line editing, 8-bit bytes). The master side is read with no
+ *  wait, the bytes stay in the pseudo-terminal until the baud rate allows them.
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "mcp4725_host_uart.h"
+
+#define HOST_UART_NS_PER_S		1000000000ULL
+#define HOST_UART_BITS_PER_BYTE	10U		/* START, 8 bits, STOP */
+
+static uint64_t mcp4725_host_uart_now_ns(void);
+static void mcp4725_host_uart_raw(int fd);
+
+/**
+  * @brief  Open a pseudo-terminal and link the UART handle to it.
+  * @param  port Pseudo-terminal, it becomes huart->Instance.
+  * @param  baud_rate Bits per second of the emulated link.
+  * @retval HAL_OK, HAL_ERROR if the pseudo-terminal could not be opened.
+  */
+HAL_StatusTypeDef mcp4725_Host_Uart_Init(UART_HandleTypeDef* huart, USART_TypeDef* port, uint32_t baud_rate){
+
+	memset(port, 0, sizeof(*port));
+
+	port->master = posix_openpt(O_RDWR | O_NOCTTY);
+	if( port->master < 0 || grantpt(port->master) != 0 || unlockpt(port->master) != 0 ){
+		return HAL_ERROR;
+	}
+
+	snprintf(port->name, sizeof(port->name), "%s", ptsname(port->master));
+
+	port->slave = open(port->name, O_RDWR | O_NOCTTY);
+	if( port->slave < 0 ){
+		close(port->master);
+		return HAL_ERROR;
+	}
+
+	mcp4725_host_uart_raw(port->master);
+	mcp4725_host_uart_raw(port->slave);
+	fcntl(port->master, F_SETFL, fcntl(port->master, F_GETFL) | O_NONBLOCK);
+
+	port->huart = huart;
+	port->last_ns = mcp4725_host_uart_now_ns();
+
+	huart->Instance = port;
+	huart->Init.BaudRate = baud_rate;
+	huart->hdmarx = &port->hdmarx;
+	huart->gState = HAL_UART_STATE_READY;
+	huart->RxState = HAL_UART_STATE_READY;
+	huart->ErrorCode = HAL_UART_ERROR_NONE;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Path of the slave side, to open as a serial port.
+  */
+const char* mcp4725_Host_Uart_Name(UART_HandleTypeDef* huart){
+	return huart->Instance->name;
+}
+
+/**
+  * @brief  Close the pseudo-terminal.
+  */
+void mcp4725_Host_Uart_DeInit(UART_HandleTypeDef* huart){
+
+	close(huart->Instance->slave);
+	close(huart->Instance->master);
+	huart->gState = HAL_UART_STATE_RESET;
+	huart->RxState = HAL_UART_STATE_RESET;
+}
+
+/**
+  * @brief  Move the bytes received since the last poll into the RX buffer and call the callbacks.
+  * @note	The RX complete callback is called when the buffer is full, the TX complete callback at the
+  * 		poll that follows the transmission.
+  * @retval None
+  */
+void mcp4725_Host_Uart_Poll(UART_HandleTypeDef* huart){
+
+	USART_TypeDef* port = huart->Instance;
+	uint64_t now = mcp4725_host_uart_now_ns();
+
+	if( port->tx_pending ){
+		port->tx_pending = 0;
+		huart->gState = HAL_UART_STATE_READY;
+		HAL_UART_TxCpltCallback(huart);
+	}
+
+	/* Bytes allowed by the baud rate, one buffer of the pseudo-terminal at most */
+	port->budget += ( now - port->last_ns ) * huart->Init.BaudRate / HOST_UART_BITS_PER_BYTE;
+	port->last_ns = now;
+	if( port->budget > 4096ULL * HOST_UART_NS_PER_S ){
+		port->budget = 4096ULL * HOST_UART_NS_PER_S;
+	}
+
+	while( port->budget >= HOST_UART_NS_PER_S ){
+
+		uint8_t byte;
+		ssize_t len = read(port->master, &byte, 1);
+
+		if( len != 1 ){
+			break;
+		}
+
+		port->budget -= HOST_UART_NS_PER_S;
+
+		if( huart->RxState != HAL_UART_STATE_BUSY_RX ){
+			port->dropped++;
+			continue;
+		}
+
+		huart->pRxBuffPtr[ huart->RxXferSize - port->hdmarx.Counter ] = byte;
+		port->rx_bytes++;
+
+		if( --port->hdmarx.Counter == 0 ){
+			huart->RxState = HAL_UART_STATE_READY;
+			HAL_UART_RxCpltCallback(huart);
+		}
+	}
+
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size){
+
+	if( huart->RxState != HAL_UART_STATE_READY ){
+		return HAL_BUSY;
+	}
+
+	if( pData == NULL || Size == 0 ){
+		return HAL_ERROR;
+	}
+
+	huart->pRxBuffPtr = pData;
+	huart->RxXferSize = Size;
+	huart->hdmarx->Counter = Size;
+	huart->ErrorCode = HAL_UART_ERROR_NONE;
+	huart->RxState = HAL_UART_STATE_BUSY_RX;
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size){
+
+	USART_TypeDef* port = huart->Instance;
+
+	if( huart->gState != HAL_UART_STATE_READY ){
+		return HAL_BUSY;
+	}
+
+	if( write(port->master, pData, Size) != (ssize_t) Size ){
+		huart->ErrorCode = HAL_UART_ERROR_ORE;
+		return HAL_ERROR;
+	}
+
+	port->tx_bytes += Size;
+	port->tx_pending = 1;
+	huart->gState = HAL_UART_STATE_BUSY_TX;
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart){
+
+	huart->RxState = HAL_UART_STATE_READY;
+
+	return HAL_OK;
+}
+
+__weak void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart){
+	UNUSED(huart);
+}
+
+__weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart){
+	UNUSED(huart);
+}
+
+__weak void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart){
+	UNUSED(huart);
+}
+
+/**
+  * @brief  Monotonic time in ns.
+  */
+static uint64_t mcp4725_host_uart_now_ns(void){
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * HOST_UART_NS_PER_S + (uint64_t) ts.tv_nsec;
+}
+
+/**
+  * @brief  Raw mode, the bytes are passed as they are.
+  */
+static void mcp4725_host_uart_raw(int fd){
+
+	struct termios tio;
+
+	if( tcgetattr(fd, &tio) == 0 ){
+		cfmakeraw(&tio);
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+
+}
@@ -0,0 +1,43 @@
+/*
+ * mcp4725_host_uart.h
+ *
+ *  UART of the host builds on a pseudo-terminal. The HAL_UART functions of the stand-in stm32f4xx_hal.h
+ *  read and write the master side, the program that plays the host PC opens the slave side (its path is
+ *  given by mcp4725_Host_Uart_Name) as a serial port.
+ *
+ *  The time is real, not the virtual time of the I2C bus: mcp4725_Host_Uart_Poll moves the bytes that
+ *  arrived into the RX DMA buffer, at BaudRate / 10 bytes per second at most, and calls the HAL callbacks
+ *  as the UART and DMA IRQs would. The bytes received with no reception started are dropped and counted,
+ *  as the overrun of the peripheral.
+ */
+
+#ifndef MCP4725_HOST_MCP4725_HOST_UART_H_
+#define MCP4725_HOST_MCP4725_HOST_UART_H_
+
+#include "stm32f4xx_hal.h"
+
+/* Pseudo-terminal Structure, the Instance of the UART handle */
+
+struct mcp4725_host_uart{
+	UART_HandleTypeDef *	huart;				/* Handle of the UART, for the callbacks */
+	DMA_HandleTypeDef		hdmarx;				/* RX DMA counter */
+	int						master;				/* Master side of the pseudo-terminal */
+	int						slave;				/* Slave side, kept open so the master does not see a hang up */
+	char					name[64];			/* Path of the slave side */
+	uint8_t					tx_pending;			/* 1 until the TX complete callback of the last transmission */
+	uint64_t				last_ns;			/* Time of the last poll */
+	uint64_t				budget;				/* Bytes that the baud rate allows, x 1e9 */
+	uint32_t				rx_bytes;			/* Bytes written in the RX buffers */
+	uint32_t				tx_bytes;
+	uint32_t				dropped;			/* Bytes received with no reception started */
+};
+
+/* Setup */
+HAL_StatusTypeDef mcp4725_Host_Uart_Init(UART_HandleTypeDef* huart, USART_TypeDef* port, uint32_t baud_rate);
+const char* mcp4725_Host_Uart_Name(UART_HandleTypeDef* huart);
+void mcp4725_Host_Uart_DeInit(UART_HandleTypeDef* huart);
+
+/* Transfers and callbacks, call in loop */
+void mcp4725_Host_Uart_Poll(UART_HandleTypeDef* huart);
+
+#endif /* MCP4725_HOST_MCP4725_HOST_UART_H_ */
@@ -0,0 +1,121 @@
+/*
+ * mcp4725_jitter_bench.c
+ *
+ *  Jitter of the IRQ paced writes against the paced stream, on a latency model. The SCL rising edges
+ *  that the input capture of a free running timer would record are generated for both modes and
+ *  measured with mcp4725_Jitter_Capture, as on the target.
+ *
+ *  IRQ paced (one Fast Mode write per sample from the timer IRQ): the START comes after the IRQ entry
+ *  and the HAL handlers, 180 to 300 cycles, and 5 % of the samples wait up to 10 us more for a higher
+ *  priority IRQ or a critical section. The bytes follow back to back (double buffered data register).
+ *  Paced stream (one byte per timer update by DMA): the byte leaves the bus after the DMA request,
+ *  3 to 8 cycles, and the synchronization of the I2C peripheral, up to 2 cycles of PCLK1.
+ *  The latencies are the model, the figures only compare the two modes.
+ *
+ *  gcc -DSTM32F401xC -I. -I.. -O2 -o mcp4725_jitter_bench mcp4725_jitter_bench.c mcp4725_host.c mcp4725_model.c ../mcp4725.c ../mcp4725_jitter.c -lm
+ *  ./mcp4725_jitter_bench [sample_rate] [bus_clock]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mcp4725_host.h"
+#include "mcp4725_jitter.h"
+
+#define BENCH_CLOCK				84000000U	/* Capture timer and CPU clock, TIM2 of the STM32F401 */
+#define BENCH_SAMPLES			2000
+#define BENCH_IRQ_MIN			180			/* Cycles from the timer update to the START */
+#define BENCH_IRQ_MAX			300
+#define BENCH_PREEMPT_PERCENT	5			/* Samples delayed by a higher priority IRQ */
+#define BENCH_PREEMPT_MAX		840			/* Cycles, 10 us */
+#define BENCH_DMA_MIN			3			/* Cycles from the timer update to the data register */
+#define BENCH_DMA_MAX			8
+#define BENCH_SYNC_MAX			4			/* 2 cycles of PCLK1 (42 MHz) */
+
+static uint32_t edges[MCP4725_JITTER_EDGES_ADDR + BENCH_SAMPLES * MCP4725_JITTER_EDGES_SINGLE];
+static uint32_t seed = 2463534242U;
+
+/* xorshift32, the same sequence at each run */
+static uint32_t bench_random(uint32_t min, uint32_t max){
+
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return min + seed % ( max - min + 1U );
+}
+
+/* Rising edges of a byte with its ACK, the first one a SCL period after the release of the bus */
+static uint32_t bench_byte(uint32_t* dest, uint32_t release, uint32_t scl){
+
+	for( uint32_t bit = 0; bit < 9; bit++ ){
+		dest[bit] = release + ( bit + 1U ) * scl;
+	}
+
+	return 9;
+}
+
+static void bench_print(const char* mode, MCP4725_Jitter_t* jitter, uint32_t stamped){
+
+	printf("%-14s %5lu samples, peak %7.3f us, RMS %7.3f us, mean period %8.3f us\n", mode, (unsigned long) stamped,
+			mcp4725_Jitter_Peak_ns(jitter) / 1e3, mcp4725_Jitter_RMS_ns(jitter) / 1e3, mcp4725_Jitter_Mean_Period_ns(jitter) / 1e3);
+}
+
+int main(int argc, char* argv[]){
+
+	uint32_t sample_rate = ( argc > 1 ) ? (uint32_t) atoi(argv[1]) : 10000;
+	uint32_t bus_clock = ( argc > 2 ) ? (uint32_t) atoi(argv[2]) : 400000;
+
+	if( sample_rate == 0 || bus_clock == 0 ){
+		printf("usage: mcp4725_jitter_bench [sample_rate] [bus_clock]\n");
+		return 1;
+	}
+
+	uint32_t scl = BENCH_CLOCK / bus_clock;
+	uint32_t period = BENCH_CLOCK / sample_rate;
+	MCP4725_Jitter_t jitter;
+	uint32_t num_edges;
+	uint32_t stamped;
+
+	/* The paced stream needs an idle gap before each byte */
+	if( period / 2 <= 11U * scl ){
+		printf("sample rate too high for the paced stream: the update period must be longer than 11 SCL periods\n");
+		return 1;
+	}
+
+	printf("model: %lu samples/s, SCL %lu kHz, capture at %lu MHz\n", (unsigned long) sample_rate,
+			(unsigned long) ( bus_clock / 1000 ), (unsigned long) ( BENCH_CLOCK / 1000000 ));
+
+	/* IRQ paced: address, 2 data bytes and the STOP condition per sample */
+	num_edges = 0;
+	for( uint32_t sample = 0; sample < BENCH_SAMPLES; sample++ ){
+
+		uint32_t start = sample * period + bench_random(BENCH_IRQ_MIN, BENCH_IRQ_MAX);
+		if( bench_random(1, 100) <= BENCH_PREEMPT_PERCENT ){
+			start += bench_random(0, BENCH_PREEMPT_MAX);
+		}
+
+		for( uint32_t byte = 0; byte < 3; byte++ ){
+			num_edges += bench_byte(&edges[num_edges], start + byte * 9U * scl, scl);
+		}
+		edges[num_edges] = edges[num_edges - 1] + scl;
+		num_edges++;
+	}
+
+	mcp4725_Jitter_Init(&jitter, BENCH_CLOCK, 0xFFFFFFFFU, sample_rate);
+	stamped = mcp4725_Jitter_Capture(&jitter, edges, num_edges, bus_clock, MCP4725_JITTER_SINGLE);
+	bench_print("IRQ paced:", &jitter, stamped);
+
+	/* Paced stream: the address byte at the open, then one byte per timer update at twice the sample rate */
+	num_edges = bench_byte(edges, 0, scl);
+	for( uint32_t byte = 0; byte < 2U * BENCH_SAMPLES; byte++ ){
+
+		uint32_t release = ( byte + 1U ) * ( period / 2 ) + bench_random(BENCH_DMA_MIN, BENCH_DMA_MAX) + bench_random(0, BENCH_SYNC_MAX);
+		num_edges += bench_byte(&edges[num_edges], release, scl);
+	}
+
+	mcp4725_Jitter_Init(&jitter, BENCH_CLOCK, 0xFFFFFFFFU, sample_rate);
+	stamped = mcp4725_Jitter_Capture(&jitter, edges, num_edges, bus_clock, MCP4725_JITTER_PACED);
+	bench_print("paced stream:", &jitter, stamped);
+
+	return ( stamped == BENCH_SAMPLES ) ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+/*
+ * mcp4725_model.c
+ *
+ *  Byte-accurate model of the MCP4725, the host bus (mcp4725_host.c) gives it the bytes of each
+ *  transaction with the time of the bus.
+ */
+
+#include "mcp4725_model.h"
+
+#define MODEL_GENERAL_CALL_ADDR		0x00
+#define MODEL_GENERAL_CALL_RESET	0x06
+#define MODEL_GENERAL_CALL_WAKEUP	0x09
+
+#define MODEL_CMD_FAST_MODE			0x00	/* C2 C1 of the first byte */
+#define MODEL_CMD_WRITE_DAC			0x02	/* C2 C1 C0 of the first byte */
+#define MODEL_CMD_WRITE_EEPROM		0x03
+
+#define MODEL_READ_BYTES			5
+#define MODEL_RDY_BSY				0x80
+#define MODEL_POR					0x40
+
+static void mcp4725_model_update(MCP4725_Model_t* model, uint64_t now_ns);
+static void mcp4725_model_command(MCP4725_Model_t* model, uint8_t byte);
+
+/**
+  * @brief  Power on the model: the DAC register is loaded from the EEPROM.
+  * @param  dev_addr 7-bit slave address (0x60 + A2 A1 A0).
+  * @param  eeprom_dac 12-bit code stored in the EEPROM.
+  * @param  eeprom_powerdown Power down bits stored in the EEPROM, 0 for normal mode.
+  * @retval None
+  */
+void mcp4725_Model_Init(MCP4725_Model_t* model, uint8_t dev_addr, uint16_t eeprom_dac, uint8_t eeprom_powerdown){
+
+	*model = (MCP4725_Model_t){0};
+
+	model->dev_addr = dev_addr;
+	model->eeprom_dac = eeprom_dac & 0xFFF;
+	model->eeprom_powerdown = eeprom_powerdown & 0x3;
+	model->dac_register = model->eeprom_dac;
+	model->powerdown_mode = model->eeprom_powerdown;
+	model->eeprom_write_ns = MCP4725_MODEL_EEPROM_WRITE_NS;
+
+}
+
+/**
+  * @brief  Address byte after a START or repeated START condition.
+  * @param  address 8-bit address byte, 7-bit address and R/W bit.
+  * @retval 1 if the device acknowledges: its address or a general call write.
+  */
+uint8_t mcp4725_Model_Address(MCP4725_Model_t* model, uint8_t address, uint64_t now_ns){
+
+	mcp4725_model_update(model, now_ns);
+
+	model->read = address & 0x1;
+	model->general_call = ( address == MODEL_GENERAL_CALL_ADDR );
+	model->count = 0;
+
+	if( model->general_call ){
+		return 1;
+	}
+
+	if( ( address >> 1 ) != model->dev_addr ){
+		return 0;
+	}
+
+	if( model->read ){
+		model->reads++;
+	}
+
+	return 1;
+}
+
+/**
+  * @brief  Data byte written by the master, the command is applied at its last byte.
+  * @retval 1 (ACK), the device acknowledges every byte.
+  */
+uint8_t mcp4725_Model_Write_Byte(MCP4725_Model_t* model, uint8_t byte, uint64_t now_ns){
+
+	mcp4725_model_update(model, now_ns);
+
+	if( model->general_call ){
+		/* Only the second byte is a command */
+		if( model->count++ == 0 ){
+			if( byte == MODEL_GENERAL_CALL_RESET ){
+				model->dac_register = model->eeprom_dac;
+				model->powerdown_mode = model->eeprom_powerdown;
+				model->general_calls++;
+			}else if( byte == MODEL_GENERAL_CALL_WAKEUP ){
+				model->powerdown_mode = 0;
+				model->general_calls++;
+			}
+		}
+		return 1;
+	}
+
+	mcp4725_model_command(model, byte);
+
+	return 1;
+}
+
+/**
+  * @brief  Data byte read by the master: status and DAC register (3 bytes), EEPROM (2 bytes), repeated.
+  * @retval The byte sent by the device.
+  */
+uint8_t mcp4725_Model_Read_Byte(MCP4725_Model_t* model, uint64_t now_ns){
+
+	mcp4725_model_update(model, now_ns);
+
+	uint8_t idx = model->count;
+	model->count = ( model->count + 1 ) % MODEL_READ_BYTES;
+
+	switch( idx ){
+		case 0:
+			return ( model->eeprom_busy ? 0 : MODEL_RDY_BSY ) | MODEL_POR | ( model->powerdown_mode << 1 );
+		case 1:
+			return (uint8_t) ( model->dac_register >> 4 );
+		case 2:
+			return (uint8_t) ( ( model->dac_register & 0x0F ) << 4 );
+		case 3:
+			return (uint8_t) ( ( model->eeprom_powerdown << 5 ) | ( model->eeprom_dac >> 8 ) );
+		default:
+			return (uint8_t) ( model->eeprom_dac & 0xFF );
+	}
+}
+
+/**
+  * @brief  STOP condition, a Write DAC Register and EEPROM command starts the programming.
+  * @retval None
+  */
+void mcp4725_Model_Stop(MCP4725_Model_t* model, uint64_t now_ns){
+
+	mcp4725_model_update(model, now_ns);
+
+	if( model->eeprom_request ){
+		model->eeprom_request = 0;
+		model->eeprom_busy = 1;
+		model->eeprom_ready_ns = now_ns + model->eeprom_write_ns;
+		model->eeprom_writes++;
+	}
+
+	model->count = 0;
+	model->general_call = 0;
+}
+
+/**
+  * @brief  Check the RDY/BSY state of the device.
+  * @retval 1 while the EEPROM is programmed.
+  */
+uint8_t mcp4725_Model_Busy(MCP4725_Model_t* model, uint64_t now_ns){
+
+	mcp4725_model_update(model, now_ns);
+	return model->eeprom_busy;
+}
+
+/**
+  * @brief  Voltage of the output, Vout = VDD * code / 4096.
+  * @param  vdd_mv Supply (reference) voltage in mV.
+  * @retval Output voltage in mV, 0 in power down mode (output pulled down to GND).
+  */
+uint32_t mcp4725_Model_Output_mV(MCP4725_Model_t* model, uint32_t vdd_mv){
+
+	if( model->powerdown_mode != 0 ){
+		return 0;
+	}
+
+	return ( vdd_mv * model->dac_register ) / 4096U;
+}
+
+/**
+  * @brief  End of the EEPROM programming when its time elapsed.
+  */
+static void mcp4725_model_update(MCP4725_Model_t* model, uint64_t now_ns){
+
+	if( model->eeprom_busy && now_ns >= model->eeprom_ready_ns ){
+		model->eeprom_dac = model->eeprom_next_dac;
+		model->eeprom_powerdown = model->eeprom_next_pd;
+		model->eeprom_busy = 0;
+	}
+
+}
+
+/**
+  * @brief  Decode the bytes of the write commands. The first byte of each group selects the command,
+  * 		Fast Mode groups have 2 bytes and Write DAC Register groups 3 bytes.
+  */
+static void mcp4725_model_command(MCP4725_Model_t* model, uint8_t byte){
+
+	uint8_t pos = model->count++;
+
+	if( pos == 0 ){
+		model->command = byte;
+		return;
+	}
+
+	if( ( model->command >> 6 ) == MODEL_CMD_FAST_MODE ){
+
+		/* C2 C1 PD1 PD0 D11 D10 D9 D8, D7..D0 */
+		model->count = 0;
+		if( model->eeprom_busy ){
+			model->ignored++;
+			return;
+		}
+		model->powerdown_mode = ( model->command >> 4 ) & 0x3;
+		model->dac_register = ( ( model->command & 0x0F ) << 8 ) | byte;
+		model->fast_writes++;
+		return;
+	}
+
+	uint8_t cmd = model->command >> 5;
+
+	if( pos == 1 ){
+		model->data = byte;
+		return;
+	}
+
+	/* C2 C1 C0 X X PD1 PD0 X, D11..D4, D3..D0 X X X X */
+	model->count = 0;
+
+	if( cmd != MODEL_CMD_WRITE_DAC && cmd != MODEL_CMD_WRITE_EEPROM ){
+		return;		/* Reserved commands */
+	}
+
+	if( model->eeprom_busy ){
+		model->ignored++;
+		return;
+	}
+
+	model->powerdown_mode = ( model->command >> 1 ) & 0x3;
+	model->dac_register = ( model->data << 4 ) | ( byte >> 4 );
+	model->dac_writes++;
+
+	if( cmd == MODEL_CMD_WRITE_EEPROM ){
+		/* The last command of the transaction is programmed */
+		model->eeprom_request = 1;
+		model->eeprom_next_dac = model->dac_register;
+		model->eeprom_next_pd = model->powerdown_mode;
+	}
+
+}
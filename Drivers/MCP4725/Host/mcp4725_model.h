@@ -0,0 +1,65 @@
+/*
+ * mcp4725_model.h
+ *
+ *  Byte-accurate model of the MCP4725 for host builds. The model decodes the bytes of the I2C
+ *  transactions as the device does (datasheet DS20002039, section 6):
+ *
+ *  - Fast Mode write (C2 C1 = 0 0): 2 bytes, repeated words are accepted in the same transaction.
+ *  - Write DAC Register (C2 C1 C0 = 0 1 0) and Write DAC Register and EEPROM (0 1 1): 3 bytes, repeated.
+ *    The EEPROM is programmed after the STOP condition, the write commands are ignored and the
+ *    RDY/BSY bit reads 0 until the programming time elapses.
+ *  - Read: 5 bytes (status and DAC register, EEPROM), repeated while the master acknowledges.
+ *  - General call reset (0x06): the DAC register is loaded from the EEPROM.
+ *  - General call wake-up (0x09): the power down bits of the DAC register are cleared.
+ */
+
+#ifndef MCP4725_HOST_MCP4725_MODEL_H_
+#define MCP4725_HOST_MCP4725_MODEL_H_
+
+#include <stdint.h>
+
+#ifndef MCP4725_MODEL_EEPROM_WRITE_NS
+#define MCP4725_MODEL_EEPROM_WRITE_NS	25000000ULL		/* EEPROM programming time, datasheet: 25 ms typical, 50 ms max */
+#endif
+
+/* MCP4725 Model Structure */
+
+typedef struct mcp4725_model{
+	uint8_t			dev_addr;				/* 7-bit slave address, 0x60 to 0x67 */
+	uint16_t		dac_register;			/* 12-bit DAC input code */
+	uint8_t			powerdown_mode;			/* PD1 PD0 of the DAC register */
+	uint16_t		eeprom_dac;				/* DAC input code stored in the EEPROM */
+	uint8_t			eeprom_powerdown;		/* PD1 PD0 stored in the EEPROM */
+	uint64_t		eeprom_write_ns;		/* Programming time of the EEPROM */
+	uint64_t		eeprom_ready_ns;		/* End of the programming in progress */
+	uint8_t			eeprom_busy;			/* 1 while the EEPROM is programmed */
+	uint16_t		eeprom_next_dac;		/* Values programmed at the end of the busy time */
+	uint8_t			eeprom_next_pd;
+	uint8_t			eeprom_request;			/* 1 when a write to EEPROM was received, it starts at the STOP */
+	uint8_t			read;					/* Direction of the transaction in progress */
+	uint8_t			general_call;			/* 1 if the transaction in progress is a general call */
+	uint8_t			command;				/* First byte of the write command in progress */
+	uint8_t			count;					/* Bytes of the transaction in progress after the address */
+	uint8_t			data;					/* Second byte of the Write DAC Register command in progress */
+	uint32_t		fast_writes;			/* Fast Mode words applied */
+	uint32_t		dac_writes;				/* Write DAC Register commands applied, with or without EEPROM */
+	uint32_t		eeprom_writes;			/* EEPROM programming cycles, the endurance is 1 million */
+	uint32_t		reads;					/* Read transactions */
+	uint32_t		ignored;				/* Write commands received while the EEPROM was programmed */
+	uint32_t		general_calls;			/* Reset and wake-up commands applied */
+}MCP4725_Model_t;
+
+/* Power on: the DAC register is loaded from the EEPROM */
+void mcp4725_Model_Init(MCP4725_Model_t* model, uint8_t dev_addr, uint16_t eeprom_dac, uint8_t eeprom_powerdown);
+
+/* I2C transaction, byte by byte. now_ns is the time of the bus */
+uint8_t mcp4725_Model_Address(MCP4725_Model_t* model, uint8_t address, uint64_t now_ns);
+uint8_t mcp4725_Model_Write_Byte(MCP4725_Model_t* model, uint8_t byte, uint64_t now_ns);
+uint8_t mcp4725_Model_Read_Byte(MCP4725_Model_t* model, uint64_t now_ns);
+void mcp4725_Model_Stop(MCP4725_Model_t* model, uint64_t now_ns);
+
+/* State of the device */
+uint8_t mcp4725_Model_Busy(MCP4725_Model_t* model, uint64_t now_ns);
+uint32_t mcp4725_Model_Output_mV(MCP4725_Model_t* model, uint32_t vdd_mv);
+
+#endif /* MCP4725_HOST_MCP4725_MODEL_H_ */
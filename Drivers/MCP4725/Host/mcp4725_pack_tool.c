@@ -0,0 +1,188 @@
+/*
+ * mcp4725_pack_tool.c
+ *
+ *  Compress a waveform for mcp4725_pack.c. The samples (12-bit integers, separated by spaces, commas or
+ *  new lines) are read from a file or stdin, the C table of the codes is written to stdout. The codes are
+ *  decoded again in blocks and compared with the Fast Mode words of the samples, the sizes, the ratio and
+ *  the decode time on the host are written to stderr.
+ *
+ *  gcc -DSTM32F401xC -I. -I.. -O2 -o mcp4725_pack_tool mcp4725_pack_tool.c mcp4725_host.c mcp4725_model.c ../mcp4725.c ../mcp4725_pack.c ../mcp4725_wave.c -lm
+ *  ./mcp4725_pack_tool profile.txt profile > profile_pack.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mcp4725_pack.h"
+#include "mcp4725_wave.h"
+
+#define TOOL_BLOCK			61		/* Decode block, not a divisor of the runs */
+#define TOOL_REPEAT			100		/* Decodes of the waveform for the time */
+
+static uint16_t* tool_read(FILE* file, uint32_t* num_samples){
+
+	uint32_t capacity = 1024;
+	uint16_t* samples = malloc(capacity * sizeof(uint16_t));
+	long value;
+	int c;
+
+	*num_samples = 0;
+
+	while( samples != NULL ){
+
+		if( fscanf(file, "%ld", &value) == 1 ){
+			if( value < 0 || value > 4095 ){
+				fprintf(stderr, "sample %lu out of range: %ld\n", (unsigned long) *num_samples, value);
+				free(samples);
+				return NULL;
+			}
+			if( *num_samples == capacity ){
+				capacity *= 2;
+				uint16_t* grown = realloc(samples, capacity * sizeof(uint16_t));
+				if( grown == NULL ){
+					free(samples);
+					return NULL;
+				}
+				samples = grown;
+			}
+			samples[(*num_samples)++] = (uint16_t) value;
+			continue;
+		}
+
+		/* Skip a separator, stop at the end of the file */
+		c = fgetc(file);
+		if( c == EOF ){
+			break;
+		}
+		if( c != ',' && c != ';' && c != ' ' && c != '\t' && c != '\r' && c != '\n' ){
+			fprintf(stderr, "unexpected character '%c' after sample %lu\n", c, (unsigned long) *num_samples);
+			free(samples);
+			return NULL;
+		}
+	}
+
+	return samples;
+}
+
+/* Decode in blocks and compare with the table of the samples in Fast Mode words */
+static int tool_verify(const MCP4725_Pack_t* pack, const uint16_t* samples, double* ns_per_sample){
+
+	MCP4725_Unpack_t unpack;
+	uint8_t* expected = malloc(MCP4725_WAVE_BYTES(pack->num_samples));
+	uint8_t* decoded = malloc(MCP4725_WAVE_BYTES(pack->num_samples + TOOL_BLOCK));
+	int result = 0;
+
+	if( expected == NULL || decoded == NULL ){
+		free(expected);
+		free(decoded);
+		return -1;
+	}
+
+	for( uint32_t idx = 0; idx < pack->num_samples; idx += 0xFFFF ){
+		uint32_t block = ( pack->num_samples - idx > 0xFFFF ) ? 0xFFFF : pack->num_samples - idx;
+		mcp4725_Wave_Encode(&expected[2 * idx], &samples[idx], (uint16_t) block, MCP4725_NORMAL_MODE);
+	}
+
+	mcp4725_Unpack_Init(&unpack, pack, 0, MCP4725_NORMAL_MODE);
+
+	uint32_t total = 0;
+	for( uint32_t idx = 0; idx < pack->num_samples; idx += TOOL_BLOCK ){
+		total += mcp4725_Unpack_Block(&unpack, &decoded[2 * idx], TOOL_BLOCK);
+	}
+
+	if( total != pack->num_samples || memcmp(expected, decoded, MCP4725_WAVE_BYTES(pack->num_samples)) != 0 ){
+		result = -1;
+	}
+
+	/* Decode time, the whole waveform in blocks of the stream buffer size */
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for( uint32_t repeat = 0; repeat < TOOL_REPEAT; repeat++ ){
+		mcp4725_Unpack_Rewind(&unpack);
+		for( uint32_t idx = 0; idx < pack->num_samples; idx += TOOL_BLOCK ){
+			mcp4725_Unpack_Block(&unpack, &decoded[2 * idx], TOOL_BLOCK);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double elapsed = ( end.tv_sec - start.tv_sec ) * 1e9 + ( end.tv_nsec - start.tv_nsec );
+	*ns_per_sample = elapsed / ( (double) TOOL_REPEAT * pack->num_samples );
+
+	free(expected);
+	free(decoded);
+
+	return result;
+}
+
+static void tool_print(const MCP4725_Pack_t* pack, const char* name){
+
+	printf("/* %lu samples in %lu bytes, generated by mcp4725_pack_tool */\n",
+			(unsigned long) pack->num_samples, (unsigned long) pack->size);
+	printf("const uint8_t %s_codes[%lu] = {", name, (unsigned long) pack->size);
+
+	for( uint32_t idx = 0; idx < pack->size; idx++ ){
+		printf("%s0x%02X%s", ( idx % 16 == 0 ) ? "\n\t" : "", pack->data[idx], ( idx + 1 < pack->size ) ? ", " : "");
+	}
+
+	printf("\n};\n\n");
+	printf("const MCP4725_Pack_t %s = { %s_codes, %lu, %lu };\n", name, name,
+			(unsigned long) pack->size, (unsigned long) pack->num_samples);
+}
+
+int main(int argc, char** argv){
+
+	const char* name = ( argc > 2 ) ? argv[2] : "wave";
+	FILE* file = stdin;
+	uint32_t num_samples;
+	double ns_per_sample;
+
+	if( argc > 1 && strcmp(argv[1], "-") != 0 ){
+		file = fopen(argv[1], "r");
+		if( file == NULL ){
+			perror(argv[1]);
+			return 1;
+		}
+	}
+
+	uint16_t* samples = tool_read(file, &num_samples);
+	if( file != stdin ){
+		fclose(file);
+	}
+	if( samples == NULL ){
+		return 1;
+	}
+	if( num_samples == 0 ){
+		fprintf(stderr, "no samples\n");
+		free(samples);
+		return 1;
+	}
+
+	uint8_t* codes = malloc(MCP4725_PACK_MAX_BYTES(num_samples));
+	if( codes == NULL ){
+		free(samples);
+		return 1;
+	}
+
+	MCP4725_Pack_t pack = { codes, 0, num_samples };
+	pack.size = mcp4725_Pack_Encode(codes, MCP4725_PACK_MAX_BYTES(num_samples), samples, num_samples);
+
+	if( pack.size == 0 || tool_verify(&pack, samples, &ns_per_sample) != 0 ){
+		fprintf(stderr, "verification failed\n");
+		free(samples);
+		free(codes);
+		return 1;
+	}
+
+	tool_print(&pack, name);
+
+	uint32_t ratio = mcp4725_Pack_Ratio_x100(&pack);
+	fprintf(stderr, "%lu samples, %lu bytes raw, %lu bytes packed, ratio %lu.%02lu:1, decode %.1f ns/sample (host), verified\n",
+			(unsigned long) num_samples, (unsigned long) MCP4725_WAVE_BYTES(num_samples), (unsigned long) pack.size,
+			(unsigned long) ( ratio / 100 ), (unsigned long) ( ratio % 100 ), ns_per_sample);
+
+	free(samples);
+	free(codes);
+
+	return 0;
+}
@@ -0,0 +1,210 @@
+/*
+ * mcp4725_uart_bench.c
+ *
+ *  UART source of the streaming mode on a pseudo-terminal, in real time. A child process plays the host
+ *  PC: it waits for the credits and sends a ramp of Fast Mode words, one half per credit, with a stall
+ *  after some blocks. The parent plays the stream: each half is sent to the MCP4725 model at the start of
+ *  its period (the bytes received later in the period are not sent), then released to the UART source.
+ *
+ *  The ramp gives the check: a sample is the previous one + 1 (in order), the same (held) or a jump.
+ *  A block dropped by a resync gives one jump.
+ *
+ *  gcc -DSTM32F401xC -I. -I.. -O2 -o mcp4725_uart_bench mcp4725_uart_bench.c mcp4725_host_uart.c mcp4725_host.c mcp4725_model.c ../mcp4725.c ../mcp4725_uart.c
+ *  ./mcp4725_uart_bench [blocks] [stall_ms]
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "mcp4725_host.h"
+#include "mcp4725_host_uart.h"
+#include "mcp4725.h"
+#include "mcp4725_uart.h"
+
+#define BENCH_ADDR			0x60
+#define BENCH_BUS_CLOCK		400000U
+#define BENCH_BAUD			921600U
+#define BENCH_SAMPLES		512			/* Stream buffer, 2 halves of 256 samples */
+#define BENCH_HALF			( BENCH_SAMPLES / 2 )
+#define BENCH_STALL_BLOCK	20			/* The host stalls after this block */
+#define BENCH_SCL_PER_SAMPLE	18			/* Streaming mode, 2 bytes and 2 ACK */
+
+static I2C_HandleTypeDef hi2c1;
+static struct mcp4725_host_bus bus1;
+static MCP4725_Model_t model;
+static MCP4725_Handle_t mcp4725_dev;
+
+static UART_HandleTypeDef huart2;
+static struct mcp4725_host_uart port2;
+static MCP4725_Uart_t uart_source;
+
+static uint8_t stream_buffer[ BENCH_SAMPLES * 2 ];
+
+/* Route the HAL callbacks as in the target project */
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart){
+	mcp4725_Uart_RxCpltCallback(huart);
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart){
+	mcp4725_Uart_TxCpltCallback(huart);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart){
+	mcp4725_Uart_ErrorCallback(huart);
+}
+
+static uint64_t bench_now_us(void){
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000ULL + (uint64_t) ts.tv_nsec / 1000U;
+}
+
+/* Host PC: one block of the ramp per credit */
+static void bench_host(const char* name, uint32_t blocks, uint32_t stall_ms){
+
+	int fd = open(name, O_RDWR | O_NOCTTY);
+	struct termios tio;
+	uint8_t block[ BENCH_HALF * 2 ];
+	uint16_t value = 0;
+
+	if( fd < 0 ){
+		_exit(1);
+	}
+
+	tcgetattr(fd, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(fd, TCSANOW, &tio);
+
+	for( uint32_t sent = 0; sent < blocks; ){
+
+		uint8_t credit;
+		if( read(fd, &credit, 1) != 1 ){
+			_exit(1);
+		}
+		if( credit != MCP4725_UART_CREDIT ){
+			continue;
+		}
+
+		if( sent == BENCH_STALL_BLOCK && stall_ms ){
+			usleep(stall_ms * 1000U);
+		}
+
+		for( uint16_t idx = 0; idx < BENCH_HALF; idx++, value = ( value + 1 ) & 0xFFF ){
+			block[2 * idx] = (uint8_t) ( value >> 8 );
+			block[2 * idx + 1] = (uint8_t) value;
+		}
+
+		if( write(fd, block, sizeof(block)) != (ssize_t) sizeof(block) ){
+			_exit(1);
+		}
+		sent++;
+	}
+
+	_exit(0);
+}
+
+int main(int argc, char** argv){
+
+	uint32_t blocks = ( argc > 1 ) ? (uint32_t) atoi(argv[1]) : 200;
+	uint32_t stall_ms = ( argc > 2 ) ? (uint32_t) atoi(argv[2]) : 0;
+	uint32_t in_order = 0, held = 0, jumps = 0;
+	int32_t previous = -1;
+	uint8_t drain = 0;
+
+	mcp4725_Model_Init(&model, BENCH_ADDR, 0, 0);
+	mcp4725_Host_Init(&hi2c1, &bus1, BENCH_BUS_CLOCK);
+	mcp4725_Host_Attach(&hi2c1, &model);
+
+	if( mcp4725_Init(&mcp4725_dev, &hi2c1, BENCH_ADDR, 0, MCP4725_NORMAL_MODE) != HAL_OK ||
+		mcp4725_Host_Uart_Init(&huart2, &port2, BENCH_BAUD) != HAL_OK ||
+		mcp4725_Uart_Init(&uart_source, &huart2, stream_buffer, BENCH_SAMPLES) != HAL_OK ){
+		printf("init failed\n");
+		return 1;
+	}
+
+	pid_t host = fork();
+	if( host == 0 ){
+		bench_host(mcp4725_Host_Uart_Name(&huart2), blocks, stall_ms);
+	}
+
+	mcp4725_Uart_Start(&uart_source);
+
+	uint64_t start = bench_now_us();
+	while( mcp4725_Uart_Ready(&uart_source) == 0 ){
+		mcp4725_Host_Uart_Poll(&huart2);
+		if( bench_now_us() - start > 2000000U ){
+			printf("no data from the host\n");
+			return 1;
+		}
+	}
+
+	/* Stream period of a half: 18 SCL periods per sample */
+	const uint64_t half_us = ( (uint64_t) BENCH_HALF * BENCH_SCL_PER_SAMPLE * 1000000ULL ) / BENCH_BUS_CLOCK;
+	uint64_t deadline = bench_now_us();
+
+	for( uint8_t half = 0; ; half ^= 1 ){
+
+		uint8_t* words = &stream_buffer[ half * BENCH_HALF * 2 ];
+
+		for( uint16_t idx = 0; idx < BENCH_HALF; idx++ ){
+			int32_t value = ( ( words[2 * idx] & 0x0F ) << 8 ) | words[2 * idx + 1];
+			if( previous >= 0 ){
+				if( value == ( ( previous + 1 ) & 0xFFF ) )	in_order++;
+				else if( value == previous )				held++;
+				else										jumps++;
+			}
+			previous = value;
+		}
+
+		mcp4725_Host_Stream(&hi2c1, BENCH_ADDR << 1, words, BENCH_HALF);
+
+		deadline += half_us;
+		while( bench_now_us() < deadline ){
+			mcp4725_Host_Uart_Poll(&huart2);
+			usleep(100);
+		}
+
+		/* End of the stream: the host sent all its blocks (one half period ago) and the next half is not received */
+		if( drain && ( ( uart_source.free_halves & ( 1 << ( half ^ 1 ) ) ) || ++drain > 4 ) ){
+			break;
+		}
+		if( drain == 0 && waitpid(host, NULL, WNOHANG) == host ){
+			host = 0;
+			drain = 1;
+		}
+		if( bench_now_us() - start > 60000000U ){
+			break;
+		}
+
+		mcp4725_Uart_Release(&uart_source, words, BENCH_HALF);
+	}
+
+	mcp4725_Uart_Stop(&uart_source);
+	if( host > 0 ){
+		kill(host, SIGKILL);
+		waitpid(host, NULL, 0);
+	}
+
+	printf("%lu blocks, %.1f kS/s, %lu bd, host stall %lu ms\n", (unsigned long) blocks,
+			BENCH_BUS_CLOCK / ( BENCH_SCL_PER_SAMPLE * 1000.0 ), (unsigned long) BENCH_BAUD, (unsigned long) stall_ms);
+	printf("received %lu blocks, %lu credits, %lu bytes dropped\n", (unsigned long) uart_source.blocks,
+			(unsigned long) uart_source.credits, (unsigned long) port2.dropped);
+	printf("underruns %lu, held samples %lu, resyncs %lu, sync errors %lu, UART errors %lu\n", (unsigned long) uart_source.underruns,
+			(unsigned long) uart_source.held_samples, (unsigned long) uart_source.resyncs, (unsigned long) uart_source.sync_errors,
+			(unsigned long) uart_source.uart_errors);
+	printf("played: %lu in order, %lu held, %lu jumps, %lu Fast Mode words to the model\n", (unsigned long) in_order,
+			(unsigned long) held, (unsigned long) jumps, (unsigned long) model.fast_writes);
+
+	mcp4725_Host_Uart_DeInit(&huart2);
+
+	return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * stm32f4xx_hal.h
+ *
+ *  Host stand-in of the STM32F4 HAL for the MCP4725 driver, the subset used by mcp4725.c,
+ *  mcp4725_bus.c, mcp4725_wave.c, mcp4725_dds.c, mcp4725_group.c, mcp4725_uart.c, mcp4725_jitter.c and the TIMINGR calculator of
+ *  mcp4725_speed.c (mcp4725_Speed_Set returns HAL_ERROR, no I2C module). The I2C functions are implemented
+ *  by mcp4725_host.c on a simulated bus with MCP4725 models, the time is virtual. The UART functions
+ *  are implemented by mcp4725_host_uart.c on a pseudo-terminal.
+ *
+ *  Build with -DSTM32F401xC and this directory first in the include path.
+ */
+
+#ifndef MCP4725_HOST_STM32F4XX_HAL_H_
+#define MCP4725_HOST_STM32F4XX_HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define __IO				volatile
+#define __weak				__attribute__((weak))
+#define UNUSED(X)			(void)(X)
+
+typedef enum{
+	HAL_OK		=	0x00U,
+	HAL_ERROR	=	0x01U,
+	HAL_BUSY	=	0x02U,
+	HAL_TIMEOUT	=	0x03U
+}HAL_StatusTypeDef;
+
+typedef enum{
+	HAL_I2C_STATE_RESET		=	0x00U,
+	HAL_I2C_STATE_READY		=	0x20U,
+	HAL_I2C_STATE_BUSY_TX	=	0x21U,
+	HAL_I2C_STATE_BUSY_RX	=	0x22U
+}HAL_I2C_StateTypeDef;
+
+typedef enum{
+	HAL_I2C_MODE_NONE		=	0x00U,
+	HAL_I2C_MODE_MASTER		=	0x10U
+}HAL_I2C_ModeTypeDef;
+
+#define HAL_I2C_ERROR_NONE		0x00000000U
+#define HAL_I2C_ERROR_AF		0x00000004U		/* NACK of the address or of a data byte */
+
+/* Options of the sequential transfers, the frames with LAST end with a STOP, the others with no STOP */
+#define I2C_FIRST_FRAME				0x00000001U
+#define I2C_FIRST_AND_NEXT_FRAME	0x00000002U
+#define I2C_NEXT_FRAME				0x00000004U
+#define I2C_FIRST_AND_LAST_FRAME	0x00000008U
+#define I2C_LAST_FRAME_NO_STOP		0x00000010U
+#define I2C_LAST_FRAME				0x00000020U
+#define I2C_OTHER_FRAME				0x000000AAU
+#define I2C_OTHER_AND_LAST_FRAME	0x0000AA00U
+
+/* The simulated bus (mcp4725_host.h) takes the place of the peripheral registers */
+typedef struct mcp4725_host_bus I2C_TypeDef;
+
+typedef struct{
+	uint32_t				ClockSpeed;			/* SCL frequency in Hz, 100 kHz, 400 kHz or 3.4 MHz (HS mode) */
+}I2C_InitTypeDef;
+
+typedef struct __I2C_HandleTypeDef{
+	I2C_TypeDef *			Instance;			/* Simulated bus, set by mcp4725_Host_Init */
+	I2C_InitTypeDef			Init;
+	__IO HAL_I2C_StateTypeDef	State;
+	__IO HAL_I2C_ModeTypeDef	Mode;
+	__IO uint32_t			ErrorCode;
+}I2C_HandleTypeDef;
+
+#define HAL_UART_MODULE_ENABLED
+
+typedef enum{
+	HAL_UART_STATE_RESET		=	0x00U,
+	HAL_UART_STATE_READY		=	0x20U,
+	HAL_UART_STATE_BUSY_TX		=	0x21U,
+	HAL_UART_STATE_BUSY_RX		=	0x22U
+}HAL_UART_StateTypeDef;
+
+#define HAL_UART_ERROR_NONE		0x00000000U
+#define HAL_UART_ERROR_ORE		0x00000008U		/* Overrun, the pseudo-terminal closed */
+
+/* Bytes left of the RX DMA transfer, the NDTR register */
+typedef struct{
+	__IO uint32_t			Counter;
+}DMA_HandleTypeDef;
+
+#define __HAL_DMA_GET_COUNTER(__HANDLE__)	((__HANDLE__)->Counter)
+
+/* The pseudo-terminal (mcp4725_host_uart.h) takes the place of the peripheral registers */
+typedef struct mcp4725_host_uart USART_TypeDef;
+
+typedef struct{
+	uint32_t				BaudRate;			/* Bytes are delivered at BaudRate / 10 per second at most */
+}UART_InitTypeDef;
+
+typedef struct __UART_HandleTypeDef{
+	USART_TypeDef *			Instance;			/* Pseudo-terminal, set by mcp4725_Host_Uart_Init */
+	UART_InitTypeDef		Init;
+	uint8_t *				pRxBuffPtr;
+	uint16_t				RxXferSize;
+	DMA_HandleTypeDef *		hdmarx;
+	__IO HAL_UART_StateTypeDef	gState;
+	__IO HAL_UART_StateTypeDef	RxState;
+	__IO uint32_t			ErrorCode;
+}UART_HandleTypeDef;
+
+/* One thread of execution, the IRQs are the completions run by mcp4725_Host_Advance */
+static inline uint32_t __get_PRIMASK(void){ return 0; }
+static inline void __set_PRIMASK(uint32_t priMask){ (void) priMask; }
+static inline void __disable_irq(void){}
+static inline void __enable_irq(void){}
+
+/* Cycle counter of mcp4725_jitter.c, not advanced: the benches stamp with mcp4725_Jitter_Stamp */
+#define __CORTEX_M					4U
+#define DWT_CTRL_CYCCNTENA_Msk		0x00000001U
+#define CoreDebug_DEMCR_TRCENA_Msk	0x01000000U
+
+typedef struct{
+	__IO uint32_t			CTRL;
+	__IO uint32_t			CYCCNT;
+}DWT_Type;
+
+typedef struct{
+	__IO uint32_t			DEMCR;
+}CoreDebug_Type;
+
+extern DWT_Type host_dwt;
+extern CoreDebug_Type host_coredebug;
+extern uint32_t SystemCoreClock;
+
+#define DWT					(&host_dwt)
+#define CoreDebug			(&host_coredebug)
+
+/* Virtual time */
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+/* I2C master functions */
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Master_Receive_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size);
+
+/* I2C sequential transfers, the next frame starts with a repeated START */
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t XferOptions);
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t XferOptions);
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t XferOptions);
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t XferOptions);
+
+/* Weak callbacks, called at the end of the asynchronous transfers */
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c);
+
+/* UART functions, RX in DMA Mode and TX in Interrupt Mode */
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart);
+
+/* Weak callbacks, called by mcp4725_Host_Uart_Poll */
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+
+#endif /* MCP4725_HOST_STM32F4XX_HAL_H_ */
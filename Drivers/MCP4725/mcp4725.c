@@ -27,8 +27,16 @@
 #define WRITE_EEPROM_CMD_POS	5
 #define WRITE_EEPROM_PD_POS		1
 
-#define GENERAL_CALL_RESET		0x06
-#define GENERAL_CALL_WAKEUP		0x09
+#define READ_RDY_BSY			0x80	/* Status byte: 1 when the EEPROM write is complete */
+
+/* Asynchronous transfers in progress, one per I2C bus */
+static MCP4725_Handle_t* async_xfer[MCP4725_MAX_I2C_BUS] = {0};
+
+static HAL_StatusTypeDef mcp4725_async_start(MCP4725_Handle_t* mcp4725_dev, MCP4725_Operation_e operation, uint16_t dac_data, MCP4725_PowerDown_e pd_mode);
+static MCP4725_Handle_t* mcp4725_async_release(I2C_HandleTypeDef* hi2c);
+static void mcp4725_eeprom_done(MCP4725_Handle_t* mcp4725_dev, uint8_t send_queued);
+static uint8_t mcp4725_cache_skip(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode);
+
 
 /**
   * @brief  Initialize the mcp4725 instance with corresponding values. Write the DAC register and the power down mode selected.
@@ -46,12 +54,12 @@
   */
 HAL_StatusTypeDef mcp4725_Init(MCP4725_Handle_t* mcp4725_dev, I2C_HandleTypeDef* i2c_handle, uint8_t mcp4725_addr, uint16_t dac_data, MCP4725_PowerDown_e pd_mode){
 
+	/* The first write is always sent, the asynchronous transfers use the Interrupt Mode */
+	mcp4725_Handle_Init(mcp4725_dev, i2c_handle, mcp4725_addr);
+
 	/* Verify MCP4725 device with mcp4725_addr address is present in I2C Bus */
 	if( HAL_I2C_IsDeviceReady(i2c_handle, mcp4725_addr << 1, MAX_TRIALS, TIMEOUT) == HAL_OK ){
 
-		mcp4725_dev->i2c_handle = i2c_handle;
-		mcp4725_dev->dev_addr = mcp4725_addr;
-
 		uint8_t status1, status2;
 		/* Write the configuration for mcp4725 device in Fast Mode Command */
 		status1 = mcp4725_Write_PowerDown_DAC_Register(mcp4725_dev, dac_data, pd_mode);
@@ -72,25 +80,66 @@ HAL_StatusTypeDef mcp4725_Init(MCP4725_Handle_t* mcp4725_dev, I2C_HandleTypeDef*
 
 }
 
+/**
+  * @brief  Set up the instance with no bus traffic: no transfer in progress, cache off and stale, EEPROM not read.
+  * @note	Called by mcp4725_Init and by the layers that replace it (mcp4725_Group_Add). Select the DMA Mode
+  * 		(xfer_mode) and the cache mode after it.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @param  i2c_handle I2C bus of the device.
+  * @param  mcp4725_addr 7-bit address, 0x60 to 0x67.
+  * @retval None
+  */
+void mcp4725_Handle_Init(MCP4725_Handle_t* mcp4725_dev, I2C_HandleTypeDef* i2c_handle, uint8_t mcp4725_addr){
+
+	mcp4725_dev->i2c_handle = i2c_handle;
+	mcp4725_dev->dev_addr = mcp4725_addr;
+	mcp4725_dev->xfer_mode = MCP4725_XFER_IT;
+	mcp4725_dev->state = MCP4725_STATE_READY;
+	mcp4725_dev->operation = MCP4725_OP_NONE;
+	mcp4725_dev->pending_pd = 0;
+	mcp4725_dev->pending_dac = 0;
+	mcp4725_dev->cache_mode = MCP4725_CACHE_OFF;
+	mcp4725_dev->cache_stale = 1;
+	mcp4725_dev->skipped_writes = 0;
+	mcp4725_dev->eeprom_stale = 1;
+	mcp4725_dev->eeprom_busy = 0;
+	mcp4725_dev->eeprom_polls = 0;
+	mcp4725_dev->queued = 0;
+	mcp4725_dev->queued_pd = 0;
+	mcp4725_dev->queued_dac = 0;
+
+}
+
 /**
   * @brief  Write the specified DAC data and Power Mode.
   * @param  hi2c Pointer to a MCP4725_Handle_t structure that contains
   *         the configuration information for the specified mcp4527 device.
-  * @retval HAL status
+  * @retval HAL status, HAL_BUSY while an EEPROM commit or an asynchronous transfer of the device is in progress.
   */
 HAL_StatusTypeDef mcp4725_Write_PowerDown_DAC_Register(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode){
 
 	uint8_t data[2] = {0};
-	data[0] = ( ( (uint8_t) pd_mode) << FM_POWERDOWN_POS ) | ( ( dac_data & 0xF00 ) >> 8 );
-	data[1] =  (uint8_t) ( dac_data & 0xFF);
+
+	/* The device ignores the commands while it programs the EEPROM, an asynchronous transfer owns the bus */
+	if( mcp4725_dev->eeprom_busy || mcp4725_dev->state != MCP4725_STATE_READY ){
+		return HAL_BUSY;
+	}
+
+	if( mcp4725_cache_skip(mcp4725_dev, dac_data, pd_mode) ){
+		return HAL_OK;
+	}
+
+	mcp4725_Encode_Fast_Mode(data, dac_data, pd_mode);
 
 	if( HAL_I2C_Master_Transmit(mcp4725_dev->i2c_handle, mcp4725_dev->dev_addr << 1, &data[0], 2, TIMEOUT) == HAL_OK ){
 
 		mcp4725_dev->powerdown_mode = pd_mode;
 		mcp4725_dev->dac_register = dac_data;
+		mcp4725_dev->cache_stale = 0;
 		return HAL_OK;
 
 	}else{
+		mcp4725_dev->cache_stale = 1;
 		return HAL_ERROR;
 	}
 
@@ -101,20 +150,31 @@ HAL_StatusTypeDef mcp4725_Write_PowerDown_DAC_Register(MCP4725_Handle_t* mcp4725
   * affected by this command. This command updates Power-Down mode selection bits (PD1 and PD0) and 12 bits of the DAC input code in the DAC register.
   * @param  hi2c Pointer to a MCP4725_Handle_t structure that contains
   *         the configuration information for the specified mcp4527 device.
-  * @retval HAL status
+  * @retval HAL status, HAL_BUSY while an EEPROM commit or an asynchronous transfer of the device is in progress.
   */
 HAL_StatusTypeDef mcp4725_Write_DAC_Register(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data){
 
 	uint8_t data[2] = {0};
-	data[0] = ( ( (uint8_t) mcp4725_dev->powerdown_mode) << FM_POWERDOWN_POS ) | ( ( dac_data & 0xF00 ) >> 8 );
-	data[1] =  (uint8_t) ( dac_data & 0xFF);
+
+	/* The device ignores the commands while it programs the EEPROM, an asynchronous transfer owns the bus */
+	if( mcp4725_dev->eeprom_busy || mcp4725_dev->state != MCP4725_STATE_READY ){
+		return HAL_BUSY;
+	}
+
+	if( mcp4725_cache_skip(mcp4725_dev, dac_data, mcp4725_dev->powerdown_mode) ){
+		return HAL_OK;
+	}
+
+	mcp4725_Encode_Fast_Mode(data, dac_data, mcp4725_dev->powerdown_mode);
 
 	if( HAL_I2C_Master_Transmit(mcp4725_dev->i2c_handle, mcp4725_dev->dev_addr << 1, &data[0], 2, TIMEOUT) == HAL_OK ){
 
 		mcp4725_dev->dac_register = dac_data;
+		mcp4725_dev->cache_stale = 0;
 		return HAL_OK;
 
 	}else{
+		mcp4725_dev->cache_stale = 1;
 		return HAL_ERROR;
 	}
 
@@ -125,20 +185,31 @@ HAL_StatusTypeDef mcp4725_Write_DAC_Register(MCP4725_Handle_t* mcp4725_dev, uint
   * affected by this command. This command updates Power-Down mode selection bits (PD1 and PD0) and 12 bits of the DAC input code in the DAC register..
   * @param  hi2c Pointer to a MCP4725_Handle_t structure that contains
   *         the configuration information for the specified mcp4527 device.
-  * @retval HAL status
+  * @retval HAL status, HAL_BUSY while an EEPROM commit or an asynchronous transfer of the device is in progress.
   */
 HAL_StatusTypeDef mcp4725_Write_PowerDown(MCP4725_Handle_t* mcp4725_dev, MCP4725_PowerDown_e pd_mode){
 
 	uint8_t data[2] = {0};
-	data[0] = ( ( (uint8_t) pd_mode) << FM_POWERDOWN_POS ) | ( ( mcp4725_dev->dac_register & 0xF00 ) >> 8 );
-	data[1] =  (uint8_t) ( mcp4725_dev->dac_register & 0xFF);
+
+	/* The device ignores the commands while it programs the EEPROM, an asynchronous transfer owns the bus */
+	if( mcp4725_dev->eeprom_busy || mcp4725_dev->state != MCP4725_STATE_READY ){
+		return HAL_BUSY;
+	}
+
+	if( mcp4725_cache_skip(mcp4725_dev, mcp4725_dev->dac_register, pd_mode) ){
+		return HAL_OK;
+	}
+
+	mcp4725_Encode_Fast_Mode(data, mcp4725_dev->dac_register, pd_mode);
 
 	if( HAL_I2C_Master_Transmit(mcp4725_dev->i2c_handle, mcp4725_dev->dev_addr << 1, &data[0], 2, TIMEOUT) == HAL_OK ){
 
 		mcp4725_dev->powerdown_mode = pd_mode;
+		mcp4725_dev->cache_stale = 0;
 		return HAL_OK;
 
 	}else{
+		mcp4725_dev->cache_stale = 1;
 		return HAL_ERROR;
 	}
 
@@ -149,15 +220,20 @@ HAL_StatusTypeDef mcp4725_Write_PowerDown(MCP4725_Handle_t* mcp4725_dev, MCP4725
   * and (b) also writes the EEPROM.
   * @param  hi2c Pointer to a MCP4725_Handle_t structure that contains
   *         the configuration information for the specified mcp4527 device.
-  * @retval HAL status
+  * @retval HAL status, HAL_BUSY while an EEPROM commit or an asynchronous transfer of the device is in progress.
   */
 HAL_StatusTypeDef mcp4725_Write_DAC_EEPROM(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode){
 
+	/* The device ignores the commands while it programs the EEPROM, an asynchronous transfer owns the bus */
+	if( mcp4725_dev->eeprom_busy || mcp4725_dev->state != MCP4725_STATE_READY ){
+		return HAL_BUSY;
+	}
+
 	uint8_t data[3] = {0};
+	mcp4725_Encode_DAC_EEPROM(data, dac_data, pd_mode);
 
-	data[0] = ( WRITE_EEPROM_CMD << WRITE_EEPROM_CMD_POS )  | ( pd_mode << WRITE_EEPROM_PD_POS);
-	data[1] = ( (dac_data & 0xFF0) >> 4);
-	data[2] = ( (dac_data & 0x0F) << 4);
+	/* The DAC register and the EEPROM change, the cached values are known again after a read */
+	mcp4725_dev->cache_stale = 1;
 
 	if( HAL_I2C_Master_Transmit(mcp4725_dev->i2c_handle, mcp4725_dev->dev_addr << 1, data, 3, TIMEOUT) == HAL_OK ){
 		return HAL_OK;
@@ -178,18 +254,42 @@ HAL_StatusTypeDef mcp4725_Read_DAC_EEPROM(MCP4725_Handle_t* mcp4725_dev){
 	uint8_t data[5] = {0};
 	if( HAL_I2C_Master_Receive(mcp4725_dev->i2c_handle, mcp4725_dev->dev_addr << 1, data, 5, TIMEOUT) == HAL_OK ){
 
-		mcp4725_dev->powerdown_mode = (data[0] & 0x06) >> 1;
-		mcp4725_dev->dac_register = (data[1] << 4) | ( ( data[2] & 0xF0) >> 4 );
-		mcp4725_dev->eeprom_powerdown_mode = (data[3] & 0x60) >> 5;
-		mcp4725_dev->eeprom_dac_register = ( (data[3] & 0x0F) << 8 ) | data[4];
-
+		mcp4725_Decode_DAC_EEPROM(mcp4725_dev, data);
+		mcp4725_dev->cache_stale = 0;
 		return HAL_OK;
 	}else{
+		mcp4725_dev->cache_stale = 1;
 		return HAL_ERROR;
 	}
 
 }
 
+/**
+  * @brief  EEPROM settings of the device, read from the device on the first access.
+  * @note	The devices found by mcp4725_Group_Scan are not read beyond the DAC register, the EEPROM is read
+  * 		(blocking, 5 bytes) the first time it is needed. The next calls return the values of the instance.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @param  dac_data DAC register saved in EEPROM, can be NULL.
+  * @param  pd_mode Power down mode saved in EEPROM, can be NULL.
+  * @retval HAL_OK, HAL_BUSY if an asynchronous transfer is in progress, HAL_ERROR if the read failed.
+  */
+HAL_StatusTypeDef mcp4725_Get_EEPROM(MCP4725_Handle_t* mcp4725_dev, uint16_t* dac_data, MCP4725_PowerDown_e* pd_mode){
+
+	if( mcp4725_dev->eeprom_stale ){
+		if( mcp4725_dev->state != MCP4725_STATE_READY ){
+			return HAL_BUSY;
+		}
+		if( mcp4725_Read_DAC_EEPROM(mcp4725_dev) != HAL_OK ){
+			return HAL_ERROR;
+		}
+	}
+
+	if( dac_data != NULL )	*dac_data = mcp4725_dev->eeprom_dac_register;
+	if( pd_mode != NULL )	*pd_mode = (MCP4725_PowerDown_e) mcp4725_dev->eeprom_powerdown_mode;
+
+	return HAL_OK;
+}
+
 /**
   * @brief  Make a general call reset, the device will abort current conversion and perform an
   * 		internal reset similar to a power-on-reset (POR). Immediately after this reset event, the device uploads the
@@ -200,13 +300,17 @@ HAL_StatusTypeDef mcp4725_Read_DAC_EEPROM(MCP4725_Handle_t* mcp4725_dev){
   */
 HAL_StatusTypeDef mcp4725_GeneralCall_Reset(MCP4725_Handle_t* mcp4725_dev){
 
-	const uint8_t data = GENERAL_CALL_RESET;
-	if( HAL_I2C_Master_Transmit(mcp4725_dev->i2c_handle, 0x00, (uint8_t *) &data, 1, TIMEOUT) == HAL_OK){
+	const uint8_t data = MCP4725_GENERAL_CALL_RESET;
+	if( HAL_I2C_Master_Transmit(mcp4725_dev->i2c_handle, MCP4725_GENERAL_CALL_ADDR, (uint8_t *) &data, 1, TIMEOUT) == HAL_OK){
 
-		mcp4725_dev->dac_register = mcp4725_dev->eeprom_dac_register;
-		mcp4725_dev->powerdown_mode = mcp4725_dev->eeprom_powerdown_mode;
+		if( mcp4725_dev->eeprom_stale == 0 ){
+			mcp4725_dev->dac_register = mcp4725_dev->eeprom_dac_register;
+			mcp4725_dev->powerdown_mode = mcp4725_dev->eeprom_powerdown_mode;
+		}
+		mcp4725_dev->cache_stale = 1;
 		return HAL_OK;
 	}else{
+		mcp4725_dev->cache_stale = 1;
 		return HAL_ERROR;
 	}
 
@@ -221,14 +325,565 @@ HAL_StatusTypeDef mcp4725_GeneralCall_Reset(MCP4725_Handle_t* mcp4725_dev){
   */
 HAL_StatusTypeDef mcp4725_GeneralCall_WakeUp(MCP4725_Handle_t* mcp4725_dev){
 
-	const uint8_t data = GENERAL_CALL_WAKEUP;
-	if( HAL_I2C_Master_Transmit(mcp4725_dev->i2c_handle, 0x00, (uint8_t *) &data, 1, TIMEOUT) == HAL_OK){
+	const uint8_t data = MCP4725_GENERAL_CALL_WAKEUP;
+	if( HAL_I2C_Master_Transmit(mcp4725_dev->i2c_handle, MCP4725_GENERAL_CALL_ADDR, (uint8_t *) &data, 1, TIMEOUT) == HAL_OK){
 
-		mcp4725_dev->dac_register = mcp4725_dev->eeprom_dac_register;
-		mcp4725_dev->powerdown_mode = mcp4725_dev->eeprom_powerdown_mode;
+		/* The DAC register is kept */
+		mcp4725_dev->powerdown_mode = MCP4725_NORMAL_MODE;
+		mcp4725_dev->cache_stale = 1;
 		return HAL_OK;
 	}else{
+		mcp4725_dev->cache_stale = 1;
 		return HAL_ERROR;
 	}
 
 }
+
+/**
+  * @brief  Start the Fast Mode write of the DAC data and Power Mode, return without waiting the transfer.
+  * @note	The sample can be written from an IRQ, only the start of the transfer is done here. The instance
+  * 		is updated and mcp4725_TxCpltCallback is called when the transfer ends.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval HAL_OK if the transfer was started, HAL_BUSY if the device or the I2C bus has a transfer in progress.
+  */
+HAL_StatusTypeDef mcp4725_Write_PowerDown_DAC_Register_Async(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode){
+	return mcp4725_async_start(mcp4725_dev, MCP4725_OP_FAST_MODE, dac_data, pd_mode);
+}
+
+/**
+  * @brief  Start the Fast Mode write of the DAC register keeping the power down mode.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval HAL_OK if the transfer was started, HAL_BUSY if the device or the I2C bus has a transfer in progress.
+  */
+HAL_StatusTypeDef mcp4725_Write_DAC_Register_Async(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data){
+	return mcp4725_async_start(mcp4725_dev, MCP4725_OP_FAST_MODE, dac_data, mcp4725_dev->powerdown_mode);
+}
+
+/**
+  * @brief  Start the Fast Mode write of the power down mode keeping the DAC register.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval HAL_OK if the transfer was started, HAL_BUSY if the device or the I2C bus has a transfer in progress.
+  */
+HAL_StatusTypeDef mcp4725_Write_PowerDown_Async(MCP4725_Handle_t* mcp4725_dev, MCP4725_PowerDown_e pd_mode){
+	return mcp4725_async_start(mcp4725_dev, MCP4725_OP_FAST_MODE, mcp4725_dev->dac_register, pd_mode);
+}
+
+/**
+  * @brief  Start the write of the DAC register and the EEPROM.
+  * @note	mcp4725_TxCpltCallback is called when the command is sent, the device keeps programming the EEPROM after it.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval HAL_OK if the transfer was started, HAL_BUSY if the device or the I2C bus has a transfer in progress.
+  */
+HAL_StatusTypeDef mcp4725_Write_DAC_EEPROM_Async(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode){
+	return mcp4725_async_start(mcp4725_dev, MCP4725_OP_DAC_EEPROM, dac_data, pd_mode);
+}
+
+/**
+  * @brief  Start the read of the current settings and EEPROM settings, the instance is updated before mcp4725_RxCpltCallback.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval HAL_OK if the transfer was started, HAL_BUSY if the device or the I2C bus has a transfer in progress.
+  */
+HAL_StatusTypeDef mcp4725_Read_DAC_EEPROM_Async(MCP4725_Handle_t* mcp4725_dev){
+	return mcp4725_async_start(mcp4725_dev, MCP4725_OP_READ, 0, MCP4725_NORMAL_MODE);
+}
+
+/**
+  * @brief  Start a general call reset, see mcp4725_GeneralCall_Reset.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval HAL_OK if the transfer was started, HAL_BUSY if the device or the I2C bus has a transfer in progress.
+  */
+HAL_StatusTypeDef mcp4725_GeneralCall_Reset_Async(MCP4725_Handle_t* mcp4725_dev){
+	return mcp4725_async_start(mcp4725_dev, MCP4725_OP_GC_RESET, 0, MCP4725_NORMAL_MODE);
+}
+
+/**
+  * @brief  Start a general call wake-up, see mcp4725_GeneralCall_WakeUp.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval HAL_OK if the transfer was started, HAL_BUSY if the device or the I2C bus has a transfer in progress.
+  */
+HAL_StatusTypeDef mcp4725_GeneralCall_WakeUp_Async(MCP4725_Handle_t* mcp4725_dev){
+	return mcp4725_async_start(mcp4725_dev, MCP4725_OP_GC_WAKEUP, 0, MCP4725_NORMAL_MODE);
+}
+
+/**
+  * @brief  Return the state of the asynchronous transfer of the device.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval MCP4725_State_e
+  */
+MCP4725_State_e mcp4725_GetState(MCP4725_Handle_t* mcp4725_dev){
+	return mcp4725_dev->state;
+}
+
+/**
+  * @brief  Start the write of the DAC register and the EEPROM, the end of the EEPROM programming is polled.
+  * @note	While the device programs the EEPROM (up to 50 ms) it ignores the commands: the state is
+  * 		MCP4725_STATE_BUSY_EEPROM and the asynchronous Fast Mode writes are queued (the last one is kept),
+  * 		the queued write is sent when the device is ready. Call mcp4725_EEPROM_Poll every 1 ms.
+  * 		The instance is updated before mcp4725_EEPROM_CpltCallback is called.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval HAL_OK if the transfer was started, HAL_BUSY if the device or the I2C bus has a transfer in progress.
+  */
+HAL_StatusTypeDef mcp4725_Write_DAC_EEPROM_Commit(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode){
+	return mcp4725_async_start(mcp4725_dev, MCP4725_OP_EEPROM_COMMIT, dac_data, pd_mode);
+}
+
+/**
+  * @brief  Poll the end of the EEPROM programming with a 1-byte read of the status (RDY/BSY bit).
+  * @note	Call every 1 ms from a timer IRQ (or HAL_SYSTICK_Callback), it returns at once when there is no commit
+  * 		in progress. The read is retried at the next call if the I2C bus is in use. When the device does not
+  * 		report ready after MCP4725_EEPROM_MAX_POLLS reads, the queued Fast Mode write is dropped and
+  * 		mcp4725_ErrorCallback is called.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval None
+  */
+void mcp4725_EEPROM_Poll(MCP4725_Handle_t* mcp4725_dev){
+
+	if( mcp4725_dev->state != MCP4725_STATE_BUSY_EEPROM ){
+		return;
+	}
+
+	if( mcp4725_dev->eeprom_polls >= MCP4725_EEPROM_MAX_POLLS ){
+		/* The device never reported ready, the EEPROM content is unknown. The queued write is dropped,
+		   the device may still be programming */
+		mcp4725_eeprom_done(mcp4725_dev, 0);
+		mcp4725_dev->cache_stale = 1;
+		mcp4725_ErrorCallback(mcp4725_dev);
+		return;
+	}
+
+	mcp4725_dev->eeprom_polls++;
+	mcp4725_async_start(mcp4725_dev, MCP4725_OP_STATUS, mcp4725_dev->pending_dac, (MCP4725_PowerDown_e) mcp4725_dev->pending_pd);
+
+}
+
+/**
+  * @brief  Select the suppression of the redundant Fast Mode writes.
+  * @note	The cache is marked stale, the first write (or the first verify) synchronizes it with the device.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @param  cache_mode Reference to MCP4725_Cache_e
+  * @retval None
+  */
+void mcp4725_Set_Cache_Mode(MCP4725_Handle_t* mcp4725_dev, MCP4725_Cache_e cache_mode){
+
+	mcp4725_dev->cache_mode = cache_mode;
+	mcp4725_dev->cache_stale = 1;
+	mcp4725_dev->skipped_writes = 0;
+
+}
+
+/**
+  * @brief  Mark the cached values as unknown, the next write is sent to the device.
+  * @note	Call it when the device state changed outside of this handle: a general call sent for other
+  * 		device of the bus, a power cycle of the DAC.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval None
+  */
+void mcp4725_Invalidate_Cache(MCP4725_Handle_t* mcp4725_dev){
+	mcp4725_dev->cache_stale = 1;
+}
+
+/**
+  * @brief  Read back the DAC register and EEPROM (5 bytes) only if the cache is stale.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval HAL_OK if the cache is valid, HAL_ERROR if the read failed.
+  */
+HAL_StatusTypeDef mcp4725_Verify_Cache(MCP4725_Handle_t* mcp4725_dev){
+
+	if( mcp4725_dev->cache_stale == 0 ){
+		return HAL_OK;
+	}
+
+	return mcp4725_Read_DAC_EEPROM(mcp4725_dev);
+}
+
+/**
+  * @brief  Check if a Fast Mode write would not change the device, the write is counted as skipped.
+  * @note	Does not use the bus. The asynchronous functions always start the transfer, check it before them.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval 1 if the write can be skipped: cache enabled, not stale and same DAC register and power down mode.
+  */
+uint8_t mcp4725_Cache_Hit(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode){
+
+	if( mcp4725_dev->cache_mode == MCP4725_CACHE_OFF || mcp4725_dev->cache_stale ){
+		return 0;
+	}
+
+	if( mcp4725_dev->dac_register != ( dac_data & 0xFFF ) || mcp4725_dev->powerdown_mode != pd_mode ){
+		return 0;
+	}
+
+	mcp4725_dev->skipped_writes++;
+	return 1;
+}
+
+/**
+  * @brief  End of the asynchronous transfer on the I2C bus, update the instance as the blocking functions do.
+  * @note	Call from HAL_I2C_MasterTxCpltCallback and HAL_I2C_MasterRxCpltCallback. The transfers that were
+  * 		not started by this driver are ignored.
+  * @param  hi2c Pointer to the I2C_HandleTypeDef of the completed transfer.
+  * @retval None
+  */
+void mcp4725_I2C_CpltCallback(I2C_HandleTypeDef* hi2c){
+
+	MCP4725_Handle_t* mcp4725_dev = mcp4725_async_release(hi2c);
+	if( mcp4725_dev == NULL )	return;
+
+	switch( mcp4725_dev->operation ){
+		case MCP4725_OP_FAST_MODE:
+			mcp4725_dev->dac_register = mcp4725_dev->pending_dac;
+			mcp4725_dev->powerdown_mode = mcp4725_dev->pending_pd;
+			mcp4725_dev->cache_stale = 0;
+			break;
+		case MCP4725_OP_READ:
+			mcp4725_Decode_DAC_EEPROM(mcp4725_dev, mcp4725_dev->buffer);
+			mcp4725_dev->cache_stale = 0;
+			break;
+		case MCP4725_OP_GC_RESET:
+			if( mcp4725_dev->eeprom_stale == 0 ){
+				mcp4725_dev->dac_register = mcp4725_dev->eeprom_dac_register;
+				mcp4725_dev->powerdown_mode = mcp4725_dev->eeprom_powerdown_mode;
+			}
+			mcp4725_dev->cache_stale = 1;
+			break;
+		case MCP4725_OP_GC_WAKEUP:
+			mcp4725_dev->powerdown_mode = MCP4725_NORMAL_MODE;
+			mcp4725_dev->cache_stale = 1;
+			break;
+		case MCP4725_OP_EEPROM_COMMIT:
+			/* The device is programming the EEPROM, poll its status */
+			mcp4725_dev->state = MCP4725_STATE_BUSY_EEPROM;
+			return;
+		case MCP4725_OP_STATUS:
+			if( ( mcp4725_dev->buffer[0] & READ_RDY_BSY ) == 0 ){
+				mcp4725_dev->state = MCP4725_STATE_BUSY_EEPROM;
+				return;
+			}
+			/* The command also loaded the DAC register */
+			mcp4725_dev->eeprom_dac_register = mcp4725_dev->pending_dac;
+			mcp4725_dev->eeprom_powerdown_mode = mcp4725_dev->pending_pd;
+			mcp4725_dev->eeprom_stale = 0;
+			mcp4725_dev->dac_register = mcp4725_dev->pending_dac;
+			mcp4725_dev->powerdown_mode = mcp4725_dev->pending_pd;
+			mcp4725_dev->cache_stale = 0;
+			mcp4725_eeprom_done(mcp4725_dev, 1);
+			mcp4725_EEPROM_CpltCallback(mcp4725_dev);
+			return;
+		default:
+			mcp4725_dev->cache_stale = 1;
+			break;
+	}
+
+	mcp4725_dev->state = MCP4725_STATE_READY;
+
+	if( mcp4725_dev->operation == MCP4725_OP_READ ){
+		mcp4725_RxCpltCallback(mcp4725_dev);
+	}else{
+		mcp4725_TxCpltCallback(mcp4725_dev);
+	}
+
+}
+
+/**
+  * @brief  The asynchronous transfer on the I2C bus failed (NACK, arbitration lost, bus error).
+  * @note	Call from HAL_I2C_ErrorCallback, the cause is in hi2c->ErrorCode. The instance is not updated.
+  * @param  hi2c Pointer to the I2C_HandleTypeDef of the failed transfer.
+  * @retval None
+  */
+void mcp4725_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c){
+
+	MCP4725_Handle_t* mcp4725_dev = mcp4725_async_release(hi2c);
+	if( mcp4725_dev == NULL )	return;
+
+	if( mcp4725_dev->operation == MCP4725_OP_STATUS ){
+		/* Retried at the next poll */
+		mcp4725_dev->state = MCP4725_STATE_BUSY_EEPROM;
+		return;
+	}
+
+	mcp4725_dev->cache_stale = 1;
+
+	if( mcp4725_dev->operation == MCP4725_OP_EEPROM_COMMIT ){
+		mcp4725_eeprom_done(mcp4725_dev, 1);
+	}else{
+		mcp4725_dev->state = MCP4725_STATE_READY;
+	}
+
+	mcp4725_ErrorCallback(mcp4725_dev);
+
+}
+
+/**
+  * @brief  Asynchronous write completed callback.
+  * @note	This function should not be modified, when the callback is needed it can be implemented in the user file.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval None
+  */
+__weak void mcp4725_TxCpltCallback(MCP4725_Handle_t* mcp4725_dev){
+	UNUSED(mcp4725_dev);
+}
+
+/**
+  * @brief  Asynchronous read completed callback, the instance is already updated.
+  * @note	This function should not be modified, when the callback is needed it can be implemented in the user file.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval None
+  */
+__weak void mcp4725_RxCpltCallback(MCP4725_Handle_t* mcp4725_dev){
+	UNUSED(mcp4725_dev);
+}
+
+/**
+  * @brief  Asynchronous transfer error callback.
+  * @note	This function should not be modified, when the callback is needed it can be implemented in the user file.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval None
+  */
+__weak void mcp4725_ErrorCallback(MCP4725_Handle_t* mcp4725_dev){
+	UNUSED(mcp4725_dev);
+}
+
+/**
+  * @brief  EEPROM commit completed callback, the device is ready and eeprom_dac_register / eeprom_powerdown_mode are updated.
+  * @note	This function should not be modified, when the callback is needed it can be implemented in the user file.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @retval None
+  */
+__weak void mcp4725_EEPROM_CpltCallback(MCP4725_Handle_t* mcp4725_dev){
+	UNUSED(mcp4725_dev);
+}
+
+/**
+  * @brief  Encode the Fast Mode write command: power down bits (PD1, PD0) and the 12 bits of the DAC register.
+  * @param  data Buffer of 2 bytes to store the command in the order sent to the device.
+  * @param  dac_data 12-bit value for DAC output.
+  * @param  pd_mode Power Down Mode. Reference to MCP4725_PowerDown_e
+  * @retval None
+  */
+void mcp4725_Encode_Fast_Mode(uint8_t data[2], uint16_t dac_data, MCP4725_PowerDown_e pd_mode){
+
+	data[0] = ( ( (uint8_t) pd_mode) << FM_POWERDOWN_POS ) | ( ( dac_data & 0xF00 ) >> 8 );
+	data[1] =  (uint8_t) ( dac_data & 0xFF);
+
+}
+
+/**
+  * @brief  Encode the Write DAC Register and EEPROM command.
+  * @param  data Buffer of 3 bytes to store the command in the order sent to the device.
+  * @param  dac_data 12-bit value for DAC output.
+  * @param  pd_mode Power Down Mode. Reference to MCP4725_PowerDown_e
+  * @retval None
+  */
+void mcp4725_Encode_DAC_EEPROM(uint8_t data[3], uint16_t dac_data, MCP4725_PowerDown_e pd_mode){
+
+	data[0] = ( WRITE_EEPROM_CMD << WRITE_EEPROM_CMD_POS )  | ( pd_mode << WRITE_EEPROM_PD_POS);
+	data[1] = ( (dac_data & 0xFF0) >> 4);
+	data[2] = ( (dac_data & 0x0F) << 4);
+
+}
+
+/**
+  * @brief  Update the MCP4725_Handle_t instance with the first 3 bytes read from the device (status and DAC Register).
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @param  data The 3 bytes read from the device.
+  * @retval None
+  */
+void mcp4725_Decode_DAC_Register(MCP4725_Handle_t* mcp4725_dev, const uint8_t data[3]){
+
+	mcp4725_dev->powerdown_mode = (data[0] & 0x06) >> 1;
+	mcp4725_dev->dac_register = (data[1] << 4) | ( ( data[2] & 0xF0) >> 4 );
+
+}
+
+/**
+  * @brief  Update the MCP4725_Handle_t instance with the 5 bytes read from the device (DAC Register and EEPROM).
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @param  data The 5 bytes read from the device.
+  * @retval None
+  */
+void mcp4725_Decode_DAC_EEPROM(MCP4725_Handle_t* mcp4725_dev, const uint8_t data[5]){
+
+	mcp4725_Decode_DAC_Register(mcp4725_dev, data);
+	mcp4725_dev->eeprom_powerdown_mode = (data[3] & 0x60) >> 5;
+	mcp4725_dev->eeprom_dac_register = ( (data[3] & 0x0F) << 8 ) | data[4];
+	mcp4725_dev->eeprom_stale = 0;
+
+}
+
+/**
+  * @brief  Claim the device and its I2C bus, encode the command and start the transfer in IT or DMA Mode.
+  * @note	The claim is done with the IRQs disabled, so the functions can be called from any IRQ priority.
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef mcp4725_async_start(MCP4725_Handle_t* mcp4725_dev, MCP4725_Operation_e operation, uint16_t dac_data, MCP4725_PowerDown_e pd_mode){
+
+	I2C_HandleTypeDef* hi2c = mcp4725_dev->i2c_handle;
+	uint8_t slot = MCP4725_MAX_I2C_BUS;
+
+	/* The status read is the only transfer while the EEPROM is programmed */
+	MCP4725_State_e required = ( operation == MCP4725_OP_STATUS ) ? MCP4725_STATE_BUSY_EEPROM : MCP4725_STATE_READY;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if( mcp4725_dev->eeprom_busy && operation == MCP4725_OP_FAST_MODE ){
+		/* Sent when the EEPROM commit ends */
+		mcp4725_dev->queued_dac = dac_data;
+		mcp4725_dev->queued_pd = pd_mode;
+		mcp4725_dev->queued = 1;
+		__set_PRIMASK(primask);
+		return HAL_OK;
+	}
+
+	if( mcp4725_dev->state == required ){
+		for( uint8_t idx = 0; idx < MCP4725_MAX_I2C_BUS; idx++ ){
+			if( async_xfer[idx] != NULL && async_xfer[idx]->i2c_handle == hi2c ){
+				slot = MCP4725_MAX_I2C_BUS;		/* Other device is using the bus */
+				break;
+			}
+			if( async_xfer[idx] == NULL && slot == MCP4725_MAX_I2C_BUS ){
+				slot = idx;
+			}
+		}
+	}
+
+	if( slot != MCP4725_MAX_I2C_BUS ){
+		async_xfer[slot] = mcp4725_dev;
+		mcp4725_dev->state = ( operation == MCP4725_OP_READ || operation == MCP4725_OP_STATUS ) ? MCP4725_STATE_BUSY_RX : MCP4725_STATE_BUSY_TX;
+		if( operation == MCP4725_OP_EEPROM_COMMIT ){
+			mcp4725_dev->eeprom_busy = 1;
+			mcp4725_dev->eeprom_polls = 0;
+		}
+	}
+
+	__set_PRIMASK(primask);
+
+	if( slot == MCP4725_MAX_I2C_BUS ){
+		return HAL_BUSY;
+	}
+
+	mcp4725_dev->operation = operation;
+	mcp4725_dev->pending_dac = dac_data;
+	mcp4725_dev->pending_pd = pd_mode;
+
+	uint16_t dev_addr = mcp4725_dev->dev_addr << 1;
+	uint16_t size = 0;
+
+	switch( operation ){
+		case MCP4725_OP_FAST_MODE:
+			mcp4725_Encode_Fast_Mode(mcp4725_dev->buffer, dac_data, pd_mode);
+			size = 2;
+			break;
+		case MCP4725_OP_DAC_EEPROM:
+		case MCP4725_OP_EEPROM_COMMIT:
+			mcp4725_Encode_DAC_EEPROM(mcp4725_dev->buffer, dac_data, pd_mode);
+			size = 3;
+			break;
+		case MCP4725_OP_READ:
+			size = 5;
+			break;
+		case MCP4725_OP_STATUS:
+			size = 1;
+			break;
+		case MCP4725_OP_GC_RESET:
+			mcp4725_dev->buffer[0] = MCP4725_GENERAL_CALL_RESET;
+			dev_addr = MCP4725_GENERAL_CALL_ADDR;
+			size = 1;
+			break;
+		case MCP4725_OP_GC_WAKEUP:
+			mcp4725_dev->buffer[0] = MCP4725_GENERAL_CALL_WAKEUP;
+			dev_addr = MCP4725_GENERAL_CALL_ADDR;
+			size = 1;
+			break;
+		default:
+			break;
+	}
+
+	HAL_StatusTypeDef status;
+
+	if( operation == MCP4725_OP_READ || operation == MCP4725_OP_STATUS ){
+		if( mcp4725_dev->xfer_mode == MCP4725_XFER_DMA ){
+			status = HAL_I2C_Master_Receive_DMA(hi2c, dev_addr, mcp4725_dev->buffer, size);
+		}else{
+			status = HAL_I2C_Master_Receive_IT(hi2c, dev_addr, mcp4725_dev->buffer, size);
+		}
+	}else{
+		if( mcp4725_dev->xfer_mode == MCP4725_XFER_DMA ){
+			status = HAL_I2C_Master_Transmit_DMA(hi2c, dev_addr, mcp4725_dev->buffer, size);
+		}else{
+			status = HAL_I2C_Master_Transmit_IT(hi2c, dev_addr, mcp4725_dev->buffer, size);
+		}
+	}
+
+	if( status != HAL_OK ){
+		/* The transfer was not started (I2C used by other driver), release the bus */
+		mcp4725_async_release(hi2c);
+		if( operation == MCP4725_OP_STATUS ){
+			mcp4725_dev->state = MCP4725_STATE_BUSY_EEPROM;
+		}else if( operation == MCP4725_OP_EEPROM_COMMIT ){
+			mcp4725_eeprom_done(mcp4725_dev, 1);
+		}else{
+			mcp4725_dev->state = MCP4725_STATE_READY;
+		}
+	}
+
+	return status;
+}
+
+/**
+  * @brief  Search the device with the asynchronous transfer in progress on the I2C bus and release the bus.
+  * @retval Pointer to the device, NULL if the transfer was not started by this driver.
+  */
+static MCP4725_Handle_t* mcp4725_async_release(I2C_HandleTypeDef* hi2c){
+
+	MCP4725_Handle_t* mcp4725_dev = NULL;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	for( uint8_t idx = 0; idx < MCP4725_MAX_I2C_BUS; idx++ ){
+		if( async_xfer[idx] != NULL && async_xfer[idx]->i2c_handle == hi2c ){
+			mcp4725_dev = async_xfer[idx];
+			async_xfer[idx] = NULL;
+			break;
+		}
+	}
+
+	__set_PRIMASK(primask);
+
+	return mcp4725_dev;
+}
+
+/**
+  * @brief  End of the EEPROM commit, the device accepts commands again: send the queued Fast Mode write.
+  * @param  send_queued 0 to drop the queued write (commit timed out).
+  */
+static void mcp4725_eeprom_done(MCP4725_Handle_t* mcp4725_dev, uint8_t send_queued){
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint8_t queued = mcp4725_dev->queued;
+	mcp4725_dev->queued = 0;
+	mcp4725_dev->eeprom_busy = 0;
+	mcp4725_dev->state = MCP4725_STATE_READY;
+
+	__set_PRIMASK(primask);
+
+	if( queued && send_queued ){
+		mcp4725_async_start(mcp4725_dev, MCP4725_OP_FAST_MODE, mcp4725_dev->queued_dac, (MCP4725_PowerDown_e) mcp4725_dev->queued_pd);
+	}
+
+}
+
+/**
+  * @brief  Decide if a blocking Fast Mode write is redundant. In MCP4725_CACHE_VERIFY mode a stale cache is read first.
+  * @retval 1 if the write must be skipped.
+  */
+static uint8_t mcp4725_cache_skip(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode){
+
+	if( mcp4725_dev->cache_mode == MCP4725_CACHE_VERIFY ){
+		mcp4725_Verify_Cache(mcp4725_dev);
+	}
+
+	return mcp4725_Cache_Hit(mcp4725_dev, dac_data, pd_mode);
+}
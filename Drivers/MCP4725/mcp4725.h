@@ -11,6 +11,18 @@
 #ifndef MCP4725_MCP4725_H_
 #define MCP4725_MCP4725_H_
 
+#define MCP4725_GENERAL_CALL_ADDR	0x00
+#define MCP4725_GENERAL_CALL_RESET	0x06
+#define MCP4725_GENERAL_CALL_WAKEUP	0x09
+
+#ifndef MCP4725_EEPROM_MAX_POLLS
+#define MCP4725_EEPROM_MAX_POLLS	100		/* Status reads before an EEPROM commit fails, 100 ms polling every 1 ms (datasheet: 50 ms max) */
+#endif
+
+#ifndef MCP4725_MAX_I2C_BUS
+#define MCP4725_MAX_I2C_BUS			3		/* I2C buses with an asynchronous transfer in progress at the same time */
+#endif
+
 /* Enumerators for MCP4725 configurations */
 
 typedef enum mcp4725_powerdown_modes{
@@ -21,6 +33,35 @@ typedef enum mcp4725_powerdown_modes{
 	MCP4725_PD_LEN
 }MCP4725_PowerDown_e;
 
+typedef enum mcp4725_states{
+	MCP4725_STATE_READY		=	0,		/* No asynchronous transfer in progress */
+	MCP4725_STATE_BUSY_TX,				/* Asynchronous write in progress */
+	MCP4725_STATE_BUSY_RX,				/* Asynchronous read in progress */
+	MCP4725_STATE_BUSY_EEPROM,			/* EEPROM programming after a commit, the Fast Mode writes are queued */
+}MCP4725_State_e;
+
+typedef enum mcp4725_xfer_modes{
+	MCP4725_XFER_IT			=	0,		/* Asynchronous transfers in Interrupt Mode */
+	MCP4725_XFER_DMA,					/* Asynchronous transfers in DMA Mode, the DMA must be linked to the I2C handle */
+}MCP4725_Xfer_e;
+
+typedef enum mcp4725_operations{
+	MCP4725_OP_NONE			=	0,
+	MCP4725_OP_FAST_MODE,				/* Write DAC register and power down bits */
+	MCP4725_OP_DAC_EEPROM,				/* Write DAC register and EEPROM */
+	MCP4725_OP_READ,					/* Read DAC register and EEPROM */
+	MCP4725_OP_GC_RESET,				/* General call reset */
+	MCP4725_OP_GC_WAKEUP,				/* General call wake-up */
+	MCP4725_OP_EEPROM_COMMIT,			/* Write DAC register and EEPROM, then poll the RDY/BSY bit */
+	MCP4725_OP_STATUS,					/* Read the status byte (RDY/BSY) */
+}MCP4725_Operation_e;
+
+typedef enum mcp4725_cache_modes{
+	MCP4725_CACHE_OFF		=	0,		/* Every write is sent to the device */
+	MCP4725_CACHE_WRITE_THROUGH,		/* Skip the Fast Mode writes equal to the cached values, a stale cache is written */
+	MCP4725_CACHE_VERIFY,				/* As write-through, a stale cache is read back from the device before the compare */
+}MCP4725_Cache_e;
+
 /* MCP4725 Handle Structure */
 
 typedef struct mcp4725_handle {
@@ -30,10 +71,26 @@ typedef struct mcp4725_handle {
 	uint32_t 			dev_addr				: 8  ;	/* Store the mcp4725 slave address, commonly address are 0x60 or 0x61, depend of the logic state of the A0 pin*/
 	uint8_t				powerdown_mode			: 2  ;	/* Store the last power down mode written to the device, reference to MCP4725_PowerDown_e */
 	uint8_t 			eeprom_powerdown_mode	: 2  ;	/* Store the power down mode save when EEPROM is read */
+	__IO uint8_t		eeprom_stale;					/* 1 until the EEPROM is read (device found by a bus scan), mcp4725_Get_EEPROM reads it */
+	MCP4725_Xfer_e		xfer_mode;						/* Select Interrupt or DMA Mode for the asynchronous functions, reference to MCP4725_Xfer_e */
+	__IO MCP4725_State_e state;							/* Asynchronous transfer in progress, reference to MCP4725_State_e */
+	uint8_t				operation;						/* Asynchronous command in progress, reference to MCP4725_Operation_e */
+	uint8_t				pending_pd;						/* Power down mode written by the asynchronous command, stored when it ends */
+	uint16_t			pending_dac;					/* DAC register written by the asynchronous command, stored when it ends */
+	uint8_t				buffer[5];						/* Bytes of the asynchronous transfer, valid until it ends */
+	MCP4725_Cache_e		cache_mode;						/* Suppression of the redundant writes, reference to MCP4725_Cache_e */
+	__IO uint8_t		cache_stale;					/* 1 when dac_register/powerdown_mode may differ from the device (I2C error, general call, EEPROM write) */
+	uint32_t			skipped_writes;					/* Writes suppressed by the cache */
+	__IO uint8_t		eeprom_busy;					/* 1 from the start of an EEPROM commit until the device is ready */
+	uint16_t			eeprom_polls;					/* Status reads of the EEPROM commit in progress */
+	uint8_t				queued;							/* 1 if a Fast Mode write waits the end of the EEPROM commit */
+	uint8_t				queued_pd;						/* Power down mode of the queued write */
+	uint16_t			queued_dac;						/* DAC register of the queued write, a new write replaces it */
 }MCP4725_Handle_t;
 
-/* Initialization function */
+/* Initialization functions */
 HAL_StatusTypeDef mcp4725_Init(MCP4725_Handle_t* mcp4725_dev, I2C_HandleTypeDef* i2c_handle, uint8_t mcp4725_addr, uint16_t dac_data, MCP4725_PowerDown_e pd_mode);
+void mcp4725_Handle_Init(MCP4725_Handle_t* mcp4725_dev, I2C_HandleTypeDef* i2c_handle, uint8_t mcp4725_addr);
 
 /* Control functions */
 HAL_StatusTypeDef mcp4725_Write_PowerDown_DAC_Register(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode);
@@ -43,9 +100,46 @@ HAL_StatusTypeDef mcp4725_Write_PowerDown(MCP4725_Handle_t* mcp4725_dev, MCP4725
 /* Write and Read data to/from EEPROM */
 HAL_StatusTypeDef mcp4725_Write_DAC_EEPROM(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode);
 HAL_StatusTypeDef mcp4725_Read_DAC_EEPROM(MCP4725_Handle_t* mcp4725_dev);
+HAL_StatusTypeDef mcp4725_Get_EEPROM(MCP4725_Handle_t* mcp4725_dev, uint16_t* dac_data, MCP4725_PowerDown_e* pd_mode);
 
 /* General call*/
 HAL_StatusTypeDef mcp4725_GeneralCall_Reset(MCP4725_Handle_t* mcp4725_dev);
 HAL_StatusTypeDef mcp4725_GeneralCall_WakeUp(MCP4725_Handle_t* mcp4725_dev);
 
+/* Asynchronous functions, return at once and the end is notified by the callbacks */
+HAL_StatusTypeDef mcp4725_Write_PowerDown_DAC_Register_Async(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode);
+HAL_StatusTypeDef mcp4725_Write_DAC_Register_Async(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data);
+HAL_StatusTypeDef mcp4725_Write_PowerDown_Async(MCP4725_Handle_t* mcp4725_dev, MCP4725_PowerDown_e pd_mode);
+HAL_StatusTypeDef mcp4725_Write_DAC_EEPROM_Async(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode);
+HAL_StatusTypeDef mcp4725_Read_DAC_EEPROM_Async(MCP4725_Handle_t* mcp4725_dev);
+HAL_StatusTypeDef mcp4725_GeneralCall_Reset_Async(MCP4725_Handle_t* mcp4725_dev);
+HAL_StatusTypeDef mcp4725_GeneralCall_WakeUp_Async(MCP4725_Handle_t* mcp4725_dev);
+MCP4725_State_e mcp4725_GetState(MCP4725_Handle_t* mcp4725_dev);
+
+/* Non-blocking EEPROM commit, poll every 1 ms from a timer IRQ until the device is ready */
+HAL_StatusTypeDef mcp4725_Write_DAC_EEPROM_Commit(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode);
+void mcp4725_EEPROM_Poll(MCP4725_Handle_t* mcp4725_dev);
+
+/* Write suppression cache */
+void mcp4725_Set_Cache_Mode(MCP4725_Handle_t* mcp4725_dev, MCP4725_Cache_e cache_mode);
+void mcp4725_Invalidate_Cache(MCP4725_Handle_t* mcp4725_dev);
+HAL_StatusTypeDef mcp4725_Verify_Cache(MCP4725_Handle_t* mcp4725_dev);
+uint8_t mcp4725_Cache_Hit(MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode);
+
+/* Call from HAL_I2C_MasterTxCpltCallback / HAL_I2C_MasterRxCpltCallback and HAL_I2C_ErrorCallback */
+void mcp4725_I2C_CpltCallback(I2C_HandleTypeDef* hi2c);
+void mcp4725_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c);
+
+/* Weak callbacks of the asynchronous functions, implement them in the user file */
+void mcp4725_TxCpltCallback(MCP4725_Handle_t* mcp4725_dev);
+void mcp4725_RxCpltCallback(MCP4725_Handle_t* mcp4725_dev);
+void mcp4725_ErrorCallback(MCP4725_Handle_t* mcp4725_dev);
+void mcp4725_EEPROM_CpltCallback(MCP4725_Handle_t* mcp4725_dev);
+
+/* Command encoding, shared by the blocking functions and other transfer layers */
+void mcp4725_Encode_Fast_Mode(uint8_t data[2], uint16_t dac_data, MCP4725_PowerDown_e pd_mode);
+void mcp4725_Encode_DAC_EEPROM(uint8_t data[3], uint16_t dac_data, MCP4725_PowerDown_e pd_mode);
+void mcp4725_Decode_DAC_Register(MCP4725_Handle_t* mcp4725_dev, const uint8_t data[3]);
+void mcp4725_Decode_DAC_EEPROM(MCP4725_Handle_t* mcp4725_dev, const uint8_t data[5]);
+
 #endif /* MCP4725_MCP4725_H_ */
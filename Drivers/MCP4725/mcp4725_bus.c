@@ -0,0 +1,415 @@
+/*
+ * mcp4725_bus.c
+ *
+ *  I2C bus manager, prioritized queue of transactions run back to back in IT or DMA Mode.
+ *
+ *  The queue is a linked list of the descriptors of the callers, no memory is allocated. The claim of
+ *  the bus is done with the IRQs disabled, so the transactions can be submitted from any IRQ priority.
+ *  When the I2C peripheral is used by other code (HAL_BUSY) the transaction stays at the head of the
+ *  queue and it is started again at the next completion callback of the bus.
+ */
+
+#include "mcp4725_bus.h"
+
+#define BUS_SCL_PER_BYTE	9U		/* 8 bits and ACK */
+#define BUS_SCL_START_STOP	2U		/* START and STOP conditions */
+#define BUS_PER_MILLE		1000U
+
+/* Managed buses */
+static MCP4725_Bus_Handle_t* buses[MCP4725_MAX_I2C_BUS] = {0};
+
+static MCP4725_Bus_Handle_t* mcp4725_bus_find(I2C_HandleTypeDef* hi2c);
+static void mcp4725_bus_insert(MCP4725_Bus_Handle_t* bus, MCP4725_Bus_Xfer_t* xfer);
+static void mcp4725_bus_start_next(MCP4725_Bus_Handle_t* bus);
+static void mcp4725_bus_complete(MCP4725_Bus_Handle_t* bus, HAL_StatusTypeDef status);
+static MCP4725_Bus_Client_t* mcp4725_bus_client(MCP4725_Bus_Handle_t* bus, uint8_t dev_addr);
+
+/**
+  * @brief  Register the I2C peripheral in the manager.
+  * @param  bus Pointer to a MCP4725_Bus_Handle_t structure.
+  * @param  i2c_handle I2C peripheral initialized, with the event/error IRQs (and the DMA in DMA Mode) enabled.
+  * @param  bus_clock SCL frequency in Hz (hi2c.Init.ClockSpeed on STM32F1/F4).
+  * @param  xfer_mode Reference to MCP4725_Xfer_e
+  * @retval HAL_OK, HAL_ERROR if there are MCP4725_MAX_I2C_BUS buses.
+  */
+HAL_StatusTypeDef mcp4725_Bus_Init(MCP4725_Bus_Handle_t* bus, I2C_HandleTypeDef* i2c_handle, uint32_t bus_clock, MCP4725_Xfer_e xfer_mode){
+
+	bus->i2c_handle = i2c_handle;
+	bus->bus_clock = bus_clock;
+	bus->xfer_mode = xfer_mode;
+	bus->head = NULL;
+	bus->active = NULL;
+
+	mcp4725_Bus_Reset_Stats(bus);
+
+	for( uint8_t idx = 0; idx < MCP4725_MAX_I2C_BUS; idx++ ){
+		if( buses[idx] == NULL || buses[idx] == bus ){
+			buses[idx] = bus;
+			return HAL_OK;
+		}
+	}
+
+	return HAL_ERROR;
+}
+
+/**
+  * @brief  Queue the transaction by priority, it is started at once if the bus is idle.
+  * @note	The descriptor must stay valid until its callback is called.
+  * @param  xfer Descriptor filled by the caller or by the mcp4725_Bus_Prepare_xxx functions.
+  * @retval HAL_OK, HAL_BUSY if the descriptor is already queued, HAL_ERROR if it is not valid.
+  */
+HAL_StatusTypeDef mcp4725_Bus_Submit(MCP4725_Bus_Handle_t* bus, MCP4725_Bus_Xfer_t* xfer){
+
+	if( xfer->data == NULL || xfer->size == 0 ){
+		return HAL_ERROR;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if( xfer->queued ){
+		__set_PRIMASK(primask);
+		return HAL_BUSY;
+	}
+
+	xfer->queued = 1;
+	mcp4725_bus_insert(bus, xfer);
+
+	__set_PRIMASK(primask);
+
+	mcp4725_bus_start_next(bus);
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Remove a transaction from the queue, its callback is not called.
+  * @retval HAL_OK, HAL_BUSY if the transaction is on the bus, HAL_ERROR if it is not queued.
+  */
+HAL_StatusTypeDef mcp4725_Bus_Cancel(MCP4725_Bus_Handle_t* bus, MCP4725_Bus_Xfer_t* xfer){
+
+	HAL_StatusTypeDef status = HAL_ERROR;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if( bus->active == xfer ){
+		status = HAL_BUSY;
+	}else{
+		for( MCP4725_Bus_Xfer_t** link = &bus->head; *link != NULL; link = &(*link)->next ){
+			if( *link == xfer ){
+				*link = xfer->next;
+				xfer->queued = 0;
+				status = HAL_OK;
+				break;
+			}
+		}
+	}
+
+	__set_PRIMASK(primask);
+
+	return status;
+}
+
+/**
+  * @brief  Fill the descriptor with the Fast Mode write of the MCP4725, the instance is updated when it ends.
+  * @note	The callback and context of the descriptor are not modified. The descriptor must not be queued.
+  * @retval None
+  */
+void mcp4725_Bus_Prepare_Fast_Mode(MCP4725_Bus_Xfer_t* xfer, MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode, uint8_t priority){
+
+	mcp4725_Encode_Fast_Mode(xfer->buffer, dac_data, pd_mode);
+
+	xfer->dev_addr = mcp4725_dev->dev_addr;
+	xfer->dir = MCP4725_BUS_WRITE;
+	xfer->data = xfer->buffer;
+	xfer->size = 2;
+	xfer->priority = priority;
+	xfer->device = mcp4725_dev;
+	xfer->operation = MCP4725_OP_FAST_MODE;
+	xfer->dac_data = dac_data;
+	xfer->pd_mode = pd_mode;
+
+}
+
+/**
+  * @brief  Fill the descriptor with the write of the DAC register and EEPROM of the MCP4725.
+  * @note	The device programs the EEPROM after the transaction, commonly submitted with a low priority.
+  * @retval None
+  */
+void mcp4725_Bus_Prepare_DAC_EEPROM(MCP4725_Bus_Xfer_t* xfer, MCP4725_Handle_t* mcp4725_dev, uint16_t dac_data, MCP4725_PowerDown_e pd_mode, uint8_t priority){
+
+	mcp4725_Encode_DAC_EEPROM(xfer->buffer, dac_data, pd_mode);
+
+	xfer->dev_addr = mcp4725_dev->dev_addr;
+	xfer->dir = MCP4725_BUS_WRITE;
+	xfer->data = xfer->buffer;
+	xfer->size = 3;
+	xfer->priority = priority;
+	xfer->device = mcp4725_dev;
+	xfer->operation = MCP4725_OP_DAC_EEPROM;
+	xfer->dac_data = dac_data;
+	xfer->pd_mode = pd_mode;
+
+}
+
+/**
+  * @brief  Fill the descriptor with the read of the DAC register and EEPROM (5 bytes), the instance is updated when it ends.
+  * @retval None
+  */
+void mcp4725_Bus_Prepare_Read(MCP4725_Bus_Xfer_t* xfer, MCP4725_Handle_t* mcp4725_dev, uint8_t priority){
+
+	xfer->dev_addr = mcp4725_dev->dev_addr;
+	xfer->dir = MCP4725_BUS_READ;
+	xfer->data = xfer->buffer;
+	xfer->size = 5;
+	xfer->priority = priority;
+	xfer->device = mcp4725_dev;
+	xfer->operation = MCP4725_OP_READ;
+
+}
+
+/**
+  * @brief  End of a transaction on the I2C bus, call the callback and start the next one.
+  * @note	Call from HAL_I2C_MasterTxCpltCallback and HAL_I2C_MasterRxCpltCallback, with the other drivers of the bus.
+  * @param  hi2c Pointer to the I2C_HandleTypeDef of the completed transfer.
+  * @retval None
+  */
+void mcp4725_Bus_I2C_CpltCallback(I2C_HandleTypeDef* hi2c){
+
+	MCP4725_Bus_Handle_t* bus = mcp4725_bus_find(hi2c);
+	if( bus == NULL )	return;
+
+	if( bus->active != NULL ){
+		mcp4725_bus_complete(bus, HAL_OK);
+	}
+
+	/* Also when the transfer was started by other code, the bus is free again */
+	mcp4725_bus_start_next(bus);
+}
+
+/**
+  * @brief  A transaction failed (NACK, arbitration lost, bus error), call the callback with HAL_ERROR and start the next one.
+  * @note	Call from HAL_I2C_ErrorCallback, the cause is in hi2c->ErrorCode.
+  * @param  hi2c Pointer to the I2C_HandleTypeDef of the failed transfer.
+  * @retval None
+  */
+void mcp4725_Bus_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c){
+
+	MCP4725_Bus_Handle_t* bus = mcp4725_bus_find(hi2c);
+	if( bus == NULL )	return;
+
+	if( bus->active != NULL ){
+		mcp4725_bus_complete(bus, HAL_ERROR);
+	}
+
+	mcp4725_bus_start_next(bus);
+}
+
+/**
+  * @brief  Bus time used by a slave address since the reset of the statistics.
+  * @param  dev_addr 7-bit slave address.
+  * @retval Per mille of the elapsed time, 0 if the address has no transactions.
+  */
+uint16_t mcp4725_Bus_Utilisation(MCP4725_Bus_Handle_t* bus, uint8_t dev_addr){
+
+	uint32_t elapsed = HAL_GetTick() - bus->stats_tick;
+	if( elapsed == 0 )	return 0;
+
+	for( uint8_t idx = 0; idx < bus->num_clients; idx++ ){
+		if( bus->clients[idx].dev_addr == dev_addr ){
+			/* scl / ( bus_clock * elapsed / 1000 ) in per mille */
+			return (uint16_t) ( ( (uint64_t) bus->clients[idx].scl * BUS_PER_MILLE * 1000U ) / ( (uint64_t) bus->bus_clock * elapsed ) );
+		}
+	}
+
+	return 0;
+}
+
+/**
+  * @brief  Bus time used by all the transactions of the manager since the reset of the statistics.
+  * @retval Per mille of the elapsed time.
+  */
+uint16_t mcp4725_Bus_Total_Utilisation(MCP4725_Bus_Handle_t* bus){
+
+	uint64_t scl = 0;
+	uint32_t elapsed = HAL_GetTick() - bus->stats_tick;
+	if( elapsed == 0 )	return 0;
+
+	for( uint8_t idx = 0; idx < bus->num_clients; idx++ ){
+		scl += bus->clients[idx].scl;
+	}
+
+	return (uint16_t) ( ( scl * BUS_PER_MILLE * 1000U ) / ( (uint64_t) bus->bus_clock * elapsed ) );
+}
+
+/**
+  * @brief  Clear the statistics of all the slave addresses and restart the time base.
+  */
+void mcp4725_Bus_Reset_Stats(MCP4725_Bus_Handle_t* bus){
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	bus->num_clients = 0;
+	bus->stats_tick = HAL_GetTick();
+
+	__set_PRIMASK(primask);
+
+}
+
+/**
+  * @brief  Search the manager of the I2C peripheral.
+  */
+static MCP4725_Bus_Handle_t* mcp4725_bus_find(I2C_HandleTypeDef* hi2c){
+
+	for( uint8_t idx = 0; idx < MCP4725_MAX_I2C_BUS; idx++ ){
+		if( buses[idx] != NULL && buses[idx]->i2c_handle == hi2c ){
+			return buses[idx];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+  * @brief  Insert the descriptor sorted by priority, after the descriptors with the same priority.
+  * @note	Call with the IRQs disabled.
+  */
+static void mcp4725_bus_insert(MCP4725_Bus_Handle_t* bus, MCP4725_Bus_Xfer_t* xfer){
+
+	MCP4725_Bus_Xfer_t** link = &bus->head;
+
+	while( *link != NULL && (*link)->priority >= xfer->priority ){
+		link = &(*link)->next;
+	}
+
+	xfer->next = *link;
+	*link = xfer;
+}
+
+/**
+  * @brief  Start the transaction at the head of the queue if the bus is idle.
+  * @note	The check of the peripheral, the start and the publication of the active transaction are done
+  * 		with the IRQs disabled: a completion of other code can not take the transaction before it is on
+  * 		the bus, and its own completion always finds it. The IT/DMA starts do not wait for the transfer.
+  */
+static void mcp4725_bus_start_next(MCP4725_Bus_Handle_t* bus){
+
+	I2C_HandleTypeDef* hi2c = bus->i2c_handle;
+	MCP4725_Bus_Xfer_t* xfer;
+	HAL_StatusTypeDef status;
+
+	do{
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+
+		xfer = bus->head;
+
+		/* A transfer of other code is on the bus, retried at its completion callback */
+		if( bus->active != NULL || xfer == NULL || hi2c->State != HAL_I2C_STATE_READY ){
+			__set_PRIMASK(primask);
+			return;
+		}
+
+		uint16_t dev_addr = xfer->dev_addr << 1;
+
+		if( xfer->dir == MCP4725_BUS_READ ){
+			if( bus->xfer_mode == MCP4725_XFER_DMA ){
+				status = HAL_I2C_Master_Receive_DMA(hi2c, dev_addr, xfer->data, xfer->size);
+			}else{
+				status = HAL_I2C_Master_Receive_IT(hi2c, dev_addr, xfer->data, xfer->size);
+			}
+		}else{
+			if( bus->xfer_mode == MCP4725_XFER_DMA ){
+				status = HAL_I2C_Master_Transmit_DMA(hi2c, dev_addr, xfer->data, xfer->size);
+			}else{
+				status = HAL_I2C_Master_Transmit_IT(hi2c, dev_addr, xfer->data, xfer->size);
+			}
+		}
+
+		/* HAL_BUSY: the peripheral is used by other code, the transaction stays at the head */
+		if( status != HAL_BUSY ){
+			bus->head = xfer->next;
+			bus->active = xfer;
+		}
+
+		__set_PRIMASK(primask);
+
+		if( status == HAL_BUSY ){
+			return;
+		}
+
+		if( status != HAL_OK ){
+			mcp4725_bus_complete(bus, status);
+		}
+
+	}while( status != HAL_OK );
+}
+
+/**
+  * @brief  Account the bus time, update the MCP4725 instance and call the callback of the active transaction.
+  */
+static void mcp4725_bus_complete(MCP4725_Bus_Handle_t* bus, HAL_StatusTypeDef status){
+
+	MCP4725_Bus_Xfer_t* xfer = bus->active;
+	MCP4725_Bus_Client_t* client = mcp4725_bus_client(bus, xfer->dev_addr);
+
+	if( client != NULL ){
+		client->scl += BUS_SCL_PER_BYTE * ( xfer->size + 1U ) + BUS_SCL_START_STOP;
+		if( status == HAL_OK ){
+			client->xfers++;
+		}else{
+			client->errors++;
+		}
+	}
+
+	MCP4725_Handle_t* mcp4725_dev = xfer->device;
+	if( mcp4725_dev != NULL ){
+		if( status != HAL_OK ){
+			mcp4725_dev->cache_stale = 1;
+		}else if( xfer->operation == MCP4725_OP_FAST_MODE ){
+			mcp4725_dev->dac_register = xfer->dac_data;
+			mcp4725_dev->powerdown_mode = xfer->pd_mode;
+			mcp4725_dev->cache_stale = 0;
+		}else if( xfer->operation == MCP4725_OP_READ ){
+			mcp4725_Decode_DAC_EEPROM(mcp4725_dev, xfer->data);
+			mcp4725_dev->cache_stale = 0;
+		}else{
+			mcp4725_dev->cache_stale = 1;
+		}
+	}
+
+	/* The descriptor can be submitted again from its callback */
+	bus->active = NULL;
+	xfer->queued = 0;
+
+	if( xfer->callback != NULL ){
+		xfer->callback(xfer, status);
+	}
+}
+
+/**
+  * @brief  Statistics of the slave address, a new entry is added if there is space.
+  */
+static MCP4725_Bus_Client_t* mcp4725_bus_client(MCP4725_Bus_Handle_t* bus, uint8_t dev_addr){
+
+	for( uint8_t idx = 0; idx < bus->num_clients; idx++ ){
+		if( bus->clients[idx].dev_addr == dev_addr ){
+			return &bus->clients[idx];
+		}
+	}
+
+	if( bus->num_clients == MCP4725_BUS_MAX_CLIENTS ){
+		return NULL;
+	}
+
+	MCP4725_Bus_Client_t* client = &bus->clients[bus->num_clients];
+	client->dev_addr = dev_addr;
+	client->xfers = 0;
+	client->errors = 0;
+	client->scl = 0;
+	bus->num_clients++;
+
+	return client;
+}
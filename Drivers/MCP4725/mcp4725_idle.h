@@ -0,0 +1,80 @@
+/*
+ * mcp4725_idle.h
+ *
+ *  Idle manager for MCP4725. The output is put in a power down mode after a quiet period with no
+ *  writes, and woken with no extra transaction:
+ *
+ *  	Fast Mode wake: the first write after the power down has the PD bits at 0, the same transaction
+ *  	wakes the output and loads the new value.
+ *  	General call wake: mcp4725_Idle_Wake sends the 1-byte general call wake-up ahead of the writes (when
+ *  	the activity is known in advance), all the DACs of the bus come back at their previous values.
+ *
+ *  The time in power down gives the energy saved, from the supply currents of the datasheet (210 uA in
+ *  normal mode, 0.06 uA in power down). The wake latency, from the wake request to the end of the
+ *  transaction that clears the PD bits, is timed with the DWT cycle counter.
+ */
+
+#ifndef MCP4725_MCP4725_IDLE_H_
+#define MCP4725_MCP4725_IDLE_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+
+#ifndef MCP4725_IDLE_MAX_DEVICES
+#define MCP4725_IDLE_MAX_DEVICES	8			/* Managed devices, woken together by a general call */
+#endif
+
+#ifndef MCP4725_IDLE_SUPPLY_MV
+#define MCP4725_IDLE_SUPPLY_MV		3300		/* VDD of the devices */
+#endif
+
+#ifndef MCP4725_IDLE_ACTIVE_NA
+#define MCP4725_IDLE_ACTIVE_NA		210000		/* Supply current in normal mode, typical */
+#endif
+
+#ifndef MCP4725_IDLE_PD_NA
+#define MCP4725_IDLE_PD_NA			60			/* Supply current in power down, typical */
+#endif
+
+/* MCP4725 Idle Manager Structure */
+
+typedef struct mcp4725_idle{
+	MCP4725_Handle_t *		device;				/* Managed device */
+	MCP4725_PowerDown_e		pd_mode;			/* Power down mode of the idle output */
+	uint32_t				timeout_ms;			/* Quiet period before the power down */
+	__IO uint8_t			asleep;				/* 1 while the output is in power down */
+	__IO uint32_t			last_activity;		/* HAL tick of the last write */
+	uint32_t				state_tick;			/* HAL tick of the last power down or wake */
+	/* Statistics */
+	uint32_t				sleeps;				/* Power downs after a quiet period */
+	uint32_t				wakes;				/* Wakes by a write or a general call */
+	uint32_t				general_calls;		/* Wakes by a general call */
+	uint32_t				errors;				/* Power down or wake commands failed */
+	uint32_t				asleep_ms;			/* Time in power down, current period excluded */
+	uint32_t				awake_ms;			/* Time in normal mode, current period excluded */
+	uint32_t				last_wake_us;		/* Wake request to the end of the transaction */
+	uint32_t				max_wake_us;
+}MCP4725_Idle_t;
+
+/* Initialization function */
+HAL_StatusTypeDef mcp4725_Idle_Init(MCP4725_Idle_t* idle, MCP4725_Handle_t* mcp4725_dev, MCP4725_PowerDown_e pd_mode, uint32_t timeout_ms);
+
+/* Writes and wake */
+HAL_StatusTypeDef mcp4725_Idle_Write(MCP4725_Idle_t* idle, uint16_t dac_data);
+HAL_StatusTypeDef mcp4725_Idle_Wake(MCP4725_Idle_t* idle);
+void mcp4725_Idle_Touch(MCP4725_Idle_t* idle);
+HAL_StatusTypeDef mcp4725_Idle_Poll(MCP4725_Idle_t* idle);
+
+/* Statistics */
+uint32_t mcp4725_Idle_Asleep_Permille(const MCP4725_Idle_t* idle);
+uint32_t mcp4725_Idle_Energy_Saved_uJ(const MCP4725_Idle_t* idle);
+void mcp4725_Idle_Reset_Stats(MCP4725_Idle_t* idle);
+
+#endif /* MCP4725_MCP4725_IDLE_H_ */
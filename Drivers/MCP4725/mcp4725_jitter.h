@@ -0,0 +1,74 @@
+/*
+ * mcp4725_jitter.h
+ *
+ *  Jitter of the sample instants of MCP4725. The instants are stamped with a free running counter and
+ *  the period between two stamps is compared with the nominal period of the sample rate: peak to peak
+ *  and RMS deviation, mean period.
+ *
+ *  Two sources of stamps:
+ *  	DWT cycle counter: mcp4725_Jitter_Stamp_DWT where the write of the sample is started (timer IRQ in
+ *  	the IRQ paced mode). It measures the latency of the IRQ, the bus time after it is constant.
+ *  	Input capture: a channel of a free running timer (32-bit, or 16-bit with counter_mask 0xFFFF) wired
+ *  	to SCL captures the rising edges in a buffer by DMA. mcp4725_Jitter_Capture stamps the ACK clock of
+ *  	the DAC update: in the IRQ paced mode each transaction is framed by the idle gap before it (longer
+ *  	than 2 SCL periods), in the paced stream the bytes are counted 9 clocks each from the address byte.
+ *  	No CPU in the measure, the same wiring compares the IRQ paced and the timer paced
+ *  	(mcp4725_Stream_Start_Paced) output. Host/mcp4725_jitter_bench.c compares them on a latency model.
+ */
+
+#ifndef MCP4725_MCP4725_JITTER_H_
+#define MCP4725_MCP4725_JITTER_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+
+/* SCL rising edges of a sample and ACK clock stamped, in the input capture */
+#define MCP4725_JITTER_EDGES_SINGLE		28		/* Fast Mode write: 3 bytes with ACK and the STOP condition */
+#define MCP4725_JITTER_ACK_SINGLE		26		/* ACK of the second data byte, the DAC update */
+#define MCP4725_JITTER_EDGES_ADDR		9		/* Paced stream: address byte with ACK, at the start of the capture */
+#define MCP4725_JITTER_EDGES_PACED		18		/* Paced stream: 2 bytes with ACK, one per timer update */
+#define MCP4725_JITTER_ACK_PACED		17		/* ACK of the second byte, the DAC update */
+
+typedef enum mcp4725_jitter_captures{
+	MCP4725_JITTER_SINGLE = 0,		/* One write transaction per sample, IRQ paced */
+	MCP4725_JITTER_PACED			/* Open transaction, one byte per timer update */
+}MCP4725_Jitter_Capture_e;
+
+/* MCP4725 Jitter Structure */
+
+typedef struct mcp4725_jitter{
+	uint32_t				clock;				/* Frequency of the stamps, Hz */
+	uint32_t				nominal;			/* Nominal period, counts */
+	uint32_t				counter_mask;		/* Range of the counter, 0xFFFFFFFF or 0xFFFF */
+	uint32_t				last;				/* Previous stamp */
+	uint8_t					started;			/* 1 once the first stamp is taken */
+	uint32_t				periods;			/* Periods measured */
+	int32_t					min_error;			/* Smallest period - nominal, counts */
+	int32_t					max_error;			/* Largest period - nominal, counts */
+	int64_t					sum_error;			/* Sum of the errors, for the mean period */
+	uint64_t				sum_square;			/* Sum of the squared errors, for the RMS jitter */
+}MCP4725_Jitter_t;
+
+/* Initialization function */
+HAL_StatusTypeDef mcp4725_Jitter_Init(MCP4725_Jitter_t* jitter, uint32_t clock, uint32_t counter_mask, uint32_t sample_rate);
+HAL_StatusTypeDef mcp4725_Jitter_Init_DWT(MCP4725_Jitter_t* jitter, uint32_t sample_rate);
+void mcp4725_Jitter_Reset(MCP4725_Jitter_t* jitter);
+
+/* Stamps */
+void mcp4725_Jitter_Stamp(MCP4725_Jitter_t* jitter, uint32_t stamp);
+void mcp4725_Jitter_Stamp_DWT(MCP4725_Jitter_t* jitter);
+uint32_t mcp4725_Jitter_Capture(MCP4725_Jitter_t* jitter, const uint32_t* edges, uint32_t num_edges, uint32_t bus_clock, MCP4725_Jitter_Capture_e capture);
+
+/* Results */
+uint32_t mcp4725_Jitter_Peak_ns(const MCP4725_Jitter_t* jitter);
+uint32_t mcp4725_Jitter_RMS_ns(const MCP4725_Jitter_t* jitter);
+uint32_t mcp4725_Jitter_Mean_Period_ns(const MCP4725_Jitter_t* jitter);
+
+#endif /* MCP4725_MCP4725_JITTER_H_ */
@@ -0,0 +1,377 @@
+/*
+ * mcp4725_multi.c
+ *
+ *  Synchronous output of several MCP4725, one frame writes all the channels.
+ *
+ *  The channels of a bus are chained with the sequential transfers of the HAL: the first write is
+ *  started with a START condition, each next write is started from the completion IRQ of the previous
+ *  one with a repeated START and the new address, the last one ends with the STOP condition. All the
+ *  Fast Mode words are encoded before the first bus is started, so the buses start back to back.
+ *
+ *  The DAC output of the MCP4725 is updated at the ACK of the second byte of the Fast Mode write, the
+ *  completion IRQ follows it by a fixed delay, the same for all the channels, so the difference of the
+ *  stamps is the skew of the outputs.
+ */
+
+#include "mcp4725_multi.h"
+
+#define MULTI_NS_PER_S		1000000000ULL
+
+/* Multi-channel outputs registered */
+static MCP4725_Multi_Handle_t* multis[MCP4725_MAX_I2C_BUS] = {0};
+
+static MCP4725_Multi_Handle_t* mcp4725_multi_find(I2C_HandleTypeDef* hi2c, uint8_t* bus);
+static HAL_StatusTypeDef mcp4725_multi_start(MCP4725_Multi_Handle_t* multi, uint8_t bus);
+static void mcp4725_multi_abort(MCP4725_Multi_Handle_t* multi, uint8_t bus);
+static void mcp4725_multi_done(MCP4725_Multi_Handle_t* multi, uint8_t num_channels);
+
+/**
+  * @brief  Register the multi-channel output, with no channels, and start the DWT cycle counter.
+  * @param  multi Pointer to a MCP4725_Multi_Handle_t structure.
+  * @param  xfer_mode Reference to MCP4725_Xfer_e, the DMA of each I2C peripheral must be linked in DMA Mode.
+  * @retval HAL_OK, HAL_ERROR if there are MCP4725_MAX_I2C_BUS outputs.
+  */
+HAL_StatusTypeDef mcp4725_Multi_Init(MCP4725_Multi_Handle_t* multi, MCP4725_Xfer_e xfer_mode){
+
+	multi->num_channels = 0;
+	multi->num_buses = 0;
+	multi->xfer_mode = xfer_mode;
+	multi->pending = 0;
+	multi->frame_error = 0;
+
+	mcp4725_Multi_Reset_Stats(multi);
+
+	/* Enable the DWT cycle counter, it stamps the end of the writes */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	#if (__CORTEX_M == 7U)
+		DWT->LAR = 0xC5ACCE55;
+	#endif
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	for( uint8_t idx = 0; idx < MCP4725_MAX_I2C_BUS; idx++ ){
+		if( multis[idx] == NULL || multis[idx] == multi ){
+			multis[idx] = multi;
+			return HAL_OK;
+		}
+	}
+
+	return HAL_ERROR;
+}
+
+/**
+  * @brief  Add a device to the output, the index of the channel is the order of the calls (0 is the first).
+  * @note	The channels of a bus are written in the order they are added. The I2C peripherals of the
+  * 		output must not be used by other code while a frame is in progress.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t initialized by mcp4725_Init.
+  * @retval HAL_OK, HAL_BUSY if a frame is in progress,
+  * 		HAL_ERROR if there are MCP4725_MULTI_MAX_CHANNELS channels or MCP4725_MAX_I2C_BUS buses.
+  */
+HAL_StatusTypeDef mcp4725_Multi_Add_Channel(MCP4725_Multi_Handle_t* multi, MCP4725_Handle_t* mcp4725_dev){
+
+	if( multi->pending ){
+		return HAL_BUSY;
+	}
+
+	if( multi->num_channels == MCP4725_MULTI_MAX_CHANNELS ){
+		return HAL_ERROR;
+	}
+
+	uint8_t channel = multi->num_channels;
+	uint8_t bus = 0;
+
+	while( bus < multi->num_buses && multi->buses[bus] != mcp4725_dev->i2c_handle ){
+		bus++;
+	}
+
+	if( bus == multi->num_buses ){
+
+		if( multi->num_buses == MCP4725_MAX_I2C_BUS ){
+			return HAL_ERROR;
+		}
+
+		multi->buses[bus] = mcp4725_dev->i2c_handle;
+		multi->first[bus] = channel;
+		multi->active[bus] = MCP4725_MULTI_NO_CHANNEL;
+		multi->num_buses++;
+
+	}else{
+
+		/* Append to the chain of the bus */
+		uint8_t last = multi->first[bus];
+		while( multi->channels[last].next != MCP4725_MULTI_NO_CHANNEL ){
+			last = multi->channels[last].next;
+		}
+		multi->channels[last].next = channel;
+
+	}
+
+	multi->channels[channel].device = mcp4725_dev;
+	multi->channels[channel].value = mcp4725_dev->dac_register;
+	multi->channels[channel].next = MCP4725_MULTI_NO_CHANNEL;
+	multi->channels[channel].stamp = 0;
+	multi->num_channels++;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Start a frame: write a value to each channel, the buses run in parallel.
+  * @note	The power down mode of each device is kept. mcp4725_Multi_CpltCallback is called when all
+  * 		the channels are written, mcp4725_Multi_ErrorCallback if a write fails.
+  * @param  values 12-bit value of each channel, values[0] for the channel 0.
+  * @retval HAL_OK, HAL_BUSY if the previous frame is in progress (counted as overrun) or an I2C
+  * 		peripheral is used by other code, HAL_ERROR if the output has no channels.
+  */
+HAL_StatusTypeDef mcp4725_Multi_Write(MCP4725_Multi_Handle_t* multi, const uint16_t* values){
+
+	if( multi->num_channels == 0 ){
+		return HAL_ERROR;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if( multi->pending ){
+		multi->overruns++;
+		__set_PRIMASK(primask);
+		return HAL_BUSY;
+	}
+
+	for( uint8_t bus = 0; bus < multi->num_buses; bus++ ){
+		if( multi->buses[bus]->State != HAL_I2C_STATE_READY ){
+			__set_PRIMASK(primask);
+			return HAL_BUSY;
+		}
+	}
+
+	multi->pending = multi->num_channels;
+
+	__set_PRIMASK(primask);
+
+	for( uint8_t channel = 0; channel < multi->num_channels; channel++ ){
+		MCP4725_Multi_Channel_t* ch = &multi->channels[channel];
+		ch->value = values[channel] & 0xFFF;
+		mcp4725_Encode_Fast_Mode(ch->buffer, ch->value, (MCP4725_PowerDown_e) ch->device->powerdown_mode);
+	}
+
+	multi->frame_error = 0;
+	multi->frame_start = DWT->CYCCNT;
+
+	for( uint8_t bus = 0; bus < multi->num_buses; bus++ ){
+		multi->active[bus] = multi->first[bus];
+		if( mcp4725_multi_start(multi, bus) != HAL_OK ){
+			mcp4725_multi_abort(multi, bus);
+		}
+	}
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Check if a frame is in progress.
+  * @retval 1 until all the channels of the last frame are written.
+  */
+uint8_t mcp4725_Multi_Busy(MCP4725_Multi_Handle_t* multi){
+	return ( multi->pending != 0 );
+}
+
+/**
+  * @brief  Inter-channel skew of the last frame completed without errors.
+  * @retval Time between the first and the last output update, ns.
+  */
+uint32_t mcp4725_Multi_Skew_ns(MCP4725_Multi_Handle_t* multi){
+	return (uint32_t) ( ( (uint64_t) multi->skew * MULTI_NS_PER_S ) / SystemCoreClock );
+}
+
+/**
+  * @brief  Largest inter-channel skew since the reset of the statistics.
+  * @retval Time between the first and the last output update, ns.
+  */
+uint32_t mcp4725_Multi_Max_Skew_ns(MCP4725_Multi_Handle_t* multi){
+	return (uint32_t) ( ( (uint64_t) multi->max_skew * MULTI_NS_PER_S ) / SystemCoreClock );
+}
+
+/**
+  * @brief  Reset the frame counters and the skew statistics.
+  * @retval None
+  */
+void mcp4725_Multi_Reset_Stats(MCP4725_Multi_Handle_t* multi){
+
+	multi->frames = 0;
+	multi->overruns = 0;
+	multi->errors = 0;
+	multi->skew = 0;
+	multi->max_skew = 0;
+	multi->latency = 0;
+
+}
+
+/**
+  * @brief  End of the write of a channel, stamp it and chain the next channel of the bus.
+  * @note	Call from HAL_I2C_MasterTxCpltCallback, the transfers of other drivers are ignored.
+  * @param  hi2c Pointer to the I2C_HandleTypeDef of the completed transfer.
+  * @retval None
+  */
+void mcp4725_Multi_I2C_CpltCallback(I2C_HandleTypeDef* hi2c){
+
+	uint32_t stamp = DWT->CYCCNT;
+	uint8_t bus;
+
+	MCP4725_Multi_Handle_t* multi = mcp4725_multi_find(hi2c, &bus);
+	if( multi == NULL )	return;
+
+	MCP4725_Multi_Channel_t* ch = &multi->channels[ multi->active[bus] ];
+
+	ch->stamp = stamp;
+	ch->device->dac_register = ch->value;
+
+	multi->active[bus] = ch->next;
+
+	if( ch->next != MCP4725_MULTI_NO_CHANNEL && mcp4725_multi_start(multi, bus) != HAL_OK ){
+		mcp4725_multi_abort(multi, bus);
+	}
+
+	mcp4725_multi_done(multi, 1);
+}
+
+/**
+  * @brief  A write failed (NACK, arbitration lost, bus error), the rest of the channels of the bus are not written in this frame.
+  * @note	Call from HAL_I2C_ErrorCallback, the cause is in hi2c->ErrorCode.
+  * @param  hi2c Pointer to the I2C_HandleTypeDef of the failed transfer.
+  * @retval None
+  */
+void mcp4725_Multi_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c){
+
+	uint8_t bus;
+
+	MCP4725_Multi_Handle_t* multi = mcp4725_multi_find(hi2c, &bus);
+	if( multi == NULL )	return;
+
+	mcp4725_multi_abort(multi, bus);
+}
+
+/**
+  * @brief  Frame completed callback, all the channels are written and the skew is updated.
+  * @note	This function should not be modified, when the callback is needed it can be implemented in the user file.
+  * @retval None
+  */
+__weak void mcp4725_Multi_CpltCallback(MCP4725_Multi_Handle_t* multi){
+	UNUSED(multi);
+}
+
+/**
+  * @brief  Frame error callback, at least one channel was not written. The frame is over, a new one can be started.
+  * @note	This function should not be modified, when the callback is needed it can be implemented in the user file.
+  * @retval None
+  */
+__weak void mcp4725_Multi_ErrorCallback(MCP4725_Multi_Handle_t* multi){
+	UNUSED(multi);
+}
+
+/**
+  * @brief  Search the output with a frame in progress on the I2C bus.
+  * @param  bus Index of the bus in the output.
+  * @retval Pointer to the output, NULL if the transfer was not started by this module.
+  */
+static MCP4725_Multi_Handle_t* mcp4725_multi_find(I2C_HandleTypeDef* hi2c, uint8_t* bus){
+
+	for( uint8_t idx = 0; idx < MCP4725_MAX_I2C_BUS; idx++ ){
+
+		MCP4725_Multi_Handle_t* multi = multis[idx];
+		if( multi == NULL )	continue;
+
+		for( uint8_t b = 0; b < multi->num_buses; b++ ){
+			if( multi->buses[b] == hi2c && multi->active[b] != MCP4725_MULTI_NO_CHANNEL ){
+				*bus = b;
+				return multi;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/**
+  * @brief  Start the write of the active channel of the bus, with a repeated START if it is not the first one.
+  */
+static HAL_StatusTypeDef mcp4725_multi_start(MCP4725_Multi_Handle_t* multi, uint8_t bus){
+
+	uint8_t channel = multi->active[bus];
+	MCP4725_Multi_Channel_t* ch = &multi->channels[channel];
+	I2C_HandleTypeDef* hi2c = multi->buses[bus];
+	uint32_t option;
+
+	if( channel == multi->first[bus] ){
+		option = ( ch->next == MCP4725_MULTI_NO_CHANNEL ) ? I2C_FIRST_AND_LAST_FRAME : I2C_FIRST_FRAME;
+	}else{
+		option = ( ch->next == MCP4725_MULTI_NO_CHANNEL ) ? I2C_OTHER_AND_LAST_FRAME : I2C_OTHER_FRAME;
+	}
+
+	if( multi->xfer_mode == MCP4725_XFER_DMA ){
+		return HAL_I2C_Master_Seq_Transmit_DMA(hi2c, ch->device->dev_addr << 1, ch->buffer, 2, option);
+	}
+
+	return HAL_I2C_Master_Seq_Transmit_IT(hi2c, ch->device->dev_addr << 1, ch->buffer, 2, option);
+}
+
+/**
+  * @brief  Drop the channels of the bus not written yet, their devices keep the previous value.
+  */
+static void mcp4725_multi_abort(MCP4725_Multi_Handle_t* multi, uint8_t bus){
+
+	uint8_t dropped = 0;
+
+	for( uint8_t channel = multi->active[bus]; channel != MCP4725_MULTI_NO_CHANNEL; channel = multi->channels[channel].next ){
+		/* The write in progress may have reached the device */
+		multi->channels[channel].device->cache_stale = 1;
+		dropped++;
+	}
+
+	multi->active[bus] = MCP4725_MULTI_NO_CHANNEL;
+	multi->frame_error = 1;
+
+	if( dropped ){
+		mcp4725_multi_done(multi, dropped);
+	}
+}
+
+/**
+  * @brief  Count the channels finished, at the end of the frame update the statistics and call the callback.
+  */
+static void mcp4725_multi_done(MCP4725_Multi_Handle_t* multi, uint8_t num_channels){
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	multi->pending -= num_channels;
+	uint8_t last = ( multi->pending == 0 );
+
+	__set_PRIMASK(primask);
+
+	if( last == 0 )	return;
+
+	if( multi->frame_error ){
+		multi->errors++;
+		mcp4725_Multi_ErrorCallback(multi);
+		return;
+	}
+
+	/* Offsets from the start of the frame, the counter may wrap */
+	uint32_t first = UINT32_MAX;
+	uint32_t latest = 0;
+
+	for( uint8_t channel = 0; channel < multi->num_channels; channel++ ){
+		uint32_t offset = multi->channels[channel].stamp - multi->frame_start;
+		if( offset < first )	first = offset;
+		if( offset > latest )	latest = offset;
+	}
+
+	multi->latency = first;
+	multi->skew = latest - first;
+	if( multi->skew > multi->max_skew ){
+		multi->max_skew = multi->skew;
+	}
+	multi->frames++;
+
+	mcp4725_Multi_CpltCallback(multi);
+}
@@ -0,0 +1,87 @@
+/*
+ * mcp4725_multi.h
+ *
+ *  Synchronous output of several MCP4725 (I/Q, X/Y pairs). A frame writes one value to each channel,
+ *  started by one call from the pacing timer IRQ.
+ *
+ *  Channels on the same I2C bus (addresses 0x60 and 0x61) are written in one sequence: the frames are
+ *  chained with a repeated START, so the STOP and the bus free time are not spent between them and the
+ *  skew is one Fast Mode write (28 SCL periods, 70 us at 400 kHz). Channels on separate I2C peripherals
+ *  are written in parallel, the skew is the time to start the buses (some us).
+ *
+ *  The end of the write of each channel is stamped with the DWT cycle counter, the inter-channel skew
+ *  of each frame is the time between the first and the last stamp.
+ */
+
+#ifndef MCP4725_MCP4725_MULTI_H_
+#define MCP4725_MCP4725_MULTI_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+
+#ifndef MCP4725_MULTI_MAX_CHANNELS
+#define MCP4725_MULTI_MAX_CHANNELS	4		/* Devices written in each frame */
+#endif
+
+#define MCP4725_MULTI_NO_CHANNEL	0xFF
+
+/* Channel Structure */
+
+typedef struct mcp4725_multi_channel{
+	MCP4725_Handle_t *		device;						/* Handle of the MCP4725, initialized by mcp4725_Init */
+	uint16_t				value;						/* DAC register written in the frame in progress */
+	uint8_t					buffer[2];					/* Fast Mode word of the frame in progress */
+	uint8_t					next;						/* Next channel on the same bus, MCP4725_MULTI_NO_CHANNEL for the last */
+	uint32_t				stamp;						/* DWT cycle counter at the end of the write */
+}MCP4725_Multi_Channel_t;
+
+/* Multi-Channel Handle Structure */
+
+typedef struct mcp4725_multi_handle{
+	MCP4725_Multi_Channel_t	channels[MCP4725_MULTI_MAX_CHANNELS];
+	uint8_t					num_channels;				/* Entries used in channels[] */
+	MCP4725_Xfer_e			xfer_mode;					/* Interrupt or DMA Mode, reference to MCP4725_Xfer_e */
+	I2C_HandleTypeDef *		buses[MCP4725_MAX_I2C_BUS];	/* I2C peripherals of the channels */
+	uint8_t					first[MCP4725_MAX_I2C_BUS];	/* First channel of each bus */
+	__IO uint8_t			active[MCP4725_MAX_I2C_BUS];	/* Channel on each bus, MCP4725_MULTI_NO_CHANNEL when the bus is done */
+	uint8_t					num_buses;					/* Entries used in buses[] */
+	__IO uint8_t			pending;					/* Channels not written yet in the frame in progress */
+	uint8_t					frame_error;				/* 1 if a write of the frame in progress failed */
+	uint32_t				frame_start;				/* DWT cycle counter at the start of the frame */
+	__IO uint32_t			frames;						/* Frames completed */
+	__IO uint32_t			overruns;					/* Frames not started, the previous one was in progress */
+	__IO uint32_t			errors;						/* Frames with a failed write */
+	__IO uint32_t			skew;						/* Skew of the last frame, CPU cycles */
+	__IO uint32_t			max_skew;					/* Largest skew since the reset of the statistics, CPU cycles */
+	__IO uint32_t			latency;					/* Start of the last frame to the end of its first write, CPU cycles */
+}MCP4725_Multi_Handle_t;
+
+/* Initialization functions */
+HAL_StatusTypeDef mcp4725_Multi_Init(MCP4725_Multi_Handle_t* multi, MCP4725_Xfer_e xfer_mode);
+HAL_StatusTypeDef mcp4725_Multi_Add_Channel(MCP4725_Multi_Handle_t* multi, MCP4725_Handle_t* mcp4725_dev);
+
+/* Start a frame, commonly from the pacing timer IRQ */
+HAL_StatusTypeDef mcp4725_Multi_Write(MCP4725_Multi_Handle_t* multi, const uint16_t* values);
+uint8_t mcp4725_Multi_Busy(MCP4725_Multi_Handle_t* multi);
+
+/* Skew statistics */
+uint32_t mcp4725_Multi_Skew_ns(MCP4725_Multi_Handle_t* multi);
+uint32_t mcp4725_Multi_Max_Skew_ns(MCP4725_Multi_Handle_t* multi);
+void mcp4725_Multi_Reset_Stats(MCP4725_Multi_Handle_t* multi);
+
+/* Call from HAL_I2C_MasterTxCpltCallback and HAL_I2C_ErrorCallback */
+void mcp4725_Multi_I2C_CpltCallback(I2C_HandleTypeDef* hi2c);
+void mcp4725_Multi_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c);
+
+/* Weak callbacks, implement them in the user file */
+void mcp4725_Multi_CpltCallback(MCP4725_Multi_Handle_t* multi);
+void mcp4725_Multi_ErrorCallback(MCP4725_Multi_Handle_t* multi);
+
+#endif /* MCP4725_MCP4725_MULTI_H_ */
@@ -0,0 +1,65 @@
+/*
+ * mcp4725_plan.h
+ *
+ *  Sample rate planner for MCP4725. Computes the maximum sample rate the I2C bus can sustain for
+ *  the transfer mode and the number of DACs on the bus, configures the pacing timer and reports
+ *  the headroom. At run time it counts the overruns: samples due while the previous transfer of
+ *  the device was still in progress (the sample is dropped).
+ *
+ *  SCL periods of one sample on the bus:
+ *  	Single transfer:	START + address + 2 bytes + STOP, 29 periods plus MCP4725_PLAN_GAP_SCL per DAC.
+ *  	Streaming:			2 bytes, 18 periods. Only one DAC per bus, the transaction is kept open.
+ */
+
+#ifndef MCP4725_MCP4725_PLAN_H_
+#define MCP4725_MCP4725_PLAN_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+
+#define MCP4725_PLAN_SINGLE_SCL		29		/* SCL periods of a Fast Mode write: START, 3 bytes with ACK, STOP */
+#define MCP4725_PLAN_STREAM_SCL		18		/* SCL periods of a sample in the streaming mode */
+
+#ifndef MCP4725_PLAN_GAP_SCL
+#define MCP4725_PLAN_GAP_SCL		2		/* Idle SCL periods between transfers: bus free time and IRQ latency */
+#endif
+
+/* Transfer Mode Enumeration */
+
+typedef enum{
+	MCP4725_PLAN_SINGLE = 0,		/* One transfer per sample and DAC, paced by a timer */
+	MCP4725_PLAN_STREAM				/* One open transaction fed by DMA, paced by the I2C clock */
+}MCP4725_Plan_Mode_e;
+
+/* MCP4725 Planner Structure */
+
+typedef struct mcp4725_plan{
+	uint32_t				bus_clock;			/* SCL frequency, Hz */
+	MCP4725_Plan_Mode_e		mode;				/* Transfer mode, reference to MCP4725_Plan_Mode_e */
+	uint8_t					num_dacs;			/* DACs updated at each sample on the same bus */
+	uint32_t				scl_per_sample;		/* SCL periods to update all the DACs */
+	uint32_t				max_rate;			/* Maximum sustainable sample rate, samples per second */
+	uint32_t				sample_rate;		/* Sample rate of the pacing timer (or the bus in streaming), samples per second */
+	uint16_t				headroom;			/* Free bus time at sample_rate, per mille of the sample period */
+	TIM_HandleTypeDef *		htim;				/* Pacing timer, NULL in streaming */
+	__IO uint32_t			samples;			/* Samples due since the start */
+	__IO uint32_t			overruns;			/* Samples due while the previous transfer was in progress */
+}MCP4725_Plan_t;
+
+/* Planning functions */
+HAL_StatusTypeDef mcp4725_Plan_Init(MCP4725_Plan_t* plan, uint32_t bus_clock, MCP4725_Plan_Mode_e mode, uint8_t num_dacs);
+HAL_StatusTypeDef mcp4725_Plan_Config_Timer(MCP4725_Plan_t* plan, TIM_HandleTypeDef* htim, uint32_t sample_rate);
+uint16_t mcp4725_Plan_Headroom(const MCP4725_Plan_t* plan, uint32_t sample_rate);
+
+/* Run time, call at each timer update before the transfer */
+uint8_t mcp4725_Plan_Check(MCP4725_Plan_t* plan, MCP4725_Handle_t* mcp4725_dev);
+void mcp4725_Plan_Reset_Stats(MCP4725_Plan_t* plan);
+
+#endif /* MCP4725_MCP4725_PLAN_H_ */
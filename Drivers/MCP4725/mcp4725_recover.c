@@ -0,0 +1,410 @@
+/*
+ * mcp4725_recover.c
+ *
+ *  I2C error recovery for MCP4725.
+ *
+ *  Bus clear (I2C specification, 3.1.16): a device stopped in the middle of a byte holds SDA low until it
+ *  gets the rest of its clocks. SCL is toggled as a GPIO until SDA is high, at most 9 clocks, then a STOP
+ *  condition resets the state machine of the devices. The I2C peripheral is deinitialized before (the
+ *  pins are given back by HAL_I2C_MspDeInit) and initialized again after, which also clears the BUSY flag
+ *  latched by the glitches of the bus clear.
+ *
+ *  The phase of a stream is kept with the DWT cycle counter: the samples that would have been sent since
+ *  the error are counted from the sample rate, and the stream is started again when the buffer position
+ *  comes back to 0, minus the time from the start of the transaction to the first DAC update.
+ */
+
+#include "mcp4725_recover.h"
+
+#define RECOVER_US_PER_S		1000000U
+#define RECOVER_SCL_PER_OPEN	27		/* SCL periods from the start of the stream to the first DAC update */
+
+static HAL_StatusTypeDef mcp4725_recover_command(MCP4725_Handle_t* mcp4725_dev, MCP4725_Operation_e operation, uint16_t dac_data, MCP4725_PowerDown_e pd_mode);
+static uint8_t mcp4725_recover_classify(MCP4725_Recover_t* recover, uint32_t error);
+static uint8_t mcp4725_recover_release_scl(MCP4725_Recover_t* recover);
+static void mcp4725_recover_delay_us(uint32_t us);
+static uint32_t mcp4725_recover_us(uint32_t start);
+static void mcp4725_recover_stats(uint32_t us, uint32_t* last, uint32_t* max);
+
+/**
+  * @brief  Initialize the recovery of an I2C bus and start the DWT cycle counter.
+  * @param  recover Pointer to a MCP4725_Recover_t structure.
+  * @param  hi2c I2C bus of the devices.
+  * @param  scl_port GPIO port of the SCL pin of hi2c.
+  * @param  scl_pin GPIO pin of SCL, GPIO_PIN_x.
+  * @param  sda_port GPIO port of the SDA pin of hi2c.
+  * @param  sda_pin GPIO pin of SDA, GPIO_PIN_x.
+  * @retval HAL_OK, HAL_ERROR if the parameters are not valid.
+  */
+HAL_StatusTypeDef mcp4725_Recover_Init(MCP4725_Recover_t* recover, I2C_HandleTypeDef* hi2c, GPIO_TypeDef* scl_port, uint16_t scl_pin, GPIO_TypeDef* sda_port, uint16_t sda_pin){
+
+	if( hi2c == NULL || scl_port == NULL || sda_port == NULL ){
+		return HAL_ERROR;
+	}
+
+	recover->hi2c = hi2c;
+	recover->scl_port = scl_port;
+	recover->scl_pin = scl_pin;
+	recover->sda_port = sda_port;
+	recover->sda_pin = sda_pin;
+	recover->stream = NULL;
+	recover->sample_rate = 0;
+	recover->stream_pending = 0;
+	recover->stream_error = HAL_I2C_ERROR_NONE;
+
+	mcp4725_Recover_Reset_Stats(recover);
+
+	/* Enable the DWT cycle counter, it times the waits and the recovery */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	#if (__CORTEX_M == 7U)
+		DWT->LAR = 0xC5ACCE55;
+	#endif
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Restart a stream of the bus after an error, at the same phase.
+  * @note	Call mcp4725_Recover_Stream_Error from mcp4725_Stream_ErrorCallback and mcp4725_Recover_Poll from the main loop.
+  * @param  stream Pointer to a MCP4725_Stream_Handle_t registered on the bus.
+  * @param  sample_rate Samples per second of the stream: f_SCL / 18, or the timer rate / 2 when paced.
+  * @retval HAL_OK, HAL_ERROR if the stream is not on the bus.
+  */
+HAL_StatusTypeDef mcp4725_Recover_Attach_Stream(MCP4725_Recover_t* recover, MCP4725_Stream_Handle_t* stream, uint32_t sample_rate){
+
+	if( stream == NULL || stream->device->i2c_handle != recover->hi2c || sample_rate == 0 || sample_rate > SystemCoreClock ){
+		return HAL_ERROR;
+	}
+
+	recover->stream = stream;
+	recover->sample_rate = sample_rate;
+	recover->stream_pending = 0;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Clear the bus and initialize the I2C peripheral again.
+  * @note	No transfer must be in progress on the bus. Takes about 120 us plus the SCL held low by a device.
+  * @param  recover Pointer to a MCP4725_Recover_t structure.
+  * @retval HAL_OK, HAL_ERROR if SDA or SCL are still low or the peripheral can not be initialized.
+  */
+HAL_StatusTypeDef mcp4725_Recover_Bus(MCP4725_Recover_t* recover){
+
+	uint32_t start = DWT->CYCCNT;
+	GPIO_InitTypeDef gpio = {0};
+	uint8_t released;
+
+	HAL_I2C_DeInit(recover->hi2c);
+
+	/* Open drain outputs, released (high) before they are driven */
+	HAL_GPIO_WritePin(recover->scl_port, recover->scl_pin, GPIO_PIN_SET);
+	HAL_GPIO_WritePin(recover->sda_port, recover->sda_pin, GPIO_PIN_SET);
+
+	gpio.Mode = GPIO_MODE_OUTPUT_OD;
+	gpio.Pull = GPIO_NOPULL;
+	gpio.Speed = GPIO_SPEED_FREQ_HIGH;
+	gpio.Pin = recover->scl_pin;
+	HAL_GPIO_Init(recover->scl_port, &gpio);
+	gpio.Pin = recover->sda_pin;
+	HAL_GPIO_Init(recover->sda_port, &gpio);
+
+	mcp4725_recover_delay_us(MCP4725_RECOVER_HALF_US);
+	released = mcp4725_recover_release_scl(recover);
+
+	/* Clock out the byte in progress until the device releases SDA */
+	for( uint8_t clk = 0; released && clk < MCP4725_RECOVER_CLOCKS; clk++ ){
+
+		if( HAL_GPIO_ReadPin(recover->sda_port, recover->sda_pin) == GPIO_PIN_SET ){
+			break;
+		}
+
+		HAL_GPIO_WritePin(recover->scl_port, recover->scl_pin, GPIO_PIN_RESET);
+		mcp4725_recover_delay_us(MCP4725_RECOVER_HALF_US);
+		released = mcp4725_recover_release_scl(recover);
+		mcp4725_recover_delay_us(MCP4725_RECOVER_HALF_US);
+	}
+
+	/* STOP condition: SDA rises while SCL is high */
+	HAL_GPIO_WritePin(recover->scl_port, recover->scl_pin, GPIO_PIN_RESET);
+	mcp4725_recover_delay_us(MCP4725_RECOVER_HALF_US);
+	HAL_GPIO_WritePin(recover->sda_port, recover->sda_pin, GPIO_PIN_RESET);
+	mcp4725_recover_delay_us(MCP4725_RECOVER_HALF_US);
+	released &= mcp4725_recover_release_scl(recover);
+	mcp4725_recover_delay_us(MCP4725_RECOVER_HALF_US);
+	HAL_GPIO_WritePin(recover->sda_port, recover->sda_pin, GPIO_PIN_SET);
+	mcp4725_recover_delay_us(MCP4725_RECOVER_HALF_US);
+
+	if( HAL_GPIO_ReadPin(recover->sda_port, recover->sda_pin) == GPIO_PIN_RESET || HAL_GPIO_ReadPin(recover->scl_port, recover->scl_pin) == GPIO_PIN_RESET ){
+		released = 0;
+	}
+
+	/* The pins are configured again by HAL_I2C_MspInit */
+	HAL_GPIO_DeInit(recover->scl_port, recover->scl_pin);
+	HAL_GPIO_DeInit(recover->sda_port, recover->sda_pin);
+
+	HAL_StatusTypeDef status = HAL_I2C_Init(recover->hi2c);
+
+	recover->bus_clears++;
+	if( released == 0 || status != HAL_OK ){
+		recover->clear_failures++;
+		status = HAL_ERROR;
+	}
+
+	mcp4725_recover_stats(mcp4725_recover_us(start), &recover->last_recovery_us, &recover->max_recovery_us);
+
+	return status;
+}
+
+/**
+  * @brief  Send a blocking command, retried on error: backoff on NACK and arbitration lost, bus clear on bus errors.
+  * @param  recover Pointer to a MCP4725_Recover_t structure of the bus of the device.
+  * @param  mcp4725_dev Pointer to a MCP4725_Handle_t structure.
+  * @param  operation MCP4725_OP_FAST_MODE, MCP4725_OP_DAC_EEPROM, MCP4725_OP_READ, MCP4725_OP_GC_RESET or MCP4725_OP_GC_WAKEUP.
+  * @param  dac_data 12-bit value for DAC output, for the writes.
+  * @param  pd_mode Power Down Mode, for the writes. Reference to MCP4725_PowerDown_e
+  * @retval HAL_OK, HAL_BUSY if another transfer owns the bus (no recovery is done, it would abort that transfer),
+  * 		HAL_ERROR if the command failed after MCP4725_RECOVER_RETRIES retries.
+  */
+HAL_StatusTypeDef mcp4725_Recover_Execute(MCP4725_Recover_t* recover, MCP4725_Handle_t* mcp4725_dev, MCP4725_Operation_e operation, uint16_t dac_data, MCP4725_PowerDown_e pd_mode){
+
+	if( mcp4725_dev->i2c_handle != recover->hi2c ){
+		return HAL_ERROR;
+	}
+
+	/* A stream, asynchronous, group or bus manager transfer is in progress */
+	if( recover->hi2c->State != HAL_I2C_STATE_READY ){
+		return HAL_BUSY;
+	}
+
+	HAL_StatusTypeDef status = mcp4725_recover_command(mcp4725_dev, operation, dac_data, pd_mode);
+	if( status == HAL_OK || status == HAL_BUSY ){
+		return status;
+	}
+
+	uint32_t start = DWT->CYCCNT;
+	uint32_t backoff = MCP4725_RECOVER_BACKOFF_US;
+
+	for( uint8_t retry = 0; retry < MCP4725_RECOVER_RETRIES && status != HAL_OK; retry++ ){
+
+		if( recover->hi2c->State != HAL_I2C_STATE_READY ){
+			status = HAL_BUSY;
+			break;
+		}
+
+		if( mcp4725_recover_classify(recover, recover->hi2c->ErrorCode) ){
+			mcp4725_Recover_Bus(recover);
+		}else{
+			mcp4725_recover_delay_us(backoff);
+			backoff *= 2;
+		}
+
+		recover->retries++;
+		status = mcp4725_recover_command(mcp4725_dev, operation, dac_data, pd_mode);
+		if( status == HAL_BUSY ){
+			break;
+		}
+	}
+
+	if( status == HAL_ERROR ){
+		mcp4725_recover_classify(recover, recover->hi2c->ErrorCode);
+		recover->failures++;
+	}
+
+	mcp4725_recover_stats(mcp4725_recover_us(start), &recover->last_recovery_us, &recover->max_recovery_us);
+
+	return status;
+}
+
+/**
+  * @brief  The attached stream was stopped by an error, it is restarted by mcp4725_Recover_Poll.
+  * @note	Call from mcp4725_Stream_ErrorCallback.
+  * @retval None
+  */
+void mcp4725_Recover_Stream_Error(MCP4725_Recover_t* recover){
+
+	if( recover->stream == NULL || recover->stream_pending ){
+		return;
+	}
+
+	recover->stream_stamp = DWT->CYCCNT;
+	recover->stream_error = recover->stream->error;
+	recover->stream_pending = 1;
+
+	mcp4725_recover_classify(recover, recover->stream_error);
+}
+
+/**
+  * @brief  Restart the stream stopped by an error: bus clear if needed, then wait for the phase of the buffer.
+  * @note	Call from the main loop or a task, it waits up to one period of the buffer. The phase is kept if the poll
+  * 		comes within 2^32 cycles of the error (7 s at 550 MHz). For a refilled buffer the halves are not generated
+  * 		again, the content is the one of the stop.
+  * @param  recover Pointer to a MCP4725_Recover_t structure.
+  * @retval HAL_OK if no stream is waiting or it was restarted, HAL_ERROR if the bus is not recovered (the restart
+  * 		is tried again at the next poll).
+  */
+HAL_StatusTypeDef mcp4725_Recover_Poll(MCP4725_Recover_t* recover){
+
+	MCP4725_Stream_Handle_t* stream = recover->stream;
+
+	if( stream == NULL || recover->stream_pending == 0 ){
+		return HAL_OK;
+	}
+
+	if( ( recover->stream_error & ( HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_TIMEOUT ) )
+			|| HAL_GPIO_ReadPin(recover->sda_port, recover->sda_pin) == GPIO_PIN_RESET ){
+		if( mcp4725_Recover_Bus(recover) != HAL_OK ){
+			return HAL_ERROR;
+		}
+		recover->stream_error = HAL_I2C_ERROR_NONE;
+	}
+
+	uint64_t cycles_per_sample = SystemCoreClock / recover->sample_rate;
+	uint64_t buffer_cycles = cycles_per_sample * stream->num_samples;
+	uint64_t lead;
+
+	if( stream->htim != NULL ){
+		lead = cycles_per_sample;				/* Two timer updates */
+	}else{
+		lead = ( cycles_per_sample * RECOVER_SCL_PER_OPEN ) / MCP4725_STREAM_SCL_PER_SAMPLE;
+	}
+
+	/* Time left until the position in the buffer comes back to 0 */
+	uint32_t elapsed = DWT->CYCCNT - recover->stream_stamp;
+	uint64_t position = ( stream->stop_sample * cycles_per_sample + elapsed ) % buffer_cycles;
+	uint64_t wait = buffer_cycles - position;
+
+	while( wait < lead ){
+		wait += buffer_cycles;
+	}
+	wait -= lead;
+
+	uint32_t start = DWT->CYCCNT;
+	while( ( DWT->CYCCNT - start ) < wait );
+
+	HAL_StatusTypeDef status = ( stream->htim != NULL ) ? mcp4725_Stream_Start_Paced(stream, stream->htim) : mcp4725_Stream_Start(stream);
+	if( status != HAL_OK ){
+		return HAL_ERROR;
+	}
+
+	recover->stream_pending = 0;
+	recover->stream_restarts++;
+	mcp4725_recover_stats(mcp4725_recover_us(recover->stream_stamp), &recover->last_outage_us, &recover->max_outage_us);
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Clear the error counters and the recovery times.
+  */
+void mcp4725_Recover_Reset_Stats(MCP4725_Recover_t* recover){
+
+	recover->nacks = 0;
+	recover->arbitration_lost = 0;
+	recover->bus_errors = 0;
+	recover->retries = 0;
+	recover->bus_clears = 0;
+	recover->clear_failures = 0;
+	recover->stream_restarts = 0;
+	recover->failures = 0;
+	recover->last_recovery_us = 0;
+	recover->max_recovery_us = 0;
+	recover->last_outage_us = 0;
+	recover->max_outage_us = 0;
+
+}
+
+/**
+  * @brief  Blocking command of the driver.
+  */
+static HAL_StatusTypeDef mcp4725_recover_command(MCP4725_Handle_t* mcp4725_dev, MCP4725_Operation_e operation, uint16_t dac_data, MCP4725_PowerDown_e pd_mode){
+
+	switch( operation ){
+		case MCP4725_OP_FAST_MODE:
+			return mcp4725_Write_PowerDown_DAC_Register(mcp4725_dev, dac_data, pd_mode);
+		case MCP4725_OP_DAC_EEPROM:
+			return mcp4725_Write_DAC_EEPROM(mcp4725_dev, dac_data, pd_mode);
+		case MCP4725_OP_READ:
+			return mcp4725_Read_DAC_EEPROM(mcp4725_dev);
+		case MCP4725_OP_GC_RESET:
+			return mcp4725_GeneralCall_Reset(mcp4725_dev);
+		case MCP4725_OP_GC_WAKEUP:
+			return mcp4725_GeneralCall_WakeUp(mcp4725_dev);
+		default:
+			return HAL_ERROR;
+	}
+}
+
+/**
+  * @brief  Count the error.
+  * @note	No error code (the HAL found the handle busy) is not a bus fault, the command is retried after the backoff.
+  * @retval 1 if the bus must be cleared: bus error, timeout (BUSY flag stuck) or SDA held low.
+  */
+static uint8_t mcp4725_recover_classify(MCP4725_Recover_t* recover, uint32_t error){
+
+	if( ( error & ( HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_TIMEOUT ) )
+			|| HAL_GPIO_ReadPin(recover->sda_port, recover->sda_pin) == GPIO_PIN_RESET ){
+		recover->bus_errors++;
+		return 1;
+	}
+
+	if( error & HAL_I2C_ERROR_ARLO ){
+		recover->arbitration_lost++;
+	}else{
+		/* HAL_I2C_ERROR_AF, and DMA/overrun errors that only need a retry */
+		recover->nacks += ( error & HAL_I2C_ERROR_AF ) ? 1 : 0;
+	}
+
+	return 0;
+}
+
+/**
+  * @brief  Release SCL and wait until it is high, a device can hold it low (clock stretching).
+  * @retval 1 if SCL is high, 0 if it is still low after MCP4725_RECOVER_STRETCH_US.
+  */
+static uint8_t mcp4725_recover_release_scl(MCP4725_Recover_t* recover){
+
+	uint32_t start = DWT->CYCCNT;
+
+	HAL_GPIO_WritePin(recover->scl_port, recover->scl_pin, GPIO_PIN_SET);
+
+	while( HAL_GPIO_ReadPin(recover->scl_port, recover->scl_pin) == GPIO_PIN_RESET ){
+		if( mcp4725_recover_us(start) > MCP4725_RECOVER_STRETCH_US ){
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/**
+  * @brief  Busy wait on the DWT cycle counter.
+  */
+static void mcp4725_recover_delay_us(uint32_t us){
+
+	uint32_t start = DWT->CYCCNT;
+	uint32_t cycles = us * ( SystemCoreClock / RECOVER_US_PER_S );
+
+	while( ( DWT->CYCCNT - start ) < cycles );
+
+}
+
+/**
+  * @brief  us elapsed since a DWT stamp.
+  */
+static uint32_t mcp4725_recover_us(uint32_t start){
+	return ( DWT->CYCCNT - start ) / ( SystemCoreClock / RECOVER_US_PER_S );
+}
+
+/**
+  * @brief  Store the last and the maximum time.
+  */
+static void mcp4725_recover_stats(uint32_t us, uint32_t* last, uint32_t* max){
+
+	*last = us;
+	if( us > *max ){
+		*max = us;
+	}
+
+}
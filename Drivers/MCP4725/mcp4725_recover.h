@@ -0,0 +1,87 @@
+/*
+ * mcp4725_recover.h
+ *
+ *  I2C error recovery for MCP4725, in a bounded time.
+ *
+ *  	NACK, arbitration lost: the command is retried after a backoff, doubled at each retry.
+ *  	Bus error, timeout, SDA held low: the bus is cleared (up to 9 SCL clocks driven by GPIO until the
+ *  	device releases SDA, then a STOP condition) and the I2C peripheral is initialized again.
+ *  	Stream stopped by an error: after the bus recovery the stream is started again when the sample
+ *  	it would be sending comes back to the start of the buffer, so the waveform keeps its phase.
+ *
+ *  Worst case: bus clear 9 + 1 SCL periods at 100 kHz plus MCP4725_RECOVER_STRETCH_US, the backoffs of
+ *  MCP4725_RECOVER_RETRIES retries, and for a stream one buffer period of wait for the phase.
+ *  The recovery uses busy waits on the DWT cycle counter, call it from the main loop or a task.
+ */
+
+#ifndef MCP4725_MCP4725_RECOVER_H_
+#define MCP4725_MCP4725_RECOVER_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+#include "mcp4725_stream.h"
+
+#ifndef MCP4725_RECOVER_RETRIES
+#define MCP4725_RECOVER_RETRIES		3		/* Retries of a command after the first attempt */
+#endif
+
+#ifndef MCP4725_RECOVER_BACKOFF_US
+#define MCP4725_RECOVER_BACKOFF_US	50		/* Wait before the first retry, doubled at each retry */
+#endif
+
+#ifndef MCP4725_RECOVER_STRETCH_US
+#define MCP4725_RECOVER_STRETCH_US	100		/* Longest SCL low held by a device during the bus clear */
+#endif
+
+#define MCP4725_RECOVER_CLOCKS		9		/* SCL clocks to release SDA: 8 bits and the ACK of a byte in progress */
+#define MCP4725_RECOVER_HALF_US		5		/* Half period of the bus clear clock, 100 kHz */
+
+/* MCP4725 Recovery Handle Structure */
+
+typedef struct mcp4725_recover{
+	I2C_HandleTypeDef *		hi2c;				/* Bus to recover */
+	GPIO_TypeDef *			scl_port;			/* SCL pin, driven as open drain GPIO during the bus clear */
+	uint16_t				scl_pin;
+	GPIO_TypeDef *			sda_port;			/* SDA pin */
+	uint16_t				sda_pin;
+	MCP4725_Stream_Handle_t * stream;			/* Stream restarted after an error, NULL if none */
+	uint32_t				sample_rate;		/* Samples per second of the stream, for the phase */
+	__IO uint8_t			stream_pending;		/* 1 when the stream was stopped by an error */
+	__IO uint32_t			stream_error;		/* I2C error of the stream, HAL_I2C_ERROR_xxx */
+	__IO uint32_t			stream_stamp;		/* DWT cycle counter when the stream stopped */
+	/* Statistics */
+	uint32_t				nacks;				/* Commands not acknowledged */
+	uint32_t				arbitration_lost;	/* Commands lost to another master */
+	uint32_t				bus_errors;			/* Misplaced START/STOP, timeouts, SDA held low */
+	uint32_t				retries;			/* Commands sent again */
+	uint32_t				bus_clears;			/* Bus clear and initialization of the peripheral */
+	uint32_t				clear_failures;		/* Bus clear that did not release SDA or SCL */
+	uint32_t				stream_restarts;	/* Streams restarted after an error */
+	uint32_t				failures;			/* Commands failed after all the retries */
+	uint32_t				last_recovery_us;	/* Time from the first error to the end of the recovery */
+	uint32_t				max_recovery_us;
+	uint32_t				last_outage_us;		/* Time from the stop of the stream to its restart */
+	uint32_t				max_outage_us;
+}MCP4725_Recover_t;
+
+/* Initialization function */
+HAL_StatusTypeDef mcp4725_Recover_Init(MCP4725_Recover_t* recover, I2C_HandleTypeDef* hi2c, GPIO_TypeDef* scl_port, uint16_t scl_pin, GPIO_TypeDef* sda_port, uint16_t sda_pin);
+HAL_StatusTypeDef mcp4725_Recover_Attach_Stream(MCP4725_Recover_t* recover, MCP4725_Stream_Handle_t* stream, uint32_t sample_rate);
+
+/* Recovery */
+HAL_StatusTypeDef mcp4725_Recover_Bus(MCP4725_Recover_t* recover);
+HAL_StatusTypeDef mcp4725_Recover_Execute(MCP4725_Recover_t* recover, MCP4725_Handle_t* mcp4725_dev, MCP4725_Operation_e operation, uint16_t dac_data, MCP4725_PowerDown_e pd_mode);
+void mcp4725_Recover_Stream_Error(MCP4725_Recover_t* recover);
+HAL_StatusTypeDef mcp4725_Recover_Poll(MCP4725_Recover_t* recover);
+
+/* Statistics */
+void mcp4725_Recover_Reset_Stats(MCP4725_Recover_t* recover);
+
+#endif /* MCP4725_MCP4725_RECOVER_H_ */
@@ -0,0 +1,85 @@
+/*
+ * mcp4725_rtos.h
+ *
+ *  FreeRTOS layer for MCP4725. The transfers use the asynchronous functions of mcp4725.c, the calling
+ *  task is suspended until the transfer ends and the I2C completion IRQ wakes it with a task notification.
+ *
+ *  Define MCP4725_USE_FREERTOS in the project symbols to compile this layer.
+ */
+
+#ifndef MCP4725_MCP4725_RTOS_H_
+#define MCP4725_MCP4725_RTOS_H_
+
+#ifdef MCP4725_USE_FREERTOS
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef MCP4725_RTOS_QUEUE_LEN
+#define MCP4725_RTOS_QUEUE_LEN		8		/* Requests waiting per device */
+#endif
+
+#ifndef MCP4725_RTOS_MAX_DEVICES
+#define MCP4725_RTOS_MAX_DEVICES	4		/* Devices registered in the layer, on any I2C bus */
+#endif
+
+#ifndef MCP4725_RTOS_NOTIFY_INDEX
+#define MCP4725_RTOS_NOTIFY_INDEX	1		/* Task notification index of the layer, index 0 is left to the application */
+#endif
+
+#if ( MCP4725_RTOS_NOTIFY_INDEX >= configTASK_NOTIFICATION_ARRAY_ENTRIES )
+#error "configTASK_NOTIFICATION_ARRAY_ENTRIES must be greater than MCP4725_RTOS_NOTIFY_INDEX (FreeRTOS V10.4 or later)"
+#endif
+
+/* Enumerators for MCP4725 RTOS requests */
+
+typedef enum mcp4725_rtos_requests{
+	MCP4725_RTOS_REQ_FAST_MODE	=	0,	/* Write DAC register and power down bits */
+	MCP4725_RTOS_REQ_DAC_EEPROM,		/* Write DAC register and EEPROM */
+	MCP4725_RTOS_REQ_READ,				/* Read DAC register and EEPROM */
+	MCP4725_RTOS_REQ_GC_RESET,			/* General call reset */
+	MCP4725_RTOS_REQ_GC_WAKEUP,			/* General call wake-up */
+}MCP4725_RTOS_ReqType_e;
+
+typedef struct mcp4725_rtos_request{
+	MCP4725_RTOS_ReqType_e	type;			/* Transfer to do */
+	uint8_t					priority;		/* Higher value is served first, same priority in order of arrival */
+	uint8_t					pd_mode;		/* Power down mode to write, reference to MCP4725_PowerDown_e */
+	uint16_t				dac_data;		/* DAC register to write */
+	TaskHandle_t			task;			/* Task to notify at the end of the transfer, NULL if nobody waits */
+}MCP4725_RTOS_Request_t;
+
+/* MCP4725 RTOS Handle Structure */
+
+typedef struct mcp4725_rtos_handle{
+	MCP4725_Handle_t *		device;							/* Handle of the MCP4725, initialized by mcp4725_Init */
+	MCP4725_RTOS_Request_t	queue[MCP4725_RTOS_QUEUE_LEN];	/* Requests sorted by priority */
+	uint8_t					count;							/* Number of requests in queue[] */
+	MCP4725_RTOS_Request_t	active;							/* Request whose transfer is in progress */
+	uint8_t					busy;							/* 1 while the transfer of active is in progress */
+}MCP4725_RTOS_Handle_t;
+
+/* Initialization function */
+HAL_StatusTypeDef mcp4725_rtos_Init(MCP4725_RTOS_Handle_t* rtos, MCP4725_Handle_t* mcp4725_dev);
+
+/* Control functions, the calling task waits until the transfer ends */
+HAL_StatusTypeDef mcp4725_rtos_Write_PowerDown_DAC_Register(MCP4725_RTOS_Handle_t* rtos, uint16_t dac_data, MCP4725_PowerDown_e pd_mode, uint8_t priority, TickType_t timeout);
+HAL_StatusTypeDef mcp4725_rtos_Write_DAC_Register(MCP4725_RTOS_Handle_t* rtos, uint16_t dac_data, uint8_t priority, TickType_t timeout);
+HAL_StatusTypeDef mcp4725_rtos_Write_PowerDown(MCP4725_RTOS_Handle_t* rtos, MCP4725_PowerDown_e pd_mode, uint8_t priority, TickType_t timeout);
+HAL_StatusTypeDef mcp4725_rtos_Write_DAC_EEPROM(MCP4725_RTOS_Handle_t* rtos, uint16_t dac_data, MCP4725_PowerDown_e pd_mode, uint8_t priority, TickType_t timeout);
+HAL_StatusTypeDef mcp4725_rtos_Read_DAC_EEPROM(MCP4725_RTOS_Handle_t* rtos, uint8_t priority, TickType_t timeout);
+HAL_StatusTypeDef mcp4725_rtos_GeneralCall_Reset(MCP4725_RTOS_Handle_t* rtos, uint8_t priority, TickType_t timeout);
+HAL_StatusTypeDef mcp4725_rtos_GeneralCall_WakeUp(MCP4725_RTOS_Handle_t* rtos, uint8_t priority, TickType_t timeout);
+
+#endif /* MCP4725_USE_FREERTOS */
+
+#endif /* MCP4725_MCP4725_RTOS_H_ */
@@ -0,0 +1,251 @@
+/*
+ * mcp4725_speed.c
+ *
+ *  I2C bus speed for MCP4725, TIMINGR calculator (I2C v2) and change of the SCL clock.
+ *
+ *  TIMINGR (RM0468, I2C timings): the SCL low and high periods are (SCLL + 1) and (SCLH + 1) periods of the
+ *  prescaled clock plus the synchronization delays (slope of the line, analog filter, 2 to 3 kernel clocks).
+ *  SDADEL and SCLDEL give the data hold and setup times. For each prescaler the periods are computed to
+ *  meet the minimum low/high times of the mode, the prescaler with the clock closest to the target (not
+ *  above it) is selected.
+ */
+
+#include "mcp4725_speed.h"
+
+#define SPEED_PS_PER_S			1000000000000ULL
+#define SPEED_PS_PER_NS			1000ULL
+#define SPEED_AF_MIN_NS			50		/* Delay of the analog filter */
+#define SPEED_AF_MAX_NS			260
+#define SPEED_SYNC_CLKS			2		/* Kernel clocks of the SCL synchronization */
+#define SPEED_MAX_PRESC			16
+#define SPEED_MAX_DEL			15
+#define SPEED_MAX_SCL			256
+
+/* Fields of TIMINGR, defined here so the calculator (mcp4725_Speed_Timing) also builds for the I2C v1 devices and the host */
+#define SPEED_PRESC_POS			28
+#define SPEED_SCLDEL_POS		20
+#define SPEED_SDADEL_POS		16
+#define SPEED_SCLH_POS			8
+
+/* I2C specification limits of each mode, ns */
+typedef struct{
+	uint32_t	freq;
+	uint16_t	low_min;
+	uint16_t	high_min;
+	uint16_t	su_dat_min;
+	uint16_t	vd_dat_max;
+}SPEED_Mode_t;
+
+static const SPEED_Mode_t speed_modes[] = {
+	{ MCP4725_SPEED_STANDARD,	4700,	4000,	250,	3450 },
+	{ MCP4725_SPEED_FAST,		1300,	600,	100,	900 },
+	{ MCP4725_SPEED_FAST_PLUS,	500,	260,	50,		450 },
+};
+
+static uint64_t mcp4725_speed_ceil(int64_t num, uint64_t den);
+
+/**
+  * @brief  Compute the TIMINGR value of the I2C v2 peripheral, analog filter on and digital filter off.
+  * @param  i2c_clk Kernel clock of the I2C peripheral in Hz.
+  * @param  scl_freq Target SCL frequency in Hz, up to 1 MHz.
+  * @param  rise_ns Rise time of the lines, the I2C maximum is 1000 ns (SM), 300 ns (FM) and 120 ns (FM+).
+  * @param  fall_ns Fall time of the lines.
+  * @param  actual_freq SCL frequency reached, not above the target. Can be NULL.
+  * @retval TIMINGR value, 0 if the target is above 1 MHz or can not be reached with the kernel clock.
+  */
+uint32_t mcp4725_Speed_Timing(uint32_t i2c_clk, uint32_t scl_freq, uint16_t rise_ns, uint16_t fall_ns, uint32_t* actual_freq){
+
+	const SPEED_Mode_t* mode = NULL;
+
+	for( uint8_t idx = 0; idx < sizeof(speed_modes) / sizeof(speed_modes[0]); idx++ ){
+		if( scl_freq <= speed_modes[idx].freq ){
+			mode = &speed_modes[idx];
+			break;
+		}
+	}
+
+	if( mode == NULL || i2c_clk == 0 || scl_freq == 0 ){
+		return 0;
+	}
+
+	int64_t t_clk = SPEED_PS_PER_S / i2c_clk;
+	int64_t t_rise = rise_ns * SPEED_PS_PER_NS;
+	int64_t t_fall = fall_ns * SPEED_PS_PER_NS;
+	int64_t t_af_min = SPEED_AF_MIN_NS * SPEED_PS_PER_NS;
+	int64_t t_af_max = SPEED_AF_MAX_NS * SPEED_PS_PER_NS;
+	int64_t t_period = SPEED_PS_PER_S / scl_freq;
+
+	/* SCL low starts after the fall and the filter, SCL high after the rise and the filter */
+	int64_t t_sync_low = t_fall + t_af_min + SPEED_SYNC_CLKS * t_clk;
+	int64_t t_sync_high = t_rise + t_af_min + SPEED_SYNC_CLKS * t_clk;
+
+	uint32_t timing = 0;
+	int64_t best_period = 0;
+
+	for( uint32_t presc = 0; presc < SPEED_MAX_PRESC; presc++ ){
+
+		int64_t t_presc = ( presc + 1 ) * t_clk;
+
+		/* Data hold: tSDADEL = SDADEL * tPRESC + tI2CCLK, the shortest delay that covers the fall of SCL.
+		 * With slow kernel clocks the upper limit (data valid time) can be below 0, SDADEL = 0 is then
+		 * the best value and the data setup is kept by SCLDEL. */
+		int64_t sdadel_min = t_fall - t_af_min - 4 * t_clk;
+		int64_t sdadel_max = mode->vd_dat_max * SPEED_PS_PER_NS - t_rise - t_af_max - 5 * t_clk;
+		uint64_t sdadel = mcp4725_speed_ceil(sdadel_min, t_presc);
+
+		if( sdadel > SPEED_MAX_DEL || ( sdadel > 0 && (int64_t) sdadel * t_presc > sdadel_max ) ){
+			continue;
+		}
+
+		/* Data setup: tSCLDEL = ( SCLDEL + 1 ) * tPRESC */
+		uint64_t scldel = mcp4725_speed_ceil(t_rise + mode->su_dat_min * SPEED_PS_PER_NS, t_presc);
+		scldel = ( scldel > 0 ) ? scldel - 1 : 0;
+
+		if( scldel > SPEED_MAX_DEL ){
+			continue;
+		}
+
+		uint64_t low_min = mcp4725_speed_ceil(mode->low_min * SPEED_PS_PER_NS - t_sync_low, t_presc);
+		uint64_t high_min = mcp4725_speed_ceil(mode->high_min * SPEED_PS_PER_NS - t_sync_high, t_presc);
+		if( low_min == 0 )	low_min = 1;
+		if( high_min == 0 )	high_min = 1;
+
+		/* Prescaled periods of SCL, rounded up to stay at or below the target */
+		uint64_t count = mcp4725_speed_ceil(t_period - t_sync_low - t_sync_high, t_presc);
+		if( count < low_min + high_min ){
+			count = low_min + high_min;
+		}
+
+		/* Share the periods in the ratio of the minimum times of the mode */
+		uint64_t low = ( count * mode->low_min ) / ( mode->low_min + mode->high_min );
+		if( low < low_min )	low = low_min;
+		uint64_t high = count - low;
+		if( high < high_min ){
+			high = high_min;
+			low = count - high;
+		}
+
+		if( low > SPEED_MAX_SCL || high > SPEED_MAX_SCL ){
+			continue;
+		}
+
+		int64_t period = t_sync_low + t_sync_high + (int64_t) count * t_presc;
+
+		if( timing == 0 || period < best_period ){
+			best_period = period;
+			timing = ( presc << SPEED_PRESC_POS ) | ( (uint32_t) scldel << SPEED_SCLDEL_POS ) | ( (uint32_t) sdadel << SPEED_SDADEL_POS )
+					| ( (uint32_t) ( high - 1 ) << SPEED_SCLH_POS ) | (uint32_t) ( low - 1 );
+		}
+	}
+
+	if( timing != 0 && actual_freq != NULL ){
+		*actual_freq = (uint32_t) ( SPEED_PS_PER_S / best_period );
+	}
+
+	return timing;
+}
+
+/**
+  * @brief  Change the SCL clock of the I2C peripheral, the peripheral is initialized again.
+  * @note	I2C v2: the kernel clock is read from the RCC, the FM+ drive of the pins is enabled above 400 kHz
+  * 		(the SYSCFG clock must be enabled). The rise/fall times are MCP4725_SPEED_RISE_NS / MCP4725_SPEED_FALL_NS.
+  * 		I2C v1: up to 400 kHz. In Fast Mode the duty cycle (2 or 16/9) with the frequency closest to the
+  * 		target without going above it is selected, hi2c->Init.DutyCycle is kept on a tie.
+  * @param  hi2c Pointer to the I2C_HandleTypeDef, already initialized.
+  * @param  scl_freq Target SCL frequency in Hz.
+  * @param  actual_freq SCL frequency reached. Can be NULL.
+  * @retval HAL_OK, HAL_BUSY if a transfer is in progress, HAL_ERROR if the frequency can not be reached
+  * 		or the I2C module is not enabled (host build).
+  */
+HAL_StatusTypeDef mcp4725_Speed_Set(I2C_HandleTypeDef* hi2c, uint32_t scl_freq, uint32_t* actual_freq){
+
+#if defined(HAL_I2C_MODULE_ENABLED)
+	if( hi2c->State != HAL_I2C_STATE_READY ){
+		return HAL_BUSY;
+	}
+
+#if defined(I2C_TIMINGR_PRESC)
+
+	uint32_t i2c_clk;
+	uint32_t fmp;
+
+	if( hi2c->Instance == I2C4 ){
+		i2c_clk = HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_I2C4);
+		fmp = I2C_FASTMODEPLUS_I2C4;
+	}else{
+		i2c_clk = HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_I2C123);
+		fmp = ( hi2c->Instance == I2C1 ) ? I2C_FASTMODEPLUS_I2C1 : ( hi2c->Instance == I2C2 ) ? I2C_FASTMODEPLUS_I2C2 :
+#if defined(I2C5)
+			( hi2c->Instance == I2C5 ) ? I2C_FASTMODEPLUS_I2C5 :
+#endif
+			I2C_FASTMODEPLUS_I2C3;
+	}
+
+	uint32_t timing = mcp4725_Speed_Timing(i2c_clk, scl_freq, MCP4725_SPEED_RISE_NS, MCP4725_SPEED_FALL_NS, actual_freq);
+	if( timing == 0 ){
+		return HAL_ERROR;
+	}
+
+	if( scl_freq > MCP4725_SPEED_FAST ){
+		HAL_I2CEx_EnableFastModePlus(fmp);
+	}else{
+		HAL_I2CEx_DisableFastModePlus(fmp);
+	}
+
+	hi2c->Init.Timing = timing;
+
+#else
+
+	if( scl_freq > MCP4725_SPEED_FAST ){
+		return HAL_ERROR;
+	}
+
+	uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+
+	uint32_t freq;
+
+	/* CCR rounded up by the HAL: T = 2 * CCR (Standard Mode, CCR 4 at least), 3 * CCR (Fast Mode, duty cycle 2),
+	   25 * CCR (Fast Mode, duty cycle 16/9) */
+	if( scl_freq <= MCP4725_SPEED_STANDARD ){
+		uint32_t ccr = ( pclk - 1 ) / ( scl_freq * 2 ) + 1;
+		freq = pclk / ( 2 * ( ( ccr < 4 ) ? 4 : ccr ) );
+	}else{
+		uint32_t freq_2 = pclk / ( 3 * ( ( pclk - 1 ) / ( scl_freq * 3 ) + 1 ) );
+		uint32_t freq_16_9 = pclk / ( 25 * ( ( pclk - 1 ) / ( scl_freq * 25 ) + 1 ) );
+
+		if( freq_2 > freq_16_9 ){
+			hi2c->Init.DutyCycle = I2C_DUTYCYCLE_2;
+		}else if( freq_16_9 > freq_2 ){
+			hi2c->Init.DutyCycle = I2C_DUTYCYCLE_16_9;
+		}
+		freq = ( hi2c->Init.DutyCycle == I2C_DUTYCYCLE_2 ) ? freq_2 : freq_16_9;
+	}
+
+	hi2c->Init.ClockSpeed = scl_freq;
+
+	if( actual_freq != NULL ){
+		*actual_freq = freq;
+	}
+
+#endif
+
+	return HAL_I2C_Init(hi2c);
+#else
+	UNUSED(hi2c);
+	UNUSED(scl_freq);
+	UNUSED(actual_freq);
+	return HAL_ERROR;
+#endif
+}
+
+/**
+  * @brief  Division rounded up, 0 for a negative numerator.
+  */
+static uint64_t mcp4725_speed_ceil(int64_t num, uint64_t den){
+
+	if( num <= 0 ){
+		return 0;
+	}
+
+	return ( (uint64_t) num + den - 1 ) / den;
+}
@@ -0,0 +1,70 @@
+/*
+ * mcp4725_stream.h
+ *
+ *  Streaming mode for MCP4725. One I2C write transaction is kept open and the Fast Mode words
+ *  (2 bytes per sample) are fed by a circular DMA, the address byte and the START/STOP conditions
+ *  are sent only once. Each sample takes 18 SCL periods (2 bytes + ACK), so the sample rate is
+ *  paced by the I2C clock: f_SCL / 18, about 22.2 kS/s at 400 kHz.
+ *
+ *  The half/complete DMA callbacks ask for the half of the buffer that was just sent. A pre-encoded
+ *  table (mcp4725_wave.h) can be streamed in loop directly from flash, with no refill.
+ *
+ *  Paced streaming (mcp4725_Stream_Start_Paced): the bytes are written by the DMA of a timer update
+ *  request instead of the I2C request. Between two bytes the master holds SCL low, each byte starts at
+ *  a timer event, so the DAC update (ACK of the second byte) is set by the hardware, not by an IRQ.
+ *  The timer runs at twice the sample rate, one byte per update, up to f_SCL / 9 updates per second.
+ */
+
+#ifndef MCP4725_MCP4725_STREAM_H_
+#define MCP4725_MCP4725_STREAM_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+#include "mcp4725_wave.h"
+
+#define MCP4725_STREAM_BYTES_PER_SAMPLE		2		/* Fast Mode word */
+#define MCP4725_STREAM_SCL_PER_SAMPLE		18		/* SCL periods of a sample, 2 bytes and 2 ACK */
+
+/* MCP4725 Stream Handle Structure */
+
+typedef struct mcp4725_stream_handle{
+	MCP4725_Handle_t *		device;				/* Handle of the MCP4725, initialized by mcp4725_Init */
+	DMA_HandleTypeDef *		hdma;				/* DMA of the I2C TX request (timer update request when paced), Circular Mode with byte transfers */
+	TIM_HandleTypeDef *		htim;				/* Pacing timer, NULL when the I2C clock paces the samples */
+	uint8_t *				buffer;				/* Fast Mode words, 2 bytes per sample, sent in loop */
+	uint16_t				num_samples;		/* Samples in buffer, must be even (two halves) */
+	uint8_t					refill;				/* 1 if the halves are refilled by the callbacks, 0 for a constant table */
+	__IO uint8_t			running;			/* 1 while the transaction is open */
+	__IO uint32_t			error;				/* I2C error that stopped the stream, HAL_I2C_ERROR_xxx */
+	__IO uint32_t			blocks;				/* Half buffers sent since the start */
+	uint16_t				stop_sample;		/* Sample of the buffer in progress when the stream was stopped */
+}MCP4725_Stream_Handle_t;
+
+/* Initialization function */
+HAL_StatusTypeDef mcp4725_Stream_Init(MCP4725_Stream_Handle_t* stream, MCP4725_Handle_t* mcp4725_dev, DMA_HandleTypeDef* hdma, uint8_t* buffer, uint16_t num_samples);
+HAL_StatusTypeDef mcp4725_Stream_Init_Wave(MCP4725_Stream_Handle_t* stream, MCP4725_Handle_t* mcp4725_dev, DMA_HandleTypeDef* hdma, const MCP4725_Wave_t* wave);
+
+/* Control functions */
+HAL_StatusTypeDef mcp4725_Stream_Start(MCP4725_Stream_Handle_t* stream);
+HAL_StatusTypeDef mcp4725_Stream_Start_Paced(MCP4725_Stream_Handle_t* stream, TIM_HandleTypeDef* htim);
+HAL_StatusTypeDef mcp4725_Stream_Stop(MCP4725_Stream_Handle_t* stream);
+
+/* Encode samples in Fast Mode words, with the power down mode of the device */
+void mcp4725_Stream_Encode(MCP4725_Stream_Handle_t* stream, uint8_t* dest, const uint16_t* samples, uint16_t num_samples);
+
+/* Call from the I2Cx_ER_IRQHandler, HAL_I2C_ER_IRQHandler only when it returns 0 */
+uint8_t mcp4725_Stream_I2C_ER_IRQHandler(I2C_HandleTypeDef* hi2c);
+
+/* Weak callbacks, implement them in the user file to refill the buffer */
+void mcp4725_Stream_HalfCpltCallback(MCP4725_Stream_Handle_t* stream, uint8_t* half, uint16_t num_samples);
+void mcp4725_Stream_CpltCallback(MCP4725_Stream_Handle_t* stream, uint8_t* half, uint16_t num_samples);
+void mcp4725_Stream_ErrorCallback(MCP4725_Stream_Handle_t* stream);
+
+#endif /* MCP4725_MCP4725_STREAM_H_ */
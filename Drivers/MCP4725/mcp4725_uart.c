@@ -0,0 +1,433 @@
+/*
+ * mcp4725_uart.c
+ *
+ *  UART source of the MCP4725 streaming mode.
+ *
+ *  The halves are received in the order they are sent: rx_half toggles at each reception and a half is
+ *  received only when the stream released it and is not sending it. The stream callbacks (I2C DMA IRQ)
+ *  and the UART callbacks can preempt each other, the state is changed with the IRQs masked.
+ *
+ *  The command bits of a half are checked before it is sent: at the end of its reception, or at the
+ *  underrun for the words received before it. While resynchronizing, the RX DMA writes only in the
+ *  discard buffer, never in the stream buffer.
+ */
+
+#include "mcp4725_uart.h"
+
+#if defined(HAL_UART_MODULE_ENABLED)
+
+#define UART_BYTES_PER_SAMPLE	2
+#define UART_COMMAND_MASK		0xC0		/* C2 C1 of the Fast Mode word, always 0 */
+
+static MCP4725_Uart_t* uart_registry[MCP4725_UART_MAX_SOURCES] = {0};
+
+static MCP4725_Uart_t* mcp4725_uart_find(UART_HandleTypeDef* huart);
+static void mcp4725_uart_receive(MCP4725_Uart_t* uart);
+static void mcp4725_uart_credit(MCP4725_Uart_t* uart);
+static uint16_t mcp4725_uart_received(MCP4725_Uart_t* uart);
+static void mcp4725_uart_hold(MCP4725_Uart_t* uart, uint8_t half, uint16_t received);
+static void mcp4725_uart_check(MCP4725_Uart_t* uart, uint8_t half);
+static void mcp4725_uart_resync(MCP4725_Uart_t* uart);
+static void mcp4725_uart_discard(MCP4725_Uart_t* uart);
+
+/**
+  * @brief  Register the UART source of a stream buffer.
+  * @param  uart Pointer to a MCP4725_Uart_t structure.
+  * @param  huart UART with the RX DMA linked (hdmarx), Normal Mode.
+  * @param  buffer Buffer of the stream, given to mcp4725_Stream_Init.
+  * @param  num_samples Samples in buffer, even.
+  * @retval HAL_OK, HAL_ERROR if the parameters are not valid or MCP4725_UART_MAX_SOURCES are registered.
+  */
+HAL_StatusTypeDef mcp4725_Uart_Init(MCP4725_Uart_t* uart, UART_HandleTypeDef* huart, uint8_t* buffer, uint16_t num_samples){
+
+	uint8_t slot = MCP4725_UART_MAX_SOURCES;
+
+	if( huart == NULL || huart->hdmarx == NULL || buffer == NULL || num_samples < 2 || ( num_samples & 1 ) ){
+		return HAL_ERROR;
+	}
+
+	for( uint8_t idx = 0; idx < MCP4725_UART_MAX_SOURCES; idx++ ){
+		if( uart_registry[idx] == uart ){
+			slot = idx;
+			break;
+		}
+		if( uart_registry[idx] == NULL && slot == MCP4725_UART_MAX_SOURCES ){
+			slot = idx;
+		}
+	}
+
+	if( slot == MCP4725_UART_MAX_SOURCES ){
+		return HAL_ERROR;
+	}
+
+	uart->huart = huart;
+	uart->buffer = buffer;
+	uart->num_samples = num_samples;
+	uart->half_bytes = (uint16_t) ( ( num_samples / 2 ) * UART_BYTES_PER_SAMPLE );
+	uart->running = 0;
+	uart->rx_busy = 0;
+
+	mcp4725_Uart_Reset_Stats(uart);
+
+	uart_registry[slot] = uart;
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Start the reception of the two halves, the first credit is sent to the host.
+  * @note	Start the stream when mcp4725_Uart_Ready returns 1, the buffer is then full.
+  * @param  uart Pointer to a MCP4725_Uart_t structure.
+  * @retval HAL_OK, HAL_BUSY if already running, HAL_ERROR if the reception could not start.
+  */
+HAL_StatusTypeDef mcp4725_Uart_Start(MCP4725_Uart_t* uart){
+
+	if( uart->running ){
+		return HAL_BUSY;
+	}
+
+	uart->rx_busy = 0;
+	uart->rx_half = 0;
+	uart->free_halves = 0x03;
+	uart->playing = MCP4725_UART_NO_HALF;
+	uart->credits_pending = 0;
+	uart->resync = 0;
+	uart->running = 1;
+
+	mcp4725_uart_receive(uart);
+
+	if( uart->rx_busy == 0 ){
+		uart->running = 0;
+		return HAL_ERROR;
+	}
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  Stop the reception, the credits not used by the host are lost.
+  * @note	Stop the stream first, the buffer is not refilled anymore.
+  * @param  uart Pointer to a MCP4725_Uart_t structure.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef mcp4725_Uart_Stop(MCP4725_Uart_t* uart){
+
+	uart->running = 0;
+	uart->resync = 0;
+
+	if( uart->rx_busy ){
+		uart->rx_busy = 0;
+		return HAL_UART_AbortReceive(uart->huart);
+	}
+
+	return HAL_OK;
+}
+
+/**
+  * @brief  The two halves are received, the stream can start.
+  * @retval 1 if ready, 0 otherwise.
+  */
+uint8_t mcp4725_Uart_Ready(const MCP4725_Uart_t* uart){
+	return ( uart->running && uart->free_halves == 0 ) ? 1 : 0;
+}
+
+/**
+  * @brief  The stream sent a half, it is received again while the other half is sent.
+  * @note	Call from mcp4725_Stream_HalfCpltCallback and mcp4725_Stream_CpltCallback with their parameters.
+  * 		If the other half is not received yet, its missing samples hold the last sample and the rest of
+  * 		the block is discarded. The end of a resync is detected here.
+  * @param  uart Pointer to a MCP4725_Uart_t structure.
+  * @param  half Half of the stream buffer that was sent.
+  * @param  num_samples Samples of the half.
+  * @retval None
+  */
+void mcp4725_Uart_Release(MCP4725_Uart_t* uart, uint8_t* half, uint16_t num_samples){
+
+	UNUSED(num_samples);
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if( uart->running == 0 ){
+		__set_PRIMASK(primask);
+		return;
+	}
+
+	uint8_t sent = ( half == uart->buffer ) ? 0 : 1;
+	uint8_t next = sent ^ 1;
+
+	uart->free_halves |= (uint8_t) ( 1 << sent );
+	uart->playing = next;
+
+	if( uart->resync ){
+		/* The line is idle since the previous release, the host waits for a credit */
+		uint32_t discarded = uart->resync_bytes + ( uart->rx_busy ? mcp4725_uart_received(uart) : 0 );
+		if( discarded == uart->resync_seen ){
+			HAL_UART_AbortReceive(uart->huart);
+			uart->rx_busy = 0;
+			uart->resync = 0;
+		}
+		uart->resync_seen = discarded;
+	}
+
+	if( uart->free_halves & ( 1 << next ) ){
+		/* Underrun, the half sent now is late or not started */
+		uint16_t received = 0;
+		if( uart->rx_busy && uart->resync == 0 && uart->rx_half == next ){
+			/* Stop the late reception, the other half is received after the resync */
+			received = mcp4725_uart_received(uart);
+			mcp4725_uart_resync(uart);
+			uart->rx_half = sent;
+		}
+		uart->underruns++;
+		mcp4725_uart_hold(uart, next, received);
+		mcp4725_uart_check(uart, next);
+	}
+
+	mcp4725_uart_receive(uart);
+
+	/* Credit delayed by a transmission of the application, with no TX complete callback */
+	if( uart->credits_pending && uart->huart->gState == HAL_UART_STATE_READY ){
+		uart->credits_pending--;
+		mcp4725_uart_credit(uart);
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief  End of the reception of a half, the next one is started if the stream released it.
+  * @note	Call from HAL_UART_RxCpltCallback. The receptions of other UARTs are ignored.
+  * @param  huart Pointer to the UART_HandleTypeDef of the completed reception.
+  * @retval None
+  */
+void mcp4725_Uart_RxCpltCallback(UART_HandleTypeDef* huart){
+
+	MCP4725_Uart_t* uart = mcp4725_uart_find(huart);
+	if( uart == NULL || uart->rx_busy == 0 )	return;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if( uart->resync ){
+		uart->resync_bytes += MCP4725_UART_DISCARD_BYTES;
+		mcp4725_uart_discard(uart);
+		__set_PRIMASK(primask);
+		return;
+	}
+
+	mcp4725_uart_check(uart, uart->rx_half);
+
+	uart->rx_busy = 0;
+	uart->free_halves &= (uint8_t) ~( 1 << uart->rx_half );
+	uart->rx_half ^= 1;
+	uart->blocks++;
+
+	mcp4725_uart_receive(uart);
+
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief  End of the transmission of a credit, send the credits that were delayed.
+  * @note	Call from HAL_UART_TxCpltCallback. The transmissions of other UARTs are ignored.
+  * @param  huart Pointer to the UART_HandleTypeDef of the completed transmission.
+  * @retval None
+  */
+void mcp4725_Uart_TxCpltCallback(UART_HandleTypeDef* huart){
+
+	MCP4725_Uart_t* uart = mcp4725_uart_find(huart);
+	if( uart == NULL || uart->credits_pending == 0 )	return;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uart->credits_pending--;
+	mcp4725_uart_credit(uart);
+
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief  UART error, the HAL stopped the RX DMA. A byte may be lost, the half is dropped and the reception
+  * 		is resynchronized on the next block of the host.
+  * @note	Call from HAL_UART_ErrorCallback. The half stays free, the stream holds the last sample if it
+  * 		reaches it before the resync ends.
+  * @param  huart Pointer to the UART_HandleTypeDef of the error.
+  * @retval None
+  */
+void mcp4725_Uart_ErrorCallback(UART_HandleTypeDef* huart){
+
+	MCP4725_Uart_t* uart = mcp4725_uart_find(huart);
+	if( uart == NULL )	return;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uart->uart_errors++;
+
+	if( uart->resync ){
+		uart->resync_bytes += mcp4725_uart_received(uart);
+		mcp4725_uart_discard(uart);
+	}
+	else if( uart->rx_busy ){
+		mcp4725_uart_resync(uart);
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Clear the statistics.
+  */
+void mcp4725_Uart_Reset_Stats(MCP4725_Uart_t* uart){
+
+	uart->blocks = 0;
+	uart->credits = 0;
+	uart->underruns = 0;
+	uart->held_samples = 0;
+	uart->sync_errors = 0;
+	uart->uart_errors = 0;
+	uart->resyncs = 0;
+
+}
+
+/**
+  * @brief  Find the source of a UART.
+  */
+static MCP4725_Uart_t* mcp4725_uart_find(UART_HandleTypeDef* huart){
+
+	for( uint8_t idx = 0; idx < MCP4725_UART_MAX_SOURCES; idx++ ){
+		if( uart_registry[idx] != NULL && uart_registry[idx]->huart == huart ){
+			return uart_registry[idx];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+  * @brief  Start the reception of rx_half if the stream released it and does not send it, then send a credit.
+  * @note	Called with the IRQs masked.
+  */
+static void mcp4725_uart_receive(MCP4725_Uart_t* uart){
+
+	if( uart->running == 0 || uart->rx_busy || ( uart->free_halves & ( 1 << uart->rx_half ) ) == 0 || uart->rx_half == uart->playing ){
+		return;
+	}
+
+	if( HAL_UART_Receive_DMA(uart->huart, &uart->buffer[ uart->rx_half * uart->half_bytes ], uart->half_bytes) != HAL_OK ){
+		uart->uart_errors++;
+		return;
+	}
+
+	uart->rx_busy = 1;
+
+	mcp4725_uart_credit(uart);
+}
+
+/**
+  * @brief  Send a credit to the host, delayed to the end of the transmission in progress.
+  */
+static void mcp4725_uart_credit(MCP4725_Uart_t* uart){
+
+	uart->credit = MCP4725_UART_CREDIT;
+
+	if( HAL_UART_Transmit_IT(uart->huart, &uart->credit, 1) != HAL_OK ){
+		uart->credits_pending++;
+		return;
+	}
+
+	uart->credits++;
+}
+
+/**
+  * @brief  Bytes of rx_half written by the RX DMA.
+  */
+static uint16_t mcp4725_uart_received(MCP4725_Uart_t* uart){
+	return (uint16_t) ( uart->huart->RxXferSize - __HAL_DMA_GET_COUNTER(uart->huart->hdmarx) );
+}
+
+/**
+  * @brief  Replace the samples of a half not received yet by the last sample, received or sent.
+  */
+static void mcp4725_uart_hold(MCP4725_Uart_t* uart, uint8_t half, uint16_t received){
+
+	uint8_t* words = &uart->buffer[ half * uart->half_bytes ];
+	uint16_t first = (uint16_t) ( received / UART_BYTES_PER_SAMPLE );		/* A word with one byte is held too */
+	uint16_t last = uart->half_bytes / UART_BYTES_PER_SAMPLE;
+	const uint8_t* hold;
+
+	if( first >= last ){
+		return;
+	}
+
+	if( first > 0 ){
+		hold = &words[ ( first - 1 ) * UART_BYTES_PER_SAMPLE ];
+	}
+	else{
+		/* Last sample of the other half, sent before this one */
+		hold = &uart->buffer[ ( half ^ 1 ) * uart->half_bytes + uart->half_bytes - UART_BYTES_PER_SAMPLE ];
+	}
+
+	uint8_t high = hold[0] & (uint8_t) ~UART_COMMAND_MASK;
+	uint8_t low = hold[1];
+
+	for( uint16_t idx = first; idx < last; idx++ ){
+		words[ idx * UART_BYTES_PER_SAMPLE ] = high;
+		words[ idx * UART_BYTES_PER_SAMPLE + 1 ] = low;
+	}
+
+	uart->held_samples += last - first;
+}
+
+/**
+  * @brief  Check the command bits of the words received, a word with C2 C1 set would change the command of
+  * 		the DAC for the rest of the transaction.
+  */
+static void mcp4725_uart_check(MCP4725_Uart_t* uart, uint8_t half){
+
+	uint8_t* words = &uart->buffer[ half * uart->half_bytes ];
+
+	for( uint16_t idx = 0; idx < uart->half_bytes; idx += UART_BYTES_PER_SAMPLE ){
+		if( words[idx] & UART_COMMAND_MASK ){
+			words[idx] &= (uint8_t) ~UART_COMMAND_MASK;
+			uart->sync_errors++;
+		}
+	}
+
+}
+
+/**
+  * @brief  Stop the reception of the half and discard the bytes of the host until the line is idle.
+  * @note	Called with the IRQs masked.
+  */
+static void mcp4725_uart_resync(MCP4725_Uart_t* uart){
+
+	if( uart->rx_busy ){
+		HAL_UART_AbortReceive(uart->huart);
+	}
+
+	uart->rx_busy = 0;
+	uart->resync = 1;
+	uart->resync_bytes = 0;
+	uart->resync_seen = UINT32_MAX;
+	uart->resyncs++;
+
+	mcp4725_uart_discard(uart);
+}
+
+/**
+  * @brief  Receive the next bytes of the host in the discard buffer.
+  * @note	Called with the IRQs masked.
+  */
+static void mcp4725_uart_discard(MCP4725_Uart_t* uart){
+
+	uart->rx_busy = ( HAL_UART_Receive_DMA(uart->huart, uart->discard, MCP4725_UART_DISCARD_BYTES) == HAL_OK ) ? 1 : 0;
+
+	if( uart->rx_busy == 0 ){
+		uart->uart_errors++;
+	}
+}
+
+#endif /* HAL_UART_MODULE_ENABLED */
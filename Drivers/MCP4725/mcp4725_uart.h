@@ -0,0 +1,100 @@
+/*
+ * mcp4725_uart.h
+ *
+ *  UART source of the MCP4725 streaming mode. The host sends the Fast Mode words (2 bytes per sample,
+ *  big-endian, bits 15:14 at 0, as mcp4725_Wave_Encode writes them) and the UART RX DMA writes them
+ *  directly in the halves of the stream buffer: the bytes on the wire are the bytes on the I2C bus,
+ *  there is no copy and no conversion.
+ *
+ *  Flow control: the UART receives one half at a time. Each time a half is free (sent by the stream)
+ *  the reception is started and one credit byte (MCP4725_UART_CREDIT) is sent to the host, the host
+ *  sends one half of bytes per credit. The host never sends more than the free space, so no byte is
+ *  lost even with no RTS/CTS lines.
+ *
+ *  The half is sent by the I2C DMA in num_samples / 2 sample periods, its reception takes
+ *  num_samples * 10 / baud seconds: the baud rate must be above 40 x the sample rate (at 22.2 kS/s,
+ *  921600 bd) with a margin for the latency of the host.
+ *
+ *  Underrun: when the stream reaches a half that is not received, the missing samples are replaced by
+ *  the last sample (the output holds instead of playing the old half). The words already received are
+ *  checked at that point, the reception of the half is stopped: no late byte reaches the bus.
+ *
+ *  Resync: after an underrun or a UART error (a byte may be lost) the rest of the block of the host is
+ *  received in a small discard buffer with no credit. When no byte came during one half period the host
+ *  is waiting for a credit, the next half is received from its first byte with a new credit. A lost byte
+ *  costs the blocks in flight, the next blocks are aligned again.
+ */
+
+#ifndef MCP4725_MCP4725_UART_H_
+#define MCP4725_MCP4725_UART_H_
+
+#if defined(STM32F446xx) || defined(STM32F401xC)
+	#include "stm32f4xx_hal.h"
+#elif defined(STM32F103x6)
+	#include "stm32f1xx_hal.h"
+#elif defined(STM32H723xx)
+	#include "stm32h7xx_hal.h"
+#endif
+
+#include "mcp4725.h"
+
+#if defined(HAL_UART_MODULE_ENABLED)
+
+#ifndef MCP4725_UART_MAX_SOURCES
+#define MCP4725_UART_MAX_SOURCES	2			/* UART sources, one per stream */
+#endif
+
+#define MCP4725_UART_CREDIT			0x11		/* Sent for each half that can be received (DC1 / XON) */
+#define MCP4725_UART_NO_HALF		0xFF
+#define MCP4725_UART_DISCARD_BYTES	16			/* Bytes of the discard buffer, one IRQ each while resynchronizing */
+
+/* MCP4725 UART Source Structure */
+
+typedef struct mcp4725_uart{
+	UART_HandleTypeDef *	huart;				/* UART with the RX DMA in Normal Mode, byte transfers */
+	uint8_t *				buffer;				/* Buffer of the stream, written by the RX DMA */
+	uint16_t				num_samples;		/* Samples in buffer, must be even (two halves) */
+	uint16_t				half_bytes;			/* Bytes of a half, received for each credit */
+	__IO uint8_t			running;			/* 1 between mcp4725_Uart_Start and mcp4725_Uart_Stop */
+	__IO uint8_t			rx_busy;			/* 1 while a half is received */
+	__IO uint8_t			rx_half;			/* Half received or to receive next, 0 or 1 */
+	__IO uint8_t			free_halves;		/* Bit n set when the half n was sent by the stream and not received again */
+	__IO uint8_t			playing;			/* Half sent by the stream, MCP4725_UART_NO_HALF before the start */
+	__IO uint8_t			credits_pending;	/* Credits not sent, the UART TX was busy */
+	uint8_t					credit;				/* TX buffer of the credit byte */
+	__IO uint8_t			resync;				/* 1 while the bytes of the host are discarded, until the line is idle */
+	__IO uint32_t			resync_bytes;		/* Bytes discarded in the completed receptions of the discard buffer */
+	uint32_t				resync_seen;		/* Bytes discarded at the previous release of a half */
+	uint8_t					discard[MCP4725_UART_DISCARD_BYTES];
+	/* Statistics */
+	__IO uint32_t			blocks;				/* Halves received */
+	__IO uint32_t			credits;			/* Credits sent to the host */
+	__IO uint32_t			underruns;			/* Halves not received when the stream reached them */
+	__IO uint32_t			held_samples;		/* Samples replaced by the last sample */
+	__IO uint32_t			sync_errors;		/* Words with bits 15:14 set (a byte was lost), cleared before the I2C */
+	__IO uint32_t			uart_errors;		/* Overrun, noise, framing errors */
+	__IO uint32_t			resyncs;			/* Blocks of the host dropped to align the reception again */
+}MCP4725_Uart_t;
+
+/* Initialization function */
+HAL_StatusTypeDef mcp4725_Uart_Init(MCP4725_Uart_t* uart, UART_HandleTypeDef* huart, uint8_t* buffer, uint16_t num_samples);
+
+/* Control functions */
+HAL_StatusTypeDef mcp4725_Uart_Start(MCP4725_Uart_t* uart);
+HAL_StatusTypeDef mcp4725_Uart_Stop(MCP4725_Uart_t* uart);
+uint8_t mcp4725_Uart_Ready(const MCP4725_Uart_t* uart);
+
+/* Call from mcp4725_Stream_HalfCpltCallback and mcp4725_Stream_CpltCallback */
+void mcp4725_Uart_Release(MCP4725_Uart_t* uart, uint8_t* half, uint16_t num_samples);
+
+/* Call from HAL_UART_RxCpltCallback, HAL_UART_TxCpltCallback and HAL_UART_ErrorCallback */
+void mcp4725_Uart_RxCpltCallback(UART_HandleTypeDef* huart);
+void mcp4725_Uart_TxCpltCallback(UART_HandleTypeDef* huart);
+void mcp4725_Uart_ErrorCallback(UART_HandleTypeDef* huart);
+
+/* Statistics */
+void mcp4725_Uart_Reset_Stats(MCP4725_Uart_t* uart);
+
+#endif /* HAL_UART_MODULE_ENABLED */
+
+#endif /* MCP4725_MCP4725_UART_H_ */
@@ -0,0 +1,112 @@
+/*
+ * mcp4725_wave.c
+ *
+ *  Generators of waveform tables in the wire format of the MCP4725 (Fast Mode words).
+ *  The tables are built once (at start-up or when the waveform changes), the samples are
+ *  sent later by the streaming mode or by the asynchronous functions with no encoding work.
+ */
+
+#include <math.h>
+#include "mcp4725_wave.h"
+
+static uint16_t mcp4725_wave_clamp(int32_t value);
+static void mcp4725_wave_store(uint8_t* dest, uint16_t idx, int32_t value, MCP4725_PowerDown_e pd_mode);
+
+/**
+  * @brief  Encode an arbitrary table of 12-bit values in Fast Mode words.
+  * @param  dest Buffer of MCP4725_WAVE_BYTES(num_samples) bytes.
+  * @param  samples 12-bit values for DAC output.
+  * @param  pd_mode Power Down Mode written with each sample. Reference to MCP4725_PowerDown_e
+  * @retval None
+  */
+void mcp4725_Wave_Encode(uint8_t* dest, const uint16_t* samples, uint16_t num_samples, MCP4725_PowerDown_e pd_mode){
+
+	for( uint16_t idx = 0; idx < num_samples; idx++ ){
+		mcp4725_wave_store(dest, idx, samples[idx], pd_mode);
+	}
+
+}
+
+/**
+  * @brief  Build one period of a sine wave: offset + amplitude * sin(2*pi*idx/num_samples).
+  * @note	The values out of 0 - 4095 are clamped.
+  * @param  dest Buffer of MCP4725_WAVE_BYTES(num_samples) bytes.
+  * @param  amplitude Peak value, in DAC codes.
+  * @param  offset Middle value, in DAC codes (2048 for a wave centered in the output range).
+  * @retval None
+  */
+void mcp4725_Wave_Sine(uint8_t* dest, uint16_t num_samples, uint16_t amplitude, uint16_t offset, MCP4725_PowerDown_e pd_mode){
+
+	const float step = MCP4725_WAVE_TWO_PI / (float) num_samples;
+
+	for( uint16_t idx = 0; idx < num_samples; idx++ ){
+		float value = (float) offset + (float) amplitude * sinf(step * (float) idx);
+		mcp4725_wave_store(dest, idx, (int32_t) lrintf(value), pd_mode);
+	}
+
+}
+
+/**
+  * @brief  Build one period of a triangle wave, from offset - amplitude up to offset + amplitude and back.
+  * @note	The values out of 0 - 4095 are clamped.
+  * @param  dest Buffer of MCP4725_WAVE_BYTES(num_samples) bytes.
+  * @retval None
+  */
+void mcp4725_Wave_Triangle(uint8_t* dest, uint16_t num_samples, uint16_t amplitude, uint16_t offset, MCP4725_PowerDown_e pd_mode){
+
+	for( uint16_t idx = 0; idx < num_samples; idx++ ){
+
+		/* Position in the half period (rise or fall of 2 * amplitude), scaled to 0 - num_samples */
+		int32_t pos = ( 2 * (int32_t) idx ) % num_samples;
+		int32_t ramp = ( 2 * (int32_t) amplitude * pos ) / num_samples;
+
+		int32_t value = ( 2 * idx < num_samples ) ? ( offset - amplitude + ramp ) : ( offset + amplitude - ramp );
+		mcp4725_wave_store(dest, idx, value, pd_mode);
+	}
+
+}
+
+/**
+  * @brief  Build one period of a sawtooth wave, from offset - amplitude up to offset + amplitude.
+  * @note	The values out of 0 - 4095 are clamped.
+  * @param  dest Buffer of MCP4725_WAVE_BYTES(num_samples) bytes.
+  * @retval None
+  */
+void mcp4725_Wave_Sawtooth(uint8_t* dest, uint16_t num_samples, uint16_t amplitude, uint16_t offset, MCP4725_PowerDown_e pd_mode){
+
+	for( uint16_t idx = 0; idx < num_samples; idx++ ){
+		int32_t value = offset - amplitude + ( 2 * (int32_t) amplitude * idx ) / num_samples;
+		mcp4725_wave_store(dest, idx, value, pd_mode);
+	}
+
+}
+
+/**
+  * @brief  Decode the 12-bit value of a sample of the table.
+  * @param  idx Sample index, less than wave->num_samples.
+  * @retval DAC code
+  */
+uint16_t mcp4725_Wave_Sample(const MCP4725_Wave_t* wave, uint16_t idx){
+
+	const uint8_t* word = &wave->words[ MCP4725_WAVE_BYTES(idx) ];
+	return ( (uint16_t) ( word[0] & 0x0F ) << 8 ) | word[1];
+
+}
+
+/**
+  * @brief  Limit the value to the range of the DAC register.
+  */
+static uint16_t mcp4725_wave_clamp(int32_t value){
+
+	if( value < 0 )					return 0;
+	if( value > MCP4725_DAC_MAX )	return MCP4725_DAC_MAX;
+	return (uint16_t) value;
+
+}
+
+/**
+  * @brief  Store the Fast Mode word of the sample idx.
+  */
+static void mcp4725_wave_store(uint8_t* dest, uint16_t idx, int32_t value, MCP4725_PowerDown_e pd_mode){
+	mcp4725_Encode_Fast_Mode(&dest[ MCP4725_WAVE_BYTES(idx) ], mcp4725_wave_clamp(value), pd_mode);
+}
@@ -26,27 +26,95 @@ static const uint8_t DispNumber[] = { // Represent the Value to display each num
 		0b01100111, //	9
 };
 
+/*
+ *	Timers available to generate the SCLK signal. tim1637_GetFreeTimer() selects the Basic Timers
+ *	(last field) before the other ones, the order of the table does not matter.
+ */
+static const TIM1637_TimerDesc_t TimerDesc[] = {
+#ifdef STM32F446xx
+	{ TIM6,  &RCC->APB1ENR, RCC_APB1ENR_TIM6EN,  DMA1_Stream1, DMA_CHANNEL_7, TIM6_DAC_IRQn,            TIM1637_TIMBUS_APB1, 1 },
+	{ TIM7,  &RCC->APB1ENR, RCC_APB1ENR_TIM7EN,  DMA1_Stream2, DMA_CHANNEL_1, TIM7_IRQn,                TIM1637_TIMBUS_APB1, 1 },
+	{ TIM1,  &RCC->APB2ENR, RCC_APB2ENR_TIM1EN,  DMA2_Stream5, DMA_CHANNEL_6, TIM1_UP_TIM10_IRQn,       TIM1637_TIMBUS_APB2, 0 },
+	{ TIM2,  &RCC->APB1ENR, RCC_APB1ENR_TIM2EN,  DMA1_Stream1, DMA_CHANNEL_3, TIM2_IRQn,                TIM1637_TIMBUS_APB1, 0 },
+	{ TIM3,  &RCC->APB1ENR, RCC_APB1ENR_TIM3EN,  DMA1_Stream2, DMA_CHANNEL_5, TIM3_IRQn,                TIM1637_TIMBUS_APB1, 0 },
+	{ TIM4,  &RCC->APB1ENR, RCC_APB1ENR_TIM4EN,  DMA1_Stream6, DMA_CHANNEL_2, TIM4_IRQn,                TIM1637_TIMBUS_APB1, 0 },
+	{ TIM5,  &RCC->APB1ENR, RCC_APB1ENR_TIM5EN,  DMA1_Stream0, DMA_CHANNEL_6, TIM5_IRQn,                TIM1637_TIMBUS_APB1, 0 },
+	{ TIM8,  &RCC->APB2ENR, RCC_APB2ENR_TIM8EN,  DMA2_Stream1, DMA_CHANNEL_7, TIM8_UP_TIM13_IRQn,       TIM1637_TIMBUS_APB2, 0 },
+	{ TIM9,  &RCC->APB2ENR, RCC_APB2ENR_TIM9EN,  NULL, TIM1637_DMA_REQUEST_NONE, TIM1_BRK_TIM9_IRQn,       TIM1637_TIMBUS_APB2, 0 },
+	{ TIM10, &RCC->APB2ENR, RCC_APB2ENR_TIM10EN, NULL, TIM1637_DMA_REQUEST_NONE, TIM1_UP_TIM10_IRQn,       TIM1637_TIMBUS_APB2, 0 },
+	{ TIM11, &RCC->APB2ENR, RCC_APB2ENR_TIM11EN, NULL, TIM1637_DMA_REQUEST_NONE, TIM1_TRG_COM_TIM11_IRQn,  TIM1637_TIMBUS_APB2, 0 },
+	{ TIM12, &RCC->APB1ENR, RCC_APB1ENR_TIM12EN, NULL, TIM1637_DMA_REQUEST_NONE, TIM8_BRK_TIM12_IRQn,      TIM1637_TIMBUS_APB1, 0 },
+	{ TIM13, &RCC->APB1ENR, RCC_APB1ENR_TIM13EN, NULL, TIM1637_DMA_REQUEST_NONE, TIM8_UP_TIM13_IRQn,       TIM1637_TIMBUS_APB1, 0 },
+	{ TIM14, &RCC->APB1ENR, RCC_APB1ENR_TIM14EN, NULL, TIM1637_DMA_REQUEST_NONE, TIM8_TRG_COM_TIM14_IRQn,  TIM1637_TIMBUS_APB1, 0 },
+#elif defined(STM32F103x6)
+	{ TIM1,  &RCC->APB2ENR, RCC_APB2ENR_TIM1EN,  DMA1_Channel5, TIM1637_DMA_REQUEST_NONE, TIM1_UP_IRQn,     TIM1637_TIMBUS_APB2, 0 },
+	{ TIM2,  &RCC->APB1ENR, RCC_APB1ENR_TIM2EN,  DMA1_Channel2, TIM1637_DMA_REQUEST_NONE, TIM2_IRQn,        TIM1637_TIMBUS_APB1, 0 },
+	{ TIM3,  &RCC->APB1ENR, RCC_APB1ENR_TIM3EN,  DMA1_Channel3, TIM1637_DMA_REQUEST_NONE, TIM3_IRQn,        TIM1637_TIMBUS_APB1, 0 },
+#elif defined(STM32H723xx)
+	{ TIM6,  &RCC->APB1LENR, RCC_APB1LENR_TIM6EN,  NULL, DMA_REQUEST_TIM6_UP,  TIM6_DAC_IRQn,               TIM1637_TIMBUS_APB1, 1 },
+	{ TIM7,  &RCC->APB1LENR, RCC_APB1LENR_TIM7EN,  NULL, DMA_REQUEST_TIM7_UP,  TIM7_IRQn,                   TIM1637_TIMBUS_APB1, 1 },
+	{ TIM1,  &RCC->APB2ENR,  RCC_APB2ENR_TIM1EN,   NULL, DMA_REQUEST_TIM1_UP,  TIM1_UP_IRQn,                TIM1637_TIMBUS_APB2, 0 },
+	{ TIM2,  &RCC->APB1LENR, RCC_APB1LENR_TIM2EN,  NULL, DMA_REQUEST_TIM2_UP,  TIM2_IRQn,                   TIM1637_TIMBUS_APB1, 0 },
+	{ TIM3,  &RCC->APB1LENR, RCC_APB1LENR_TIM3EN,  NULL, DMA_REQUEST_TIM3_UP,  TIM3_IRQn,                   TIM1637_TIMBUS_APB1, 0 },
+	{ TIM4,  &RCC->APB1LENR, RCC_APB1LENR_TIM4EN,  NULL, DMA_REQUEST_TIM4_UP,  TIM4_IRQn,                   TIM1637_TIMBUS_APB1, 0 },
+	{ TIM5,  &RCC->APB1LENR, RCC_APB1LENR_TIM5EN,  NULL, DMA_REQUEST_TIM5_UP,  TIM5_IRQn,                   TIM1637_TIMBUS_APB1, 0 },
+	{ TIM8,  &RCC->APB2ENR,  RCC_APB2ENR_TIM8EN,   NULL, DMA_REQUEST_TIM8_UP,  TIM8_UP_TIM13_IRQn,          TIM1637_TIMBUS_APB2, 0 },
+	{ TIM12, &RCC->APB1LENR, RCC_APB1LENR_TIM12EN, NULL, TIM1637_DMA_REQUEST_NONE, TIM8_BRK_TIM12_IRQn,     TIM1637_TIMBUS_APB1, 0 },
+	{ TIM13, &RCC->APB1LENR, RCC_APB1LENR_TIM13EN, NULL, TIM1637_DMA_REQUEST_NONE, TIM8_UP_TIM13_IRQn,      TIM1637_TIMBUS_APB1, 0 },
+	{ TIM14, &RCC->APB1LENR, RCC_APB1LENR_TIM14EN, NULL, TIM1637_DMA_REQUEST_NONE, TIM8_TRG_COM_TIM14_IRQn, TIM1637_TIMBUS_APB1, 0 },
+	{ TIM15, &RCC->APB2ENR,  RCC_APB2ENR_TIM15EN,  NULL, DMA_REQUEST_TIM15_UP, TIM15_IRQn,                  TIM1637_TIMBUS_APB2, 0 },
+	{ TIM16, &RCC->APB2ENR,  RCC_APB2ENR_TIM16EN,  NULL, DMA_REQUEST_TIM16_UP, TIM16_IRQn,                  TIM1637_TIMBUS_APB2, 0 },
+	{ TIM17, &RCC->APB2ENR,  RCC_APB2ENR_TIM17EN,  NULL, DMA_REQUEST_TIM17_UP, TIM17_IRQn,                  TIM1637_TIMBUS_APB2, 0 },
+	{ TIM23, &RCC->APB1HENR, RCC_APB1HENR_TIM23EN, NULL, DMA_REQUEST_TIM23_UP, TIM23_IRQn,                  TIM1637_TIMBUS_APB1, 0 },
+	{ TIM24, &RCC->APB1HENR, RCC_APB1HENR_TIM24EN, NULL, DMA_REQUEST_TIM24_UP, TIM24_IRQn,                  TIM1637_TIMBUS_APB1, 0 },
+#endif
+};
+
+#define TIM1637_NUM_TIMERS		( sizeof(TimerDesc) / sizeof(TimerDesc[0]) )
+
+#define TIM1637_CALIBRATION_LOOPS	1000U
+
+/*
+ *	Timing of Blocking Mode, common for all the handles since depends only on the CPU clock.
+ */
+static uint32_t	HalfPeriod_Cycles = 0;		// CPU cycles of a half SCLK period
+static uint32_t	HalfPeriod_Loops = 0;		// Busy loop iterations of a half SCLK period when DWT is not available
+static uint8_t	DWT_Available = 0;
+
 
 /*	*********************************
  * 		Declare Private Methods
  *  *********************************/
-static void tim1637_send_displayctrl( TIM1637_Handle_t* tim1637, TIM1637_DisplayCtrl_e OnOff , TIM1637_PulseWidth_e Brightness );
-static void tim1637_send_1byte( TIM1637_Handle_t* tim1637, uint8_t DisplayValue , TIM1637_DisplayAddress_e DisplayAddr );
-static void tim1637_send_6bytes( TIM1637_Handle_t* tim1637, uint8_t ArrayBytes[] );
+static HAL_StatusTypeDef tim1637_send_displayctrl( TIM1637_Handle_t* tim1637, TIM1637_DisplayCtrl_e OnOff , TIM1637_PulseWidth_e Brightness );
+static HAL_StatusTypeDef tim1637_send_1byte( TIM1637_Handle_t* tim1637, uint8_t DisplayValue , TIM1637_DisplayAddress_e DisplayAddr );
+static HAL_StatusTypeDef tim1637_send_6bytes( TIM1637_Handle_t* tim1637, const uint8_t ArrayBytes[] );
+static void tim1637_transmit( TIM1637_Handle_t* tim1637, TIM1637_State_e FirstState );
+static void tim1637_load_digits( uint8_t Dest[TIM1637_NUM_DIGITS], const uint8_t Digits[TIM1637_NUM_DIGITS] );
+static uint8_t tim1637_frame_claim( TIM1637_Handle_t* tim1637 );
+static uint8_t tim1637_claim( TIM1637_Handle_t* tim1637, TIM1637_State_e FirstState );
+
+static void tim1637_wide_update( TIM1637_Wide_Handle_t* wide );
+
+static void tim1637_blocking_timing_init(void);
+static void tim1637_blocking_delay(void);
+static void tim1637_blocking_byte(TIM1637_Handle_t* tim1637, uint8_t Byte);
+static void tim1637_blocking_frame(TIM1637_Handle_t* tim1637);
 
 static void tim1637_start_condition(TIM1637_Handle_t* tim1637);
 static void tim1637_stop_condition(TIM1637_Handle_t* tim1637);
 
 static void tim1637_msp_gpio(TIM1637_Handle_t* tim1637);
-static void tim1637_msp_tim(TIM1637_Handle_t* tim1637);
+static void tim1637_msp_tim(const TIM1637_TimerDesc_t* Desc);
 
 /**
   * @brief  Initialize the peripheral and configure the timer to generate SCLK frequency.
   * @note	Use TIM1637_Handle_t to set the GPIO, PINS and Timer to use. (Recommend use a Basic Timer)
+  * 		When Timer.Instance is NULL a free timer is selected, use tim1637_GetTimerDesc() to know its IRQ:
+  * 		its IRQHandler must be added to stm32xx_it.c and call tim1637_Callback(), as for a timer specified.
   * @param  None
-  * @retval None
+  * @retval HAL_OK, HAL_ERROR if there is no free timer, the timer is not supported or its configuration failed.
   */
-void tim1637_Init(TIM1637_Handle_t* tim1637){
+HAL_StatusTypeDef tim1637_Init(TIM1637_Handle_t* tim1637){
 
 	/* Check the parameters	*/
 	assert_param(IS_GPIO_ALL_INSTANCE(tim1637->SCLK_gpio));
@@ -55,34 +123,29 @@ void tim1637_Init(TIM1637_Handle_t* tim1637){
 	assert_param(IS_GPIO_ALL_INSTANCE(tim1637->SDIO_gpio));
 	assert_param(IS_GPIO_PIN(tim1637->SDIO_pin));
 
-	assert_param(IS_TIM_INSTANCE(tim1637->Timer));
+	/* Select a free timer when no one was specified */
+	if( tim1637->Timer.Instance == NULL ){
+		tim1637->Timer.Instance = tim1637_GetFreeTimer();
+	}
+
+	const TIM1637_TimerDesc_t* Desc = tim1637_GetTimerDesc(tim1637->Timer.Instance);
+	if( Desc == NULL ){
+		return HAL_ERROR;
+	}
 
 	/* Enable clock and peripheral configuration */
 	tim1637_msp_gpio(tim1637);
-	tim1637_msp_tim(tim1637);
+	tim1637_msp_tim(Desc);
 
 	uint16_t prescaler = 0;
 	uint32_t PCLK = 0;
 
-	#ifdef STM32F446xx	// Search in which APB is located the TIM
-		if( ( APB1PERIPH_BASE < (uint32_t)(tim1637->Timer.Instance) ) && ( (uint32_t)(tim1637->Timer.Instance)  < APB2PERIPH_BASE ) ){
-			PCLK = HAL_RCC_GetPCLK1Freq();
-		}else{
-			PCLK = HAL_RCC_GetPCLK2Freq();
-		}
-	#elif defined(STM32F103x6)
-		if( ( APB1PERIPH_BASE < (uint32_t)(tim1637->Timer.Instance) ) && ( (uint32_t)(tim1637->Timer.Instance)  < APB2PERIPH_BASE ) ){
-			PCLK = HAL_RCC_GetPCLK1Freq();
-		}else{
-			PCLK = HAL_RCC_GetPCLK2Freq();
-		}
-	#elif defined(STM32H723xx)
-		if( ( APB1PERIPH_BASE < (uint32_t)(tim1637->Timer.Instance) ) && ( (uint32_t)(tim1637->Timer.Instance)  < APB2PERIPH_BASE ) ){
-			PCLK = HAL_RCC_GetPCLK1Freq();
-		}else{
-			PCLK = HAL_RCC_GetPCLK2Freq();
-		}
-	#endif
+	// Get the clock of the APB where the TIM is located
+	if( Desc->Bus == TIM1637_TIMBUS_APB1 ){
+		PCLK = HAL_RCC_GetPCLK1Freq();
+	}else{
+		PCLK = HAL_RCC_GetPCLK2Freq();
+	}
 
 	/* Configure Timer to generate an Update Interrupt Event @ tim1637->SCLK_Freq / 2 */
 	prescaler = ( (PCLK * 2) / ( tim1637->SCLK_Freq * 4 ) ) - 1;
@@ -91,11 +154,13 @@ void tim1637_Init(TIM1637_Handle_t* tim1637){
 
 
 	if( HAL_TIM_Base_Init( &(tim1637->Timer) ) != HAL_OK){
-		Error_Handler();
-	}else{
-		tim1637->State = TIM1637_STATE_READY;
+		return HAL_ERROR;
 	}
 
+	tim1637->Bit_Count = 0;
+	tim1637->Mode = TIM1637_MODE_IT;
+	tim1637->State = TIM1637_STATE_READY;
+
 
 	tim1637_ClearAll(tim1637);
 	if( tim1637->DispCtrl == TIM1637_DISPLAY_ON ){
@@ -104,6 +169,67 @@ void tim1637_Init(TIM1637_Handle_t* tim1637){
 		tim1637_TurnOff(tim1637);
 	}
 
+	return HAL_OK;
+}
+
+/**
+  * @brief  Initialize the GPIO only and send the frames in Blocking Mode.
+  * @note	Use during early boot or in fault handlers, where the IRQs are disabled or the timer is not configured.
+  * 		Call tim1637_Init() later to change to Interrupt Mode.
+  * @param  TIM1637_Handle_t* tim1637
+  * @retval None
+  */
+void tim1637_InitBlocking(TIM1637_Handle_t* tim1637){
+
+	/* Check the parameters	*/
+	assert_param(IS_GPIO_ALL_INSTANCE(tim1637->SCLK_gpio));
+	assert_param(IS_GPIO_PIN(tim1637->SCLK_pin));
+
+	assert_param(IS_GPIO_ALL_INSTANCE(tim1637->SDIO_gpio));
+	assert_param(IS_GPIO_PIN(tim1637->SDIO_pin));
+
+	tim1637_msp_gpio(tim1637);
+
+	tim1637->Bit_Count = 0;
+	tim1637->State = TIM1637_STATE_READY;
+	tim1637_SetMode(tim1637, TIM1637_MODE_BLOCKING);
+
+	tim1637_ClearAll(tim1637);
+	if( tim1637->DispCtrl == TIM1637_DISPLAY_ON ){
+		tim1637_TurnOn(tim1637);
+	}else{
+		tim1637_TurnOff(tim1637);
+	}
+
+}
+
+/**
+  * @brief  Select how the frames are sent, by the Timer Update Interrupt or in Blocking Mode.
+  * @note	Changing to Blocking Mode aborts the frame in progress (if any) with a stop condition,
+  * 		it is safe to call from fault handlers. Interrupt Mode requires tim1637_Init() called before.
+  * @param  Mode @ref TIM1637_Mode_e
+  * @retval None
+  */
+void tim1637_SetMode(TIM1637_Handle_t* tim1637, TIM1637_Mode_e Mode){
+
+	if( Mode == TIM1637_MODE_BLOCKING ){
+
+		if( tim1637->State != TIM1637_STATE_READY ){
+			// Abort the frame sent by the Timer
+			HAL_TIM_Base_Stop_IT( &(tim1637->Timer) );
+
+			HAL_GPIO_WritePin(tim1637->SCLK_gpio, tim1637->SCLK_pin, GPIO_PIN_RESET);
+			HAL_GPIO_WritePin(tim1637->SDIO_gpio, tim1637->SDIO_pin, GPIO_PIN_RESET);
+			tim1637_stop_condition(tim1637);
+
+			tim1637->Bit_Count = 0;
+			tim1637->State = TIM1637_STATE_READY;
+		}
+
+		tim1637_blocking_timing_init();
+	}
+
+	tim1637->Mode = Mode;
 }
 
 /**
@@ -115,8 +241,7 @@ void tim1637_Init(TIM1637_Handle_t* tim1637){
 void tim1637_ClearAll( TIM1637_Handle_t* tim1637 ){
 	uint8_t DataBytes[TIM1637_NUM_DIGITS] = {0};
 
-	while( tim1637->State != TIM1637_STATE_READY);
-	tim1637_send_6bytes(tim1637, DataBytes);
+	while( tim1637_send_6bytes(tim1637, DataBytes) != HAL_OK );
 
 }
 
@@ -125,9 +250,10 @@ void tim1637_ClearAll( TIM1637_Handle_t* tim1637 ){
   * @note
   * @param 	DisplayAddr specifies the display to set the value.
   * @param  Value represents the state of the 8 segments in the display, where LSB represents the A-Segment and MSB represents the dot-segment.
-  * @retval None
+  * @retval HAL_OK when the frame was sent (Blocking Mode) or started, HAL_BUSY if a frame is on the way,
+  * 		HAL_ERROR if DisplayAddr is not 0 to 5.
   */
-void tim1637_SetValue( TIM1637_Handle_t* tim1637, uint8_t DisplayAddr, uint8_t Value ){
+HAL_StatusTypeDef tim1637_SetValue( TIM1637_Handle_t* tim1637, uint8_t DisplayAddr, uint8_t Value ){
 
 	TIM1637_DisplayAddress_e DispAddr = 0;
 
@@ -151,11 +277,10 @@ void tim1637_SetValue( TIM1637_Handle_t* tim1637, uint8_t DisplayAddr, uint8_t V
 			DispAddr = TIM1637_DISPLAYADDR_5;
 			break;
 		default:
-			break;
+			return HAL_ERROR;
 	}
 
-	while( tim1637->State != TIM1637_STATE_READY);
-	tim1637_send_1byte(tim1637, Value, DispAddr);
+	return tim1637_send_1byte(tim1637, Value, DispAddr);
 }
 
 
@@ -169,6 +294,22 @@ void tim1637_SetIntNumber( TIM1637_Handle_t* tim1637, uint32_t Number ){
 
 	uint8_t DisplayAddr[6] = {0} ;
 
+	tim1637_FormatIntNumber(DisplayAddr, Number);
+	tim1637_send_6bytes(tim1637, DisplayAddr);
+}
+
+/**
+  * @brief	Encode an Integer Number in the segments of the 6 digits.
+  * @note	Use by tim1637_SetIntNumber and any layer that sends the digits by itself.
+  * @param	DisplayAddr Buffer of 6 digits to store the segments, DisplayAddr[0] is the right digit.
+  * @retval None
+  */
+void tim1637_FormatIntNumber( uint8_t DisplayAddr[TIM1637_NUM_DIGITS], uint32_t Number ){
+
+	for( uint8_t digit = 0; digit < TIM1637_NUM_DIGITS; digit ++ ){
+		DisplayAddr[digit] = 0;
+	}
+
 	if( Number < 10 ){
 
 		DisplayAddr[0] =  DispNumber[ Number ];
@@ -210,7 +351,6 @@ void tim1637_SetIntNumber( TIM1637_Handle_t* tim1637, uint32_t Number ){
 
 	}
 
-	tim1637_send_6bytes(tim1637, DisplayAddr);
 }
 
 /**
@@ -222,7 +362,26 @@ void tim1637_SetIntNumber( TIM1637_Handle_t* tim1637, uint32_t Number ){
   */
 void tim1637_SetFloatNumber( TIM1637_Handle_t* tim1637, double Number, uint8_t NumDecimals ){
 
-	uint8_t DisplayAddr[6] = {0}, idx = 0 ;
+	uint8_t DisplayAddr[6] = {0} ;
+
+	tim1637_FormatFloatNumber(DisplayAddr, Number, NumDecimals);
+	tim1637_send_6bytes(tim1637, DisplayAddr);
+}
+
+/**
+  * @brief	Encode a double or float value in the segments of the 6 digits.
+  * @note	Use by tim1637_SetFloatNumber and any layer that sends the digits by itself.
+  * @param	DisplayAddr Buffer of 6 digits to store the segments, DisplayAddr[0] is the right digit.
+  * @param	uint8_t NumDecimals represent the number of digits to use after of decimal point. Maximun of 3.
+  * @retval None
+  */
+void tim1637_FormatFloatNumber( uint8_t DisplayAddr[TIM1637_NUM_DIGITS], double Number, uint8_t NumDecimals ){
+
+	uint8_t idx = 0 ;
+
+	for( uint8_t digit = 0; digit < TIM1637_NUM_DIGITS; digit ++ ){
+		DisplayAddr[digit] = 0;
+	}
 	double aux = 0;
 
 	if( NumDecimals <= 0)		NumDecimals = 1;
@@ -294,8 +453,50 @@ void tim1637_SetFloatNumber( TIM1637_Handle_t* tim1637, double Number, uint8_t N
 
 	// Add dot
 	DisplayAddr[NumDecimals] |= TIM1637_ADD_DOT;
+}
 
-	tim1637_send_6bytes(tim1637, DisplayAddr);
+/**
+  * @brief	Send the segments of the 6 digits.
+  * @note	Does not wait for the transfer in progress.
+  * @param	Digits contains the 8 segments of each digit, Digits[0] is the right digit.
+  * @retval HAL_OK if the frame was started, HAL_BUSY if the previous frame is in progress.
+  */
+HAL_StatusTypeDef tim1637_SetDigits( TIM1637_Handle_t* tim1637, const uint8_t Digits[TIM1637_NUM_DIGITS] ){
+
+	return tim1637_send_6bytes(tim1637, Digits);
+}
+
+/**
+  * @brief	Write the segments of the 6 digits in the back framebuffer, never waits.
+  * @note	Can be called at any time and from any context (task, IRQ). The buffers are swapped at the
+  * 		end of the frame in progress, so a frame is never sent half old and half new. Only the
+  * 		last frame written before the swap is sent, the intermediate ones are dropped.
+  * @param	Digits contains the 8 segments of each digit, Digits[0] is the right digit.
+  * @retval None
+  */
+void tim1637_WriteFrame( TIM1637_Handle_t* tim1637, const uint8_t Digits[TIM1637_NUM_DIGITS] ){
+
+	uint8_t Wire[TIM1637_NUM_DIGITS];
+	uint8_t Start;
+
+	tim1637_load_digits(Wire, Digits);
+
+	// The copy and the swap exclude each other, the masked section lasts a few cycles
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint8_t* Back = tim1637->Frame[ tim1637->Front ^ 1U ];
+	for( uint8_t idx = 0; idx < TIM1637_NUM_DIGITS; idx ++ ){
+		Back[idx] = Wire[idx];
+	}
+	tim1637->Swap_Pending = 1;
+
+	Start = tim1637_frame_claim(tim1637);
+	__set_PRIMASK(primask);
+
+	if( Start ){
+		tim1637_transmit(tim1637, TIM1637_STATE_BUSY_IN_DATA_CMD);
+	}
 }
 
 
@@ -339,8 +540,7 @@ void tim1637_Demo(TIM1637_Handle_t* tim1637 ){
 void tim1637_TurnOn( TIM1637_Handle_t* tim1637 ){
 	// Update the DispCtrl state
 	tim1637->DispCtrl = TIM1637_DISPLAY_ON;
-	while( tim1637->State != TIM1637_STATE_READY);
-	tim1637_send_displayctrl(tim1637, TIM1637_DISPLAY_ON, tim1637->Brightness);
+	while( tim1637_send_displayctrl(tim1637, TIM1637_DISPLAY_ON, tim1637->Brightness) != HAL_OK );
 
 }
 
@@ -353,8 +553,7 @@ void tim1637_TurnOn( TIM1637_Handle_t* tim1637 ){
 void tim1637_TurnOff( TIM1637_Handle_t* tim1637 ){
 	// Update the DispCtrl state
 	tim1637->DispCtrl = TIM1637_DISPLAY_OFF;
-	while( tim1637->State != TIM1637_STATE_READY);
-	tim1637_send_displayctrl(tim1637, TIM1637_DISPLAY_OFF, tim1637->Brightness);
+	while( tim1637_send_displayctrl(tim1637, TIM1637_DISPLAY_OFF, tim1637->Brightness) != HAL_OK );
 }
 
 /**
@@ -366,10 +565,223 @@ void tim1637_TurnOff( TIM1637_Handle_t* tim1637 ){
 void tim1637_SetBrightness( TIM1637_Handle_t* tim1637, TIM1637_PulseWidth_e Brightness ){
 	// Update the Brightness value
 	tim1637->Brightness = Brightness;
-	while( tim1637->State != TIM1637_STATE_READY);
-	tim1637_send_displayctrl(tim1637, tim1637->DispCtrl, Brightness);
+	while( tim1637_send_displayctrl(tim1637, tim1637->DispCtrl, Brightness) != HAL_OK );
+}
+
+/**
+  * @brief	Turn the displays on or off and set the brightness without waiting for the frame on the way.
+  * @note	Usable from an ISR or a critical section, unlike tim1637_TurnOn, tim1637_TurnOff and tim1637_SetBrightness.
+  * @param	OnOff TIM1637_DISPLAY_ON or TIM1637_DISPLAY_OFF.
+  * @param	Brightness Pulse width of the segments.
+  * @retval HAL_OK when the frame was sent (Blocking Mode) or started, HAL_BUSY if a frame is on the way.
+  */
+HAL_StatusTypeDef tim1637_SetDisplayCtrl( TIM1637_Handle_t* tim1637, TIM1637_DisplayCtrl_e OnOff, TIM1637_PulseWidth_e Brightness ){
+
+	HAL_StatusTypeDef status = tim1637_send_displayctrl(tim1637, OnOff, Brightness);
+
+	if( status == HAL_OK ){
+		tim1637->DispCtrl = OnOff;
+		tim1637->Brightness = Brightness;
+	}
+	return status;
+}
+
+
+/**
+  * @brief	Join several modules in one wide display, the modules must be initialized before.
+  * @note	Modules[0] shows the least significant digits (right side), Modules[NumModules - 1] the most significant.
+  * @param	Modules Array of handles of the modules.
+  * @param	NumModules Number of modules, maximum TIM1637_WIDE_MAX_MODULES.
+  * @retval None
+  */
+void tim1637_Wide_Init( TIM1637_Wide_Handle_t* wide, TIM1637_Handle_t* Modules[], uint8_t NumModules ){
+
+	if( NumModules > TIM1637_WIDE_MAX_MODULES )		NumModules = TIM1637_WIDE_MAX_MODULES;
+
+	wide->NumModules = NumModules;
+	for( uint8_t module = 0; module < NumModules; module ++ ){
+		wide->Modules[module] = Modules[module];
+	}
+
+	// Modules are cleared by tim1637_Init()
+	for( uint8_t digit = 0; digit < TIM1637_WIDE_MAX_DIGITS; digit ++ ){
+		wide->Frame[digit] = 0;
+		wide->Sent[digit] = 0;
+	}
+	wide->Dirty = 0;
+}
+
+/**
+  * @brief	Set the segments of the digits of the wide display and refresh the modules that changed.
+  * @note
+  * @param	Digits contains the 8 segments of each digit, Digits[0] is the right digit. The digits not specified are turned off.
+  * @param	NumDigits number of values in Digits[].
+  * @retval None
+  */
+void tim1637_Wide_SetDigits( TIM1637_Wide_Handle_t* wide, const uint8_t Digits[], uint8_t NumDigits ){
+
+	for( uint8_t digit = 0; digit < (wide->NumModules * TIM1637_NUM_DIGITS); digit ++ ){
+		wide->Frame[digit] = ( digit < NumDigits ) ? Digits[digit] : 0;
+	}
+
+	tim1637_wide_update(wide);
+}
+
+/**
+  * @brief	Represent an Integer Number using all the digits of the wide display.
+  * @note	If the Number does not fit in the display all the digits are turned off.
+  * @param	Number to display
+  * @retval None
+  */
+void tim1637_Wide_SetIntNumber( TIM1637_Wide_Handle_t* wide, uint64_t Number ){
+
+	uint8_t NumDigits = wide->NumModules * TIM1637_NUM_DIGITS;
+	uint8_t digit = 0;
+
+	do{
+		wide->Frame[digit ++] = DispNumber[ Number % 10 ];
+		Number /= 10;
+	}while( Number != 0 && digit < NumDigits );
+
+	if( Number != 0 ){
+		digit = 0;		// Overflow
+	}
+
+	for( ; digit < NumDigits; digit ++ ){
+		wide->Frame[digit] = 0;
+	}
+
+	tim1637_wide_update(wide);
+}
+
+/**
+  * @brief	Represent a double or float value using all the digits of the wide display.
+  * @note	A negative Number is shown with a minus sign on the left digit. If the Number does not fit in the
+  * 		display (sign included) or is not a number all the digits are turned off.
+  * @param	Number to display
+  * @param	NumDecimals represent the number of digits to use after of decimal point. From 1 to 9.
+  * @retval None
+  */
+void tim1637_Wide_SetFloatNumber( TIM1637_Wide_Handle_t* wide, double Number, uint8_t NumDecimals ){
+
+	uint8_t NumDigits = wide->NumModules * TIM1637_NUM_DIGITS;
+	uint64_t Scaled;
+	uint8_t Negative = 0;
+	double Limit = 1;
+	uint8_t digit = 0;
+
+	if( NumDecimals <= 0)		NumDecimals = 1;
+	else if(NumDecimals  > 9)	NumDecimals = 9;
+
+	if( Number < 0 ){
+		Negative = 1;
+		Number = -Number;
+	}
+
+	for( uint8_t dec = 0; dec < NumDecimals; dec ++ ){
+		Number *= 10;
+	}
+
+	// Largest value of the digits left by the sign, and of the uint64_t (19 digits). A NaN fails the test too.
+	for( uint8_t dec = 0; dec < NumDigits - Negative && dec < 19; dec ++ ){
+		Limit *= 10;
+	}
+
+	if( Number < Limit ){
+		Scaled = (uint64_t) Number;
+		if( Scaled == 0 )	Negative = 0;		// No sign for -0.0
+
+		// Decimal digits, integer digits and at least one digit before the dot.
+		while( ( Scaled != 0 || digit <= NumDecimals ) && digit < NumDigits - Negative ){
+			wide->Frame[digit ++] = DispNumber[ Scaled % 10 ];
+			Scaled /= 10;
+		}
+
+		if( digit <= NumDecimals ){
+			digit = 0;		// Overflow, not enough digits for the decimals
+		}else{
+			// Add dot and sign
+			wide->Frame[NumDecimals] |= TIM1637_ADD_DOT;
+			if( Negative )	wide->Frame[digit ++] = TIM1637_MINUS;
+		}
+	}
+
+	for( ; digit < NumDigits; digit ++ ){
+		wide->Frame[digit] = 0;
+	}
+
+	tim1637_wide_update(wide);
+}
+
+/**
+  * @brief	Start the transfer of each module whose part of the frame is not sent yet.
+  * @note	All the transfers are started in one pass without waiting for each one, a module that is still
+  * 		busy keeps pending and is sent in the next call. Call periodically until it returns 0.
+  * @param	None
+  * @retval Number of modules still pending.
+  */
+uint8_t tim1637_Wide_Refresh( TIM1637_Wide_Handle_t* wide ){
+
+	uint8_t Pending = 0;
+
+	for( uint8_t module = 0; module < wide->NumModules; module ++ ){
+
+		if( ( wide->Dirty & ( 1UL << module ) ) == 0 )	continue;
+
+		uint8_t* Segment = &wide->Frame[ module * TIM1637_NUM_DIGITS ];
+		if( tim1637_SetDigits(wide->Modules[module], Segment) == HAL_OK ){
+
+			for( uint8_t digit = 0; digit < TIM1637_NUM_DIGITS; digit ++ ){
+				wide->Sent[ module * TIM1637_NUM_DIGITS + digit ] = Segment[digit];
+			}
+			wide->Dirty &= ~( 1UL << module );
+
+		}else{
+			Pending ++;
+		}
+	}
+
+	return Pending;
+}
+
+/**
+  * @brief	Search the descriptor of the specified timer.
+  * @note	Use by the driver initialization and by any backend that needs the RCC, IRQ or DMA request of the timer.
+  * @param	Instance Base address of the timer.
+  * @retval Pointer to the timer descriptor, NULL if the timer is not supported.
+  */
+const TIM1637_TimerDesc_t* tim1637_GetTimerDesc( TIM_TypeDef* Instance ){
+
+	for( uint8_t idx = 0; idx < TIM1637_NUM_TIMERS; idx ++ ){
+		if( TimerDesc[idx].Instance == Instance ){
+			return &TimerDesc[idx];
+		}
+	}
+
+	return NULL;
 }
 
+/**
+  * @brief	Search a timer that is not used: its clock is disabled.
+  * @note	Basic Timers are preferred, the remaining timers are used when there is no Basic Timer free (STM32F103x6 has none).
+  * 		Only the timers already configured are seen as used, call it after the MX_TIMx_Init() of the project.
+  * 		The IRQHandler of the timer selected (tim1637_GetTimerDesc()->IRQn) must be added to stm32xx_it.c.
+  * @param	None
+  * @retval Base address of the timer, NULL if all the timers are in use.
+  */
+TIM_TypeDef* tim1637_GetFreeTimer( void ){
+
+	// First pass Basic Timers, second pass the others
+	for( int8_t Basic = 1; Basic >= 0; Basic -- ){
+		for( uint8_t idx = 0; idx < TIM1637_NUM_TIMERS; idx ++ ){
+			if( TimerDesc[idx].Basic == Basic && READ_BIT( *(TimerDesc[idx].RCC_ENR), TimerDesc[idx].RCC_EN_Msk ) == 0 ){
+				return TimerDesc[idx].Instance;
+			}
+		}
+	}
+
+	return NULL;
+}
 
 /**
   * @brief  Callback function for Timer Update Event to send to TIM1637, it executes when an update interrupt event rises.
@@ -379,8 +791,7 @@ void tim1637_SetBrightness( TIM1637_Handle_t* tim1637, TIM1637_PulseWidth_e Brig
   */
 void tim1637_Callback(TIM1637_Handle_t* tim1637){
 
-	static uint8_t count = 0;
-
+	TIM1637_State_e PrevState = tim1637->State;
 	uint32_t itsource = tim1637->Timer.Instance->DIER;
 	uint32_t itflag   = tim1637->Timer.Instance->SR;
 
@@ -392,40 +803,40 @@ void tim1637_Callback(TIM1637_Handle_t* tim1637){
 
 
 			// Generate the Start Condition before send 8 data bits
-			if( count == 0 && tim1637->StartCondition == TIM1637_STARTCONDITION_ENABLED){
+			if( tim1637->Bit_Count == 0 && tim1637->StartCondition == TIM1637_STARTCONDITION_ENABLED){
 				tim1637_start_condition(tim1637);
 			}
 
-			if( count % 2 == 0){		// Set LOW the SCLK pin.
+			if( tim1637->Bit_Count % 2 == 0){		// Set LOW the SCLK pin.
 				HAL_GPIO_WritePin(tim1637->SCLK_gpio, tim1637->SCLK_pin, GPIO_PIN_RESET);
 
-				if( count < 16 ){		// Change the SDIO state when SCLK is LOW.
+				if( tim1637->Bit_Count < 16 ){		// Change the SDIO state when SCLK is LOW.
 
 					if( tim1637->State == TIM1637_STATE_BUSY_IN_DATA_CMD){
-						HAL_GPIO_WritePin(tim1637->SDIO_gpio, tim1637->SDIO_pin, ( ( tim1637->Commands[ TIM1637_CMDIDX_DATA ] >> (uint8_t)(count / 2) ) & 0x1 ));
+						HAL_GPIO_WritePin(tim1637->SDIO_gpio, tim1637->SDIO_pin, ( ( tim1637->Commands[ TIM1637_CMDIDX_DATA ] >> (uint8_t)(tim1637->Bit_Count / 2) ) & 0x1 ));
 
 					}else if( tim1637->State == TIM1637_STATE_BUSY_IN_ADDR_CMD){
-						HAL_GPIO_WritePin(tim1637->SDIO_gpio, tim1637->SDIO_pin, ( ( tim1637->Commands[ TIM1637_CMDIDX_ADDR ] >> (uint8_t)(count / 2) ) & 0x1 ));
+						HAL_GPIO_WritePin(tim1637->SDIO_gpio, tim1637->SDIO_pin, ( ( tim1637->Commands[ TIM1637_CMDIDX_ADDR ] >> (uint8_t)(tim1637->Bit_Count / 2) ) & 0x1 ));
 
 					}else if( tim1637->State == TIM1637_STATE_BUSY_IN_DISPLAY_CTRL_CMD ){
-						HAL_GPIO_WritePin(tim1637->SDIO_gpio, tim1637->SDIO_pin, ( ( tim1637->Commands[ TIM1637_CMDIDX_DISPLAY_CTR ] >> (uint8_t)(count / 2) ) & 0x1 ));
+						HAL_GPIO_WritePin(tim1637->SDIO_gpio, tim1637->SDIO_pin, ( ( tim1637->Commands[ TIM1637_CMDIDX_DISPLAY_CTR ] >> (uint8_t)(tim1637->Bit_Count / 2) ) & 0x1 ));
 
 					}else if( tim1637->State == TIM1637_STATE_BUSY_IN_TX_BYTES ){
-						HAL_GPIO_WritePin(tim1637->SDIO_gpio, tim1637->SDIO_pin, ( ( tim1637->Data[ tim1637->Data_Idx ] >> (uint8_t)(count / 2) ) & 0x1 ));
+						HAL_GPIO_WritePin(tim1637->SDIO_gpio, tim1637->SDIO_pin, ( ( tim1637->TxData[ tim1637->Data_Idx ] >> (uint8_t)(tim1637->Bit_Count / 2) ) & 0x1 ));
 					}
 
 				}else{
 
 					HAL_GPIO_WritePin(tim1637->SDIO_gpio, tim1637->SDIO_pin, GPIO_PIN_RESET);
 				}
-			}else if( count % 2 == 1){
+			}else if( tim1637->Bit_Count % 2 == 1){
 
 				HAL_GPIO_WritePin(tim1637->SCLK_gpio, tim1637->SCLK_pin, GPIO_PIN_SET);
 			}
 
-			count ++;
+			tim1637->Bit_Count ++;
 
-			if( count == 19 && tim1637->StopCondition == TIM1637_STOPCONDITION_ENABLED){
+			if( tim1637->Bit_Count == 19 && tim1637->StopCondition == TIM1637_STOPCONDITION_ENABLED){
 
 				if( tim1637->State == TIM1637_STATE_BUSY_IN_DATA_CMD){
 					tim1637_stop_condition(tim1637);
@@ -454,9 +865,9 @@ void tim1637_Callback(TIM1637_Handle_t* tim1637){
 
 				}
 
-				count = 0;
+				tim1637->Bit_Count = 0;
 
-			}else if( count == 19 && tim1637->StopCondition == TIM1637_STOPCONDITION_DISABLED ){
+			}else if( tim1637->Bit_Count == 19 && tim1637->StopCondition == TIM1637_STOPCONDITION_DISABLED ){
 
 				if( tim1637->State == TIM1637_STATE_BUSY_IN_ADDR_CMD){
 
@@ -478,10 +889,36 @@ void tim1637_Callback(TIM1637_Handle_t* tim1637){
 
 				}
 
-				count = 0;
+				tim1637->Bit_Count = 0;
 			}
 	    }
 	}
+
+	// Notify the end of the frame
+	if( PrevState != TIM1637_STATE_READY && tim1637->State == TIM1637_STATE_READY ){
+		tim1637_TxCpltCallback(tim1637);
+
+		// Transaction boundary, swap the framebuffers if a new frame was written
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		uint8_t Start = tim1637_frame_claim(tim1637);
+		__set_PRIMASK(primask);
+
+		if( Start ){
+			tim1637_transmit(tim1637, TIM1637_STATE_BUSY_IN_DATA_CMD);
+		}
+	}
+}
+
+/**
+  * @brief  Frame transfer completed callback, called from tim1637_Callback (Timer IRQ) when the frame ends.
+  * 		In Blocking Mode it is called by the function that sent the frame, in the calling context.
+  * @note	This function should not be modified, when the callback is needed it can be implemented in the user file.
+  * @param  TIM1637_Handle_t* tim1637
+  * @retval None
+  */
+__weak void tim1637_TxCpltCallback(TIM1637_Handle_t* tim1637){
+	UNUSED(tim1637);
 }
 
 /**
@@ -489,25 +926,25 @@ void tim1637_Callback(TIM1637_Handle_t* tim1637){
   * @note
   * @param  TIM1637_DisplayCtrl_e OnOff
   * @param  TIM1637_PulseWidth_e Brightness represent the level of brightness, value from 0 to 7.
-  * @retval None
+  * @retval HAL_OK when the frame was sent (Blocking Mode) or started, HAL_BUSY if a frame is on the way.
   */
-static void tim1637_send_displayctrl( TIM1637_Handle_t* tim1637, TIM1637_DisplayCtrl_e OnOff , TIM1637_PulseWidth_e Brightness ){
+static HAL_StatusTypeDef tim1637_send_displayctrl( TIM1637_Handle_t* tim1637, TIM1637_DisplayCtrl_e OnOff , TIM1637_PulseWidth_e Brightness ){
 
-	if( tim1637->State ==  TIM1637_STATE_READY){
+	if( tim1637_claim(tim1637, TIM1637_STATE_BUSY_IN_DISPLAY_CTRL_CMD) == 0 ){
+		return HAL_BUSY;
+	}
 
-		tim1637->Method = TIM1637_METHOD_DISPLAY_CTRL;
-		tim1637->StartCondition = TIM1637_STARTCONDITION_ENABLED;
-		tim1637->StopCondition = TIM1637_STOPCONDITION_ENABLED;
+	tim1637->Method = TIM1637_METHOD_DISPLAY_CTRL;
+	tim1637->StartCondition = TIM1637_STARTCONDITION_ENABLED;
+	tim1637->StopCondition = TIM1637_STOPCONDITION_ENABLED;
 
-		// Set first command to send: Write SRAM data in a fixed address mode
-		tim1637->Commands[ TIM1637_CMDIDX_DISPLAY_CTR ] = TIM1637_DISPLAY_CTRL |  ( (OnOff & 0x1) << 0x03 )  | ( Brightness & 0x07 );
+	// Set first command to send: Write SRAM data in a fixed address mode
+	tim1637->Commands[ TIM1637_CMDIDX_DISPLAY_CTR ] = TIM1637_DISPLAY_CTRL |  ( (OnOff & 0x1) << 0x03 )  | ( Brightness & 0x07 );
 
-		// Update the current state to:
-		tim1637->State = TIM1637_STATE_BUSY_IN_DISPLAY_CTRL_CMD;
+	// Send the frame, first state:
+	tim1637_transmit(tim1637, TIM1637_STATE_BUSY_IN_DISPLAY_CTRL_CMD);
 
-		// Start Update Interrupt event to send messages.
-		HAL_TIM_Base_Start_IT( &(tim1637->Timer) );
-	}
+	return HAL_OK;
 }
 
 /**
@@ -515,99 +952,330 @@ static void tim1637_send_displayctrl( TIM1637_Handle_t* tim1637, TIM1637_Display
   * @note
   * @param	uint8_t DisplayValue represent the value to decode in 8 segments display
   * @param  TIM1637_DisplayAddress_e DisplayAddr specifies the display to write the value.
-  * @retval None
+  * @retval HAL_OK when the frame was sent (Blocking Mode) or started, HAL_BUSY if a frame is on the way.
   */
-static void tim1637_send_1byte( TIM1637_Handle_t* tim1637, uint8_t DisplayValue , TIM1637_DisplayAddress_e DisplayAddr ){
-
-	if( tim1637->State == TIM1637_STATE_READY ){
+static HAL_StatusTypeDef tim1637_send_1byte( TIM1637_Handle_t* tim1637, uint8_t DisplayValue , TIM1637_DisplayAddress_e DisplayAddr ){
 
-		tim1637->Method = TIM1637_METHOD_1BYTE_DATA;
-		tim1637->StartCondition = TIM1637_STARTCONDITION_ENABLED;
-		tim1637->StopCondition = TIM1637_STOPCONDITION_ENABLED;
+	if( tim1637_claim(tim1637, TIM1637_STATE_BUSY_IN_DATA_CMD) == 0 ){
+		return HAL_BUSY;
+	}
 
-		// Set first command to send: Write SRAM data in a fixed address mode
-		tim1637->Commands[TIM1637_CMDIDX_DATA] = TIM1637_DATA_CMD_FIX_ADDR;
+	tim1637->Method = TIM1637_METHOD_1BYTE_DATA;
+	tim1637->StartCondition = TIM1637_STARTCONDITION_ENABLED;
+	tim1637->StopCondition = TIM1637_STOPCONDITION_ENABLED;
 
-		// Set second command to send: The command is used to set the display register address
-		tim1637->Commands[TIM1637_CMDIDX_ADDR] = TIM1637_ADDR_CMD_SETTING | DisplayAddr;
+	// Set first command to send: Write SRAM data in a fixed address mode
+	tim1637->Commands[TIM1637_CMDIDX_DATA] = TIM1637_DATA_CMD_FIX_ADDR;
 
-		// Load the Value to send
-		tim1637->Data[0] = DisplayValue;
-		tim1637->Data_Idx = 0;
+	// Set second command to send: The command is used to set the display register address
+	tim1637->Commands[TIM1637_CMDIDX_ADDR] = TIM1637_ADDR_CMD_SETTING | DisplayAddr;
 
-		// Update the state to:
-		tim1637->State = TIM1637_STATE_BUSY_IN_DATA_CMD;
+	// Load the Value to send
+	tim1637->Data[0] = DisplayValue;
+	tim1637->TxData = tim1637->Data;
+	tim1637->Data_Idx = 0;
 
-		// Start Update Interrupt event to send messages.
-		HAL_TIM_Base_Start_IT( &(tim1637->Timer) );
-	}
+	// Send the frame, first state:
+	tim1637_transmit(tim1637, TIM1637_STATE_BUSY_IN_DATA_CMD);
 
+	return HAL_OK;
 }
 
 /**
   * @brief  Use to send 6 bytes consecutive in Automatic Add address mode.
   * @note
   * @param  uint8_t ArrayBytes[] contains the 6 bytes to decode the 8 segments for each display.
-  * @retval None
+  * @retval HAL_OK when the frame was sent (Blocking Mode) or started, HAL_BUSY if a frame is on the way.
   */
-static void tim1637_send_6bytes( TIM1637_Handle_t* tim1637, uint8_t ArrayBytes[] ){
+static HAL_StatusTypeDef tim1637_send_6bytes( TIM1637_Handle_t* tim1637, const uint8_t ArrayBytes[] ){
 
-	if( tim1637->State == TIM1637_STATE_READY ){
+	if( tim1637_claim(tim1637, TIM1637_STATE_BUSY_IN_DATA_CMD) == 0 ){
+		return HAL_BUSY;
+	}
 
-		tim1637->Method = TIM1637_METHOD_6BYTES_DATA;
-		tim1637->StartCondition = TIM1637_STARTCONDITION_ENABLED;
-		tim1637->StopCondition = TIM1637_STOPCONDITION_ENABLED;
-
-		// Set first command to send: Write SRAM data in a fixed address mode
-		tim1637->Commands[TIM1637_CMDIDX_DATA] = TIM1637_DATA_CMD_AUTO_ADDR;
-
-		// Set second command to send: The command is used to set the display register address
-		tim1637->Commands[TIM1637_CMDIDX_ADDR] = TIM1637_ADDR_CMD_SETTING;
-
-		// Load the Values to send
-		for( uint8_t digit = 0; digit < TIM1637_NUM_DIGITS; digit ++ ){
-
-			switch (digit) {
-				case 0x0:
-					tim1637->Data[ TIM1637_DISPLAYADDR_0 ] = ArrayBytes[digit];
-					break;
-				case 0x1:
-					tim1637->Data[ TIM1637_DISPLAYADDR_1 ] = ArrayBytes[digit];
-					break;
-				case 0x2:
-					tim1637->Data[ TIM1637_DISPLAYADDR_2 ] = ArrayBytes[digit];
-					break;
-				case 0x3:
-					tim1637->Data[ TIM1637_DISPLAYADDR_3 ] = ArrayBytes[digit];
-					break;
-				case 0x4:
-					tim1637->Data[ TIM1637_DISPLAYADDR_4 ] = ArrayBytes[digit];
-					break;
-				case 0x5:
-					tim1637->Data[ TIM1637_DISPLAYADDR_5 ] = ArrayBytes[digit];
-					break;
-				default:
-					break;
-			}
+	tim1637->Method = TIM1637_METHOD_6BYTES_DATA;
+	tim1637->StartCondition = TIM1637_STARTCONDITION_ENABLED;
+	tim1637->StopCondition = TIM1637_STOPCONDITION_ENABLED;
 
-		}
-		tim1637->Data_Idx = 0;
+	// Set first command to send: Write SRAM data in a fixed address mode
+	tim1637->Commands[TIM1637_CMDIDX_DATA] = TIM1637_DATA_CMD_AUTO_ADDR;
+
+	// Set second command to send: The command is used to set the display register address
+	tim1637->Commands[TIM1637_CMDIDX_ADDR] = TIM1637_ADDR_CMD_SETTING;
+
+	// Load the Values to send
+	tim1637_load_digits(tim1637->Data, ArrayBytes);
+	tim1637->TxData = tim1637->Data;
+	tim1637->Data_Idx = 0;
 
-		// Update the state to:
-		tim1637->State = TIM1637_STATE_BUSY_IN_DATA_CMD;
+	// Send the frame, first state:
+	tim1637_transmit(tim1637, TIM1637_STATE_BUSY_IN_DATA_CMD);
 
+	return HAL_OK;
+}
+
+
+/**
+  * @brief  Send the frame loaded in Commands[] and TxData[] according to the Mode of the handle.
+  * @note	The frame encoding is shared by Interrupt and Blocking Mode. In Blocking Mode the frame written
+  * 		with tim1637_WriteFrame during the transfer is sent after it, as the Timer IRQ does at the end of a frame.
+  * @param  FirstState State of the Interrupt Mode sequence to start the frame.
+  * @retval None
+  */
+static void tim1637_transmit( TIM1637_Handle_t* tim1637, TIM1637_State_e FirstState ){
+
+	tim1637->State = FirstState;
+
+	if( tim1637->Mode == TIM1637_MODE_BLOCKING ){
+		uint8_t Start;
+		do{
+			tim1637_blocking_frame(tim1637);
+			tim1637->State = TIM1637_STATE_READY;
+			tim1637_TxCpltCallback(tim1637);
+
+			// Flush the back framebuffer
+			uint32_t primask = __get_PRIMASK();
+			__disable_irq();
+			Start = tim1637_frame_claim(tim1637);
+			__set_PRIMASK(primask);
+		}while( Start );
+	}else{
 		// Start Update Interrupt event to send messages.
 		HAL_TIM_Base_Start_IT( &(tim1637->Timer) );
 	}
+}
+
+/**
+  * @brief  Map the digits (Digits[0] is the right digit) to the display address order of the frame.
+  * @note
+  * @param  Dest Bytes in the order sent after the address command.
+  * @retval None
+  */
+static void tim1637_load_digits( uint8_t Dest[TIM1637_NUM_DIGITS], const uint8_t Digits[TIM1637_NUM_DIGITS] ){
+
+	for( uint8_t digit = 0; digit < TIM1637_NUM_DIGITS; digit ++ ){
+
+		switch (digit) {
+			case 0x0:
+				Dest[ TIM1637_DISPLAYADDR_0 ] = Digits[digit];
+				break;
+			case 0x1:
+				Dest[ TIM1637_DISPLAYADDR_1 ] = Digits[digit];
+				break;
+			case 0x2:
+				Dest[ TIM1637_DISPLAYADDR_2 ] = Digits[digit];
+				break;
+			case 0x3:
+				Dest[ TIM1637_DISPLAYADDR_3 ] = Digits[digit];
+				break;
+			case 0x4:
+				Dest[ TIM1637_DISPLAYADDR_4 ] = Digits[digit];
+				break;
+			case 0x5:
+				Dest[ TIM1637_DISPLAYADDR_5 ] = Digits[digit];
+				break;
+			default:
+				break;
+		}
+
+	}
+}
+
+/**
+  * @brief  Swap the framebuffers and load the frame of the new front buffer if the device is READY.
+  * @note	Call with the IRQs disabled. The State leaves READY here, so no other context can start
+  * 		a frame until tim1637_transmit() is called.
+  * @retval 1 when the frame was loaded and must be sent with tim1637_transmit(), 0 otherwise.
+  */
+static uint8_t tim1637_frame_claim( TIM1637_Handle_t* tim1637 ){
+
+	if( tim1637->Swap_Pending == 0 || tim1637->State != TIM1637_STATE_READY ){
+		return 0;
+	}
+
+	tim1637->Front ^= 1U;
+	tim1637->Swap_Pending = 0;
 
+	tim1637->Method = TIM1637_METHOD_6BYTES_DATA;
+	tim1637->StartCondition = TIM1637_STARTCONDITION_ENABLED;
+	tim1637->StopCondition = TIM1637_STOPCONDITION_ENABLED;
+	tim1637->Commands[TIM1637_CMDIDX_DATA] = TIM1637_DATA_CMD_AUTO_ADDR;
+	tim1637->Commands[TIM1637_CMDIDX_ADDR] = TIM1637_ADDR_CMD_SETTING;
+
+	tim1637->TxData = tim1637->Frame[ tim1637->Front ];
+	tim1637->Data_Idx = 0;
+	tim1637->State = TIM1637_STATE_BUSY_IN_DATA_CMD;
+
+	return 1;
 }
 
+/**
+  * @brief  Claim the device for a frame if it is READY, with the IRQs disabled.
+  * @note	The check and the State change are atomic against tim1637_WriteFrame called from an IRQ.
+  * @param  FirstState State set when the device is claimed.
+  * @retval 1 when the device was claimed and the frame must be sent with tim1637_transmit(), 0 otherwise.
+  */
+static uint8_t tim1637_claim( TIM1637_Handle_t* tim1637, TIM1637_State_e FirstState ){
+
+	uint8_t Claimed = 0;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if( tim1637->State == TIM1637_STATE_READY ){
+		tim1637->State = FirstState;
+		Claimed = 1;
+	}
+
+	__set_PRIMASK(primask);
+
+	return Claimed;
+}
 
 
 /*	*********************************
  * 		Define Private Methods
  *  *********************************/
 
+/**
+  * @brief  Mark the modules whose part of the frame changed and refresh them.
+  * @note
+  * @param  None
+  * @retval None
+  */
+static void tim1637_wide_update( TIM1637_Wide_Handle_t* wide ){
+
+	for( uint8_t digit = 0; digit < (wide->NumModules * TIM1637_NUM_DIGITS); digit ++ ){
+		if( wide->Frame[digit] != wide->Sent[digit] ){
+			wide->Dirty |= ( 1UL << ( digit / TIM1637_NUM_DIGITS ) );
+		}
+	}
+
+	tim1637_Wide_Refresh(wide);
+}
+
+/**
+  * @brief  Compute the half SCLK period for Blocking Mode.
+  * @note	Use the DWT cycle counter, if it does not run (some STM32F103 devices) a busy loop calibrated with SysTick is used.
+  * @param  None
+  * @retval None
+  */
+static void tim1637_blocking_timing_init(void){
+
+	HalfPeriod_Cycles = SystemCoreClock / ( 2 * TIM1637_BLOCKING_SCLK_FREQ );
+
+	// Enable the DWT cycle counter
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	#if (__CORTEX_M == 7U)
+		DWT->LAR = 0xC5ACCE55;
+	#endif
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	uint32_t start = DWT->CYCCNT;
+	for( volatile uint32_t loop = 0; loop < 16; loop ++ );
+	DWT_Available = ( DWT->CYCCNT != start );
+
+	if( DWT_Available == 0 ){
+
+		uint32_t CyclesPerLoop = 4;		// Estimation if SysTick is not running
+
+		if( ( SysTick->CTRL & SysTick_CTRL_ENABLE_Msk ) != 0 ){
+			uint32_t begin = SysTick->VAL;
+			for( volatile uint32_t loop = TIM1637_CALIBRATION_LOOPS; loop > 0; loop -- );
+			uint32_t end = SysTick->VAL;
+
+			// SysTick counts down, it could reload once during the calibration
+			uint32_t elapsed = ( begin >= end ) ? ( begin - end ) : ( begin + SysTick->LOAD + 1 - end );
+			if( ( SysTick->CTRL & SysTick_CTRL_CLKSOURCE_Msk ) == 0 ){
+				elapsed *= 8;	// SysTick clock is HCLK / 8
+			}
+
+			CyclesPerLoop = elapsed / TIM1637_CALIBRATION_LOOPS;
+			if( CyclesPerLoop == 0 )	CyclesPerLoop = 1;
+		}
+
+		HalfPeriod_Loops = ( HalfPeriod_Cycles / CyclesPerLoop ) + 1;
+	}
+}
+
+/**
+  * @brief  Wait for a half SCLK period in Blocking Mode.
+  * @note
+  * @param  None
+  * @retval None
+  */
+static void tim1637_blocking_delay(void){
+
+	if( DWT_Available ){
+		uint32_t start = DWT->CYCCNT;
+		while( ( DWT->CYCCNT - start ) < HalfPeriod_Cycles );
+	}else{
+		for( volatile uint32_t loop = HalfPeriod_Loops; loop > 0; loop -- );
+	}
+}
+
+/**
+  * @brief  Send 1 byte (LSB first) and the ACK clock in Blocking Mode, same sequence as tim1637_Callback.
+  * @note
+  * @param  Byte value to send
+  * @retval None
+  */
+static void tim1637_blocking_byte(TIM1637_Handle_t* tim1637, uint8_t Byte){
+
+	for( uint8_t bit = 0; bit < 8; bit ++ ){
+		// Change the SDIO state when SCLK is LOW.
+		HAL_GPIO_WritePin(tim1637->SCLK_gpio, tim1637->SCLK_pin, GPIO_PIN_RESET);
+		HAL_GPIO_WritePin(tim1637->SDIO_gpio, tim1637->SDIO_pin, ( Byte >> bit ) & 0x1 );
+		tim1637_blocking_delay();
+		HAL_GPIO_WritePin(tim1637->SCLK_gpio, tim1637->SCLK_pin, GPIO_PIN_SET);
+		tim1637_blocking_delay();
+	}
+
+	// ACK clock
+	HAL_GPIO_WritePin(tim1637->SCLK_gpio, tim1637->SCLK_pin, GPIO_PIN_RESET);
+	HAL_GPIO_WritePin(tim1637->SDIO_gpio, tim1637->SDIO_pin, GPIO_PIN_RESET);
+	tim1637_blocking_delay();
+	HAL_GPIO_WritePin(tim1637->SCLK_gpio, tim1637->SCLK_pin, GPIO_PIN_SET);
+	tim1637_blocking_delay();
+	HAL_GPIO_WritePin(tim1637->SCLK_gpio, tim1637->SCLK_pin, GPIO_PIN_RESET);
+	tim1637_blocking_delay();
+}
+
+/**
+  * @brief  Send the frame loaded in Commands[] and TxData[] in Blocking Mode.
+  * @note	The sequence follows the Method, as tim1637_Callback does.
+  * @param  TIM1637_Handle_t* tim1637
+  * @retval None
+  */
+static void tim1637_blocking_frame(TIM1637_Handle_t* tim1637){
+
+	tim1637_start_condition(tim1637);
+	tim1637_blocking_delay();
+
+	if( tim1637->Method == TIM1637_METHOD_DISPLAY_CTRL ){
+
+		tim1637_blocking_byte(tim1637, tim1637->Commands[ TIM1637_CMDIDX_DISPLAY_CTR ]);
+
+	}else{
+
+		tim1637_blocking_byte(tim1637, tim1637->Commands[ TIM1637_CMDIDX_DATA ]);
+		tim1637_stop_condition(tim1637);
+		tim1637_blocking_delay();
+
+		tim1637_start_condition(tim1637);
+		tim1637_blocking_delay();
+		tim1637_blocking_byte(tim1637, tim1637->Commands[ TIM1637_CMDIDX_ADDR ]);
+
+		uint8_t NumBytes = ( tim1637->Method == TIM1637_METHOD_6BYTES_DATA ) ? TIM1637_NUM_DIGITS : 1;
+		for( tim1637->Data_Idx = 0; tim1637->Data_Idx < NumBytes; tim1637->Data_Idx ++ ){
+			tim1637_blocking_byte(tim1637, tim1637->TxData[ tim1637->Data_Idx ]);
+		}
+	}
+
+	tim1637_stop_condition(tim1637);
+	tim1637_blocking_delay();
+}
+
 /**
   * @brief  Generate the Start Condition for communication protocol with TIM1637
   * @note
@@ -682,13 +1350,13 @@ static void tim1637_msp_gpio(TIM1637_Handle_t* tim1637){
 
 /**
   * @brief  Enable the selected Timer, Enable the IRQ and set the IRQ priority as lowest.
-  * @note	None
-  * @param  None
+  * @note	The clock enable bit and the IRQ are taken from the timer descriptor.
+  * @param  Desc Descriptor of the timer selected in tim1637->Timer.Instance
   * @retval None
   */
-static void tim1637_msp_tim(TIM1637_Handle_t* tim1637){
+static void tim1637_msp_tim(const TIM1637_TimerDesc_t* Desc){
 
-	uint8_t PreemptPriority, SubPriority;
+	uint8_t PreemptPriority = 0, SubPriority = 0;
 	uint32_t PriorityGrouping = HAL_NVIC_GetPriorityGrouping();
 	if(PriorityGrouping == NVIC_PRIORITYGROUP_4){
 		PreemptPriority = 15;
@@ -707,168 +1375,11 @@ static void tim1637_msp_tim(TIM1637_Handle_t* tim1637){
 		SubPriority = 15;
 	}
 
-	#ifdef STM32F446xx
-		if( tim1637->Timer.Instance == TIM1){
-			__HAL_RCC_TIM1_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM1_UP_TIM10_IRQn);
-			HAL_NVIC_SetPriority(TIM1_UP_TIM10_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM2){
-			__HAL_RCC_TIM2_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM2_IRQn);
-			HAL_NVIC_SetPriority(TIM2_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM3){
-			__HAL_RCC_TIM3_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM3_IRQn);
-			HAL_NVIC_SetPriority(TIM3_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM4){
-			__HAL_RCC_TIM4_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM4_IRQn);
-			HAL_NVIC_SetPriority(TIM4_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM5){
-			__HAL_RCC_TIM5_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM5_IRQn);
-			HAL_NVIC_SetPriority(TIM5_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM6){
-			__HAL_RCC_TIM6_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM6_DAC_IRQn);
-			HAL_NVIC_SetPriority(TIM6_DAC_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM7){
-			__HAL_RCC_TIM7_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM7_IRQn);
-			HAL_NVIC_SetPriority(TIM7_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM8){
-			__HAL_RCC_TIM8_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM8_UP_TIM13_IRQn);
-			HAL_NVIC_SetPriority(TIM8_UP_TIM13_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM9){
-			__HAL_RCC_TIM9_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM1_BRK_TIM9_IRQn);
-			HAL_NVIC_SetPriority(TIM1_BRK_TIM9_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM10){
-			__HAL_RCC_TIM10_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM1_UP_TIM10_IRQn);
-			HAL_NVIC_SetPriority(TIM1_UP_TIM10_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM11){
-			__HAL_RCC_TIM11_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM1_TRG_COM_TIM11_IRQn);
-			HAL_NVIC_SetPriority(TIM1_TRG_COM_TIM11_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM12){
-			__HAL_RCC_TIM12_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM8_BRK_TIM12_IRQn);
-			HAL_NVIC_SetPriority(TIM8_BRK_TIM12_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM13){
-			__HAL_RCC_TIM13_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM8_UP_TIM13_IRQn);
-			HAL_NVIC_SetPriority(TIM8_UP_TIM13_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM14){
-			__HAL_RCC_TIM14_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM8_TRG_COM_TIM14_IRQn);
-			HAL_NVIC_SetPriority(TIM8_TRG_COM_TIM14_IRQn, PreemptPriority, SubPriority);
-		}
-	#elif defined(STM32F103x6)
-		if( tim1637->Timer.Instance == TIM1){
-			__HAL_RCC_TIM1_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM1_UP_IRQn);
-			HAL_NVIC_SetPriority(TIM1_UP_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM2){
-			__HAL_RCC_TIM2_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM2_IRQn);
-			HAL_NVIC_SetPriority(TIM2_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM3){
-			__HAL_RCC_TIM3_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM3_IRQn);
-			HAL_NVIC_SetPriority(TIM3_IRQn, PreemptPriority, SubPriority);
-		}
-	#elif defined(STM32H723xx)
-		if( tim1637->Timer.Instance == TIM1){
-			__HAL_RCC_TIM1_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM1_UP_IRQn);
-			HAL_NVIC_SetPriority(TIM1_UP_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM2){
-			__HAL_RCC_TIM2_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM2_IRQn);
-			HAL_NVIC_SetPriority(TIM2_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM3){
-			__HAL_RCC_TIM3_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM3_IRQn);
-			HAL_NVIC_SetPriority(TIM3_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM4){
-			__HAL_RCC_TIM4_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM4_IRQn);
-			HAL_NVIC_SetPriority(TIM4_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM5){
-			__HAL_RCC_TIM5_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM5_IRQn);
-			HAL_NVIC_SetPriority(TIM5_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM6){
-			__HAL_RCC_TIM6_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM6_DAC_IRQn);
-			HAL_NVIC_SetPriority(TIM6_DAC_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM7){
-			__HAL_RCC_TIM7_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM7_IRQn);
-			HAL_NVIC_SetPriority(TIM7_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM8){
-			__HAL_RCC_TIM8_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM8_UP_TIM13_IRQn);
-			HAL_NVIC_SetPriority(TIM8_UP_TIM13_IRQn, PreemptPriority, SubPriority);
-		}else if( tim1637->Timer.Instance == TIM12){
-			__HAL_RCC_TIM12_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM8_BRK_TIM12_IRQn);
-			HAL_NVIC_SetPriority(TIM8_BRK_TIM12_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM13){
-			__HAL_RCC_TIM13_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM8_UP_TIM13_IRQn);
-			HAL_NVIC_SetPriority(TIM8_UP_TIM13_IRQn, PreemptPriority, SubPriority);
-		}
-		else if( tim1637->Timer.Instance == TIM14){
-			__HAL_RCC_TIM14_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM8_TRG_COM_TIM14_IRQn);
-			HAL_NVIC_SetPriority(TIM8_TRG_COM_TIM14_IRQn, PreemptPriority, SubPriority);
-		}else if( tim1637->Timer.Instance == TIM15){
-			__HAL_RCC_TIM12_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM15_IRQn);
-			HAL_NVIC_SetPriority(TIM15_IRQn, PreemptPriority, SubPriority);
-		}else if( tim1637->Timer.Instance == TIM16){
-			__HAL_RCC_TIM13_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM16_IRQn);
-			HAL_NVIC_SetPriority(TIM16_IRQn, PreemptPriority, SubPriority);
-		}else if( tim1637->Timer.Instance == TIM17){
-			__HAL_RCC_TIM14_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM17_IRQn);
-			HAL_NVIC_SetPriority(TIM17_IRQn, PreemptPriority, SubPriority);
-		}else if( tim1637->Timer.Instance == TIM23){
-			__HAL_RCC_TIM13_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM23_IRQn);
-			HAL_NVIC_SetPriority(TIM23_IRQn, PreemptPriority, SubPriority);
-		}else if( tim1637->Timer.Instance == TIM24){
-			__HAL_RCC_TIM14_CLK_ENABLE();
-			HAL_NVIC_EnableIRQ(TIM24_IRQn);
-			HAL_NVIC_SetPriority(TIM24_IRQn, PreemptPriority, SubPriority);
-		}
-	#endif
+	// Enable the Timer clock, read back to delay the access to the timer after the clock is enabled.
+	SET_BIT( *(Desc->RCC_ENR), Desc->RCC_EN_Msk );
+	(void) READ_BIT( *(Desc->RCC_ENR), Desc->RCC_EN_Msk );
+
+	HAL_NVIC_SetPriority(Desc->IRQn, PreemptPriority, SubPriority);
+	HAL_NVIC_EnableIRQ(Desc->IRQn);
 
 }
@@ -0,0 +1,77 @@
+/*
+ * tm1637_rtos.h
+ *
+ *  FreeRTOS layer for TM1637. The calling task is suspended until its frame is sent,
+ *  the end of the frame (Timer IRQ) wakes it with a task notification.
+ *
+ *  Define TIM1637_USE_FREERTOS in the project symbols to compile this layer.
+ */
+
+#ifndef INC_TM1637_RTOS_H_
+#define INC_TM1637_RTOS_H_
+
+#ifdef TIM1637_USE_FREERTOS
+
+#include <tm1637.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef TIM1637_RTOS_QUEUE_LEN
+#define TIM1637_RTOS_QUEUE_LEN		8				//	Requests waiting per device.
+#endif
+
+#ifndef TIM1637_RTOS_MAX_DEVICES
+#define TIM1637_RTOS_MAX_DEVICES	4				//	Devices registered in the layer.
+#endif
+
+#ifndef TIM1637_RTOS_NOTIFY_INDEX
+#define TIM1637_RTOS_NOTIFY_INDEX	1				//	Task notification index of the layer, index 0 is left to the application.
+#endif
+
+#if ( TIM1637_RTOS_NOTIFY_INDEX >= configTASK_NOTIFICATION_ARRAY_ENTRIES )
+#error "configTASK_NOTIFICATION_ARRAY_ENTRIES must be greater than TIM1637_RTOS_NOTIFY_INDEX (FreeRTOS V10.4 or later)"
+#endif
+
+typedef enum{
+	TIM1637_RTOS_REQ_DIGITS,						//	Send the 6 digits.
+	TIM1637_RTOS_REQ_VALUE,							//	Send 1 digit.
+	TIM1637_RTOS_REQ_DISPLAY_CTRL,					//	Send On/Off and brightness.
+}TIM1637_RTOS_ReqType_e;
+
+typedef struct tim1637_rtos_request{
+	TIM1637_RTOS_ReqType_e		Type;				/*!< Frame to send @ref TIM1637_RTOS_ReqType_e */
+	uint8_t						Priority;			/*!< Higher value is served first, same priority is served in order of arrival */
+	TaskHandle_t				Task;				/*!< Task to notify at the end of the frame, NULL if nobody waits */
+	uint8_t						Data[TIM1637_NUM_DIGITS];	/*!< Digits (REQ_DIGITS), address and value (REQ_VALUE), On/Off and brightness (REQ_DISPLAY_CTRL) */
+}TIM1637_RTOS_Request_t;
+
+/*	**************************************
+ * 		Handle structure for TIM1637 RTOS
+ *  **************************************/
+typedef struct tim1637_rtos_handle{
+	TIM1637_Handle_t *			Device;				/*!< Handle of the TM1637, initialized by tim1637_Init */
+
+	TIM1637_RTOS_Request_t		Queue[TIM1637_RTOS_QUEUE_LEN];	/*!< Requests sorted by priority */
+
+	uint8_t						Count;				/*!< Number of requests in Queue[] */
+
+	TIM1637_RTOS_Request_t		Active;				/*!< Request whose frame is in progress */
+
+	uint8_t						Busy;				/*!< 1 while the frame of Active is in progress */
+}TIM1637_RTOS_Handle_t;
+
+
+/*	*************************************
+ * 					METHODS
+ *  ************************************/
+HAL_StatusTypeDef tim1637_rtos_Init( TIM1637_RTOS_Handle_t* rtos, TIM1637_Handle_t* tim1637 );
+
+HAL_StatusTypeDef tim1637_rtos_SetDigits( TIM1637_RTOS_Handle_t* rtos, const uint8_t Digits[TIM1637_NUM_DIGITS], uint8_t Priority, TickType_t Timeout );
+HAL_StatusTypeDef tim1637_rtos_SetValue( TIM1637_RTOS_Handle_t* rtos, uint8_t DisplayAddr, uint8_t Value, uint8_t Priority, TickType_t Timeout );
+HAL_StatusTypeDef tim1637_rtos_SetIntNumber( TIM1637_RTOS_Handle_t* rtos, uint32_t Number, uint8_t Priority, TickType_t Timeout );
+HAL_StatusTypeDef tim1637_rtos_SetFloatNumber( TIM1637_RTOS_Handle_t* rtos, double Number, uint8_t NumDecimals, uint8_t Priority, TickType_t Timeout );
+HAL_StatusTypeDef tim1637_rtos_DisplayCtrl( TIM1637_RTOS_Handle_t* rtos, TIM1637_DisplayCtrl_e OnOff, TIM1637_PulseWidth_e Brightness, uint8_t Priority, TickType_t Timeout );
+
+#endif /* TIM1637_USE_FREERTOS */
+
+#endif /* INC_TM1637_RTOS_H_ */
@@ -30,8 +30,21 @@
 #define	TIM1637_ADDR_CMD_SETTING	0b11000000		//	Command: Display and control command setting
 
 #define TIM1637_ADD_DOT				0b10000000		// 	Add the 8-bit to represent the dot in the display.
+#define TIM1637_MINUS				0b01000000		// 	Segment G alone, the sign of a negative number.
 #define TIM1637_NUM_DIGITS			6				// 	Specifies the number of digits to control.
 
+#ifndef TIM1637_WIDE_MAX_MODULES
+#define TIM1637_WIDE_MAX_MODULES	4				// 	Maximum number of modules joined in a wide display.
+#endif
+#if TIM1637_WIDE_MAX_MODULES > 32
+#error "TIM1637_WIDE_MAX_MODULES: the Dirty mask of the wide display holds 32 modules"
+#endif
+#define TIM1637_WIDE_MAX_DIGITS		( TIM1637_WIDE_MAX_MODULES * TIM1637_NUM_DIGITS )
+
+#ifndef TIM1637_BLOCKING_SCLK_FREQ
+#define TIM1637_BLOCKING_SCLK_FREQ	250000UL		// 	SCLK frequency (Hz) used in Blocking Mode, maximum clock of the TM1637.
+#endif
+
 typedef enum{
 	PulseWidth_1_16	= 0,
 	PulseWidth_2_16,
@@ -66,6 +79,11 @@ typedef enum{
 	TIM1637_DISPLAYADDR_5 = 0x2,
 }TIM1637_DisplayAddress_e;
 
+typedef enum{
+	TIM1637_MODE_IT = 0,							//	Frames are sent by the Update Interrupt of the Timer.
+	TIM1637_MODE_BLOCKING,							//	Frames are sent by the CPU, edges timed with DWT cycle counter. No IRQ/Timer needed.
+}TIM1637_Mode_e;
+
 typedef enum{
 	TIM1637_DISPLAY_OFF,
 	TIM1637_DISPLAY_ON,
@@ -88,6 +106,41 @@ typedef enum{
 }TIM1637_StopCondition_e;
 
 
+typedef enum{
+	TIM1637_TIMBUS_APB1 = 0,
+	TIM1637_TIMBUS_APB2,
+}TIM1637_TimerBus_e;
+
+#define TIM1637_DMA_REQUEST_NONE	0xFFFFFFFFU		// 	The timer has no DMA request line for the UPDATE event.
+
+#ifdef STM32F103x6
+	typedef DMA_Channel_TypeDef		TIM1637_DMA_TypeDef;
+#else
+	typedef DMA_Stream_TypeDef		TIM1637_DMA_TypeDef;
+#endif
+
+/*	**************************************
+ * 		Timer descriptor for TIM1637
+ *  **************************************/
+typedef struct tim1637_timer_desc{
+	TIM_TypeDef *				Instance;			/*!< Base address of the timer */
+
+	__IO uint32_t *				RCC_ENR;			/*!< RCC register that holds the clock enable bit of the timer */
+
+	uint32_t					RCC_EN_Msk;			/*!< Clock enable bit of the timer inside RCC_ENR */
+
+	TIM1637_DMA_TypeDef *		DMA_Stream;			/*!< DMA Stream (F4) or Channel (F1) wired to TIMx_UP, NULL when routed by DMAMUX (H7) or not available */
+
+	uint32_t					DMA_Request;		/*!< DMA Channel (F4) or DMAMUX request (H7) for TIMx_UP, TIM1637_DMA_REQUEST_NONE if not available */
+
+	IRQn_Type					IRQn;				/*!< IRQ that serves the UPDATE interrupt event of the timer */
+
+	TIM1637_TimerBus_e			Bus;				/*!< APB bus that clocks the timer @ref TIM1637_TimerBus_e */
+
+	uint8_t						Basic;				/*!< 1 when the timer is a Basic Timer (TIM6, TIM7) */
+}TIM1637_TimerDesc_t;
+
+
 /*	**************************************
  * 		Handle structure for TIM1637
  *  **************************************/
@@ -109,25 +162,54 @@ typedef struct tim1637_handle{
 	TIM1637_DisplayCtrl_e		DispCtrl;			/*!< Use to set the Initial state of the display ON/OFF @ref TIM1637_DisplayCtrl_e */
 	TIM1637_PulseWidth_e		Brightness;			/*!< Use to save the Brightness value of the display @ref TIM1637_PulseWidth_e */
 
+	TIM1637_Mode_e				Mode;				/*!< Specifies how the frames are sent @ref TIM1637_Mode_e */
+
 	TIM1637_State_e				State;				/*!< Use for flow control in Data sending */
 	TIM1637_Methods_e			Method;				/*!< Use for flow control in Data sending */
 	TIM1637_StartCondition_e	StartCondition;	/*!< Set/Reset the start condition in data transfer */
 	TIM1637_StopCondition_e		StopCondition;		/*!< Set/Reset the stop condition in data transfer  */
 	uint8_t						Commands[3];		/*!< Use to save Commands to send base on the required sequence */
 	uint8_t						Data[6];			/*!< Use to save the value of each display-digit */
+	uint8_t *					TxData;				/*!< Bytes read by the transfer in progress, Data[] or the front framebuffer */
+	uint8_t						Frame[2][TIM1637_NUM_DIGITS];	/*!< Front/back framebuffers in display address order, see tim1637_WriteFrame() */
+	__IO uint8_t				Front;				/*!< Index of the framebuffer read by the transfer, the other one is the back buffer */
+	__IO uint8_t				Swap_Pending;		/*!< 1 when the back buffer holds a frame not sent yet */
 	uint8_t						Data_Idx;			/*!< Index to set the byte to send */
+	uint8_t						Bit_Count;			/*!< Count the Update events (SCLK edges) of the byte in progress */
 }TIM1637_Handle_t;
 
 
+/*	**************************************
+ * 	Wide display, several TM1637 modules
+ *  **************************************/
+typedef struct tim1637_wide_handle{
+	TIM1637_Handle_t *			Modules[TIM1637_WIDE_MAX_MODULES];	/*!< Handles of the modules, Modules[0] shows the least significant digits (right side) */
+
+	uint8_t						NumModules;							/*!< Number of modules in use */
+
+	uint8_t						Frame[TIM1637_WIDE_MAX_DIGITS];		/*!< Segments of each digit of the wide display, Frame[0] is the right digit */
+
+	uint8_t						Sent[TIM1637_WIDE_MAX_DIGITS];		/*!< Segments last sent to the modules */
+
+	uint32_t					Dirty;								/*!< One bit per module, set when its part of Frame[] is not sent yet */
+}TIM1637_Wide_Handle_t;
+
+
 /*	*************************************
  * 					METHODS
  *  ************************************/
-void tim1637_Init(TIM1637_Handle_t* tim1637);
+HAL_StatusTypeDef tim1637_Init(TIM1637_Handle_t* tim1637);
+void tim1637_InitBlocking(TIM1637_Handle_t* tim1637);
+void tim1637_SetMode(TIM1637_Handle_t* tim1637, TIM1637_Mode_e Mode);
 
 void tim1637_ClearAll( TIM1637_Handle_t* tim1637 );
-void tim1637_SetValue( TIM1637_Handle_t* tim1637, uint8_t DisplayAddr, uint8_t Value );
+HAL_StatusTypeDef tim1637_SetValue( TIM1637_Handle_t* tim1637, uint8_t DisplayAddr, uint8_t Value );
 void tim1637_SetIntNumber( TIM1637_Handle_t* tim1637, uint32_t Number );
 void tim1637_SetFloatNumber( TIM1637_Handle_t* tim1637, double Number, uint8_t NumDecimals );
+HAL_StatusTypeDef tim1637_SetDigits( TIM1637_Handle_t* tim1637, const uint8_t Digits[TIM1637_NUM_DIGITS] );
+void tim1637_WriteFrame( TIM1637_Handle_t* tim1637, const uint8_t Digits[TIM1637_NUM_DIGITS] );
+void tim1637_FormatIntNumber( uint8_t DisplayAddr[TIM1637_NUM_DIGITS], uint32_t Number );
+void tim1637_FormatFloatNumber( uint8_t DisplayAddr[TIM1637_NUM_DIGITS], double Number, uint8_t NumDecimals );
 void tim1637_Demo(TIM1637_Handle_t* tim1637 );
 
 /*
@@ -136,10 +218,27 @@ void tim1637_Demo(TIM1637_Handle_t* tim1637 );
 void tim1637_TurnOn( TIM1637_Handle_t* tim1637 );
 void tim1637_TurnOff( TIM1637_Handle_t* tim1637 );
 void tim1637_SetBrightness( TIM1637_Handle_t* tim1637, TIM1637_PulseWidth_e Brightness );
+HAL_StatusTypeDef tim1637_SetDisplayCtrl( TIM1637_Handle_t* tim1637, TIM1637_DisplayCtrl_e OnOff, TIM1637_PulseWidth_e Brightness );
+
+/*
+ *		Wide display Methods
+ */
+void tim1637_Wide_Init( TIM1637_Wide_Handle_t* wide, TIM1637_Handle_t* Modules[], uint8_t NumModules );
+void tim1637_Wide_SetDigits( TIM1637_Wide_Handle_t* wide, const uint8_t Digits[], uint8_t NumDigits );
+void tim1637_Wide_SetIntNumber( TIM1637_Wide_Handle_t* wide, uint64_t Number );
+void tim1637_Wide_SetFloatNumber( TIM1637_Wide_Handle_t* wide, double Number, uint8_t NumDecimals );
+uint8_t tim1637_Wide_Refresh( TIM1637_Wide_Handle_t* wide );
+
+/*
+ *		Timer descriptors
+ */
+const TIM1637_TimerDesc_t* tim1637_GetTimerDesc( TIM_TypeDef* Instance );
+TIM_TypeDef* tim1637_GetFreeTimer( void );
 
 /*
  *	Use in the Timer IRQ
  */
 void tim1637_Callback(TIM1637_Handle_t* tim1637);
+void tim1637_TxCpltCallback(TIM1637_Handle_t* tim1637);
 
 #endif /* INC_TM1637_H_ */
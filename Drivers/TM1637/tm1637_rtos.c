@@ -0,0 +1,400 @@
+/*
+ * tm1637_rtos.c
+ *
+ *  FreeRTOS layer for TM1637. The requests of the tasks are kept in a queue sorted by priority,
+ *  the frame of the first request is started when the device is free and the task waits for a
+ *  notification, sent from the Timer IRQ at the end of the frame. No CPU time is used while waiting.
+ *  The notification index TIM1637_RTOS_NOTIFY_INDEX is used, the tasks keep index 0 for their own notifications.
+ *  In Blocking Mode the frame is sent by the task that finds the device free, the requests queued
+ *  meanwhile are sent after it by the same task.
+ *  The request is taken from the queue inside a critical section, its frame is started (or sent, in
+ *  Blocking Mode) after leaving it, the interrupts are not held off while the frame goes out.
+ *
+ *  Note: The Timer IRQ priority (set as lowest by tim1637_Init) must be lower than (numerically greater)
+ *  configMAX_SYSCALL_INTERRUPT_PRIORITY. The device must be used only through this layer once registered.
+ */
+
+#include <tm1637_rtos.h>
+
+#ifdef TIM1637_USE_FREERTOS
+
+/*	*********************************
+ * 		Declare Private variables
+ *  *********************************/
+static TIM1637_RTOS_Handle_t* Devices[TIM1637_RTOS_MAX_DEVICES] = {0};
+
+
+/*	*********************************
+ * 		Declare Private Methods
+ *  *********************************/
+static HAL_StatusTypeDef tim1637_rtos_request( TIM1637_RTOS_Handle_t* rtos, TIM1637_RTOS_Request_t* request, TickType_t Timeout );
+static void tim1637_rtos_push( TIM1637_RTOS_Handle_t* rtos, const TIM1637_RTOS_Request_t* request );
+static void tim1637_rtos_cancel( TIM1637_RTOS_Handle_t* rtos, TaskHandle_t Task );
+static uint8_t tim1637_rtos_take( TIM1637_RTOS_Handle_t* rtos );
+static HAL_StatusTypeDef tim1637_rtos_send( TIM1637_RTOS_Handle_t* rtos );
+static void tim1637_rtos_start_next( TIM1637_RTOS_Handle_t* rtos, BaseType_t* HigherPriorityTaskWoken );
+static void tim1637_rtos_complete( TIM1637_RTOS_Handle_t* rtos, HAL_StatusTypeDef status, BaseType_t* HigherPriorityTaskWoken );
+
+
+/**
+  * @brief  Register the device in the RTOS layer.
+  * @note	Call after tim1637_Init(), before the tasks use the device.
+  * @param  tim1637 Handle of the TM1637 already initialized.
+  * @retval HAL_OK, HAL_ERROR if there are TIM1637_RTOS_MAX_DEVICES registered.
+  */
+HAL_StatusTypeDef tim1637_rtos_Init( TIM1637_RTOS_Handle_t* rtos, TIM1637_Handle_t* tim1637 ){
+
+	HAL_StatusTypeDef status = HAL_ERROR;
+
+	rtos->Device = tim1637;
+	rtos->Count = 0;
+	rtos->Busy = 0;
+
+	taskENTER_CRITICAL();
+	for( uint8_t idx = 0; idx < TIM1637_RTOS_MAX_DEVICES; idx ++ ){
+		if( Devices[idx] == NULL || Devices[idx] == rtos ){
+			Devices[idx] = rtos;
+			status = HAL_OK;
+			break;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return status;
+}
+
+/**
+  * @brief  Send the segments of the 6 digits, the calling task waits until the frame is sent.
+  * @param	Digits contains the 8 segments of each digit, Digits[0] is the right digit.
+  * @param	Priority Higher value is served first.
+  * @param	Timeout Maximum ticks to wait.
+  * @retval HAL_OK, HAL_BUSY if the queue is full, HAL_TIMEOUT.
+  */
+HAL_StatusTypeDef tim1637_rtos_SetDigits( TIM1637_RTOS_Handle_t* rtos, const uint8_t Digits[TIM1637_NUM_DIGITS], uint8_t Priority, TickType_t Timeout ){
+
+	TIM1637_RTOS_Request_t request = {0};
+
+	request.Type = TIM1637_RTOS_REQ_DIGITS;
+	request.Priority = Priority;
+	for( uint8_t digit = 0; digit < TIM1637_NUM_DIGITS; digit ++ ){
+		request.Data[digit] = Digits[digit];
+	}
+
+	return tim1637_rtos_request(rtos, &request, Timeout);
+}
+
+/**
+  * @brief  Send the value of 1 digit, the calling task waits until the frame is sent.
+  * @param 	DisplayAddr specifies the display to set the value.
+  * @param  Value represents the state of the 8 segments in the display.
+  * @retval HAL_OK, HAL_BUSY if the queue is full, HAL_TIMEOUT, HAL_ERROR if DisplayAddr is not 0 to 5.
+  */
+HAL_StatusTypeDef tim1637_rtos_SetValue( TIM1637_RTOS_Handle_t* rtos, uint8_t DisplayAddr, uint8_t Value, uint8_t Priority, TickType_t Timeout ){
+
+	TIM1637_RTOS_Request_t request = {0};
+
+	request.Type = TIM1637_RTOS_REQ_VALUE;
+	request.Priority = Priority;
+	request.Data[0] = DisplayAddr;
+	request.Data[1] = Value;
+
+	return tim1637_rtos_request(rtos, &request, Timeout);
+}
+
+/**
+  * @brief  Represent an Integer Number in the displays, the calling task waits until the frame is sent.
+  * @retval HAL_OK, HAL_BUSY if the queue is full, HAL_TIMEOUT.
+  */
+HAL_StatusTypeDef tim1637_rtos_SetIntNumber( TIM1637_RTOS_Handle_t* rtos, uint32_t Number, uint8_t Priority, TickType_t Timeout ){
+
+	uint8_t Digits[TIM1637_NUM_DIGITS];
+
+	tim1637_FormatIntNumber(Digits, Number);
+	return tim1637_rtos_SetDigits(rtos, Digits, Priority, Timeout);
+}
+
+/**
+  * @brief  Represent a double or float value in the displays, the calling task waits until the frame is sent.
+  * @retval HAL_OK, HAL_BUSY if the queue is full, HAL_TIMEOUT.
+  */
+HAL_StatusTypeDef tim1637_rtos_SetFloatNumber( TIM1637_RTOS_Handle_t* rtos, double Number, uint8_t NumDecimals, uint8_t Priority, TickType_t Timeout ){
+
+	uint8_t Digits[TIM1637_NUM_DIGITS];
+
+	tim1637_FormatFloatNumber(Digits, Number, NumDecimals);
+	return tim1637_rtos_SetDigits(rtos, Digits, Priority, Timeout);
+}
+
+/**
+  * @brief  Turn On/Off the displays and set the brightness, the calling task waits until the frame is sent.
+  * @retval HAL_OK, HAL_BUSY if the queue is full, HAL_TIMEOUT.
+  */
+HAL_StatusTypeDef tim1637_rtos_DisplayCtrl( TIM1637_RTOS_Handle_t* rtos, TIM1637_DisplayCtrl_e OnOff, TIM1637_PulseWidth_e Brightness, uint8_t Priority, TickType_t Timeout ){
+
+	TIM1637_RTOS_Request_t request = {0};
+
+	request.Type = TIM1637_RTOS_REQ_DISPLAY_CTRL;
+	request.Priority = Priority;
+	request.Data[0] = OnOff;
+	request.Data[1] = Brightness;
+
+	return tim1637_rtos_request(rtos, &request, Timeout);
+}
+
+/**
+  * @brief  End of frame, notify the waiting task and start the next request.
+  * @note	Called from tim1637_Callback (Timer IRQ), overrides the weak function of tm1637.c. In Blocking Mode
+  * 		it is called at the end of tim1637_rtos_send, in the context of the task that sent the frame.
+  * @param  TIM1637_Handle_t* tim1637
+  * @retval None
+  */
+void tim1637_TxCpltCallback(TIM1637_Handle_t* tim1637){
+
+	BaseType_t HigherPriorityTaskWoken = pdFALSE;
+	TIM1637_RTOS_Handle_t* rtos = NULL;
+
+	for( uint8_t idx = 0; idx < TIM1637_RTOS_MAX_DEVICES; idx ++ ){
+		if( Devices[idx] != NULL && Devices[idx]->Device == tim1637 ){
+			rtos = Devices[idx];
+			break;
+		}
+	}
+
+	if( rtos == NULL )	return;
+
+	if( tim1637->Mode == TIM1637_MODE_BLOCKING ){
+		// A frame sent from an ISR is not a request of this layer
+		if( __get_IPSR() != 0U ){
+			return;
+		}
+		// Task context, tim1637_rtos_start_next of the same task goes on with the queue
+		taskENTER_CRITICAL();
+		if( rtos->Busy ){
+			tim1637_rtos_complete(rtos, HAL_OK, NULL);
+		}
+		taskEXIT_CRITICAL();
+		return;
+	}
+
+	UBaseType_t SavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+	if( rtos->Busy ){
+		tim1637_rtos_complete(rtos, HAL_OK, &HigherPriorityTaskWoken);
+	}
+	taskEXIT_CRITICAL_FROM_ISR(SavedInterruptStatus);
+
+	// Also after a frame sent out of this layer, the requests queued meanwhile wait for it
+	tim1637_rtos_start_next(rtos, &HigherPriorityTaskWoken);
+
+	portYIELD_FROM_ISR(HigherPriorityTaskWoken);
+}
+
+
+/*	*********************************
+ * 		Define Private Methods
+ *  *********************************/
+
+/**
+  * @brief  Queue the request, start it if the device is free and suspend the task until the frame is sent.
+  * @param  request Request to send, Task is set with the calling task.
+  * @retval HAL_OK, HAL_BUSY if the queue is full, HAL_TIMEOUT.
+  */
+static HAL_StatusTypeDef tim1637_rtos_request( TIM1637_RTOS_Handle_t* rtos, TIM1637_RTOS_Request_t* request, TickType_t Timeout ){
+
+	uint32_t status = HAL_OK;
+
+	request->Task = xTaskGetCurrentTaskHandle();
+
+	// Discard a notification of a previous request that timed out
+	xTaskNotifyStateClearIndexed(NULL, TIM1637_RTOS_NOTIFY_INDEX);
+
+	taskENTER_CRITICAL();
+	if( rtos->Count == TIM1637_RTOS_QUEUE_LEN ){
+		taskEXIT_CRITICAL();
+		return HAL_BUSY;
+	}
+
+	tim1637_rtos_push(rtos, request);
+	taskEXIT_CRITICAL();
+
+	tim1637_rtos_start_next(rtos, NULL);
+
+	if( xTaskNotifyWaitIndexed(TIM1637_RTOS_NOTIFY_INDEX, 0, 0xFFFFFFFFUL, &status, Timeout) != pdTRUE ){
+
+		// The request must not notify the task after the timeout
+		taskENTER_CRITICAL();
+		tim1637_rtos_cancel(rtos, request->Task);
+		taskEXIT_CRITICAL();
+
+		return HAL_TIMEOUT;
+	}
+
+	return (HAL_StatusTypeDef) status;
+}
+
+/**
+  * @brief  Insert the request sorted by priority, after the requests with the same priority.
+  * @note	Call inside a critical section, the queue must have space.
+  * @retval None
+  */
+static void tim1637_rtos_push( TIM1637_RTOS_Handle_t* rtos, const TIM1637_RTOS_Request_t* request ){
+
+	uint8_t idx = rtos->Count;
+
+	while( idx > 0 && rtos->Queue[idx - 1].Priority < request->Priority ){
+		rtos->Queue[idx] = rtos->Queue[idx - 1];
+		idx --;
+	}
+
+	rtos->Queue[idx] = *request;
+	rtos->Count ++;
+}
+
+/**
+  * @brief  Remove the request of the task from the queue, or detach it from the frame in progress.
+  * @note	Call inside a critical section.
+  * @retval None
+  */
+static void tim1637_rtos_cancel( TIM1637_RTOS_Handle_t* rtos, TaskHandle_t Task ){
+
+	if( rtos->Busy && rtos->Active.Task == Task ){
+		rtos->Active.Task = NULL;
+		return;
+	}
+
+	for( uint8_t idx = 0; idx < rtos->Count; idx ++ ){
+		if( rtos->Queue[idx].Task == Task ){
+			for( ; idx < ( rtos->Count - 1 ); idx ++ ){
+				rtos->Queue[idx] = rtos->Queue[idx + 1];
+			}
+			rtos->Count --;
+			return;
+		}
+	}
+}
+
+/**
+  * @brief  Take the request with the highest priority as the active one, if no frame is in progress.
+  * @note	Call inside a critical section.
+  * @retval 1 if a request was taken, 0 otherwise.
+  */
+static uint8_t tim1637_rtos_take( TIM1637_RTOS_Handle_t* rtos ){
+
+	if( rtos->Busy || rtos->Count == 0 || rtos->Device->State != TIM1637_STATE_READY ){
+		return 0;
+	}
+
+	rtos->Active = rtos->Queue[0];
+	for( uint8_t idx = 1; idx < rtos->Count; idx ++ ){
+		rtos->Queue[idx - 1] = rtos->Queue[idx];
+	}
+	rtos->Count --;
+	rtos->Busy = 1;
+
+	return 1;
+}
+
+/**
+  * @brief  Start the frame of the active request, sent before returning in Blocking Mode.
+  * @note	Call outside of the critical section, only the task or ISR that took the request.
+  * @retval HAL_OK if the frame was started, HAL_BUSY if a frame out of this layer came first, HAL_ERROR.
+  */
+static HAL_StatusTypeDef tim1637_rtos_send( TIM1637_RTOS_Handle_t* rtos ){
+
+	switch (rtos->Active.Type) {
+		case TIM1637_RTOS_REQ_DIGITS:
+			return tim1637_SetDigits(rtos->Device, rtos->Active.Data);
+		case TIM1637_RTOS_REQ_VALUE:
+			return tim1637_SetValue(rtos->Device, rtos->Active.Data[0], rtos->Active.Data[1]);
+		case TIM1637_RTOS_REQ_DISPLAY_CTRL:
+			return tim1637_SetDisplayCtrl(rtos->Device, (TIM1637_DisplayCtrl_e) rtos->Active.Data[0], (TIM1637_PulseWidth_e) rtos->Active.Data[1]);
+		default:
+			return HAL_ERROR;
+	}
+}
+
+/**
+  * @brief  Start the frame of the request with the highest priority, if no frame is in progress.
+  * @note	Call outside of the critical section. In Blocking Mode the frames are sent here, one request after the other.
+  * 		A request overtaken by a frame out of this layer goes back to the queue, it is taken again once the
+  * 		device is free, here or at the end of that frame.
+  * 		A request that can not be started is completed with its error, the next one is tried.
+  * @param  HigherPriorityTaskWoken NULL in task context, the flag of the ISR otherwise.
+  * @retval None
+  */
+static void tim1637_rtos_start_next( TIM1637_RTOS_Handle_t* rtos, BaseType_t* HigherPriorityTaskWoken ){
+
+	UBaseType_t SavedInterruptStatus = 0;
+	uint8_t taken;
+
+	for( ;; ){
+
+		if( HigherPriorityTaskWoken != NULL ){
+			SavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+		}else{
+			taskENTER_CRITICAL();
+		}
+		taken = tim1637_rtos_take(rtos);
+		if( HigherPriorityTaskWoken != NULL ){
+			taskEXIT_CRITICAL_FROM_ISR(SavedInterruptStatus);
+		}else{
+			taskEXIT_CRITICAL();
+		}
+
+		if( taken == 0 ){
+			return;
+		}
+
+		HAL_StatusTypeDef status = tim1637_rtos_send(rtos);
+		if( status == HAL_OK ){
+			continue;
+		}
+
+		if( HigherPriorityTaskWoken != NULL ){
+			SavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+		}else{
+			taskENTER_CRITICAL();
+		}
+		if( status == HAL_BUSY && rtos->Active.Task != NULL && rtos->Count < TIM1637_RTOS_QUEUE_LEN ){
+			// Back in front of the requests with the same priority
+			uint8_t idx = rtos->Count;
+			while( idx > 0 && rtos->Queue[idx - 1].Priority <= rtos->Active.Priority ){
+				rtos->Queue[idx] = rtos->Queue[idx - 1];
+				idx --;
+			}
+			rtos->Queue[idx] = rtos->Active;
+			rtos->Count ++;
+			rtos->Busy = 0;
+		}else{
+			// No frame was started, the end of frame will not come
+			tim1637_rtos_complete(rtos, status, HigherPriorityTaskWoken);
+		}
+		if( HigherPriorityTaskWoken != NULL ){
+			taskEXIT_CRITICAL_FROM_ISR(SavedInterruptStatus);
+		}else{
+			taskEXIT_CRITICAL();
+		}
+	}
+}
+
+/**
+  * @brief  End of the active request, notify its task with the status.
+  * @note	Call inside a critical section.
+  * @param  HigherPriorityTaskWoken NULL in task context, the flag of the ISR otherwise.
+  * @retval None
+  */
+static void tim1637_rtos_complete( TIM1637_RTOS_Handle_t* rtos, HAL_StatusTypeDef status, BaseType_t* HigherPriorityTaskWoken ){
+
+	rtos->Busy = 0;
+
+	if( rtos->Active.Task == NULL ){
+		return;
+	}
+
+	if( HigherPriorityTaskWoken != NULL ){
+		xTaskNotifyIndexedFromISR(rtos->Active.Task, TIM1637_RTOS_NOTIFY_INDEX, status, eSetValueWithOverwrite, HigherPriorityTaskWoken);
+	}else{
+		xTaskNotifyIndexed(rtos->Active.Task, TIM1637_RTOS_NOTIFY_INDEX, status, eSetValueWithOverwrite);
+	}
+}
+
+#endif /* TIM1637_USE_FREERTOS */